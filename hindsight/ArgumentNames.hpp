@@ -22,6 +22,10 @@
 				static constexpr auto NAME_SUBCOMMAND_MORTEM = "mortem";
 				static constexpr auto DESC_SUBCOMMAND_MORTEM = "The postmortem debugger, which can be registered and automatically invoked by the system";
 
+				// hindsight [opts] batch [opts]
+				static constexpr auto NAME_SUBCOMMAND_BATCH = "batch";
+				static constexpr auto DESC_SUBCOMMAND_BATCH = "Replay many previously recorded binary log files in parallel, for triaging collections of crash logs";
+
 				// hindsight --stdout [opts] [launch|replay] [opts]
 				static constexpr auto NAME_STDOUT = "stdout";
 				static constexpr const OptionDescriptor DESC_STDOUT(NAME_STDOUT, "-s,--stdout", "Indicate that the debugger should output to stdout");
@@ -34,6 +38,34 @@
 				static constexpr auto NAME_LOGBIN = "logbinary";
 				static constexpr const OptionDescriptor DESC_LOGBIN(NAME_LOGBIN, "-w,--write-binary", "Indicate that the debugger should output to binary log file");
 
+				// hindsight --write-binary --flush [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_FLUSH = "flush";
+				static constexpr const OptionDescriptor DESC_FLUSH(NAME_FLUSH, "--flush", "Determines when the binary log file is flushed to disk: after each event, when the staged data exceeds --flush-size or on exit");
+
+				// hindsight --write-binary --flush-size [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_FLUSHSIZE = "flushsize";
+				static constexpr const OptionDescriptor DESC_FLUSHSIZE(NAME_FLUSHSIZE, "--flush-size", "The number of bytes to stage before flushing the binary log file when --flush is size");
+
+				// hindsight --write-binary --async-write [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_ASYNCWRITE = "asyncwrite";
+				static constexpr const OptionDescriptor DESC_ASYNCWRITE(NAME_ASYNCWRITE, "--async-write", "Write the binary log file from a background thread, so that the debugged process is not held up by disk I/O");
+
+				// hindsight --write-binary --compact [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_COMPACT = "compact";
+				static constexpr const OptionDescriptor DESC_COMPACT(NAME_COMPACT, "--compact", "Write stack traces in the compact varint encoding, which makes binary log files much smaller but cannot be replayed by older versions of hindsight");
+
+				// hindsight --write-binary --compress [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_COMPRESS = "compress";
+				static constexpr const OptionDescriptor DESC_COMPRESS(NAME_COMPRESS, "--compress", "Write the binary log file as independently compressed blocks, every complete block can still be read after a crash");
+
+				// hindsight --dispatch [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_DISPATCH = "dispatch";
+				static constexpr const OptionDescriptor DESC_DISPATCH(NAME_DISPATCH, "--dispatch", "Give each output its own queue and thread, so that slow output does not hold up the debugged process, and choose what happens when a queue is full. The binary log file always uses block");
+
+				// hindsight --dispatch --dispatch-queue [opts] [launch|replay|mortem] [opts]
+				static constexpr auto NAME_DISPATCHQUEUE = "dispatchqueue";
+				static constexpr const OptionDescriptor DESC_DISPATCHQUEUE(NAME_DISPATCHQUEUE, "--dispatch-queue", "The number of events that can be queued for each output with --dispatch");
+
 				// hindsight --bland [opts] [subcommand] [opts]
 				static constexpr auto NAME_BLAND = "bland";
 				static constexpr const OptionDescriptor DESC_BLAND(NAME_BLAND, "-b,--bland", "Disable colours in terminal output when --stdout was specified");
@@ -66,6 +98,14 @@
 				static constexpr auto NAME_MAX_INSTRUCTION = "maxinstruction";
 				static constexpr const OptionDescriptor DESC_MAX_INSTRUCTION(NAME_MAX_INSTRUCTION, "-i,--max-instruction", "Set the maximum number of instructions to include in a stack trace. Use 0 to disable");
 
+				// hindsight [opts] [launch|mortem] --raw-frames [opts]
+				static constexpr auto NAME_RAWFRAMES = "rawframes";
+				static constexpr const OptionDescriptor DESC_RAWFRAMES(NAME_RAWFRAMES, "--raw-frames", "Record stack frames as module + offset without resolving symbols, together with the identity of each module, and symbolize them at replay with --symbolize");
+
+				// hindsight [opts] [launch|mortem] --stack-snapshot KiB [opts]
+				static constexpr auto NAME_STACKSNAPSHOT = "stacksnapshot";
+				static constexpr const OptionDescriptor DESC_STACKSNAPSHOT(NAME_STACKSNAPSHOT, "--stack-snapshot", "Capture up to this many KiB of the stack with every exception in a single read, from the stack pointer up to the stack base, and store it in the binary log for offline analysis. Use 0 to disable");
+
 				// hindsight [opts] [launch|replay] --print--context [opts]
 				static constexpr auto NAME_PRINTCTX = "printctx";
 				static constexpr const OptionDescriptor DESC_PRINTCTX(NAME_PRINTCTX, "-c,--print-context", "Print the CPU context when a stack trace is printed for the textual output modes");
@@ -90,6 +130,54 @@
 				static constexpr auto NAME_NOSANITY = "nosanity";
 				static constexpr const OptionDescriptor DESC_NOSANITY(NAME_NOSANITY, "--no-sanity-check", "Do not verify the checksum of the event data in the file");
 
+				// hindsight [opts] replay [opts] --no-memory-map [file]
+				static constexpr auto NAME_NOMMAP = "nommap";
+				static constexpr const OptionDescriptor DESC_NOMMAP(NAME_NOMMAP, "--no-memory-map", "Read the binary log file through a regular file stream instead of mapping it into memory");
+
+				// hindsight [opts] replay [opts] --single-pass [file]
+				static constexpr auto NAME_SINGLEPASS = "singlepass";
+				static constexpr const OptionDescriptor DESC_SINGLEPASS(NAME_SINGLEPASS, "--single-pass", "Verify the checksum while playing instead of reading the file twice, events are held back until the data up to them has been verified");
+
+				// hindsight [opts] replay [opts] --recover [file]
+				static constexpr auto NAME_RECOVER = "recover";
+				static constexpr const OptionDescriptor DESC_RECOVER(NAME_RECOVER, "--recover", "Replay a binary log file that never finished writing or was damaged, up to its last intact checkpoint");
+
+				// hindsight [opts] replay [opts] --symbolize [file]
+				static constexpr auto NAME_SYMBOLIZE = "symbolize";
+				static constexpr const OptionDescriptor DESC_SYMBOLIZE(NAME_SYMBOLIZE, "--symbolize", "Resolve the symbols of stack frames that were recorded with --raw-frames, by loading the recorded modules or finding them through the symbol path");
+
+				// hindsight [opts] replay [opts] --symbolize --symbol-path [file]
+				static constexpr auto NAME_SYMBOLPATH = "symbolpath";
+				static constexpr const OptionDescriptor DESC_SYMBOLPATH(NAME_SYMBOLPATH, "--symbol-path", "The DbgHelp symbol path for --symbolize, such as srv*C:\\Symbols*https://msdl.microsoft.com/download/symbols. Defaults to _NT_SYMBOL_PATH");
+
+				// hindsight [opts] replay [opts] --symbolize --symbol-cache [path] [file]
+				static constexpr auto NAME_SYMBOLCACHE = "symbolcache";
+				static constexpr const OptionDescriptor DESC_SYMBOLCACHE(NAME_SYMBOLCACHE, "--symbol-cache", "A file that caches resolved frames for --symbolize by module build and offset, which is created when it does not exist and can be shared by all replays on this machine");
+
+				// hindsight [opts] replay [opts] --last-exception [file]
+				static constexpr auto NAME_LASTEXCEPTION = "lastexception";
+				static constexpr const OptionDescriptor DESC_LASTEXCEPTION(NAME_LASTEXCEPTION, "--last-exception", "Only replay the last exception in the file, using the index of the file to skip all other events");
+
+				// hindsight [opts] replay [opts] --window-start [file]
+				static constexpr auto NAME_WINDOWSTART = "windowstart";
+				static constexpr const OptionDescriptor DESC_WINDOWSTART(NAME_WINDOWSTART, "--window-start", "Only replay events recorded at least this many seconds after the start of the recording, using the index of the file");
+
+				// hindsight [opts] replay [opts] --window-end [file]
+				static constexpr auto NAME_WINDOWEND = "windowend";
+				static constexpr const OptionDescriptor DESC_WINDOWEND(NAME_WINDOWEND, "--window-end", "Only replay events recorded at most this many seconds after the start of the recording, using the index of the file");
+
+				// hindsight [opts] batch [opts] --jobs [path...]
+				static constexpr auto NAME_JOBS = "jobs";
+				static constexpr const OptionDescriptor DESC_JOBS(NAME_JOBS, "-j,--jobs", "The number of files to replay in parallel. Use 0 to use one thread per logical processor");
+
+				// hindsight [opts] batch [opts] --signatures [path...]
+				static constexpr auto NAME_SIGNATURES = "signatures";
+				static constexpr const OptionDescriptor DESC_SIGNATURES(NAME_SIGNATURES, "-g,--signatures", "Group all exceptions by crash signature and print the number of occurrences and a representative file for each signature");
+
+				// hindsight [opts] batch [opts] --signatures --signature-frames [path...]
+				static constexpr auto NAME_SIGFRAMES = "sigframes";
+				static constexpr const OptionDescriptor DESC_SIGFRAMES(NAME_SIGFRAMES, "--signature-frames", "The number of top stack frames that are part of a crash signature");
+
 				// hindsight [opts] replay [opts] --post-pause [file]
 				static constexpr auto NAME_PPAUSE = "ppause";
 				static constexpr const OptionDescriptor DESC_PPAUSE(NAME_PPAUSE, "-p,--post-pause", "After replaying a binary log file, pause and keep the console open until the user presses a key");
@@ -118,6 +206,10 @@
 				static constexpr auto NAME_BINPATH = "binpath";
 				static constexpr const OptionDescriptor DESC_BINPATH(NAME_BINPATH, "path", "The path to the binary log file to replay");
 
+				// hindsight [opts] batch [opts] path...
+				static constexpr auto NAME_BATCHPATH = "batchpath";
+				static constexpr const OptionDescriptor DESC_BATCHPATH(NAME_BATCHPATH, "path", "One or more binary log files, directories to search for .hind files or wildcard patterns such as crashes\\*.hind");
+
 				// hindsight [opts] launch [opts] [path] arguments...
 				static constexpr auto NAME_ARGUMENTS = "arguments";
 				static constexpr const OptionDescriptor DESC_ARGUMENTS(NAME_ARGUMENTS, "arguments", "The program parameters");
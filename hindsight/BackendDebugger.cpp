@@ -0,0 +1,415 @@
+#include "BackendDebugger.hpp"
+#include "RecursionDetector.hpp"
+#include "SnapshotMemoryReader.hpp"
+#include "String.hpp"
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#include <ctime>
+
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::Backend;
+using namespace Hindsight::Debugger::EventHandler;
+using Hindsight::Utilities::String;
+
+/// <summary>
+/// The integer registers of a 64-bit context, in the order of <see cref="::Hindsight::Debugger::Backend::IRegisterContext::Register"/>.
+/// </summary>
+static DWORD64 CONTEXT::* const context_registers[16] = {
+	&CONTEXT::Rax, &CONTEXT::Rcx, &CONTEXT::Rdx, &CONTEXT::Rbx, &CONTEXT::Rsp, &CONTEXT::Rbp, &CONTEXT::Rsi, &CONTEXT::Rdi,
+	&CONTEXT::R8, &CONTEXT::R9, &CONTEXT::R10, &CONTEXT::R11, &CONTEXT::R12, &CONTEXT::R13, &CONTEXT::R14, &CONTEXT::R15
+};
+
+/// <summary>
+/// The integer registers of a 32-bit context, in the order of <see cref="::Hindsight::Debugger::Backend::IRegisterContext::Register"/>.
+/// </summary>
+static DWORD WOW64_CONTEXT::* const wow64_context_registers[8] = {
+	&WOW64_CONTEXT::Eax, &WOW64_CONTEXT::Ecx, &WOW64_CONTEXT::Edx, &WOW64_CONTEXT::Ebx, &WOW64_CONTEXT::Esp, &WOW64_CONTEXT::Ebp, &WOW64_CONTEXT::Esi, &WOW64_CONTEXT::Edi
+};
+
+/// <summary>
+/// Translate the code of a backend exception to the exception code that is recorded. Backends on Windows report exception
+/// codes as they are, the signals of POSIX backends are mapped to the exception that Windows raises for the same fault.
+/// </summary>
+/// <param name="code">The exception code or signal number.</param>
+/// <returns>The exception code, or the signal number when no exception corresponds to it.</returns>
+static DWORD exception_code(uint32_t code) {
+#ifndef _WIN32
+	switch (code) {
+		case SIGSEGV:	return EXCEPTION_ACCESS_VIOLATION;
+		case SIGBUS:	return EXCEPTION_IN_PAGE_ERROR;
+		case SIGILL:	return EXCEPTION_ILLEGAL_INSTRUCTION;
+		case SIGFPE:	return EXCEPTION_INT_DIVIDE_BY_ZERO;
+		case SIGTRAP:	return EXCEPTION_BREAKPOINT;
+	}
+#endif
+
+	return static_cast<DWORD>(code);
+}
+
+/// <summary>
+/// Construct a new BackendDebugger for a process that was launched by a backend.
+/// </summary>
+/// <param name="backend">The backend, which must outlive the debugger.</param>
+/// <param name="config">The options of this session.</param>
+/// <param name="path">The program path.</param>
+/// <param name="workingDirectory">The program starting working directory.</param>
+/// <param name="args">The program arguments.</param>
+BackendDebugger::BackendDebugger(Backend::IDebugBackend& backend, const DebuggerConfig& config, const std::string& path, const std::string& workingDirectory, const std::vector<std::string>& args)
+	: m_Backend(backend), m_Config(config) {
+
+	// there are no handles, the IDs are all that identify the process and its main thread
+	PROCESS_INFORMATION pi = { nullptr, nullptr, backend.ProcessId(), backend.ProcessId() };
+	m_Process = std::make_shared<Hindsight::Process::Process>(pi, path, workingDirectory, args);
+}
+
+/// <summary>
+/// Add an implementation of <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/> to the debugger.
+/// </summary>
+/// <param name="handler">The debug event handler.</param>
+void BackendDebugger::AddHandler(std::shared_ptr<EventHandler::IDebuggerEventHandler> handler) {
+	m_Handlers.push_back(handler);
+}
+
+/// <summary>
+/// Start the debugger main loop, which returns when the debugged process has exited.
+/// </summary>
+void BackendDebugger::Start() {
+	auto time = std::time(nullptr);
+	for (auto handler : m_Handlers)
+		handler->OnInitialization(time, m_Process);
+
+	// While events can be processed, continue.
+	while (Tick());
+
+	// Finalize handlers.
+	time = std::time(nullptr);
+	for (auto handler : m_Handlers)
+		handler->OnModuleCollectionComplete(time, m_LoadedModules);
+}
+
+/// <summary>
+/// Get the modules that were loaded during the session.
+/// </summary>
+/// <returns>A const reference to the module collection.</returns>
+const ModuleCollection& BackendDebugger::Modules() const noexcept {
+	return m_LoadedModules;
+}
+
+/// <summary>
+/// Wait for the next event of the backend, emit it to all the handlers and continue it.
+/// </summary>
+/// <returns>When the debug loop should stop, false is returned.</returns>
+bool BackendDebugger::Tick() {
+	BackendEvent event;
+	if (!m_Backend.Next(event))
+		return false;
+
+	PROCESS_INFORMATION pi = { nullptr, nullptr, event.ProcessId, event.ThreadId };
+	auto time = std::time(nullptr);
+	auto base = reinterpret_cast<ModulePointer>(static_cast<uintptr_t>(event.Address));
+	auto stay = true;
+
+	// This debugger does not handle exceptions, it records them. Breakpoints are not passed on, like the Windows debugger does.
+	auto handled = event.Kind != BackendEventKind::Exception;
+
+	switch (event.Kind) {
+		// The process image is loaded by the creation of the process, as on Windows.
+		case BackendEventKind::CreateProcess: {
+			auto path = String::ToWString(event.Path);
+			m_LoadedModules.Load(path, base, static_cast<size_t>(event.Size));
+
+			CREATE_PROCESS_DEBUG_INFO info = {};
+			info.lpBaseOfImage = base;
+
+			for (auto handler : m_Handlers)
+				handler->OnCreateProcess(time, info, pi, path, m_LoadedModules);
+
+			break;
+		}
+
+		// The start address of a thread is not known to a backend, the handlers record threads without one.
+		case BackendEventKind::CreateThread: {
+			CREATE_THREAD_DEBUG_INFO info = {};
+
+			for (auto handler : m_Handlers)
+				handler->OnCreateThread(time, info, pi, m_LoadedModules);
+
+			break;
+		}
+
+		case BackendEventKind::ExitThread: {
+			EXIT_THREAD_DEBUG_INFO info = { event.Code };
+
+			for (auto handler : m_Handlers)
+				handler->OnExitThread(time, info, pi, m_LoadedModules);
+
+			break;
+		}
+
+		case BackendEventKind::ExitProcess: {
+			stay = false; /* stop debugging */
+			EXIT_PROCESS_DEBUG_INFO info = { event.Code };
+
+			for (auto handler : m_Handlers)
+				handler->OnExitProcess(time, info, pi, m_LoadedModules);
+
+			break;
+		}
+
+		// Mark the module as loaded before invoking the handlers.
+		case BackendEventKind::ModuleLoad: {
+			auto path = String::ToWString(event.Path);
+			m_LoadedModules.Load(path, base, static_cast<size_t>(event.Size));
+
+			LOAD_DLL_DEBUG_INFO info = {};
+			info.lpBaseOfDll = base;
+
+			for (auto handler : m_Handlers)
+				handler->OnDllLoad(time, info, pi, path, m_LoadedModules.GetIndex(path), m_LoadedModules);
+
+			break;
+		}
+
+		// Invoke the handlers and then mark the module as unloaded.
+		case BackendEventKind::ModuleUnload: {
+			auto path = m_LoadedModules.Get(base);
+
+			UNLOAD_DLL_DEBUG_INFO info = {};
+			info.lpBaseOfDll = base;
+
+			for (auto handler : m_Handlers)
+				handler->OnDllUnload(time, info, pi, path, m_LoadedModules.GetIndex(path), m_LoadedModules);
+
+			m_LoadedModules.Unload(base);
+			break;
+		}
+
+		case BackendEventKind::Breakpoint:
+		case BackendEventKind::Exception:
+			Exception(time, event, pi);
+			break;
+
+		case BackendEventKind::DebugString: {
+			OUTPUT_DEBUG_STRING_INFO info = {};
+			info.nDebugStringLength = static_cast<WORD>(event.String.size() < 0xffff ? event.String.size() : 0xffff);
+
+			auto debugString = String::Trim(event.String);
+			for (auto handler : m_Handlers)
+				handler->OnDebugString(time, info, pi, debugString);
+
+			break;
+		}
+	}
+
+	m_Backend.Continue(event, handled);
+	return stay;
+}
+
+/// <summary>
+/// Emit an exception or breakpoint event, with the registers, stack snapshot and stack trace of its thread.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="event">A const reference to the backend event.</param>
+/// <param name="pi">A const reference to the process and thread of the event.</param>
+void BackendDebugger::Exception(time_t time, const BackendEvent& event, const PROCESS_INFORMATION& pi) {
+	auto registers = m_Backend.Context(event.ThreadId);
+	auto pc = registers ? registers->ProgramCounter() : event.Address;
+
+	EXCEPTION_DEBUG_INFO info = {};
+	info.dwFirstChance						= event.FirstChance;
+	info.ExceptionRecord.ExceptionCode		= exception_code(event.Code);
+	info.ExceptionRecord.ExceptionAddress	= reinterpret_cast<PVOID>(static_cast<uintptr_t>(pc));
+
+	// like an access violation, a fault records whether it was a read or write (which is unknown here) and the address it accessed
+	if (info.ExceptionRecord.ExceptionCode == EXCEPTION_ACCESS_VIOLATION || info.ExceptionRecord.ExceptionCode == EXCEPTION_IN_PAGE_ERROR) {
+		info.ExceptionRecord.NumberParameters		 = 2;
+		info.ExceptionRecord.ExceptionInformation[1] = static_cast<ULONG_PTR>(event.Address);
+	}
+
+	// Construct the thread context in the layout of a Windows context, so that it is recorded like one.
+	std::shared_ptr<DebugContext> context;
+
+	if (registers == nullptr || registers->Is64()) {
+		CONTEXT x64 = {};
+		x64.ContextFlags = CONTEXT_FULL;
+
+		if (registers != nullptr) {
+			for (size_t i = 0; i < 16; ++i)
+				x64.*context_registers[i] = registers->Register(i);
+
+			x64.Rsp	   = registers->StackPointer();
+			x64.Rbp	   = registers->FramePointer();
+			x64.EFlags = static_cast<DWORD>(registers->Flags());
+		}
+
+		x64.Rip = pc;
+		context = std::make_shared<DebugContext>(pi, x64);
+	} else {
+		WOW64_CONTEXT x86 = {};
+		x86.ContextFlags = WOW64_CONTEXT_FULL;
+
+		for (size_t i = 0; i < 8; ++i)
+			x86.*wow64_context_registers[i] = static_cast<DWORD>(registers->Register(i));
+
+		x86.Eip	   = static_cast<DWORD>(pc);
+		x86.EFlags = static_cast<DWORD>(registers->Flags());
+		context = std::make_shared<DebugContext>(pi, x86);
+	}
+
+	// The stack is read once, the trace is walked from that snapshot and the snapshot is recorded with the exception.
+	std::vector<uint8_t> stack;
+	auto sp = registers ? registers->StackPointer() : 0;
+
+	if (registers != nullptr && m_Config.StackSnapshot != 0) {
+		stack.resize(m_Config.StackSnapshot);
+		stack.resize(m_Backend.Read(sp, stack.data(), stack.size()));
+		context->SetStack(sp, stack);
+	}
+
+	SnapshotMemoryReader memory(sp, stack.data(), stack.size(), &m_Backend);
+
+	auto trace = registers != nullptr
+		? std::make_shared<DebugStackTrace>(context, m_LoadedModules, Walk(*registers, memory))
+		: std::make_shared<DebugStackTrace>(context, m_LoadedModules, BinaryLog::StackTraceConcrete());
+
+	if (event.Kind == BackendEventKind::Breakpoint) {
+		for (auto handler : m_Handlers)
+			handler->OnBreakpointHit(time, info, pi, context, trace, m_LoadedModules);
+
+		return;
+	}
+
+	std::wstring name;
+	if (ExceptionNames.count(event.Code))
+		name = ExceptionNames.at(event.Code);
+
+	for (auto handler : m_Handlers)
+		handler->OnException(time, info, pi, event.FirstChance, name, context, trace, m_LoadedModules, nullptr);
+}
+
+/// <summary>
+/// Walk the stack along the frame pointer chain and resolve the symbols of the frames, unless frames are recorded raw. Each
+/// frame that keeps a frame pointer saves the frame pointer of its caller at [fp] and its return address right above it,
+/// the walk stops at the first frame pointer that does not point further up the stack.
+/// </summary>
+/// <param name="registers">The registers of the thread.</param>
+/// <param name="memory">The memory to read the stack from.</param>
+/// <returns>The stack trace.</returns>
+Hindsight::BinaryLog::StackTraceConcrete BackendDebugger::Walk(const IRegisterContext& registers, const IMemoryReader& memory) {
+	BinaryLog::StackTraceConcrete trace;
+	trace.MaxRecursion	  = m_Config.MaxRecursion;
+	trace.MaxInstructions = 0;
+
+	auto add = [this, &trace](uint64_t address) {
+		auto& entry	  = trace.Entries.emplace_back();
+		entry.Address = address;
+
+		auto module = m_LoadedModules.GetModuleAtAddress(reinterpret_cast<const void*>(static_cast<uintptr_t>(address)));
+		if (module == nullptr)
+			return;
+
+		auto base		 = reinterpret_cast<uint64_t>(module->Base);
+		entry.ModuleBase = base;
+
+		// Raw frames only need their module, the offset into it is resolved at replay.
+		auto symbols = m_Config.RawFrames ? nullptr : Symbols(*module);
+		SymbolRecord record;
+
+		if (symbols == nullptr || !symbols->Lookup(address - base, record))
+			return;
+
+		auto rva = address - base;
+
+		if (record.HasSymbol) {
+			entry.AbsoluteAddress  = address + (rva - record.SymbolRva);
+			entry.Name			   = record.Name;
+			entry.NameSymbolLength = entry.Name.size();
+		}
+
+		if (record.HasLine) {
+			entry.AbsoluteLineAddress = address + (rva - record.LineRva);
+			entry.LineAddress		  = base + record.LineRva;
+			entry.Path				  = String::ToWString(record.File);
+			entry.PathLength		  = entry.Path.size();
+			entry.LineNumber		  = record.Line;
+		}
+	};
+
+	// collapses direct and mutual recursion, only the frames that it passes on are resolved
+	RecursionDetector<uint64_t> recursion(
+		add,
+		[&trace](size_t skipped) {
+			auto& entry			 = trace.Entries.emplace_back();
+			entry.IsRecursion	 = true;
+			entry.RecursionCount = skipped;
+		},
+		m_Config.MaxRecursion);
+
+	auto push = [this, &recursion, &add](uint64_t address) {
+		if (m_Config.MaxRecursion != SIZE_MAX)
+			recursion.Push(address, address);
+		else
+			add(address);
+	};
+
+	auto width = registers.Is64() ? size_t(8) : size_t(4);
+	auto fp	   = registers.FramePointer();
+
+	push(registers.ProgramCounter());
+
+	for (size_t frame = 1; frame < MaxFrames && fp != 0; ++frame) {
+		uint64_t caller = 0, address = 0;
+
+		if (memory.Read(fp, &caller, width) != width || memory.Read(fp + width, &address, width) != width || address == 0)
+			break;
+
+		push(address);
+
+		if (caller <= fp)
+			break;
+
+		fp = caller;
+	}
+
+	recursion.Flush();
+	trace.TraceEntries = trace.Entries.size();
+	return trace;
+}
+
+/// <summary>
+/// Get the symbols of a module, which are read on first use.
+/// </summary>
+/// <param name="module">The module.</param>
+/// <returns>The symbols, or nullptr when the module has no readable ELF image.</returns>
+ElfSymbolProvider* BackendDebugger::Symbols(const Module& module) {
+	auto found = m_Symbols.find(module.Path);
+	if (found != m_Symbols.end())
+		return found->second.get();
+
+	std::unique_ptr<ElfSymbolProvider> symbols;
+	try {
+		symbols = std::make_unique<ElfSymbolProvider>(String::ToString(module.Path));
+	} catch (const std::exception&) {
+		// not an ELF image, or it cannot be read, its frames are recorded without symbols
+	}
+
+	return m_Symbols.emplace(module.Path, std::move(symbols)).first->second.get();
+}
+
+/// <summary>
+/// Names of the signals that exceptions are raised for.
+/// </summary>
+std::map<uint32_t, std::wstring> BackendDebugger::ExceptionNames = {
+#ifndef _WIN32
+	{ SIGABRT,	L"SIGABRT" },
+	{ SIGBUS,	L"SIGBUS" },
+	{ SIGFPE,	L"SIGFPE" },
+	{ SIGILL,	L"SIGILL" },
+	{ SIGSEGV,	L"SIGSEGV" },
+	{ SIGSYS,	L"SIGSYS" },
+	{ SIGTRAP,	L"SIGTRAP" },
+#endif
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#ifndef debugger_backend_debugger_h
+#define debugger_backend_debugger_h
+	#include "Win32Types.hpp"
+	#include "DebugBackend.hpp"
+	#include "DebuggerConfig.hpp"
+	#include "IDebuggerEventHandler.hpp"
+	#include "ElfSymbolProvider.hpp"
+	#include "ModuleCollection.hpp"
+	#include "Process.hpp"
+
+	#include <cstdint>
+	#include <map>
+	#include <memory>
+	#include <string>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The debug loop for an <see cref="::Hindsight::Debugger::Backend::IDebugBackend"/>, which translates the platform
+			/// independent events of the backend to the events of <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/>,
+			/// so that the same handlers (such as the binary log writer) record a session on any platform the backend runs on.
+			/// Exceptions are recorded with the registers of the thread, a stack snapshot and a stack trace that is walked along
+			/// the frame pointer chain and symbolized with the ELF symbols of the modules.
+			/// </summary>
+			class BackendDebugger {
+				private:
+					Backend::IDebugBackend&								m_Backend;			/* The source of the events, which is not owned */
+					DebuggerConfig										m_Config;			/* The options of this session */
+					std::shared_ptr<Hindsight::Process::Process>		m_Process;			/* The debugged process, as passed to OnInitialization */
+					std::vector<std::shared_ptr<EventHandler::IDebuggerEventHandler>> m_Handlers;	/* The event handlers */
+					ModuleCollection									m_LoadedModules;	/* The modules that are loaded in the debugged process */
+					std::map<std::wstring, std::unique_ptr<ElfSymbolProvider>> m_Symbols;	/* The symbols of each module path, nullptr when it has none */
+
+				public:
+					/// <summary>
+					/// The most frames that are walked for one stack trace.
+					/// </summary>
+					static const size_t MaxFrames = 4096;
+
+					/// <summary>
+					/// Construct a new BackendDebugger for a process that was launched by a backend.
+					/// </summary>
+					/// <param name="backend">The backend, which must outlive the debugger.</param>
+					/// <param name="config">The options of this session.</param>
+					/// <param name="path">The program path.</param>
+					/// <param name="workingDirectory">The program starting working directory.</param>
+					/// <param name="args">The program arguments.</param>
+					BackendDebugger(Backend::IDebugBackend& backend, const DebuggerConfig& config, const std::string& path, const std::string& workingDirectory, const std::vector<std::string>& args);
+
+					/// <summary>
+					/// Add an implementation of <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/> to the debugger.
+					/// </summary>
+					/// <param name="handler">The debug event handler.</param>
+					void AddHandler(std::shared_ptr<EventHandler::IDebuggerEventHandler> handler);
+
+					/// <summary>
+					/// Start the debugger main loop, which returns when the debugged process has exited.
+					/// </summary>
+					void Start();
+
+					/// <summary>
+					/// Get the modules that were loaded during the session.
+					/// </summary>
+					/// <returns>A const reference to the module collection.</returns>
+					const ModuleCollection& Modules() const noexcept;
+
+					/// <summary>
+					/// Names of the signals that exceptions are raised for.
+					/// </summary>
+					static std::map<uint32_t, std::wstring> ExceptionNames;
+
+				private:
+					/// <summary>
+					/// Wait for the next event of the backend, emit it to all the handlers and continue it.
+					/// </summary>
+					/// <returns>When the debug loop should stop, false is returned.</returns>
+					bool Tick();
+
+					/// <summary>
+					/// Emit an exception or breakpoint event, with the registers, stack snapshot and stack trace of its thread.
+					/// </summary>
+					/// <param name="time">The time of the event.</param>
+					/// <param name="event">A const reference to the backend event.</param>
+					/// <param name="pi">A const reference to the process and thread of the event.</param>
+					void Exception(time_t time, const Backend::BackendEvent& event, const PROCESS_INFORMATION& pi);
+
+					/// <summary>
+					/// Walk the stack along the frame pointer chain and resolve the symbols of the frames, unless frames are recorded raw.
+					/// </summary>
+					/// <param name="registers">The registers of the thread.</param>
+					/// <param name="memory">The memory to read the stack from.</param>
+					/// <returns>The stack trace.</returns>
+					BinaryLog::StackTraceConcrete Walk(const Backend::IRegisterContext& registers, const Backend::IMemoryReader& memory);
+
+					/// <summary>
+					/// Get the symbols of a module, which are read on first use.
+					/// </summary>
+					/// <param name="module">The module.</param>
+					/// <returns>The symbols, or nullptr when the module has no readable ELF image.</returns>
+					ElfSymbolProvider* Symbols(const Module& module);
+			};
+		}
+	}
+
+#endif
@@ -1,9 +1,25 @@
 #include "BinaryLogFile.hpp"
-#include <DbgHelp.h>
+#include "String.hpp"
 #include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
 
 using namespace Hindsight::BinaryLog;
 
+/// <summary>
+/// Determine the size of the header in a file, which depends on the version that wrote it.
+/// </summary>
+/// <param name="version">The <see cref="Version"/> of the file.</param>
+/// <returns>The number of bytes of the header in the file.</returns>
+size_t FileHeader::SizeOf(uint32_t version) {
+	// 0.7 dropped the checksum of 0.6 and 0.8 put the flags in its place
+	if ((version >> 16) == FileFormatTraceStrings)
+		return offsetof(FileHeader, Flags);
+
+	return sizeof(FileHeader);
+}
+
 /// <summary>
 /// Construct a new EventEntryProcessInformation struct instance from a const reference to a <see cref="PROCESS_INFORMATION"/> instance.
 /// </summary>
@@ -227,4 +243,404 @@ StackTrace::StackTrace() {}
 StackTrace::StackTrace(uint64_t recursion, uint64_t instructions, uint64_t entries)
 	: MaxRecursion(recursion), MaxInstructions(instructions), TraceEntries(entries) {
 
+}
+
+/// <summary>
+/// Default constructor, generally used when reading an existing binary log file.
+/// </summary>
+CheckpointEntry::CheckpointEntry() {}
+
+/// <summary>
+/// Construct a CheckpointEntry.
+/// </summary>
+/// <param name="events">The number of event entries before the checkpoint.</param>
+/// <param name="crc32">The checksum of all data after the file header up to the checkpoint.</param>
+CheckpointEntry::CheckpointEntry(uint64_t events, uint32_t crc32)
+	: Events(events), Crc32(crc32) {
+
+}
+
+/// <summary>
+/// Default constructor, generally used when reading an existing binary log file.
+/// </summary>
+FileFooter::FileFooter() {}
+
+/// <summary>
+/// Construct a FileFooter.
+/// </summary>
+/// <param name="events">The number of event entries in the file.</param>
+/// <param name="crc32">The checksum of all data after the file header up to the footer.</param>
+FileFooter::FileFooter(uint64_t events, uint32_t crc32)
+	: Events(events), Crc32(crc32) {
+
+}
+
+/// <summary>
+/// Default constructor, generally used when reading an existing binary log file.
+/// </summary>
+CompactStackTrace::CompactStackTrace() {}
+
+/// <summary>
+/// Construct a CompactStackTrace header.
+/// </summary>
+/// <param name="size">The number of encoded bytes that follow the header.</param>
+CompactStackTrace::CompactStackTrace(uint32_t size)
+	: Size(size) {
+
+}
+
+/// <summary>
+/// Default constructor, generally used when reading an existing binary log file.
+/// </summary>
+StringTableEntry::StringTableEntry() {}
+
+/// <summary>
+/// Construct a StringTableEntry header.
+/// </summary>
+/// <param name="first">The reference of the first string that is defined.</param>
+/// <param name="count">The number of strings that are defined.</param>
+/// <param name="size">The number of encoded bytes that follow the header.</param>
+StringTableEntry::StringTableEntry(uint64_t first, uint32_t count, uint32_t size)
+	: First(first), Count(count), Size(size) {
+
+}
+
+/// <summary>
+/// Default constructor, generally used when reading an existing binary log file.
+/// </summary>
+StackMemoryEntry::StackMemoryEntry() {}
+
+/// <summary>
+/// Construct a StackMemoryEntry.
+/// </summary>
+/// <param name="address">The address of the first byte of the snapshot.</param>
+/// <param name="size">The number of bytes in the snapshot.</param>
+StackMemoryEntry::StackMemoryEntry(uint64_t address, uint64_t size)
+	: Address(address), Size(size) {
+
+}
+
+/// <summary>
+/// Default constructor, generally used when reading an existing binary log file.
+/// </summary>
+ModuleIdentityEntry::ModuleIdentityEntry() {}
+
+/// <summary>
+/// Construct a ModuleIdentityEntry from the identity of a loaded module.
+/// </summary>
+/// <param name="identity">The identity of the module.</param>
+ModuleIdentityEntry::ModuleIdentityEntry(const Hindsight::Debugger::ModuleIdentity& identity)
+	: Machine(identity.Machine), TimeDateStamp(identity.TimeDateStamp), SizeOfImage(identity.SizeOfImage), 
+	  HasPdb(static_cast<uint8_t>(identity.HasPdb)), PdbAge(identity.PdbAge), PdbPathLength(identity.PdbPath.size()) {
+
+	std::memcpy(PdbGuid, identity.PdbGuid, sizeof(PdbGuid));
+}
+
+/// <summary>
+/// Convert this entry back to a <see cref="::Hindsight::Debugger::ModuleIdentity"/>, without the PDB path that follows it.
+/// </summary>
+/// <returns>A newly created <see cref="::Hindsight::Debugger::ModuleIdentity"/>.</returns>
+ModuleIdentityEntry::operator Hindsight::Debugger::ModuleIdentity() const {
+	Hindsight::Debugger::ModuleIdentity identity;
+
+	identity.Machine		= Machine;
+	identity.TimeDateStamp	= TimeDateStamp;
+	identity.SizeOfImage	= SizeOfImage;
+	identity.HasPdb			= HasPdb != 0;
+	identity.PdbAge			= PdbAge;
+	std::memcpy(identity.PdbGuid, PdbGuid, sizeof(identity.PdbGuid));
+
+	return identity;
+}
+
+/// <summary>
+/// Write an unsigned integer.
+/// </summary>
+/// <param name="value">The value to write.</param>
+void CompactEncoder::Unsigned(uint64_t value) {
+	// 7 bits per byte, the high bit is set on every byte but the last
+	while (value >= 0x80) {
+		m_Data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+
+	m_Data.push_back(static_cast<char>(value));
+}
+
+/// <summary>
+/// Write a signed integer.
+/// </summary>
+/// <param name="value">The value to write.</param>
+void CompactEncoder::Signed(int64_t value) {
+	// zigzag encoding maps 0, -1, 1, -2, ... to 0, 1, 2, 3, ... so that small negative values stay small
+	Unsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+/// <summary>
+/// Write an address relative to <paramref name="origin"/>, which is small when both are in the same module. An address of 
+/// 0 (unknown) is written as 0, so that it does not cost a full varint.
+/// </summary>
+/// <param name="value">The address to write.</param>
+/// <param name="origin">The address that <paramref name="value"/> is relative to.</param>
+void CompactEncoder::Relative(uint64_t value, uint64_t origin) {
+	if (value == 0) {
+		Unsigned(0);
+		return;
+	}
+
+	auto delta = static_cast<int64_t>(value - origin);
+	Unsigned(((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)) + 1);
+}
+
+/// <summary>
+/// Write a block of bytes preceeded by its length, without interning it.
+/// </summary>
+/// <param name="data">A pointer to <paramref name="size"/> bytes of memory to write.</param>
+/// <param name="size">The number of bytes to write.</param>
+void CompactEncoder::Raw(const char* data, size_t size) {
+	Unsigned(size);
+	m_Data.insert(m_Data.end(), data, data + size);
+}
+
+/// <summary>
+/// Get the reference of a string in the string table, adding it to the table (and to the pending strings) when it is new.
+/// </summary>
+/// <param name="s">The string.</param>
+/// <returns>The reference of the string, 0 for the empty string.</returns>
+uint64_t CompactEncoder::Intern(const std::string& s) {
+	if (s.empty())
+		return 0;
+
+	// a new string gets the next reference and waits to be written in the next string table entry
+	auto reference = m_Strings.size() + 1;
+	auto result	   = m_Strings.emplace(s, reference);
+
+	if (result.second)
+		m_Pending.push_back(s);
+
+	return result.first->second;
+}
+
+/// <summary>
+/// Get the reference of a unicode string in the string table, its UTF-16 bytes are interned as they are.
+/// </summary>
+/// <param name="s">The string.</param>
+/// <returns>The reference of the string, 0 for the empty string.</returns>
+uint64_t CompactEncoder::Intern(const std::wstring& s) {
+	auto units = Hindsight::Utilities::String::ToUtf16(s);
+	return Intern(std::string(reinterpret_cast<const char*>(units.data()), units.size() * sizeof(char16_t)));
+}
+
+/// <summary>
+/// Write a string through the string table.
+/// </summary>
+/// <param name="s">The string to write.</param>
+void CompactEncoder::Interned(const std::string& s) {
+	Unsigned(Intern(s));
+}
+
+/// <summary>
+/// Write a unicode string through the string table, its UTF-16 bytes are interned as they are.
+/// </summary>
+/// <param name="s">The string to write.</param>
+void CompactEncoder::Interned(const std::wstring& s) {
+	Unsigned(Intern(s));
+}
+
+/// <summary>
+/// Get the data encoded since the last call to <see cref="Clear"/>.
+/// </summary>
+/// <returns>A const reference to the encoded data.</returns>
+const std::vector<char>& CompactEncoder::data() const noexcept {
+	return m_Data;
+}
+
+/// <summary>
+/// Remove all encoded data, the string table and the allocated memory are kept for the next trace.
+/// </summary>
+void CompactEncoder::Clear() noexcept {
+	m_Data.clear();
+}
+
+/// <summary>
+/// Get the strings that were added to the table since the last call to <see cref="ClearPending"/>.
+/// </summary>
+/// <returns>A const reference to the strings, in order of definition.</returns>
+const std::vector<std::string>& CompactEncoder::Pending() const noexcept {
+	return m_Pending;
+}
+
+/// <summary>
+/// Get the reference of the first pending string.
+/// </summary>
+/// <returns>The reference of the first string in <see cref="Pending"/>.</returns>
+uint64_t CompactEncoder::FirstPending() const noexcept {
+	return m_Strings.size() - m_Pending.size() + 1;
+}
+
+/// <summary>
+/// Mark the pending strings as written.
+/// </summary>
+void CompactEncoder::ClearPending() noexcept {
+	m_Pending.clear();
+}
+
+/// <summary>
+/// Construct a decoder for <paramref name="size"/> bytes at <paramref name="data"/>, the data and the string table must 
+/// outlive the decoder.
+/// </summary>
+/// <param name="data">A pointer to the encoded data.</param>
+/// <param name="size">The number of encoded bytes.</param>
+/// <param name="strings">The string table of the file, as read so far.</param>
+/// <param name="definitions">
+///		When true, a reference one past the end of <paramref name="strings"/> defines the next string in place, followed by its 
+///		length and bytes. This is how the STK2 traces of a <see cref="FileFormatTraceStrings"/> file each carry their own table.
+/// </param>
+CompactDecoder::CompactDecoder(const char* data, size_t size, std::vector<std::string>& strings, bool definitions)
+	: m_Cursor(data), m_End(data + size), m_Strings(strings), m_Definitions(definitions) {
+
+}
+
+/// <summary>
+/// Read an unsigned integer.
+/// </summary>
+/// <returns>The value.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or the varint is too long.</exception>
+uint64_t CompactDecoder::Unsigned() {
+	uint64_t value = 0;
+
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		if (m_Cursor == m_End)
+			throw std::runtime_error("unexpected end of compact stack trace, binary log file damaged");
+
+		auto byte = static_cast<uint8_t>(*m_Cursor++);
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+		if ((byte & 0x80) == 0)
+			return value;
+	}
+
+	throw std::runtime_error("invalid varint in compact stack trace, binary log file damaged");
+}
+
+/// <summary>
+/// Read a signed integer.
+/// </summary>
+/// <returns>The value.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or the varint is too long.</exception>
+int64_t CompactDecoder::Signed() {
+	auto value = Unsigned();
+	return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/// <summary>
+/// Read an address relative to <paramref name="origin"/>.
+/// </summary>
+/// <param name="origin">The address that the value is relative to.</param>
+/// <returns>The address, or 0 when it was unknown.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or the varint is too long.</exception>
+uint64_t CompactDecoder::Relative(uint64_t origin) {
+	auto value = Unsigned();
+	if (value == 0)
+		return 0;
+
+	--value;
+	return origin + ((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/// <summary>
+/// Read a block of bytes preceeded by its length.
+/// </summary>
+/// <param name="result">A reference to the string that receives the bytes.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly.</exception>
+void CompactDecoder::Raw(std::string& result) {
+	auto size = Unsigned();
+	if (size > static_cast<uint64_t>(m_End - m_Cursor))
+		throw std::runtime_error("unexpected end of compact stack trace, binary log file damaged");
+
+	result.assign(m_Cursor, static_cast<size_t>(size));
+	m_Cursor += size;
+}
+
+/// <summary>
+/// Read a string through the string table.
+/// </summary>
+/// <param name="result">A reference to the string that receives the value.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or refers to an undefined string.</exception>
+void CompactDecoder::Interned(std::string& result) {
+	result = Reference();
+}
+
+/// <summary>
+/// Read a unicode string through the string table.
+/// </summary>
+/// <param name="result">A reference to the string that receives the value.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or refers to an undefined string.</exception>
+void CompactDecoder::Interned(std::wstring& result) {
+	Lookup(Unsigned(), result);
+}
+
+/// <summary>
+/// Determines if all data has been decoded.
+/// </summary>
+/// <returns>true when there is no data left.</returns>
+bool CompactDecoder::Done() const noexcept {
+	return m_Cursor == m_End;
+}
+
+/// <summary>
+/// Look up a string in the string table.
+/// </summary>
+/// <param name="reference">The reference of the string, 0 for the empty string.</param>
+/// <param name="result">A reference to the string that receives the value.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the reference refers to an undefined string.</exception>
+void CompactDecoder::Lookup(uint64_t reference, std::string& result) const {
+	if (reference == 0) {
+		result.clear();
+		return;
+	}
+
+	if (reference > m_Strings.size())
+		throw std::runtime_error("undefined string in string table, binary log file damaged");
+
+	result = m_Strings[static_cast<size_t>(reference - 1)];
+}
+
+/// <summary>
+/// Look up a unicode string in the string table.
+/// </summary>
+/// <param name="reference">The reference of the string, 0 for the empty string.</param>
+/// <param name="result">A reference to the string that receives the value.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the reference refers to an undefined string.</exception>
+void CompactDecoder::Lookup(uint64_t reference, std::wstring& result) const {
+	std::string bytes;
+	Lookup(reference, bytes);
+
+	std::u16string units(bytes.size() / sizeof(char16_t), u'\0');
+	if (!units.empty())
+		std::memcpy(&units[0], bytes.data(), units.size() * sizeof(char16_t));
+
+	result = Hindsight::Utilities::String::FromUtf16(units.data(), units.size());
+}
+
+/// <summary>
+/// Look up (or with definitions, define) the interned string that is referenced next.
+/// </summary>
+/// <returns>A const reference to the string in the table, or to an empty string.</returns>
+const std::string& CompactDecoder::Reference() {
+	static const std::string empty;
+
+	auto reference = Unsigned();
+	if (reference == 0)
+		return empty;
+
+	if (m_Definitions && reference == m_Strings.size() + 1) {
+		Raw(m_Strings.emplace_back());
+		return m_Strings.back();
+	}
+
+	if (reference > m_Strings.size())
+		throw std::runtime_error("undefined string in string table, binary log file damaged");
+
+	return m_Strings[static_cast<size_t>(reference - 1)];
 }
\ No newline at end of file
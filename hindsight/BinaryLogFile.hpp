@@ -3,16 +3,18 @@
 #ifndef binary_log_file_h
 #define binary_log_file_h
 	#include "Version.hpp"
-	#include <Windows.h>
+	#include "ModuleIdentity.hpp"
+	#include "Win32Types.hpp"
 	#include <vector>
 	#include <string>
+	#include <unordered_map>
 	/*
 		File structure:
 			- (HIND) FileHeader (always starts with this)
-			  the file header has a Crc32 checksum field as well, all data of the log should be streamed to 
-			  step through a crc32 checksum state. This way, the full data of the binary log can be verified 
-			  to be intact (and to check if the module collection is written at the end, which is important for 
-			  some event entries).
+			  the file header is written once and never updated. All data of the log after the header should be 
+			  streamed to step through a crc32 checksum state, which is compared to the checksum in the FileFooter. 
+			  This way, the full data of the binary log can be verified to be intact (and to check if the module 
+			  collection is written at the end, which is important for some event entries).
 			- Frame collection
 			  After the file header comes a collection of frames, each frame is a different type. One should first 
 			  read the signature of 4 bytes to determine what kind of frame it is. Then the frame should be read 
@@ -22,6 +24,43 @@
 				to the start of the struct and read the appropriate type (i.e. CreateProcessEventEntry)
 			  - (MODS) ModuleList
 			    A collection specifying the modules the process has loaded during its lifetime.
+			  - (CHKP) CheckpointEntry
+			    Written between events whenever the writer flushes, with the checksum of all data before it. A reader can 
+				verify and replay the data up to the last intact checkpoint of a log that never finished writing.
+			  - (MODI) ModuleIdentityEntry, optional
+			    Directly follows the path of a create process or DLL load event when stack frames were recorded raw 
+				(module + offset, without symbols), followed by the PDB path. A reader that finds no MODI signature 
+				after the path continues with the next frame.
+			  - (STRS) StringTableEntry
+			    Defines the next strings of the string table of the file, which is shared by all STK2 frames and, when 
+				the header has FileFlagInternedPaths, by the module paths of create process and DLL load events. It is 
+				written directly before the first event that refers to one of its strings, and it is listed in the index 
+				(with IndexFlagStrings) so that a reader that seeks to an event can read the table up to that event first.
+			  - (STCK) StackTrace or (STK2) CompactStackTrace
+			    Follows the thread context of an exception event. STCK is followed by fixed size StackTraceEntry 
+				structs, STK2 by a block of LEB128 varints with addresses relative to the module base and strings 
+				that refer to the string table of the file (see CompactEncoder). A reader accepts either.
+			  - (STKM) StackMemoryEntry, optional
+			    Directly follows the stack trace of an exception event when a stack snapshot was captured, followed by 
+				StackMemoryEntry::Size bytes of the stack from StackMemoryEntry::Address up. A reader that finds no 
+				STKM signature after the stack trace continues with the next frame.
+			- (INDX) Index, optional
+			  After the last frame an IndexHeader may follow with an IndexEntry for each EventEntry in the file, 
+			  terminated by an IndexFooter. The index footer directly precedes the FileFooter, so a reader can check 
+			  the bytes before it for the INDX signature and find the index through IndexFooter::IndexOffset. The 
+			  index is part of the checksummed data. Files without an index are still valid.
+			- (HEND) FileFooter
+			  The last data in a completed file, with the number of events and the checksum of all data between the 
+			  FileHeader and the FileFooter. A file without a footer never finished writing, the checkpoints in it 
+			  can still be used to recover the intact part.
+
+		Compressed file structure:
+			- (HINZ) CompressedFileHeader
+			- (HIND) FileHeader, uncompressed so that the version can be checked before decompressing anything
+			- (BLCK) BlockHeader followed by BlockHeader::StoredSize bytes, repeated
+			  The blocks are compressed independently and each has a Crc32 checksum of its stored bytes. Concatenated, 
+			  the decompressed blocks are everything that follows the FileHeader in an uncompressed file, and all offsets 
+			  (such as in the index) refer to that uncompressed data. After a crash, every complete block is still readable.
 	*/
 	namespace Hindsight {
 		namespace BinaryLog {
@@ -29,6 +68,23 @@
 			// All structs that are written to the binary output stream are packed.
 			#pragma pack(push, 1)
 
+			/// <summary>
+			/// The older formats of binary log files that can still be read, by the major and minor version in <see cref="FileHeader::Version"/> 
+			/// (i.e. <c>Version &gt;&gt; 16</c>). Files of the current version are written as described above.
+			/// </summary>
+			enum FileFormat : uint32_t {
+				FileFormatHeaderChecksum = 0x0006, /* 0.6: the checksum of all data after the header is in the place of FileHeader::Flags, there are no CHKP, INDX, STRS or HEND frames */
+				FileFormatTraceStrings	 = 0x0007  /* 0.7: the header ends before FileHeader::Flags, there are no STRS frames, every STK2 trace defines its own strings in place and paths always follow their event */
+			};
+
+			/// <summary>
+			/// Flags describing how the frames of a file are encoded, see <see cref="FileHeader::Flags"/>.
+			/// </summary>
+			enum FileHeaderFlags : uint32_t {
+				FileFlagNone			= 0,
+				FileFlagInternedPaths	= 1  /* the path of a create process or DLL load event is a reference into the string table instead of a string that follows it */
+			};
+
 			/// <summary>
 			/// The HIND format file header, each hindsight debug file should start with this struct.
 			/// </summary>
@@ -41,7 +97,14 @@
 				uint64_t	WorkingDirectoryLength;
 				uint64_t	Arguments;
 				time_t		StartTime;
-				uint32_t	Crc32; /* calculate afterwards, for sanity */
+				uint32_t	Flags = FileFlagNone; /* the checksum of the file in a FileFormatHeaderChecksum file */
+
+				/// <summary>
+				/// Determine the size of the header in a file, which depends on the version that wrote it.
+				/// </summary>
+				/// <param name="version">The <see cref="Version"/> of the file.</param>
+				/// <returns>The number of bytes of the header in the file.</returns>
+				static size_t SizeOf(uint32_t version);
 			};
 
 			/// <summary>
@@ -135,7 +198,7 @@
 			/// Create process event, followed by the path of the created processs
 			/// </summary>
 			struct CreateProcessEventEntry : public EventEntry {
-				uint64_t	PathLength		= 0;
+				uint64_t	PathLength		= 0; /* the length of the path that follows, or with FileFlagInternedPaths its reference in the string table */
 				uint64_t	ModuleBase		= 0;
 				uint64_t	ModuleSize		= 0;
 
@@ -223,7 +286,7 @@
 				int64_t		ModuleIndex = 0;
 				uint64_t	ModuleBase = 0;
 				uint64_t	ModuleSize = 0;
-				uint64_t	ModulePathSize = 0;
+				uint64_t	ModulePathSize = 0; /* the length of the path that follows, or with FileFlagInternedPaths its reference in the string table */
 
 				/// <summary>
 				/// Default constructor, generally used when reading an existing binary log file.
@@ -347,6 +410,105 @@
 				StackTrace(uint64_t recursion, uint64_t instructions, uint64_t entries);
 			};
 
+			/// <summary>
+			/// The header of a compact stack trace, which is written instead of a <see cref="StackTrace"/> when the writer is in compact 
+			/// mode. It is followed by <see cref="Size"/> bytes encoded by a <see cref="CompactEncoder"/>, so that the trace can be 
+			/// read in one go and decoded from memory.
+			/// </summary>
+			struct CompactStackTrace {
+				char		Signature[4]	= { 'S', 'T', 'K', '2' };
+				uint32_t	Size			= 0;
+
+				/// <summary>
+				/// Default constructor, generally used when reading an existing binary log file.
+				/// </summary>
+				CompactStackTrace();
+
+				/// <summary>
+				/// Construct a CompactStackTrace header.
+				/// </summary>
+				/// <param name="size">The number of encoded bytes that follow the header.</param>
+				CompactStackTrace(uint32_t size);
+			};
+
+			/// <summary>
+			/// Defines <see cref="Count"/> strings of the string table of the file, with the references <see cref="First"/> and up. It is 
+			/// followed by <see cref="Size"/> bytes with each string encoded by <see cref="CompactEncoder::Raw"/>.
+			/// </summary>
+			struct StringTableEntry {
+				char		Signature[4]	= { 'S', 'T', 'R', 'S' };
+				uint64_t	First			= 0;
+				uint32_t	Count			= 0;
+				uint32_t	Size			= 0;
+
+				/// <summary>
+				/// Default constructor, generally used when reading an existing binary log file.
+				/// </summary>
+				StringTableEntry();
+
+				/// <summary>
+				/// Construct a StringTableEntry header.
+				/// </summary>
+				/// <param name="first">The reference of the first string that is defined.</param>
+				/// <param name="count">The number of strings that are defined.</param>
+				/// <param name="size">The number of encoded bytes that follow the header.</param>
+				StringTableEntry(uint64_t first, uint32_t count, uint32_t size);
+			};
+
+			/// <summary>
+			/// The identity of a module, see <see cref="::Hindsight::Debugger::ModuleIdentity"/>, followed by the PDB path. It follows the 
+			/// path of a create process or DLL load event entry.
+			/// </summary>
+			struct ModuleIdentityEntry {
+				char		Signature[4]	= { 'M', 'O', 'D', 'I' };
+				uint16_t	Machine			= 0;
+				uint32_t	TimeDateStamp	= 0;
+				uint32_t	SizeOfImage		= 0;
+				uint8_t		HasPdb			= 0;
+				uint8_t		PdbGuid[16]		= {};
+				uint32_t	PdbAge			= 0;
+				uint64_t	PdbPathLength	= 0;
+
+				/// <summary>
+				/// Default constructor, generally used when reading an existing binary log file.
+				/// </summary>
+				ModuleIdentityEntry();
+
+				/// <summary>
+				/// Construct a ModuleIdentityEntry from the identity of a loaded module.
+				/// </summary>
+				/// <param name="identity">The identity of the module.</param>
+				ModuleIdentityEntry(const Hindsight::Debugger::ModuleIdentity& identity);
+
+				/// <summary>
+				/// Convert this entry back to a <see cref="::Hindsight::Debugger::ModuleIdentity"/>, without the PDB path that follows it.
+				/// </summary>
+				/// <returns>A newly created <see cref="::Hindsight::Debugger::ModuleIdentity"/>.</returns>
+				explicit operator Hindsight::Debugger::ModuleIdentity() const;
+			};
+
+			/// <summary>
+			/// The snapshot of the stack of the thread that caused an exception event, followed by <see cref="Size"/> bytes of memory. It 
+			/// follows the stack trace of the event.
+			/// </summary>
+			struct StackMemoryEntry {
+				char		Signature[4]	= { 'S', 'T', 'K', 'M' };
+				uint64_t	Address			= 0; /* the address of the first byte, the stack pointer at the time of the exception */
+				uint64_t	Size			= 0; /* the number of bytes that follow the entry */
+
+				/// <summary>
+				/// Default constructor, generally used when reading an existing binary log file.
+				/// </summary>
+				StackMemoryEntry();
+
+				/// <summary>
+				/// Construct a StackMemoryEntry.
+				/// </summary>
+				/// <param name="address">The address of the first byte of the snapshot.</param>
+				/// <param name="size">The number of bytes in the snapshot.</param>
+				StackMemoryEntry(uint64_t address, uint64_t size);
+			};
+
 			/// <summary>
 			/// A stack trace entry, followed by the symbol name, path and decoded instructions.
 			/// </summary>
@@ -367,6 +529,112 @@
 				uint64_t	InstructionCount;
 			};
 
+			/// <summary>
+			/// A checkpoint between event entries, see the file structure above.
+			/// </summary>
+			struct CheckpointEntry {
+				char		Signature[4]	= { 'C', 'H', 'K', 'P' };
+				uint64_t	Events			= 0; /* the number of event entries before the checkpoint */
+				uint32_t	Crc32			= 0; /* the checksum of all data after the file header up to the checkpoint */
+
+				/// <summary>
+				/// Default constructor, generally used when reading an existing binary log file.
+				/// </summary>
+				CheckpointEntry();
+
+				/// <summary>
+				/// Construct a CheckpointEntry.
+				/// </summary>
+				/// <param name="events">The number of event entries before the checkpoint.</param>
+				/// <param name="crc32">The checksum of all data after the file header up to the checkpoint.</param>
+				CheckpointEntry(uint64_t events, uint32_t crc32);
+			};
+
+			/// <summary>
+			/// Flags describing an <see cref="IndexEntry"/> in more detail, so that an event can be selected without reading its frame.
+			/// </summary>
+			enum IndexEntryFlags : uint8_t {
+				IndexFlagNone		 = 0,
+				IndexFlagBreakpoint	 = 1, /* the exception event is a breakpoint */
+				IndexFlagFirstChance = 2, /* the exception event is a first chance exception */
+				IndexFlagStrings	 = 4  /* the entry refers to a StringTableEntry rather than an event, its EventId is 0 */
+			};
+
+			/// <summary>
+			/// The header of the optional index at the end of the file, followed by <see cref="Count"/> instances of <see cref="IndexEntry"/>.
+			/// </summary>
+			struct IndexHeader {
+				char		Signature[4]	= { 'I', 'N', 'D', 'X' };
+				uint64_t	Count			= 0;
+			};
+
+			/// <summary>
+			/// Describes a single <see cref="EventEntry"/> (or <see cref="StringTableEntry"/>) in the file, which allows for seeking to an event directly.
+			/// </summary>
+			struct IndexEntry {
+				uint64_t	Offset		= 0; /* the absolute offset of the EventEntry in the file */
+				time_t		Time		= 0;
+				uint32_t	EventId		= 0;
+				uint32_t	ThreadId	= 0;
+				uint8_t		Flags		= IndexFlagNone;
+			};
+
+			/// <summary>
+			/// The footer of the optional index, which is always the last data in the file.
+			/// </summary>
+			struct IndexFooter {
+				uint64_t	IndexOffset		= 0; /* the absolute offset of the IndexHeader in the file */
+				char		Signature[4]	= { 'I', 'N', 'D', 'X' };
+			};
+
+			/// <summary>
+			/// The footer of a completed binary log file, which is always the last data in the file and is not part of the checksum itself.
+			/// </summary>
+			struct FileFooter {
+				uint64_t	Events			= 0; /* the number of event entries in the file */
+				uint32_t	Crc32			= 0; /* the checksum of all data after the file header up to the footer */
+				char		Signature[4]	= { 'H', 'E', 'N', 'D' };
+
+				/// <summary>
+				/// Default constructor, generally used when reading an existing binary log file.
+				/// </summary>
+				FileFooter();
+
+				/// <summary>
+				/// Construct a FileFooter.
+				/// </summary>
+				/// <param name="events">The number of event entries in the file.</param>
+				/// <param name="crc32">The checksum of all data after the file header up to the footer.</param>
+				FileFooter(uint64_t events, uint32_t crc32);
+			};
+
+			/// <summary>
+			/// The header of a compressed binary log file, see the compressed file structure above.
+			/// </summary>
+			struct CompressedFileHeader {
+				char		Signature[4]	= { 'H', 'I', 'N', 'Z' };
+				uint32_t	MaxBlockSize	= 0; /* the maximum decompressed size of a block */
+			};
+
+			/// <summary>
+			/// Describes how the data of a block is stored.
+			/// </summary>
+			enum BlockMethod : uint8_t {
+				BlockStored	= 0, /* the data is stored as-is, because it did not compress */
+				BlockLz		= 1  /* the data is compressed with Hindsight::Utilities::Lz */
+			};
+
+			/// <summary>
+			/// The header of an independently compressed block in a compressed binary log file.
+			/// </summary>
+			struct BlockHeader {
+				char		Signature[4]	= { 'B', 'L', 'C', 'K' };
+				uint32_t	RawSize			= 0;
+				uint32_t	StoredSize		= 0;
+				uint32_t	Crc32			= 0; /* the checksum of the StoredSize bytes that follow */
+				uint8_t		Method			= BlockStored;
+			};
+
 			/// <summary>
 			/// A decoded instruction at the location of a stack trace entry, effectively displaying
 			/// the instructions at the address of the program counter at that point in the stack trace.
@@ -409,6 +677,198 @@
 			struct StackTraceConcrete : public StackTrace {
 				std::vector<StackTraceEntryConcrete> Entries;
 			};
+
+			/// <summary>
+			/// Encodes the data of a <see cref="CompactStackTrace"/>. Integers are written as LEB128 varints, signed integers are zigzag 
+			/// encoded first. Interned strings are written as a reference into the string table of the file: 0 is the empty string and 
+			/// 1 to n refer to the strings in order of definition. The table outlives <see cref="Clear"/>, the strings it gained since the 
+			/// last call to <see cref="ClearPending"/> must be written (in a <see cref="StringTableEntry"/>) before the data that refers to them.
+			/// </summary>
+			class CompactEncoder {
+				private:
+					std::vector<char>							m_Data;		/* The encoded data */
+					std::unordered_map<std::string, uint64_t>	m_Strings;	/* The reference of each string in the table */
+					std::vector<std::string>					m_Pending;	/* The strings that were added to the table but not yet written */
+
+				public:
+					/// <summary>
+					/// Write an unsigned integer.
+					/// </summary>
+					/// <param name="value">The value to write.</param>
+					void Unsigned(uint64_t value);
+
+					/// <summary>
+					/// Write a signed integer.
+					/// </summary>
+					/// <param name="value">The value to write.</param>
+					void Signed(int64_t value);
+
+					/// <summary>
+					/// Write an address relative to <paramref name="origin"/>, which is small when both are in the same module. An address of 
+					/// 0 (unknown) is written as 0, so that it does not cost a full varint.
+					/// </summary>
+					/// <param name="value">The address to write.</param>
+					/// <param name="origin">The address that <paramref name="value"/> is relative to.</param>
+					void Relative(uint64_t value, uint64_t origin);
+
+					/// <summary>
+					/// Write a block of bytes preceeded by its length, without interning it.
+					/// </summary>
+					/// <param name="data">A pointer to <paramref name="size"/> bytes of memory to write.</param>
+					/// <param name="size">The number of bytes to write.</param>
+					void Raw(const char* data, size_t size);
+
+					/// <summary>
+					/// Get the reference of a string in the string table, adding it to the table (and to the pending strings) when it is new.
+					/// </summary>
+					/// <param name="s">The string.</param>
+					/// <returns>The reference of the string, 0 for the empty string.</returns>
+					uint64_t Intern(const std::string& s);
+
+					/// <summary>
+					/// Get the reference of a unicode string in the string table, its UTF-16 bytes are interned as they are.
+					/// </summary>
+					/// <param name="s">The string.</param>
+					/// <returns>The reference of the string, 0 for the empty string.</returns>
+					uint64_t Intern(const std::wstring& s);
+
+					/// <summary>
+					/// Write a string through the string table.
+					/// </summary>
+					/// <param name="s">The string to write.</param>
+					void Interned(const std::string& s);
+
+					/// <summary>
+					/// Write a unicode string through the string table, its UTF-16 bytes are interned as they are.
+					/// </summary>
+					/// <param name="s">The string to write.</param>
+					void Interned(const std::wstring& s);
+
+					/// <summary>
+					/// Get the data encoded since the last call to <see cref="Clear"/>.
+					/// </summary>
+					/// <returns>A const reference to the encoded data.</returns>
+					const std::vector<char>& data() const noexcept;
+
+					/// <summary>
+					/// Remove all encoded data, the string table and the allocated memory are kept for the next trace.
+					/// </summary>
+					void Clear() noexcept;
+
+					/// <summary>
+					/// Get the strings that were added to the table since the last call to <see cref="ClearPending"/>.
+					/// </summary>
+					/// <returns>A const reference to the strings, in order of definition.</returns>
+					const std::vector<std::string>& Pending() const noexcept;
+
+					/// <summary>
+					/// Get the reference of the first pending string.
+					/// </summary>
+					/// <returns>The reference of the first string in <see cref="Pending"/>.</returns>
+					uint64_t FirstPending() const noexcept;
+
+					/// <summary>
+					/// Mark the pending strings as written.
+					/// </summary>
+					void ClearPending() noexcept;
+			};
+
+			/// <summary>
+			/// Decodes the data written by a <see cref="CompactEncoder"/>.
+			/// </summary>
+			class CompactDecoder {
+				private:
+					const char*							m_Cursor;	/* The next byte to decode */
+					const char*							m_End;		/* The end of the data */
+					std::vector<std::string>&			m_Strings;		/* The string table, in order of definition */
+					bool								m_Definitions;	/* True when the data defines new strings in place */
+
+				public:
+					/// <summary>
+					/// Construct a decoder for <paramref name="size"/> bytes at <paramref name="data"/>, the data and the string table must 
+					/// outlive the decoder.
+					/// </summary>
+					/// <param name="data">A pointer to the encoded data.</param>
+					/// <param name="size">The number of encoded bytes.</param>
+					/// <param name="strings">The string table of the file, as read so far.</param>
+					/// <param name="definitions">
+					///		When true, a reference one past the end of <paramref name="strings"/> defines the next string in place, followed by its 
+					///		length and bytes. This is how the STK2 traces of a <see cref="FileFormatTraceStrings"/> file each carry their own table.
+					/// </param>
+					CompactDecoder(const char* data, size_t size, std::vector<std::string>& strings, bool definitions = false);
+
+					/// <summary>
+					/// Read an unsigned integer.
+					/// </summary>
+					/// <returns>The value.</returns>
+					/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or the varint is too long.</exception>
+					uint64_t Unsigned();
+
+					/// <summary>
+					/// Read a signed integer.
+					/// </summary>
+					/// <returns>The value.</returns>
+					/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or the varint is too long.</exception>
+					int64_t Signed();
+
+					/// <summary>
+					/// Read an address relative to <paramref name="origin"/>.
+					/// </summary>
+					/// <param name="origin">The address that the value is relative to.</param>
+					/// <returns>The address, or 0 when it was unknown.</returns>
+					/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or the varint is too long.</exception>
+					uint64_t Relative(uint64_t origin);
+
+					/// <summary>
+					/// Read a block of bytes preceeded by its length.
+					/// </summary>
+					/// <param name="result">A reference to the string that receives the bytes.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly.</exception>
+					void Raw(std::string& result);
+
+					/// <summary>
+					/// Read a string through the string table.
+					/// </summary>
+					/// <param name="result">A reference to the string that receives the value.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or refers to an undefined string.</exception>
+					void Interned(std::string& result);
+
+					/// <summary>
+					/// Read a unicode string through the string table.
+					/// </summary>
+					/// <param name="result">A reference to the string that receives the value.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the data ends unexpectedly or refers to an undefined string.</exception>
+					void Interned(std::wstring& result);
+
+					/// <summary>
+					/// Determines if all data has been decoded.
+					/// </summary>
+					/// <returns>true when there is no data left.</returns>
+					bool Done() const noexcept;
+
+					/// <summary>
+					/// Look up a string in the string table.
+					/// </summary>
+					/// <param name="reference">The reference of the string, 0 for the empty string.</param>
+					/// <param name="result">A reference to the string that receives the value.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the reference refers to an undefined string.</exception>
+					void Lookup(uint64_t reference, std::string& result) const;
+
+					/// <summary>
+					/// Look up a unicode string in the string table.
+					/// </summary>
+					/// <param name="reference">The reference of the string, 0 for the empty string.</param>
+					/// <param name="result">A reference to the string that receives the value.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the reference refers to an undefined string.</exception>
+					void Lookup(uint64_t reference, std::wstring& result) const;
+
+				private:
+					/// <summary>
+					/// Look up (or with definitions, define) the interned string that is referenced next.
+					/// </summary>
+					/// <returns>A const reference to the string in the table, or to an empty string.</returns>
+					const std::string& Reference();
+			};
 		}
 	}
 
@@ -1,18 +1,28 @@
 #include "BinaryLogPlayer.hpp"
 #include "Debugger.hpp"
 #include "Error.hpp"
+#include "String.hpp"
 #include "Version.hpp"
 #include "crc32.hpp"
 
-#include <filesystem>
 #include <iostream>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
 #include <conio.h>
 
 using namespace Hindsight::Debugger::EventHandler;
 using namespace Hindsight::Debugger;
 using namespace Hindsight::BinaryLog;
 
-namespace fs = std::filesystem;
+/// <summary>
+/// Get the lock that serializes the use of DbgHelp, which is not thread-safe, between players that replay in parallel.
+/// </summary>
+/// <returns>The lock.</returns>
+static std::mutex& symbol_engine_lock() {
+	static std::mutex lock;
+	return lock;
+}
 
 /// <summary>
 /// Construct a BinaryLogPlayer instance from a path pointing to a HIND file, and a <see cref="Hindsight::State"/> instance 
@@ -25,50 +35,118 @@ BinaryLogPlayer::BinaryLogPlayer(const std::string& path, const Cli::HindsightCl
 	: m_State(state), m_SubState(state[state.get_chosen_subcommand_name()]),
 	  m_ShouldFilter(!m_SubState.get<std::vector<std::string>>(Cli::Descriptors::NAME_FILTER).empty()),
 	  m_Filter(m_SubState.get<std::vector<std::string>>(Cli::Descriptors::NAME_FILTER).begin(), m_SubState.get<std::vector<std::string>>(Cli::Descriptors::NAME_FILTER).end()),
-	  m_Crc32(0) {
+	  m_Complete(false),
+	  m_DataEnd(0),
+	  m_Crc32(0),
+	  m_Format(0),
+	  m_Indexed(m_SubState.anyset({ Cli::Descriptors::NAME_LASTEXCEPTION, Cli::Descriptors::NAME_WINDOWSTART, Cli::Descriptors::NAME_WINDOWEND })),
+	  m_SinglePass(m_SubState.isset(Cli::Descriptors::NAME_SINGLEPASS) && !m_SubState.isset(Cli::Descriptors::NAME_NOSANITY) && !m_SubState.isset(Cli::Descriptors::NAME_RECOVER) && !m_Indexed),
+	  m_Verified(false),
+	  m_Recover(m_SubState.isset(Cli::Descriptors::NAME_RECOVER)),
+	  m_Intact(true),
+	  m_Events(0),
+	  m_VerifiedEvents(0),
+	  m_EventsEnd(0),
+	  m_Emitting(true) {
+
+	// prefer mapping the file into memory, but fall back to a regular stream when that is not possible or not desired
+	if (!m_SubState.isset(Cli::Descriptors::NAME_NOMMAP)) {
+		try {
+			m_Source = std::make_unique<MappedBinaryLogSource>(path);
+		} catch (const std::runtime_error&) {
+			m_Source = nullptr;
+		}
+	}
+
+	if (!m_Source)
+		m_Source = std::make_unique<StreamBinaryLogSource>(path);
 
-	m_Stream.open(path, std::ios::in | std::ios::binary);
-	if (!m_Stream.is_open())
-		throw std::runtime_error("cannot open file for reading: " + path);
-	m_StreamSize = static_cast<size_t>(fs::file_size(path));
+	// compressed files are decompressed block by block behind the same interface
+	if (CompressedBinaryLogSource::IsCompressed(*m_Source))
+		m_Source = std::make_unique<CompressedBinaryLogSource>(std::move(m_Source));
 
-	Read(reinterpret_cast<char*>(&m_Header), sizeof(FileHeader), false);
+	m_DataEnd = m_Source->Size();
+	// the size of the header depends on the version that wrote it, so the version is read first
+	auto header = reinterpret_cast<char*>(&m_Header);
+	Read(header, offsetof(FileHeader, ProcessId), false);
+	Read(header + offsetof(FileHeader, ProcessId), FileHeader::SizeOf(m_Header.Version) - offsetof(FileHeader, ProcessId), false);
 
 	uint32_t fileVersion     = m_Header.Version >> 16;
 	uint8_t  fileMajor       = fileVersion >> 8;
-	uint8_t  fileMinor       = fileVersion & 0xf;
+	uint8_t  fileMinor       = fileVersion & 0xff;
 	uint32_t requiredVersion = hindsight_version_int >> 16;
 	uint8_t  requiredMajor   = requiredVersion >> 8;
-	uint8_t  requiredMinor   = requiredVersion & 0xf;
+	uint8_t  requiredMinor   = requiredVersion & 0xff;
+	auto     fileName        = std::to_string(fileMajor) + "." + std::to_string(fileMinor);
+	auto     requiredName    = std::to_string(requiredMajor) + "." + std::to_string(requiredMinor);
 
-	if (fileVersion != requiredVersion)
-		throw std::runtime_error("cannot open file, the version used to generate this log differs from the used version. Hindsight " + std::to_string(fileMajor) + "." + std::to_string(fileMinor) + " is required and you are using " + std::to_string(requiredMajor) + "." + std::to_string(requiredMinor) + ".");
+	// a newer log may contain frames this version does not know, a log from before 0.6 stores its events differently
+	if (fileVersion > requiredVersion)
+		throw std::runtime_error("cannot open file, this log was written by hindsight " + fileName + ", which is newer than this hindsight " + requiredName + ". Replay it with hindsight " + fileName + " or later.");
+
+	if (fileVersion < FileFormatHeaderChecksum)
+		throw std::runtime_error("cannot open file, this log was written by hindsight " + fileName + " and hindsight " + requiredName + " cannot read it. Replay it with hindsight " + fileName + ".");
+
+	m_Format = fileVersion;
+
+	if (m_Format == FileFormatHeaderChecksum) {
+		// a 0.6 log has its checksum in the header and no frames after the events, it is verified and played as a completed file with that checksum
+		m_Footer.Crc32 = m_Header.Flags;
+		m_Header.Flags = FileFlagNone;
+		m_Complete	   = true;
+		m_EventsEnd	   = Size();
+	} else {
+		// locate the footer and the index before it at the end of the file, if the file was completed
+		ReadFooter();
+		ReadIndex();
+	}
+	if (m_Indexed && m_Index.empty())
+		throw std::runtime_error("cannot select events, this binary log file has no index. Replay it without --last-exception, --window-start and --window-end.");
 
-	if (!m_SubState.isset(Cli::Descriptors::NAME_NOSANITY))
+	if (m_Recover && m_Indexed)
+		throw std::runtime_error("cannot select events while recovering, replay the file with --recover only.");
+
+	// in single pass and recovery mode the checksum is verified while playing, indexed play cannot read all data in one pass
+	if (!m_SubState.isset(Cli::Descriptors::NAME_NOSANITY) && !m_SinglePass && !m_Recover)
 		CheckSanity();
+
+	// raw frames are resolved through a session of our own, DbgHelp only needs a unique value to tell the sessions apart
+	if (m_SubState.exists(Cli::Descriptors::NAME_SYMBOLIZE) && m_SubState.isset(Cli::Descriptors::NAME_SYMBOLIZE)) {
+		std::string symbolPath = "";
+		if (m_SubState.isset(Cli::Descriptors::NAME_SYMBOLPATH))
+			symbolPath = m_SubState.get<std::string>(Cli::Descriptors::NAME_SYMBOLPATH);
+
+		// frames that were resolved by an earlier replay of the same build are served from the shared cache file
+		std::shared_ptr<PersistentSymbolCache> cache;
+		if (m_SubState.isset(Cli::Descriptors::NAME_SYMBOLCACHE))
+			cache = std::make_shared<PersistentSymbolCache>(m_SubState.get<std::string>(Cli::Descriptors::NAME_SYMBOLCACHE));
+
+		std::lock_guard<std::mutex> lock(symbol_engine_lock());
+		m_Symbols	 = std::make_unique<SymbolSession>(reinterpret_cast<HANDLE>(this), symbolPath);
+		m_Symbolizer = std::make_unique<OfflineSymbolizer>(cache);
+	}
 }
 
 /// <summary>
-/// Walks the binary log file and verifies that all data matches the <see cref="Hindsight::BinaryLog::FileHeader::Crc32"/>.
+/// Clean up the symbol session, if any.
 /// </summary>
-/// <exception cref="std::runtime_error">This exception is thrown when the data in the file does not result in the <see cref="Hindsight::BinaryLog::FileHeader::Crc32"/> checksum.</exception>
-void BinaryLogPlayer::CheckSanity() {
-	char buf[ChecksumBufferSize] = { 0 };
-	auto pos   = m_Stream.tellg();
-	auto left  = m_StreamSize - pos;
-	auto size  = ChecksumBufferSize;
-	auto check = m_Crc32;
+BinaryLogPlayer::~BinaryLogPlayer() {
+	std::lock_guard<std::mutex> lock(symbol_engine_lock());
+	m_Symbolizer.reset();
+	m_Symbols.reset();
+}
 
-	while (left > 0) {
-		if (left < size) size = left;
-		m_Stream.read(buf, size);
-		check = Hindsight::Checksum::Crc32::Update(buf, size, check);
-		left -= size;
-	}
+/// <summary>
+/// Walks the binary log file and verifies that all data matches the <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/>.
+/// </summary>
+/// <exception cref="std::runtime_error">This exception is thrown when the file has no footer or the data in the file does not result in the <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/> checksum.</exception>
+void BinaryLogPlayer::CheckSanity() {
+	auto pos   = m_Source->Pos();
+	auto check = Checksum(Size() - pos, m_Crc32);
 
-	m_Stream.seekg(pos, std::ios::beg);
-	if (check != m_Header.Crc32)
-		throw std::runtime_error("file has been damaged, never finished writing or was appended to. Use --no-sanity-check to ignore this check.");
+	m_Source->Seek(pos);
+	if (!m_Complete || check != m_Footer.Crc32)
+		throw std::runtime_error("file has been damaged, never finished writing or was appended to. Use --recover to replay the intact part, or --no-sanity-check to ignore this check.");
 }
 
 /// <summary>
@@ -80,10 +158,29 @@ void BinaryLogPlayer::AddHandler(std::shared_ptr<EventHandler::IDebuggerEventHan
 }
 
 /// <summary>
-/// Play the binary log file and simulate the debug events that were stored in it.
+/// Determines if all data in the file could be verified. This is only false after playing in recovery mode, when the file never 
+/// finished writing or was damaged.
+/// </summary>
+/// <returns>true when no data had to be dropped.</returns>
+bool BinaryLogPlayer::Intact() const noexcept {
+	return m_Intact;
+}
+
+/// <summary>
+/// Determines the number of events that were verified and emitted in recovery mode.
+/// </summary>
+/// <returns>The number of recovered events.</returns>
+uint64_t BinaryLogPlayer::VerifiedEvents() const noexcept {
+	return m_VerifiedEvents;
+}
+
+/// <summary>
+/// Play the binary log file and simulate the debug events that were stored in it. When the player was constructed for a single pass, 
+/// the checksum is verified while reading and the events are only emitted after the data up to them has been verified, see 
+/// <see cref="Hindsight::BinaryLog::BinaryLogPlayer::Dispatch"/>.
 /// </summary>
 /// <exception cref="std::runtime_error">
-///	This exception is thrown when the checksum of all data read does not match the stored <see cref="Hindsight::BinaryLog::FileHeader::Crc32"/> 
+///	This exception is thrown when the checksum of all data read does not match the stored <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/> 
 /// checksum in the file. This exception can also be thrown when an unexpected frame type is encountered in the file, or when an unexpected end 
 /// is encountered in the file. 
 /// </exception>
@@ -101,42 +198,144 @@ void BinaryLogPlayer::Play() {
 
 	auto process = std::make_shared<Hindsight::Process::Process>(pi, path, workingDirectory, arguments);
 
-	for (auto handler : m_Handlers)
-		handler->OnInitialization(m_Header.StartTime, process);
+	Dispatch([this, process]() {
+		for (auto handler : m_Handlers)
+			handler->OnInitialization(m_Header.StartTime, process);
+	});
+
+	if (m_Indexed) {
+		PlayIndexed(); // only visit the events that are needed
+	} else if (m_Recover) {
+		PlayRecover(); // only emit the events that can be verified
+	} else {
+		while (Next()); // iterate over all events
+
+		// the remainder of the file, which is the index if there is one, is part of the checksum as well
+		m_Crc32 = Checksum(SizeLeft(), m_Crc32);
+	}
+
+	if (m_SinglePass) {
+		// the events after the last checkpoint have not been emitted yet, verify all data before invoking them
+		if (!m_Complete || m_Footer.Crc32 != m_Crc32)
+			throw std::runtime_error("file has been damaged, never finished writing or was appended to. Use --no-sanity-check to ignore this check.");
 
-	while (Next()); // iterate over all events
+		for (auto& action : m_Deferred)
+			action();
+
+		m_Deferred.clear();
+	}
 
 	auto time = std::time(nullptr);
 	for (auto handler : m_Handlers)
 		handler->OnModuleCollectionComplete(time, m_Modules);
 
-	if (m_Header.Crc32 != m_Crc32)
+	// indexed play skips data, the checksum can only be verified by CheckSanity in that case
+	if (!m_Indexed && !m_Recover && (!m_Complete || m_Footer.Crc32 != m_Crc32))
 		throw std::runtime_error("not all data that was originally written has been read.");
 }
 
+/// <summary>
+/// Play a file that may never have finished writing, or that was damaged. Events are held back until a checkpoint after them 
+/// has been verified, and are only emitted then. When the end of the file is reached and the complete file matches the footer 
+/// checksum, all events are emitted. Otherwise reading stops at the first damaged frame and the events after the last intact 
+/// checkpoint are dropped.
+/// </summary>
+void BinaryLogPlayer::PlayRecover() {
+	try {
+		while (Next());
+		m_Crc32 = Checksum(SizeLeft(), m_Crc32);
+	} catch (const std::runtime_error&) {
+		m_Intact = false;
+	}
+
+	if (m_Intact && m_Complete && m_Footer.Crc32 == m_Crc32) {
+		for (auto& action : m_Deferred)
+			action();
+
+		m_VerifiedEvents = m_Events;
+	} else {
+		m_Intact = false;
+	}
+
+	m_Deferred.clear();
+}
+
+/// <summary>
+/// Play only the events selected by the --last-exception, --window-start and --window-end options by seeking to them through the index. 
+/// Events that load or unload modules are always read, so that the module collection is correct for each selected event, but they are 
+/// only emitted when they are selected themselves.
+/// </summary>
+/// <exception cref="std::runtime_error">This exception is thrown when the index refers to data outside of the event frames.</exception>
+void BinaryLogPlayer::PlayIndexed() {
+	auto start       = m_Header.StartTime;
+	auto windowStart = m_SubState.get_isset<size_t>(Cli::Descriptors::NAME_WINDOWSTART);
+	auto windowEnd   = m_SubState.get_isset<size_t>(Cli::Descriptors::NAME_WINDOWEND);
+	auto onlyLast    = m_SubState.isset(Cli::Descriptors::NAME_LASTEXCEPTION);
+	auto last        = m_Index.size();
+
+	// find the last exception that is not a breakpoint
+	if (onlyLast) {
+		for (auto i = m_Index.size(); i-- > 0;) {
+			if (m_Index[i].EventId == EXCEPTION_DEBUG_EVENT && !(m_Index[i].Flags & IndexFlagBreakpoint)) {
+				last = i;
+				break;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < m_Index.size(); ++i) {
+		const auto& entry = m_Index[i];
+
+		auto selected = (!onlyLast || i == last) &&
+			(!windowStart || entry.Time >= start + static_cast<time_t>(*windowStart)) &&
+			(!windowEnd || entry.Time <= start + static_cast<time_t>(*windowEnd));
+
+		auto modules = entry.EventId == CREATE_PROCESS_DEBUG_EVENT || entry.EventId == LOAD_DLL_DEBUG_EVENT || entry.EventId == UNLOAD_DLL_DEBUG_EVENT;
+		auto strings = (entry.Flags & IndexFlagStrings) != 0;
+
+		if (!selected && !modules && !strings)
+			continue;
+
+		if (entry.Offset < FileHeader::SizeOf(m_Header.Version) || entry.Offset >= m_EventsEnd)
+			throw std::runtime_error("index entry refers to data outside of the event frames, binary log file damaged");
+
+		m_Source->Seek(static_cast<size_t>(entry.Offset));
+		m_Emitting = selected;
+		Next();
+	}
+
+	m_Emitting = true;
+}
+
 /// <summary>
 /// Read and process the next <see cref="Hindsight::BinaryLog::EventEntry"/> and emit it as event to the added event handlers.
 /// </summary>
 /// <seealso cref="Hindsight::BinaryLog::BinaryLogPlayer::AddHandler"/>
 /// <returns>A boolean indicating to <see cref="Hindsight::BinaryLog::BinaryLogPlayer::Play"/> that there is more data to be read and played.</returns>
 bool BinaryLogPlayer::Next() {
-	// no more data, stop reading
-	if (SizeLeft() < 4)
+	// no more event frames, stop reading
+	if (Pos() + 4 > m_EventsEnd)
 		return false;
 
-	// read the frame signature
-	char signature[4] = { 0 };
-	Read(signature, 4, false);
+	// read and verify the frame signature, checkpoints and string tables can be found between the events
+	EventEntry e;
+	if (!ReadSignature(e.Signature, "EVNT")) {
+		if (!_strnicmp(e.Signature, "STRS", 4)) {
+			ReadStrings();
+			return true;
+		}
 
-	// verify frame signature and seek back
-	if (_strnicmp(signature, "EVNT", 4))
-		throw std::runtime_error("unexpected frame in binary log file, expected event entry.");
-	m_Stream.seekg(-4, std::ios::cur);
+		if (_strnicmp(e.Signature, "CHKP", 4))
+			throw std::runtime_error("unexpected frame in binary log file, expected event entry.");
 
-	// read base frame and seek back, used to determine base event entry type.
-	EventEntry e;
-	Read(reinterpret_cast<char*>(&e), sizeof(EventEntry), false);
-	m_Stream.seekg(-static_cast<std::streamoff>(sizeof(EventEntry)), std::ios::cur);
+		ReadCheckpoint();
+		return true;
+	}
+
+	++m_Events;
+
+	// read the remainder of the base frame, used to determine base event entry type.
+	Read(reinterpret_cast<char*>(&e) + sizeof(e.Signature), sizeof(EventEntry) - sizeof(e.Signature));
 
 	EntryFrame  frame {};
 	DEBUG_EVENT event {};
@@ -148,39 +347,39 @@ bool BinaryLogPlayer::Next() {
 	// read the appripriate event entry type and emit the associated event.
 	switch (e.EventId) {
 		case EXCEPTION_DEBUG_EVENT:
-			Read(frame.ExceptionEntry);
+			ReadFrame(frame.ExceptionEntry, e);
 			EmitException(e.Time, frame.ExceptionEntry, event);
 			break;
 		case CREATE_PROCESS_DEBUG_EVENT:
-			Read(frame.CreateProcessEntry);
+			ReadFrame(frame.CreateProcessEntry, e);
 			EmitCreateProcess(e.Time, frame.CreateProcessEntry, event);
 			break;
 		case CREATE_THREAD_DEBUG_EVENT:
-			Read(frame.CreateThreadEntry);
+			ReadFrame(frame.CreateThreadEntry, e);
 			EmitCreateThread(e.Time, frame.CreateThreadEntry, event);
 			break;
 		case EXIT_PROCESS_DEBUG_EVENT:
-			Read(frame.ExitProcessEntry);
+			ReadFrame(frame.ExitProcessEntry, e);
 			EmitExitProcess(e.Time, frame.ExitProcessEntry, event);
 			break;
 		case EXIT_THREAD_DEBUG_EVENT:
-			Read(frame.ExitThreadEntry);
+			ReadFrame(frame.ExitThreadEntry, e);
 			EmitExitThread(e.Time, frame.ExitThreadEntry, event);
 			break;
 		case LOAD_DLL_DEBUG_EVENT:
-			Read(frame.DllLoadEntry);
+			ReadFrame(frame.DllLoadEntry, e);
 			EmitDllLoad(e.Time, frame.DllLoadEntry, event);
 			break;
 		case OUTPUT_DEBUG_STRING_EVENT:
-			Read(frame.DebugStringEntry);
+			ReadFrame(frame.DebugStringEntry, e);
 			EmitDebugString(e.Time, frame.DebugStringEntry, event);
 			break;
 		case RIP_EVENT:
-			Read(frame.RipEntry);
+			ReadFrame(frame.RipEntry, e);
 			EmitRip(e.Time, frame.RipEntry, event);
 			break;
 		case UNLOAD_DLL_DEBUG_EVENT:
-			Read(frame.DllUnloadEntry);
+			ReadFrame(frame.DllUnloadEntry, e);
 			EmitDllUnload(e.Time, frame.DllUnloadEntry, event);
 			break;
 		default:
@@ -190,6 +389,63 @@ bool BinaryLogPlayer::Next() {
 	return true;
 }
 
+/// <summary>
+/// Read the remainder of a <see cref="Hindsight::BinaryLog::CheckpointEntry"/> after its signature. In recovery mode the checkpoint is 
+/// verified against the checksum of all data read so far, and the events that were held back are emitted.
+/// </summary>
+/// <exception cref="std::runtime_error">This exception is thrown in recovery mode when the checkpoint does not match the data before it.</exception>
+void BinaryLogPlayer::ReadCheckpoint() {
+	CheckpointEntry checkpoint;
+
+	// the checkpoint holds the checksum of the data before it, so it is added to the checksum after comparing
+	Read(reinterpret_cast<char*>(&checkpoint) + sizeof(checkpoint.Signature), sizeof(CheckpointEntry) - sizeof(checkpoint.Signature), false);
+
+	auto intact = checkpoint.Crc32 == m_Crc32 && checkpoint.Events == m_Events;
+	m_Crc32 = Hindsight::Checksum::Crc32::Update(&checkpoint, sizeof(CheckpointEntry), m_Crc32);
+
+	// outside of recovery mode and a single pass the checksum of the complete file is verified instead
+	if (!m_Recover && !m_SinglePass)
+		return;
+
+	if (!intact)
+		throw std::runtime_error("checkpoint does not match the data before it, binary log file damaged");
+
+	for (auto& action : m_Deferred)
+		action();
+
+	m_Deferred.clear();
+	if (m_Recover)
+		m_VerifiedEvents = m_Events;
+}
+
+/// <summary>
+/// Read the remainder of a <see cref="Hindsight::BinaryLog::StringTableEntry"/> after its signature, and add its strings to the string table.
+/// </summary>
+/// <exception cref="std::runtime_error">This exception is thrown when the strings do not follow the string table read so far, or when the frame is damaged.</exception>
+void BinaryLogPlayer::ReadStrings() {
+	StringTableEntry header;
+	std::string buffer;
+
+	Read(reinterpret_cast<char*>(&header) + sizeof(header.Signature), sizeof(StringTableEntry) - sizeof(header.Signature));
+
+	if (header.First != m_Strings.size() + 1 || header.Size > m_EventsEnd - Pos())
+		throw std::runtime_error("string table entry does not follow the strings before it, binary log file damaged");
+
+	auto data = View(header.Size);
+	if (data == nullptr) {
+		buffer.resize(header.Size);
+		Read(&buffer[0], header.Size);
+		data = buffer.data();
+	}
+
+	CompactDecoder decoder(data, header.Size, m_Strings);
+	for (uint32_t i = 0; i < header.Count; ++i)
+		decoder.Raw(m_Strings.emplace_back());
+
+	if (!decoder.Done())
+		throw std::runtime_error("string table entry has trailing data, binary log file damaged");
+}
+
 /// <summary>
 /// Emit an exception debug event to all the exception handlers after reading all metadata (like paths and stack traces).
 /// </summary>
@@ -197,9 +453,7 @@ bool BinaryLogPlayer::Next() {
 /// <param name="frame">The recorded frame of the event, containing relevant information.</param>
 /// <param name="event">The DEBUG_EVENT instance.</param>
 void BinaryLogPlayer::EmitException(time_t time, const ExceptionEventEntry& frame, DEBUG_EVENT& event) {
-	char signature[4] = { 0 };
 	std::shared_ptr<DebugContext> context;
-	std::shared_ptr<DebugStackTrace> trace;
 	std::shared_ptr<CxxExceptions::ExceptionRunTimeTypeInformation> ertti = nullptr;
 	StackTraceConcrete traceConcrete;
 	WOW64_CONTEXT ctx32;
@@ -257,16 +511,92 @@ void BinaryLogPlayer::EmitException(time_t time, const ExceptionEventEntry& fram
 	event.u.Exception.ExceptionRecord.ExceptionAddress	= reinterpret_cast<PVOID>(frame.EventAddress);
 	event.u.Exception.ExceptionRecord.ExceptionCode		= frame.EventCode;
 
-	// read trace 
-	Read(signature, 4, false);
-	if (_strnicmp(signature, "STCK", 4))
+	// read trace, in either encoding
+	ReadStackTrace(traceConcrete);
+	ReadStackMemory(*context);
+
+	// should this event be emitted?
+	if (!ShouldEmit(frame.IsBreakpoint ? "breakpoint" : "exception"))
+		return;
+
+	Dispatch([this, time, frame, exception = event.u.Exception, pi, context, ertti, traceConcrete = std::move(traceConcrete)]() mutable {
+		// normalize the stack trace based on the read data, the strings are moved rather than copied. This 
+		// happens at dispatch time, because the trace resolves its modules through the module collection.
+		if (m_Symbols)
+			Symbolize(traceConcrete);
+
+		auto trace = std::make_shared<DebugStackTrace>(context, m_Modules, std::move(traceConcrete));
+
+		// invoke handlers
+		if (frame.IsBreakpoint) {
+			for (auto handler : m_Handlers)
+				handler->OnBreakpointHit(
+					time,
+					exception,
+					pi,
+					context,
+					trace,
+					m_Modules
+				);
+		} else {
+			std::wstring name = L"";
+			if (Hindsight::Debugger::Debugger::ExceptionNames.count(frame.EventCode))
+				name = Hindsight::Debugger::Debugger::ExceptionNames.at(frame.EventCode);
+
+			for (auto handler : m_Handlers)
+				handler->OnException(
+					time,
+					exception,
+					pi,
+					frame.IsFirstChance,
+					name,
+					context,
+					trace,
+					m_Modules,
+					ertti
+				);
+		}
+
+		// handle breaking, which is not available in every subcommand (such as batch)
+		if (!m_SubState.exists(Cli::Descriptors::NAME_BREAKB))
+			return;
+
+		if (frame.IsBreakpoint) {
+			if (m_SubState.isset(Cli::Descriptors::NAME_BREAKB))
+				HandleBreakpointOptions();
+		} else {
+			if (m_SubState.isset(Cli::Descriptors::NAME_BREAKE) && (!m_SubState.isset(Cli::Descriptors::NAME_BREAKF) || frame.IsFirstChance))
+				HandleBreakpointOptions();
+		}
+	});
+}
+
+/// <summary>
+/// Read a stack trace frame, which is either a <see cref="Hindsight::BinaryLog::StackTrace"/> followed by its fixed size entries, or 
+/// a <see cref="Hindsight::BinaryLog::CompactStackTrace"/>.
+/// </summary>
+/// <param name="traceConcrete">A reference to the <see cref="Hindsight::BinaryLog::StackTraceConcrete"/> that receives the trace.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when no stack trace frame follows or when it is damaged.</exception>
+void BinaryLogPlayer::ReadStackTrace(StackTraceConcrete& traceConcrete) {
+	// the signature determines the encoding, it is only part of the checksum once it is known to be valid
+	Read(traceConcrete.Signature, 4, false);
+
+	if (!_strnicmp(traceConcrete.Signature, "STK2", 4)) {
+		m_Crc32 = Hindsight::Checksum::Crc32::Update(traceConcrete.Signature, 4, m_Crc32);
+		ReadCompactStackTrace(traceConcrete);
+		return;
+	}
+
+	if (_strnicmp(traceConcrete.Signature, "STCK", 4))
 		throw std::runtime_error("stack trace expected, binary log file damaged");
-	m_Stream.seekg(-4, std::ios::cur);
-		
-	// read the trace header in the first part of the StackTraceConcrete instance
-	Read(reinterpret_cast<char*>(&traceConcrete), sizeof(StackTrace));
+
+	m_Crc32 = Hindsight::Checksum::Crc32::Update(traceConcrete.Signature, 4, m_Crc32);
+
+	// read the remainder of the trace header in the first part of the StackTraceConcrete instance
+	Read(reinterpret_cast<char*>(&traceConcrete) + sizeof(traceConcrete.Signature), sizeof(StackTrace) - sizeof(traceConcrete.Signature));
 
 	// process all trace entries
+	traceConcrete.Entries.reserve(static_cast<size_t>(traceConcrete.TraceEntries));
 	for (size_t i = 0; i < traceConcrete.TraceEntries; ++i) {
 		// construct a StackTraceEntryConcrete, to which we can read a StackTraceEntry struct
 		auto& entryConcrete = traceConcrete.Entries.emplace_back();
@@ -277,6 +607,7 @@ void BinaryLogPlayer::EmitException(time_t time, const ExceptionEventEntry& fram
 		Read(entryConcrete.Path, entryConcrete.PathLength);			/* path to source file, if PDBs were found at the time of recording */
 
 		// process all instructions that might have been decoded 
+		entryConcrete.Instructions.reserve(static_cast<size_t>(entryConcrete.InstructionCount));
 		for (size_t j = 0; j < entryConcrete.InstructionCount; ++j) {
 			// construct a StackTraceEntryInstructionConcrete, to which we can read a StackTraceEntryInstruction struct
 			auto& instructionConcrete = entryConcrete.Instructions.emplace_back();
@@ -288,52 +619,87 @@ void BinaryLogPlayer::EmitException(time_t time, const ExceptionEventEntry& fram
 			Read(instructionConcrete.Operands, instructionConcrete.OperandsSize);	/* the instruction operands as one string */
 		}
 	}
+}
 
-	// should this event be emitted?
-	if (m_ShouldFilter && ((frame.IsBreakpoint && !m_Filter.count("breakpoint")) || (!frame.IsBreakpoint && !m_Filter.count("exception"))))
-		return;
+/// <summary>
+/// Read the remainder of a <see cref="Hindsight::BinaryLog::CompactStackTrace"/> frame after its signature, and decode it.
+/// </summary>
+/// <param name="traceConcrete">A reference to the <see cref="Hindsight::BinaryLog::StackTraceConcrete"/> that receives the trace.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the frame is damaged.</exception>
+void BinaryLogPlayer::ReadCompactStackTrace(StackTraceConcrete& traceConcrete) {
+	CompactStackTrace header;
+	std::string buffer;
+
+	Read(reinterpret_cast<char*>(&header) + sizeof(header.Signature), sizeof(CompactStackTrace) - sizeof(header.Signature));
+
+	// decode straight from the mapped bytes when possible
+	auto data = View(header.Size);
+	if (data == nullptr) {
+		buffer.resize(header.Size);
+		Read(&buffer[0], header.Size);
+		data = buffer.data();
+	}
 
-	// normalize the stack trace based on the read data
-	trace = std::make_shared<DebugStackTrace>(context, m_Modules, traceConcrete);
+	// a 0.7 trace defines its strings in place in a table of its own
+	std::vector<std::string> traceStrings;
+	auto perTrace = m_Format == FileFormatTraceStrings;
 
-	// invoke handlers
-	if (frame.IsBreakpoint) {
-		for (auto handler : m_Handlers)
-			handler->OnBreakpointHit(
-				time,
-				event.u.Exception,
-				pi,
-				context,
-				trace,
-				m_Modules
-			);
-	} else {
-		std::wstring name = L"";
-		if (Hindsight::Debugger::Debugger::ExceptionNames.count(frame.EventCode))
-			name = Hindsight::Debugger::Debugger::ExceptionNames[frame.EventCode];
+	CompactDecoder decoder(data, header.Size, perTrace ? traceStrings : m_Strings, perTrace);
 
-		for (auto handler : m_Handlers)
-			handler->OnException(
-				time,
-				event.u.Exception,
-				pi,
-				frame.IsFirstChance,
-				name,
-				context,
-				trace,
-				m_Modules,
-				ertti
-			);
-	}
+	traceConcrete.MaxRecursion	  = decoder.Unsigned();
+	traceConcrete.MaxInstructions = decoder.Unsigned();
+	traceConcrete.TraceEntries	  = decoder.Unsigned();
 
-	// handle breaking
-	if (frame.IsBreakpoint) {
-		if (m_SubState.isset(Cli::Descriptors::NAME_BREAKB))
-			HandleBreakpointOptions();
-	} else {
-		if (m_SubState.isset(Cli::Descriptors::NAME_BREAKE) && (!m_SubState.isset(Cli::Descriptors::NAME_BREAKF) || frame.IsFirstChance))
-			HandleBreakpointOptions();
+	// every entry takes at least a dozen bytes, so a damaged count cannot make us reserve absurd amounts of memory
+	if (traceConcrete.TraceEntries > header.Size)
+		throw std::runtime_error("invalid compact stack trace, binary log file damaged");
+
+	traceConcrete.Entries.reserve(static_cast<size_t>(traceConcrete.TraceEntries));
+	for (size_t i = 0; i < traceConcrete.TraceEntries; ++i) {
+		auto& entryConcrete = traceConcrete.Entries.emplace_back();
+
+		entryConcrete.ModuleIndex		  = decoder.Signed();
+		entryConcrete.ModuleBase		  = decoder.Unsigned();
+		entryConcrete.Address			  = entryConcrete.ModuleBase + static_cast<uint64_t>(decoder.Signed());
+		entryConcrete.AbsoluteAddress	  = decoder.Relative(entryConcrete.Address);
+		entryConcrete.AbsoluteLineAddress = decoder.Relative(entryConcrete.Address);
+		entryConcrete.LineAddress		  = decoder.Relative(entryConcrete.Address);
+
+		decoder.Interned(entryConcrete.Name);
+		decoder.Interned(entryConcrete.Path);
+		entryConcrete.NameSymbolLength	= entryConcrete.Name.size();
+		entryConcrete.PathLength		= entryConcrete.Path.size();
+		entryConcrete.LineNumber		= decoder.Unsigned();
+		entryConcrete.IsRecursion		= static_cast<uint8_t>(decoder.Unsigned());
+		entryConcrete.RecursionCount	= decoder.Unsigned();
+		entryConcrete.InstructionCount	= decoder.Unsigned();
+
+		if (entryConcrete.InstructionCount > header.Size)
+			throw std::runtime_error("invalid compact stack trace, binary log file damaged");
+
+		// instruction offsets are relative to the one before them, starting at the frame address
+		auto previous = entryConcrete.Address;
+		entryConcrete.Instructions.reserve(static_cast<size_t>(entryConcrete.InstructionCount));
+		for (size_t j = 0; j < entryConcrete.InstructionCount; ++j) {
+			auto& instructionConcrete = entryConcrete.Instructions.emplace_back();
+
+			instructionConcrete.Is64BitAddress = static_cast<uint8_t>(decoder.Unsigned());
+			instructionConcrete.Offset		   = previous + static_cast<uint64_t>(decoder.Signed());
+			instructionConcrete.Size		   = decoder.Unsigned();
+
+			decoder.Raw(instructionConcrete.Hex);
+			decoder.Interned(instructionConcrete.Mnemonic);
+			decoder.Interned(instructionConcrete.Operands);
+			instructionConcrete.HexSize		 = instructionConcrete.Hex.size();
+			instructionConcrete.MnemonicSize = instructionConcrete.Mnemonic.size();
+			instructionConcrete.OperandsSize = instructionConcrete.Operands.size();
+
+			previous = instructionConcrete.Offset;
+		}
 	}
+
+	if (!decoder.Done())
+		throw std::runtime_error("invalid compact stack trace, binary log file damaged");
 }
 
 /// <summary>
@@ -344,32 +710,35 @@ void BinaryLogPlayer::EmitException(time_t time, const ExceptionEventEntry& fram
 /// <param name="event">The DEBUG_EVENT instance.</param>
 void BinaryLogPlayer::EmitCreateProcess(time_t time, const CreateProcessEventEntry& frame, DEBUG_EVENT& event) {
 	std::wstring path;
-	Read(path, frame.PathLength); /* read the full path of the created process as a unicode string */
+	ReadPath(path, frame.PathLength); /* read the full path of the created process as a unicode string */
+	auto identity = ReadIdentity();
 
 	// fill the event struct with relevant information for the handlers
 	event.u.CreateProcessInfo.hProcess		= reinterpret_cast<HANDLE>(frame.ProcessInformation.hProcess);
 	event.u.CreateProcessInfo.hThread		= reinterpret_cast<HANDLE>(frame.ProcessInformation.hThread);
 	event.u.CreateProcessInfo.lpBaseOfImage = reinterpret_cast<LPVOID>(frame.ModuleBase);
 
-	// simulate a module load, so that the handlers can resolve addresses to this module
-	m_Modules.Load(path, reinterpret_cast<ModulePointer>(frame.ModuleBase), frame.ModuleSize);
+	Dispatch([this, time, frame, info = event.u.CreateProcessInfo, path = std::move(path), identity, emit = ShouldEmit("create_process")]() {
+		// simulate a module load, so that the handlers can resolve addresses to this module
+		LoadModule(path, reinterpret_cast<ModulePointer>(frame.ModuleBase), static_cast<size_t>(frame.ModuleSize), identity);
 
-	// should this event be emitted?
-	if (m_ShouldFilter && !m_Filter.count("create_process"))
-		return;
+		// should this event be emitted?
+		if (!emit)
+			return;
 
-	// get a PROCESS_INFORMATION struct
-	auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
+		// get a PROCESS_INFORMATION struct
+		auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
 
-	// invoke handlers
-	for (auto handler : m_Handlers)
-		handler->OnCreateProcess(
-			time,
-			event.u.CreateProcessInfo,
-			pi,
-			path,
-			m_Modules
-		);
+		// invoke handlers
+		for (auto handler : m_Handlers)
+			handler->OnCreateProcess(
+				time,
+				info,
+				pi,
+				path,
+				m_Modules
+			);
+	});
 }
 
 /// <summary>
@@ -385,20 +754,22 @@ void BinaryLogPlayer::EmitCreateThread(time_t time, const CreateThreadEventEntry
 	event.u.CreateThread.lpStartAddress = reinterpret_cast<LPTHREAD_START_ROUTINE>(frame.EntryPointAddress);
 
 	// should this event be emitted?
-	if (m_ShouldFilter && !m_Filter.count("create_thread"))
+	if (!ShouldEmit("create_thread"))
 		return;
 
 	// get a PROCESS_INFORMATION struct
 	auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
 
 	// invoke handlers
-	for (auto handler : m_Handlers)
-		handler->OnCreateThread(
-			time,
-			event.u.CreateThread,
-			pi,
-			m_Modules
-		);
+	Dispatch([this, time, info = event.u.CreateThread, pi]() {
+		for (auto handler : m_Handlers)
+			handler->OnCreateThread(
+				time,
+				info,
+				pi,
+				m_Modules
+			);
+	});
 }
 
 /// <summary>
@@ -409,31 +780,34 @@ void BinaryLogPlayer::EmitCreateThread(time_t time, const CreateThreadEventEntry
 /// <param name="event">The DEBUG_EVENT instance.</param>
 void BinaryLogPlayer::EmitDllLoad(time_t time, const DllLoadEventEntry& frame, DEBUG_EVENT& event) {
 	std::wstring path;
-	Read(path, frame.ModulePathSize); /* read the full path of the created process as a unicode string */
+	ReadPath(path, frame.ModulePathSize); /* read the full path of the loaded module as a unicode string */
+	auto identity = ReadIdentity();
 
 	// set the base address of the module that was loaded
 	event.u.LoadDll.lpBaseOfDll = reinterpret_cast<LPVOID>(frame.ModuleBase);
 
-	// simulate a module load, see EmitCreateProcess why
-	m_Modules.Load(path, event.u.LoadDll.lpBaseOfDll, frame.ModuleSize);
+	Dispatch([this, time, frame, info = event.u.LoadDll, path = std::move(path), identity, emit = ShouldEmit("load_dll")]() {
+		// simulate a module load, see EmitCreateProcess why
+		LoadModule(path, info.lpBaseOfDll, static_cast<size_t>(frame.ModuleSize), identity);
 
-	// should this event be emitted?
-	if (m_ShouldFilter && !m_Filter.count("load_dll"))
-		return;
+		// should this event be emitted?
+		if (!emit)
+			return;
 
-	// get a PROCESS_INFORMATION struct
-	auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
+		// get a PROCESS_INFORMATION struct
+		auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
 
-	// invoke handlers
-	for (auto handler : m_Handlers)
-		handler->OnDllLoad(
-			time,
-			event.u.LoadDll,
-			pi,
-			path,
-			m_Modules.GetIndex(path),
-			m_Modules
-		);
+		// invoke handlers
+		for (auto handler : m_Handlers)
+			handler->OnDllLoad(
+				time,
+				info,
+				pi,
+				path,
+				m_Modules.GetIndex(path),
+				m_Modules
+			);
+	});
 }
 
 /// <summary>
@@ -447,20 +821,22 @@ void BinaryLogPlayer::EmitExitProcess(time_t time, const ExitProcessEventEntry&
 	event.u.ExitProcess.dwExitCode = frame.ExitCode;
 
 	// should this event be emitted?
-	if (m_ShouldFilter && !m_Filter.count("exit_process"))
+	if (!ShouldEmit("exit_process"))
 		return;
 
 	// get a PROCESS_INFORMATION struct
 	auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
 
 	// invoke handlers
-	for (auto handler : m_Handlers)
-		handler->OnExitProcess(
-			time,
-			event.u.ExitProcess,
-			pi,
-			m_Modules
-		);
+	Dispatch([this, time, info = event.u.ExitProcess, pi]() {
+		for (auto handler : m_Handlers)
+			handler->OnExitProcess(
+				time,
+				info,
+				pi,
+				m_Modules
+			);
+	});
 }
 
 /// <summary>
@@ -474,20 +850,22 @@ void BinaryLogPlayer::EmitExitThread(time_t time, const ExitThreadEventEntry& fr
 	event.u.ExitProcess.dwExitCode = frame.ExitCode;
 
 	// should this event be emitted?
-	if (m_ShouldFilter && !m_Filter.count("exit_thread"))
+	if (!ShouldEmit("exit_thread"))
 		return;
 
 	// get a PROCESS_INFORMATION struct
 	auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
 
 	// invoke handlers
-	for (auto handler : m_Handlers)
-		handler->OnExitThread(
-			time,
-			event.u.ExitThread,
-			pi,
-			m_Modules
-		);
+	Dispatch([this, time, info = event.u.ExitThread, pi]() {
+		for (auto handler : m_Handlers)
+			handler->OnExitThread(
+				time,
+				info,
+				pi,
+				m_Modules
+			);
+	});
 }
 
 /// <summary>
@@ -509,23 +887,27 @@ void BinaryLogPlayer::EmitDebugString(time_t time, const DebugStringEventEntry&
 		Read(message, frame.Length);
 
 		// should this event be emitted?
-		if (m_ShouldFilter && !m_Filter.count("debug"))
+		if (!ShouldEmit("debug"))
 			return;
 
 		// invoke handlers
-		for (auto handler : m_Handlers)
-			handler->OnDebugStringW(time, event.u.DebugString, pi, message);
+		Dispatch([this, time, info = event.u.DebugString, pi, message = std::move(message)]() {
+			for (auto handler : m_Handlers)
+				handler->OnDebugStringW(time, info, pi, message);
+		});
 	} else { /* regular ANSI */
 		std::string message;
 		Read(message, frame.Length);
 
 		// should this event be emitted?
-		if (m_ShouldFilter && !m_Filter.count("debug"))
+		if (!ShouldEmit("debug"))
 			return;
 
 		// invoke handlers
-		for (auto handler : m_Handlers)
-			handler->OnDebugString(time, event.u.DebugString, pi, message);
+		Dispatch([this, time, info = event.u.DebugString, pi, message = std::move(message)]() {
+			for (auto handler : m_Handlers)
+				handler->OnDebugString(time, info, pi, message);
+		});
 	}
 }
 
@@ -541,7 +923,7 @@ void BinaryLogPlayer::EmitRip(time_t time, const RipEventEntry& frame, DEBUG_EVE
 	event.u.RipInfo.dwType  = frame.Type;
 
 	// should this event be emitted?
-	if (m_ShouldFilter && !m_Filter.count("rip"))
+	if (!ShouldEmit("rip"))
 		return;
 
 	// get a PROCESS_INFORMATION struct
@@ -549,8 +931,10 @@ void BinaryLogPlayer::EmitRip(time_t time, const RipEventEntry& frame, DEBUG_EVE
 
 	// try formatting the error code and invoke handlers.
 	auto message = Hindsight::Utilities::Error::GetErrorMessageW(event.u.RipInfo.dwError);
-	for (auto handler : m_Handlers)
-		handler->OnRip(time, event.u.RipInfo, pi, message);
+	Dispatch([this, time, info = event.u.RipInfo, pi, message = std::move(message)]() {
+		for (auto handler : m_Handlers)
+			handler->OnRip(time, info, pi, message);
+	});
 }
 
 /// <summary>
@@ -566,31 +950,315 @@ void BinaryLogPlayer::EmitDllUnload(time_t time, const DllUnloadEventEntry& fram
 	// get a PROCESS_INFORMATION struct
 	auto pi = static_cast<PROCESS_INFORMATION>(frame.ProcessInformation);
 
-	// only when not filtering or when unload_dll is included in the filter
-	if (!m_ShouldFilter || (m_ShouldFilter && m_Filter.count("unload_dll"))) {
-		auto path = m_Modules.Get(event.u.UnloadDll.lpBaseOfDll);
-		for (auto handler : m_Handlers)
-			handler->OnDllUnload(
-				time,
-				event.u.UnloadDll, 
-				pi, 
-				path, 
-				m_Modules.GetIndex(path),
-				m_Modules);
+	Dispatch([this, time, info = event.u.UnloadDll, pi, emit = ShouldEmit("unload_dll")]() {
+		// only when not filtering or when unload_dll is included in the filter
+		if (emit) {
+			auto path = m_Modules.Get(info.lpBaseOfDll);
+			for (auto handler : m_Handlers)
+				handler->OnDllUnload(
+					time,
+					info, 
+					pi, 
+					path, 
+					m_Modules.GetIndex(path),
+					m_Modules);
+		}
+
+		// simulate the unload in our internal collection too, keep track of which modules 
+		// are still loaded so that address resolution is correct. We do this after the 
+		// handlers are invoked, so that handlers can still resolve the module name.
+		if (m_Symbols) {
+			auto module = m_Modules.GetModuleAtAddress(info.lpBaseOfDll);
+
+			std::lock_guard<std::mutex> lock(symbol_engine_lock());
+			m_Symbolizer->Unload(reinterpret_cast<uint64_t>(info.lpBaseOfDll));
+			m_Symbols->Unload(info.lpBaseOfDll, module ? module->Size : 0);
+		}
+
+		m_Modules.Unload(info.lpBaseOfDll);
+	});
+}
+
+/// <summary>
+/// Read the path of a create process or DLL load event, which follows the event or is a reference into the string table 
+/// when the file has <see cref="Hindsight::BinaryLog::FileFlagInternedPaths"/>.
+/// </summary>
+/// <param name="result">A reference to a <see cref="::std::wstring" /> instance that will hold the path.</param>
+/// <param name="size">The recorded length, or the reference of the path in the string table.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the path refers to an undefined string.</exception>
+void BinaryLogPlayer::ReadPath(std::wstring& result, uint64_t size) {
+	// the header of a 0.7 file has no flags, its paths always follow the event
+	if (m_Format == FileFormatTraceStrings || !(m_Header.Flags & FileFlagInternedPaths)) {
+		Read(result, static_cast<int64_t>(size));
+		return;
 	}
 
-	// simulate the unload in our internal collection too, keep track of which modules 
-	// are still loaded so that address resolution is correct. We do this after the 
-	// handlers are invoked, so that handlers can still resolve the module name.
-	m_Modules.Unload(event.u.UnloadDll.lpBaseOfDll);
+	CompactDecoder(nullptr, 0, m_Strings).Lookup(size, result);
 }
 
 /// <summary>
-/// Determines the size of the binary log stream, thus the filesize.
+/// Read the <see cref="Hindsight::BinaryLog::ModuleIdentityEntry"/> frame that may follow the path of a create process or DLL load 
+/// event. When the next frame is something else, the read position is left untouched.
 /// </summary>
-/// <returns>An integer representing the filesize of this binary log file.</returns>
+/// <returns>The identity of the module, or no value when it was not recorded.</returns>
+std::optional<ModuleIdentity> BinaryLogPlayer::ReadIdentity() {
+	auto pos = Pos();
+	if (pos + 4 > m_EventsEnd)
+		return std::nullopt;
+
+	ModuleIdentityEntry entry;
+	if (!ReadSignature(entry.Signature, "MODI")) {
+		m_Source->Seek(pos);
+		return std::nullopt;
+	}
+
+	Read(reinterpret_cast<char*>(&entry) + sizeof(entry.Signature), sizeof(ModuleIdentityEntry) - sizeof(entry.Signature));
+
+	auto identity = static_cast<ModuleIdentity>(entry);
+	Read(identity.PdbPath, static_cast<int64_t>(entry.PdbPathLength));
+
+	return identity;
+}
+
+/// <summary>
+/// Read the <see cref="Hindsight::BinaryLog::StackMemoryEntry"/> frame that may follow the stack trace of an exception event into 
+/// the thread context of the event. When the next frame is something else, the read position is left untouched.
+/// </summary>
+/// <param name="context">A reference to the thread context of the event.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the snapshot runs past the end of the events.</exception>
+void BinaryLogPlayer::ReadStackMemory(DebugContext& context) {
+	auto pos = Pos();
+	if (pos + 4 > m_EventsEnd)
+		return;
+
+	StackMemoryEntry entry;
+	if (!ReadSignature(entry.Signature, "STKM")) {
+		m_Source->Seek(pos);
+		return;
+	}
+
+	Read(reinterpret_cast<char*>(&entry) + sizeof(entry.Signature), sizeof(StackMemoryEntry) - sizeof(entry.Signature));
+	if (entry.Size > m_EventsEnd - Pos())
+		throw std::runtime_error("cannot read stack snapshot, it runs past the end of the events.");
+
+	std::vector<uint8_t> stack(static_cast<size_t>(entry.Size));
+	Read(reinterpret_cast<char*>(stack.data()), stack.size());
+
+	context.SetStack(entry.Address, std::move(stack));
+}
+
+/// <summary>
+/// Simulate the loading of a module in the module collection and, when symbolizing, in the symbol session.
+/// </summary>
+/// <param name="path">The recorded path of the module.</param>
+/// <param name="base">The recorded module base address.</param>
+/// <param name="size">The module size in memory.</param>
+/// <param name="identity">The recorded identity of the module, if any.</param>
+void BinaryLogPlayer::LoadModule(const std::wstring& path, ModulePointer base, size_t size, const std::optional<ModuleIdentity>& identity) {
+	m_Modules.Load(path, base, size);
+	if (identity)
+		m_Modules.SetIdentity(path, *identity);
+
+	if (!m_Symbols)
+		return;
+
+	std::lock_guard<std::mutex> lock(symbol_engine_lock());
+	if (identity) {
+		m_Symbols->Load(path, base, size, *identity);
+	} else {
+		m_Symbols->Load(path, base, size);
+	}
+
+	// only a module with a recorded identity can be cached, the path alone does not tell builds apart
+	m_Symbolizer->Load(reinterpret_cast<uint64_t>(base), size, identity ? identity->Key() : "", std::make_unique<SymbolSessionProvider>(*m_Symbols, base));
+}
+
+/// <summary>
+/// Resolve the symbols and source lines of the frames of a trace that were recorded without them (see --raw-frames). Frames 
+/// that already have a symbol are left as they are.
+/// </summary>
+/// <param name="traceConcrete">A reference to the <see cref="Hindsight::BinaryLog::StackTraceConcrete"/> to symbolize.</param>
+void BinaryLogPlayer::Symbolize(StackTraceConcrete& traceConcrete) {
+	std::lock_guard<std::mutex> lock(symbol_engine_lock());
+
+	for (auto& entry : traceConcrete.Entries) {
+		if (entry.IsRecursion || entry.Address == 0 || !entry.Name.empty())
+			continue;
+
+		// the symbolizer tries the cache file first, the session memoizes every address it is asked for
+		SymbolRecord record;
+		uint64_t base = 0;
+
+		if (!m_Symbolizer->Resolve(entry.Address, record, base))
+			continue;
+
+		auto rva = entry.Address - base;
+
+		if (record.HasSymbol) {
+			entry.AbsoluteAddress  = entry.Address + (rva - record.SymbolRva);
+			entry.Name			   = record.Name;
+			entry.NameSymbolLength = entry.Name.size();
+
+			if (entry.ModuleBase == 0)
+				entry.ModuleBase = base;
+		}
+
+		if (record.HasLine) {
+			entry.AbsoluteLineAddress = entry.Address + (rva - record.LineRva);
+			entry.LineAddress		  = base + record.LineRva;
+			entry.Path				  = Hindsight::Utilities::String::ToWString(record.File);
+			entry.PathLength		  = entry.Path.size();
+			entry.LineNumber		  = record.Line;
+		}
+	}
+}
+
+/// <summary>
+/// Determines if an event with the filter name <paramref name="name"/> should be emitted to the handlers, based on the --include-only 
+/// filter and whether the player is currently only reading an event for its effect on the module collection.
+/// </summary>
+/// <param name="name">The name of the event in the filter.</param>
+/// <returns>true when the event should be emitted.</returns>
+bool BinaryLogPlayer::ShouldEmit(const char* name) const {
+	return m_Emitting && (!m_ShouldFilter || m_Filter.count(name));
+}
+
+/// <summary>
+/// Invoke <paramref name="action"/>, which contains all side effects of an event (emitting it to handlers and updating the module collection), 
+/// immediately. In recovery mode the action is held back until the next checkpoint has been verified. In single pass mode it is 
+/// held back until the next checkpoint or the checksum of the complete file has been verified, whichever comes first. A single pass 
+/// holds back at most <see cref="MaxDeferredEvents"/> events: at that point the remainder of the file is checksummed ahead of reading 
+/// it and all events after it are invoked immediately. This bounds the memory of a file with few checkpoints (for example written 
+/// with --flush exit) at the cost of reading its remainder twice.
+/// </summary>
+/// <param name="action">The side effects of an event.</param>
+void BinaryLogPlayer::Dispatch(std::function<void()> action) {
+	if (m_Recover || (m_SinglePass && !m_Verified)) {
+		m_Deferred.push_back(std::move(action));
+
+		if (m_SinglePass && m_Deferred.size() >= MaxDeferredEvents)
+			VerifyRemainder();
+		return;
+	}
+
+	action();
+}
+
+/// <summary>
+/// Verify the remainder of the file against the <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/> checksum ahead of reading it, 
+/// and invoke all held back actions. The read position is left untouched.
+/// </summary>
+/// <exception cref="std::runtime_error">This exception is thrown when the file has no footer or the data does not match its checksum.</exception>
+void BinaryLogPlayer::VerifyRemainder() {
+	auto pos   = Pos();
+	auto check = Checksum(Size() - pos, m_Crc32);
+
+	m_Source->Seek(pos);
+	if (!m_Complete || check != m_Footer.Crc32)
+		throw std::runtime_error("file has been damaged, never finished writing or was appended to. Use --no-sanity-check to ignore this check.");
+
+	m_Verified = true;
+	for (auto& action : m_Deferred)
+		action();
+
+	m_Deferred.clear();
+}
+
+/// <summary>
+/// Read the <see cref="Hindsight::BinaryLog::FileFooter"/> at the end of the file, if the file was completed. All data before the 
+/// footer is considered the data of the log, a file without footer is considered data up to its end. The read position is left untouched.
+/// </summary>
+void BinaryLogPlayer::ReadFooter() {
+	auto pos = m_Source->Pos();
+
+	if (m_Source->Size() < pos + sizeof(FileFooter))
+		return;
+
+	m_Source->Seek(m_Source->Size() - sizeof(FileFooter));
+	m_Source->Read(reinterpret_cast<char*>(&m_Footer), sizeof(FileFooter));
+	m_Source->Seek(pos);
+
+	if (_strnicmp(m_Footer.Signature, "HEND", 4))
+		return;
+
+	m_Complete = true;
+	m_DataEnd  = m_Source->Size() - sizeof(FileFooter);
+}
+
+/// <summary>
+/// Locate and read the optional index at the end of the file. When there is no (valid) index, the event frames are assumed to 
+/// continue up to the end of the file, like in files written before the index existed. The read position is left untouched.
+/// </summary>
+void BinaryLogPlayer::ReadIndex() {
+	IndexHeader header;
+	IndexFooter footer;
+
+	auto pos = m_Source->Pos();
+	m_EventsEnd = Size();
+
+	if (Size() < pos + sizeof(IndexHeader) + sizeof(IndexFooter))
+		return;
+
+	// the index footer is always the last data before the file footer
+	m_Source->Seek(Size() - sizeof(IndexFooter));
+	m_Source->Read(reinterpret_cast<char*>(&footer), sizeof(IndexFooter));
+
+	auto tableEnd = Size() - sizeof(IndexFooter);
+	if (_strnicmp(footer.Signature, "INDX", 4) || footer.IndexOffset < pos || footer.IndexOffset + sizeof(IndexHeader) > tableEnd) {
+		m_Source->Seek(pos);
+		return;
+	}
+
+	m_Source->Seek(static_cast<size_t>(footer.IndexOffset));
+	m_Source->Read(reinterpret_cast<char*>(&header), sizeof(IndexHeader));
+
+	auto tableSize = tableEnd - static_cast<size_t>(footer.IndexOffset) - sizeof(IndexHeader);
+	if (_strnicmp(header.Signature, "INDX", 4) || tableSize % sizeof(IndexEntry) != 0 || header.Count != tableSize / sizeof(IndexEntry)) {
+		m_Source->Seek(pos);
+		return;
+	}
+
+	m_Index.resize(static_cast<size_t>(header.Count));
+	if (!m_Index.empty())
+		m_Source->Read(reinterpret_cast<char*>(m_Index.data()), tableSize);
+
+	m_EventsEnd = static_cast<size_t>(footer.IndexOffset);
+	m_Source->Seek(pos);
+}
+
+/// <summary>
+/// Update the checksum <paramref name="initial"/> with the next <paramref name="size"/> bytes in the source, advancing the read position. 
+/// Mapped data is checksummed in place, other sources are read in blocks of <see cref="ChecksumBufferSize"/> bytes.
+/// </summary>
+/// <param name="size">The number of bytes to checksum.</param>
+/// <param name="initial">The checksum to update.</param>
+/// <returns>The updated checksum.</returns>
+uint32_t BinaryLogPlayer::Checksum(size_t size, uint32_t initial) {
+	if (size == 0)
+		return initial;
+
+	if (auto view = m_Source->View(size))
+		return Hindsight::Checksum::Crc32::Update(view, size, initial);
+
+	char buf[ChecksumBufferSize] = { 0 };
+	auto block = ChecksumBufferSize;
+
+	while (size > 0) {
+		if (size < block) block = size;
+		m_Source->Read(buf, block);
+		initial = Hindsight::Checksum::Crc32::Update(buf, block, initial);
+		size -= block;
+	}
+
+	return initial;
+}
+
+/// <summary>
+/// Determines the size of the binary log data, which is the filesize without the file footer.
+/// </summary>
+/// <returns>An integer representing the size of the data of this binary log file.</returns>
 inline size_t BinaryLogPlayer::Size() {
-	return m_StreamSize;
+	return m_DataEnd;
 }
 
 /// <summary>
@@ -598,7 +1266,7 @@ inline size_t BinaryLogPlayer::Size() {
 /// </summary>
 /// <returns>An integer representing the current location in the binary log file stream.</returns>
 inline size_t BinaryLogPlayer::Pos() {
-	return static_cast<size_t>(m_Stream.tellg());
+	return m_Source->Pos();
 }
 
 /// <summary>
@@ -619,6 +1287,21 @@ inline void BinaryLogPlayer::AssertSizeLeft(size_t required) {
 		throw std::runtime_error("unexpected end of binary log file, expected more data.");
 }
 
+/// <summary>
+/// Complete reading an event entry of type <typeparamref name="T"/> of which the <see cref="Hindsight::BinaryLog::EventEntry"/> 
+/// base was already read into <paramref name="header"/>. Only the remainder of the frame is read from the stream.
+/// </summary>
+/// <param name="result">A reference to the event entry to read to.</param>
+/// <param name="header">The event entry base that was already read.</param>
+/// <typeparam name="T">The type of event entry to read from the stream.</typeparam>
+template <typename T>
+void BinaryLogPlayer::ReadFrame(T& result, const EventEntry& header) {
+	static_assert(std::is_base_of<EventEntry, T>::value, "T must be an event entry");
+
+	std::memcpy(reinterpret_cast<char*>(&result), reinterpret_cast<const char*>(&header), sizeof(EventEntry));
+	Read(reinterpret_cast<char*>(&result) + sizeof(EventEntry), sizeof(T) - sizeof(EventEntry));
+}
+
 /// <summary>
 /// Read a value T from the stream directly to the value referenced by <paramref name="result"/>.
 /// </summary>
@@ -647,12 +1330,45 @@ void BinaryLogPlayer::Read(T& result) {
 /// <param name="updateChecksum">Whether to update the internal checksum or not, used in verifying data integrity.</param>
 void BinaryLogPlayer::Read(char* buffer, size_t size, bool updateChecksum) {
 	AssertSizeLeft(size);
-	m_Stream.read(buffer, size);
+	m_Source->Read(buffer, size);
 
 	if (updateChecksum)
 		m_Crc32 = Hindsight::Checksum::Crc32::Update(buffer, size, m_Crc32);
 }
 
+/// <summary>
+/// Obtain a view of <paramref name="size"/> bytes in the source without copying, and optionally update the checksum. This is 
+/// only possible when the source is memory mapped.
+/// </summary>
+/// <param name="size">The number of bytes to view.</param>
+/// <param name="updateChecksum">Whether to update the internal checksum or not, used in verifying data integrity.</param>
+/// <returns>A pointer to the bytes in the source, or <see langword="nullptr"/> when the source cannot provide views.</returns>
+const char* BinaryLogPlayer::View(size_t size, bool updateChecksum) {
+	AssertSizeLeft(size);
+	auto view = m_Source->View(size);
+
+	if (view != nullptr && updateChecksum)
+		m_Crc32 = Hindsight::Checksum::Crc32::Update(view, size, m_Crc32);
+
+	return view;
+}
+
+/// <summary>
+/// Read a frame signature of 4 bytes without updating the checksum, and verify that it matches <paramref name="expected"/>. When 
+/// it matches, the signature is added to the checksum as part of the frame it starts.
+/// </summary>
+/// <param name="signature">A buffer of 4 bytes that receives the signature.</param>
+/// <param name="expected">The expected signature.</param>
+/// <returns>true when the signature matches <paramref name="expected"/>.</returns>
+bool BinaryLogPlayer::ReadSignature(char* signature, const char* expected) {
+	Read(signature, 4, false);
+	if (_strnicmp(signature, expected, 4))
+		return false;
+
+	m_Crc32 = Hindsight::Checksum::Crc32::Update(signature, 4, m_Crc32);
+	return true;
+}
+
 /// <summary>
 /// Read an ANSI string from the stream to <paramref name="result"/>. When <paramref name="size"/> is specified, it will read 
 /// exactly that many characters (not bytes). If it is not specified, it will read the length first as a <see cref="uint32_t"/>.
@@ -671,6 +1387,12 @@ void BinaryLogPlayer::Read(std::string& result, int64_t size) {
 		return;
 	}
 
+	// construct the string straight from the mapped bytes when possible
+	if (auto view = View(static_cast<size_t>(size) * sizeof(char))) {
+		result.assign(view, static_cast<size_t>(size));
+		return;
+	}
+
 	result.resize(size);
 	Read(&result[0], size * sizeof(char));
 }
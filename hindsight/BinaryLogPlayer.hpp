@@ -3,16 +3,21 @@
 #ifndef binary_log_player_h
 #define binary_log_player_h
 	#include "BinaryLogFile.hpp"
+	#include "BinaryLogSource.hpp"
 	#include "IDebuggerEventHandler.hpp"
 	#include "ModuleCollection.hpp"
+	#include "SymbolSession.hpp"
+	#include "OfflineSymbolizer.hpp"
 	#include "DynaCli.hpp"
 	#include "ArgumentNames.hpp"
 
 	#include <memory>
 	#include <vector>
+	#include <functional>
 	#include <fstream>
 	#include <ctime>
 	#include <set>
+	#include <optional>
 
 	namespace Hindsight {
 		namespace BinaryLog {
@@ -25,21 +30,47 @@
 			/// </summary>
 			class BinaryLogPlayer {
 				private:
-					std::ifstream				m_Stream;
-					size_t						m_StreamSize;
+					std::unique_ptr<IBinaryLogSource> m_Source;
 					const Cli::HindsightCli&	m_State;
 					const Cli::HindsightCli&	m_SubState;
 					bool						m_ShouldFilter;
 					std::set<std::string>		m_Filter;
 
 					FileHeader					m_Header;
+					FileFooter					m_Footer;
+					bool						m_Complete;
+					size_t						m_DataEnd;
 					uint32_t					m_Crc32;
+					uint32_t					m_Format;
+					bool						m_Indexed;
+					bool						m_SinglePass;
+					bool						m_Verified;
+					bool						m_Recover;
+					bool						m_Intact;
+					uint64_t					m_Events;
+					uint64_t					m_VerifiedEvents;
+
+					std::vector<IndexEntry>		m_Index;
+					std::vector<std::string>	m_Strings;
+					size_t						m_EventsEnd;
+					bool						m_Emitting;
+
+					std::vector<std::function<void()>> m_Deferred;
 
 					std::vector<std::shared_ptr<EventHandler::IDebuggerEventHandler>> m_Handlers;
 
 					ModuleCollection m_Modules;
 
+					// The symbol session that resolves frames recorded with --raw-frames, only with --symbolize.
+					std::unique_ptr<SymbolSession> m_Symbols;
+
+					// Resolves frames through the symbol cache file (--symbol-cache) before the session, only with --symbolize.
+					std::unique_ptr<OfflineSymbolizer> m_Symbolizer;
+
 					static const size_t ChecksumBufferSize = 2048;
+
+					// The number of events a single pass holds back before it verifies the rest of the file ahead of reading it.
+					static const size_t MaxDeferredEvents = 4096;
 				public:
 					/// <summary>
 					/// Construct a BinaryLogPlayer instance from a path pointing to a HIND file, and a <see cref="Hindsight::State"/> instance 
@@ -51,9 +82,14 @@
 					BinaryLogPlayer(const std::string& path, const Cli::HindsightCli& state);
 
 					/// <summary>
-					/// Walks the binary log file and verifies that all data matches the <see cref="Hindsight::BinaryLog::FileHeader::Crc32"/>.
+					/// Clean up the symbol session, if any.
+					/// </summary>
+					~BinaryLogPlayer();
+
+					/// <summary>
+					/// Walks the binary log file and verifies that all data matches the <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/>.
 					/// </summary>
-					/// <exception cref="std::runtime_error">This exception is thrown when the data in the file does not result in the <see cref="Hindsight::BinaryLog::FileHeader::Crc32"/> checksum.</exception>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file has no footer or the data in the file does not result in the <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/> checksum.</exception>
 					void CheckSanity();
 
 					/// <summary>
@@ -63,16 +99,60 @@
 					void AddHandler(std::shared_ptr<EventHandler::IDebuggerEventHandler> handler);
 
 					/// <summary>
-					/// Play the binary log file and simulate the debug events that were stored in it.
+					/// Determines if all data in the file could be verified. This is only false after playing in recovery mode, when the file never 
+					/// finished writing or was damaged.
+					/// </summary>
+					/// <returns>true when no data had to be dropped.</returns>
+					bool Intact() const noexcept;
+
+					/// <summary>
+					/// Determines the number of events that were verified and emitted in recovery mode.
+					/// </summary>
+					/// <returns>The number of recovered events.</returns>
+					uint64_t VerifiedEvents() const noexcept;
+
+					/// <summary>
+					/// Play the binary log file and simulate the debug events that were stored in it. When the player was constructed for a single pass, 
+					/// the checksum is verified while reading and the events are only emitted after the data up to them has been verified, see 
+					/// <see cref="Hindsight::BinaryLog::BinaryLogPlayer::Dispatch"/>.
 					/// </summary>
 					/// <exception cref="std::runtime_error">
-					///	This exception is thrown when the checksum of all data read does not match the stored <see cref="Hindsight::BinaryLog::FileHeader::Crc32"/> 
+					///	This exception is thrown when the checksum of all data read does not match the stored <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/> 
 					/// checksum in the file. This exception can also be thrown when an unexpected frame type is encountered in the file, or when an unexpected end 
 					/// is encountered in the file. 
 					/// </exception>
 					void Play();
 
 				private:
+					/// <summary>
+					/// Play only the events selected by the --last-exception, --window-start and --window-end options by seeking to them through the index. 
+					/// Events that load or unload modules are always read, so that the module collection is correct for each selected event, but they are 
+					/// only emitted when they are selected themselves.
+					/// </summary>
+					/// <exception cref="std::runtime_error">This exception is thrown when the index refers to data outside of the event frames.</exception>
+					void PlayIndexed();
+
+					/// <summary>
+					/// Play a file that may never have finished writing, or that was damaged. Events are held back until a checkpoint after them 
+					/// has been verified, and are only emitted then. When the end of the file is reached and the complete file matches the footer 
+					/// checksum, all events are emitted. Otherwise reading stops at the first damaged frame and the events after the last intact 
+					/// checkpoint are dropped.
+					/// </summary>
+					void PlayRecover();
+
+					/// <summary>
+					/// Read the remainder of a <see cref="Hindsight::BinaryLog::CheckpointEntry"/> after its signature. In recovery mode the checkpoint is 
+					/// verified against the checksum of all data read so far, and the events that were held back are emitted.
+					/// </summary>
+					/// <exception cref="std::runtime_error">This exception is thrown in recovery mode when the checkpoint does not match the data before it.</exception>
+					void ReadCheckpoint();
+
+					/// <summary>
+					/// Read the remainder of a <see cref="Hindsight::BinaryLog::StringTableEntry"/> after its signature, and add its strings to the string table.
+					/// </summary>
+					/// <exception cref="std::runtime_error">This exception is thrown when the strings do not follow the string table read so far, or when the frame is damaged.</exception>
+					void ReadStrings();
+
 					/// <summary>
 					/// Read and process the next <see cref="Hindsight::BinaryLog::EventEntry"/> and emit it as event to the added event handlers.
 					/// </summary>
@@ -154,9 +234,111 @@
 					void EmitDllUnload(time_t time, const DllUnloadEventEntry& frame, DEBUG_EVENT& event);
 
 					/// <summary>
-					/// Determines the size of the binary log stream, thus the filesize.
+					/// Determines if an event with the filter name <paramref name="name"/> should be emitted to the handlers, based on the --include-only 
+					/// filter and whether the player is currently only reading an event for its effect on the module collection.
+					/// </summary>
+					/// <param name="name">The name of the event in the filter.</param>
+					/// <returns>true when the event should be emitted.</returns>
+					bool ShouldEmit(const char* name) const;
+
+					/// <summary>
+					/// Invoke <paramref name="action"/>, which contains all side effects of an event (emitting it to handlers and updating the module collection), 
+					/// immediately. In recovery mode the action is held back until the next checkpoint has been verified. In single pass mode it is 
+					/// held back until the next checkpoint or the checksum of the complete file has been verified, whichever comes first. A single pass 
+					/// holds back at most <see cref="MaxDeferredEvents"/> events: at that point the remainder of the file is checksummed ahead of reading 
+					/// it and all events after it are invoked immediately. This bounds the memory of a file with few checkpoints (for example written 
+					/// with --flush exit) at the cost of reading its remainder twice.
+					/// </summary>
+					/// <param name="action">The side effects of an event.</param>
+					void Dispatch(std::function<void()> action);
+
+					/// <summary>
+					/// Read a stack trace frame, which is either a <see cref="Hindsight::BinaryLog::StackTrace"/> followed by its fixed size entries, or 
+					/// a <see cref="Hindsight::BinaryLog::CompactStackTrace"/>.
+					/// </summary>
+					/// <param name="traceConcrete">A reference to the <see cref="Hindsight::BinaryLog::StackTraceConcrete"/> that receives the trace.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when no stack trace frame follows or when it is damaged.</exception>
+					void ReadStackTrace(StackTraceConcrete& traceConcrete);
+
+					/// <summary>
+					/// Read the remainder of a <see cref="Hindsight::BinaryLog::CompactStackTrace"/> frame after its signature, and decode it.
 					/// </summary>
-					/// <returns>An integer representing the filesize of this binary log file.</returns>
+					/// <param name="traceConcrete">A reference to the <see cref="Hindsight::BinaryLog::StackTraceConcrete"/> that receives the trace.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the frame is damaged.</exception>
+					void ReadCompactStackTrace(StackTraceConcrete& traceConcrete);
+
+					/// <summary>
+					/// Read the <see cref="Hindsight::BinaryLog::ModuleIdentityEntry"/> frame that may follow the path of a create process or DLL load 
+					/// event. When the next frame is something else, the read position is left untouched.
+					/// </summary>
+					/// <returns>The identity of the module, or no value when it was not recorded.</returns>
+					std::optional<ModuleIdentity> ReadIdentity();
+
+					/// <summary>
+					/// Read the path of a create process or DLL load event, which follows the event or is a reference into the string table 
+					/// when the file has <see cref="Hindsight::BinaryLog::FileFlagInternedPaths"/>.
+					/// </summary>
+					/// <param name="result">A reference to a <see cref="::std::wstring" /> instance that will hold the path.</param>
+					/// <param name="size">The recorded length, or the reference of the path in the string table.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the path refers to an undefined string.</exception>
+					void ReadPath(std::wstring& result, uint64_t size);
+
+					/// <summary>
+					/// Read the <see cref="Hindsight::BinaryLog::StackMemoryEntry"/> frame that may follow the stack trace of an exception event into 
+					/// the thread context of the event. When the next frame is something else, the read position is left untouched.
+					/// </summary>
+					/// <param name="context">A reference to the thread context of the event.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the snapshot runs past the end of the events.</exception>
+					void ReadStackMemory(DebugContext& context);
+
+					/// <summary>
+					/// Simulate the loading of a module in the module collection and, when symbolizing, in the symbol session.
+					/// </summary>
+					/// <param name="path">The recorded path of the module.</param>
+					/// <param name="base">The recorded module base address.</param>
+					/// <param name="size">The module size in memory.</param>
+					/// <param name="identity">The recorded identity of the module, if any.</param>
+					void LoadModule(const std::wstring& path, ModulePointer base, size_t size, const std::optional<ModuleIdentity>& identity);
+
+					/// <summary>
+					/// Resolve the symbols and source lines of the frames of a trace that were recorded without them (see --raw-frames). Frames 
+					/// that already have a symbol are left as they are.
+					/// </summary>
+					/// <param name="traceConcrete">A reference to the <see cref="Hindsight::BinaryLog::StackTraceConcrete"/> to symbolize.</param>
+					void Symbolize(StackTraceConcrete& traceConcrete);
+
+					/// <summary>
+					/// Verify the remainder of the file against the <see cref="Hindsight::BinaryLog::FileFooter::Crc32"/> checksum ahead of reading it, 
+					/// and invoke all held back actions. The read position is left untouched.
+					/// </summary>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file has no footer or the data does not match its checksum.</exception>
+					void VerifyRemainder();
+
+					/// <summary>
+					/// Read the <see cref="Hindsight::BinaryLog::FileFooter"/> at the end of the file, if the file was completed. All data before the 
+					/// footer is considered the data of the log, a file without footer is considered data up to its end. The read position is left untouched.
+					/// </summary>
+					void ReadFooter();
+
+					/// <summary>
+					/// Locate and read the optional index at the end of the file. When there is no (valid) index, the event frames are assumed to 
+					/// continue up to the end of the file, like in files written before the index existed. The read position is left untouched.
+					/// </summary>
+					void ReadIndex();
+
+					/// <summary>
+					/// Update the checksum <paramref name="initial"/> with the next <paramref name="size"/> bytes in the source, advancing the read position. 
+					/// Mapped data is checksummed in place, other sources are read in blocks of <see cref="ChecksumBufferSize"/> bytes.
+					/// </summary>
+					/// <param name="size">The number of bytes to checksum.</param>
+					/// <param name="initial">The checksum to update.</param>
+					/// <returns>The updated checksum.</returns>
+					uint32_t Checksum(size_t size, uint32_t initial);
+
+					/// <summary>
+					/// Determines the size of the binary log data, which is the filesize without the file footer.
+					/// </summary>
+					/// <returns>An integer representing the size of the data of this binary log file.</returns>
 					inline size_t Size();
 
 					/// <summary>
@@ -178,6 +360,16 @@
 					/// <param name="required">The number of bytes required to be available in the stream.</param>
 					inline void AssertSizeLeft(size_t required);
 
+					/// <summary>
+					/// Complete reading an event entry of type <typeparamref name="T"/> of which the <see cref="Hindsight::BinaryLog::EventEntry"/> 
+					/// base was already read into <paramref name="header"/>. Only the remainder of the frame is read from the stream.
+					/// </summary>
+					/// <param name="result">A reference to the event entry to read to.</param>
+					/// <param name="header">The event entry base that was already read.</param>
+					/// <typeparam name="T">The type of event entry to read from the stream.</typeparam>
+					template <typename T>
+					void ReadFrame(T& result, const EventEntry& header);
+
 					/// <summary>
 					/// Read a value T from the stream directly to the value referenced by <paramref name="result"/>.
 					/// </summary>
@@ -202,6 +394,24 @@
 					/// <param name="updateChecksum">Whether to update the internal checksum or not, used in verifying data integrity.</param>
 					void Read(char* buffer, size_t size, bool updateChecksum = true);
 
+					/// <summary>
+					/// Obtain a view of <paramref name="size"/> bytes in the source without copying, and optionally update the checksum. This is 
+					/// only possible when the source is memory mapped.
+					/// </summary>
+					/// <param name="size">The number of bytes to view.</param>
+					/// <param name="updateChecksum">Whether to update the internal checksum or not, used in verifying data integrity.</param>
+					/// <returns>A pointer to the bytes in the source, or <see langword="nullptr"/> when the source cannot provide views.</returns>
+					const char* View(size_t size, bool updateChecksum = true);
+
+					/// <summary>
+					/// Read a frame signature of 4 bytes without updating the checksum, and verify that it matches <paramref name="expected"/>. When 
+					/// it matches, the signature is added to the checksum as part of the frame it starts.
+					/// </summary>
+					/// <param name="signature">A buffer of 4 bytes that receives the signature.</param>
+					/// <param name="expected">The expected signature.</param>
+					/// <returns>true when the signature matches <paramref name="expected"/>.</returns>
+					bool ReadSignature(char* signature, const char* expected);
+
 					/// <summary>
 					/// Read an ANSI string from the stream to <paramref name="result"/>. When <paramref name="size"/> is specified, it will read 
 					/// exactly that many characters (not bytes). If it is not specified, it will read the length first as a <see cref="uint32_t"/>.
@@ -0,0 +1,402 @@
+#include "BinaryLogSource.hpp"
+#include "Lz.hpp"
+#include "crc32.hpp"
+
+#include <filesystem>
+#include <stdexcept>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+using namespace Hindsight::BinaryLog;
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Open the file at <paramref name="path"/> for reading.
+/// </summary>
+/// <param name="path">The path to the file.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be opened.</exception>
+StreamBinaryLogSource::StreamBinaryLogSource(const std::string& path)
+	: m_Size(0), m_Position(0) {
+	m_Stream.open(path, std::ios::in | std::ios::binary);
+	if (!m_Stream.is_open())
+		throw std::runtime_error("cannot open file for reading: " + path);
+	m_Size = static_cast<size_t>(fs::file_size(path));
+}
+
+/// <summary>
+/// Determines the total size of the file in bytes.
+/// </summary>
+/// <returns>The size of the file.</returns>
+size_t StreamBinaryLogSource::Size() const {
+	return m_Size;
+}
+
+/// <summary>
+/// Determines the current read position.
+/// </summary>
+/// <returns>The current read position.</returns>
+size_t StreamBinaryLogSource::Pos() const {
+	return m_Position;
+}
+
+/// <summary>
+/// Move the read position to an absolute offset.
+/// </summary>
+/// <param name="position">The new read position.</param>
+void StreamBinaryLogSource::Seek(size_t position) {
+	m_Stream.seekg(static_cast<std::streamoff>(position), std::ios::beg);
+	m_Position = position;
+}
+
+/// <summary>
+/// Copy <paramref name="size"/> bytes from the file into <paramref name="buffer"/> and advance the read position.
+/// </summary>
+/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+/// <param name="size">The number of bytes to read.</param>
+void StreamBinaryLogSource::Read(char* buffer, size_t size) {
+	m_Stream.read(buffer, size);
+	m_Position += size;
+}
+
+/// <summary>
+/// Streams cannot provide views, this method always returns <see langword="nullptr"/>.
+/// </summary>
+/// <returns>Always <see langword="nullptr"/>.</returns>
+const char* StreamBinaryLogSource::View(size_t) {
+	return nullptr;
+}
+
+/// <summary>
+/// Open and map the file at <paramref name="path"/> for reading.
+/// </summary>
+/// <param name="path">The path to the file.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be opened or mapped, for example when it is empty.</exception>
+MappedBinaryLogSource::MappedBinaryLogSource(const std::string& path)
+	: m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL), m_Data(nullptr), m_Size(0), m_Position(0) {
+	LARGE_INTEGER size;
+
+	m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("cannot open file for reading: " + path);
+
+	// an empty file cannot be mapped, the caller can fall back to a stream in that case
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+		Close();
+		throw std::runtime_error("cannot map an empty file: " + path);
+	}
+
+	m_Size = static_cast<size_t>(size.QuadPart);
+
+	m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_Mapping == NULL) {
+		Close();
+		throw std::runtime_error("cannot create file mapping: " + path);
+	}
+
+	m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_Data == nullptr) {
+		Close();
+		throw std::runtime_error("cannot map view of file: " + path);
+	}
+}
+
+/// <summary>
+/// Unmap the view and close all handles.
+/// </summary>
+MappedBinaryLogSource::~MappedBinaryLogSource() {
+	Close();
+}
+
+/// <summary>
+/// Determines the total size of the mapping in bytes.
+/// </summary>
+/// <returns>The size of the mapping.</returns>
+size_t MappedBinaryLogSource::Size() const {
+	return m_Size;
+}
+
+/// <summary>
+/// Determines the current read position.
+/// </summary>
+/// <returns>The current read position.</returns>
+size_t MappedBinaryLogSource::Pos() const {
+	return m_Position;
+}
+
+/// <summary>
+/// Move the read position to an absolute offset.
+/// </summary>
+/// <param name="position">The new read position.</param>
+void MappedBinaryLogSource::Seek(size_t position) {
+	m_Position = position;
+}
+
+/// <summary>
+/// Copy <paramref name="size"/> bytes from the mapping into <paramref name="buffer"/> and advance the read position.
+/// </summary>
+/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+/// <param name="size">The number of bytes to read.</param>
+void MappedBinaryLogSource::Read(char* buffer, size_t size) {
+	std::memcpy(buffer, m_Data + m_Position, size);
+	m_Position += size;
+}
+
+/// <summary>
+/// Obtain a view of <paramref name="size"/> bytes in the mapping at the current read position and advance the read position.
+/// </summary>
+/// <param name="size">The number of bytes to view.</param>
+/// <returns>A pointer into the mapped file.</returns>
+const char* MappedBinaryLogSource::View(size_t size) {
+	auto view = m_Data + m_Position;
+	m_Position += size;
+	return view;
+}
+
+/// <summary>
+/// Unmap the view and close all handles that were opened so far.
+/// </summary>
+void MappedBinaryLogSource::Close() {
+	if (m_Data != nullptr) {
+		UnmapViewOfFile(m_Data);
+		m_Data = nullptr;
+	}
+
+	if (m_Mapping != NULL) {
+		CloseHandle(m_Mapping);
+		m_Mapping = NULL;
+	}
+
+	if (m_File != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+}
+
+/// <summary>
+/// Determines if <paramref name="source"/> contains a compressed binary log file, the read position is moved to the start.
+/// </summary>
+/// <param name="source">A reference to the source to check.</param>
+/// <returns>true when the source starts with a <see cref="::Hindsight::BinaryLog::CompressedFileHeader"/> signature.</returns>
+bool CompressedBinaryLogSource::IsCompressed(IBinaryLogSource& source) {
+	char signature[4] = { 0 };
+
+	if (source.Size() < sizeof(signature))
+		return false;
+
+	source.Seek(0);
+	source.Read(signature, sizeof(signature));
+	source.Seek(0);
+
+	return std::memcmp(signature, CompressedFileHeader().Signature, sizeof(signature)) == 0;
+}
+
+/// <summary>
+/// Read the headers of the compressed binary log file in <paramref name="source"/> and verify its blocks.
+/// </summary>
+/// <param name="source">The source of the compressed file, which is owned by this source from now on.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file is not a compressed binary log file, or is too short to contain the file header.</exception>
+CompressedBinaryLogSource::CompressedBinaryLogSource(std::unique_ptr<IBinaryLogSource> source)
+	: m_Source(std::move(source)), m_Header(), m_HeaderSize(sizeof(FileHeader)), m_Current(0), m_Size(0), m_Position(0), m_Damaged(false) {
+	CompressedFileHeader header;
+
+	if (m_Source->Size() < sizeof(CompressedFileHeader) + offsetof(FileHeader, ProcessId))
+		throw std::runtime_error("file is too short to be a compressed binary log file");
+
+	m_Source->Seek(0);
+	m_Source->Read(reinterpret_cast<char*>(&header), sizeof(CompressedFileHeader));
+
+	if (std::memcmp(header.Signature, CompressedFileHeader().Signature, sizeof(header.Signature)) != 0)
+		throw std::runtime_error("file is not a compressed binary log file");
+
+	// the size of the file header depends on the version that wrote it, so the version is read first
+	m_Source->Read(m_Header, offsetof(FileHeader, ProcessId));
+	m_HeaderSize = FileHeader::SizeOf(reinterpret_cast<const FileHeader*>(m_Header)->Version);
+	if (m_Source->Size() < sizeof(CompressedFileHeader) + m_HeaderSize)
+		throw std::runtime_error("file is too short to be a compressed binary log file");
+
+	m_Source->Read(m_Header + offsetof(FileHeader, ProcessId), m_HeaderSize - offsetof(FileHeader, ProcessId));
+	m_Size = m_HeaderSize;
+
+	Scan(header.MaxBlockSize);
+	m_Current = m_Blocks.size();
+}
+
+/// <summary>
+/// Determines if the file was cut short or damaged, in which case only the data of the intact blocks before it can be read.
+/// </summary>
+/// <returns>true when the file does not end with an intact block.</returns>
+bool CompressedBinaryLogSource::Damaged() const noexcept {
+	return m_Damaged;
+}
+
+/// <summary>
+/// Determines the size of the decompressed file in bytes.
+/// </summary>
+/// <returns>The size of the decompressed file.</returns>
+size_t CompressedBinaryLogSource::Size() const {
+	return m_Size;
+}
+
+/// <summary>
+/// Determines the current read position in the decompressed file.
+/// </summary>
+/// <returns>The current read position.</returns>
+size_t CompressedBinaryLogSource::Pos() const {
+	return m_Position;
+}
+
+/// <summary>
+/// Move the read position to an absolute offset in the decompressed file.
+/// </summary>
+/// <param name="position">The new read position.</param>
+void CompressedBinaryLogSource::Seek(size_t position) {
+	m_Position = position;
+}
+
+/// <summary>
+/// Copy <paramref name="size"/> decompressed bytes into <paramref name="buffer"/> and advance the read position, decompressing 
+/// blocks as needed.
+/// </summary>
+/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+/// <param name="size">The number of bytes to read.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when reading past the end, or when a block cannot be decompressed.</exception>
+void CompressedBinaryLogSource::Read(char* buffer, size_t size) {
+	while (size > 0) {
+		const char* data;
+		size_t available;
+
+		if (m_Position < m_HeaderSize) {
+			data	  = m_Header + m_Position;
+			available = m_HeaderSize - m_Position;
+		} else {
+			const auto& block = Load(m_Position);
+			data	  = m_Data.data() + (m_Position - block.Offset);
+			available = block.RawSize - (m_Position - block.Offset);
+		}
+
+		auto count = size < available ? size : available;
+		std::memcpy(buffer, data, count);
+
+		buffer	   += count;
+		size	   -= count;
+		m_Position += count;
+	}
+}
+
+/// <summary>
+/// Obtain a view of <paramref name="size"/> decompressed bytes, which is only possible when they are all in the same block.
+/// </summary>
+/// <param name="size">The number of bytes to view.</param>
+/// <returns>A pointer to the decompressed bytes, which is valid until the next read from the source, or <see langword="nullptr"/>.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when a block cannot be decompressed.</exception>
+const char* CompressedBinaryLogSource::View(size_t size) {
+	const char* view = nullptr;
+
+	if (m_Position < m_HeaderSize) {
+		if (size <= m_HeaderSize - m_Position)
+			view = m_Header + m_Position;
+	} else if (m_Position < m_Size) {
+		const auto& block = Load(m_Position);
+		if (size <= block.RawSize - (m_Position - block.Offset))
+			view = m_Data.data() + (m_Position - block.Offset);
+	}
+
+	if (view != nullptr)
+		m_Position += size;
+
+	return view;
+}
+
+/// <summary>
+/// Read all block headers and verify the checksum of each block, up to the end of the file or the first damaged block.
+/// </summary>
+/// <param name="maxBlockSize">The maximum decompressed size of a block according to the file header.</param>
+void CompressedBinaryLogSource::Scan(size_t maxBlockSize) {
+	auto position = m_Source->Pos();
+	auto end	  = m_Source->Size();
+
+	while (position < end) {
+		BlockHeader header;
+
+		// a block header or block that was only partially written before a crash ends the readable data
+		if (end - position < sizeof(BlockHeader)) {
+			m_Damaged = true;
+			break;
+		}
+
+		m_Source->Read(reinterpret_cast<char*>(&header), sizeof(BlockHeader));
+		position += sizeof(BlockHeader);
+
+		bool valid = 
+			std::memcmp(header.Signature, BlockHeader().Signature, sizeof(header.Signature)) == 0 &&
+			header.RawSize <= maxBlockSize &&
+			header.StoredSize <= end - position &&
+			(header.Method == BlockLz || (header.Method == BlockStored && header.StoredSize == header.RawSize));
+
+		if (!valid) {
+			m_Damaged = true;
+			break;
+		}
+
+		// verify the stored bytes, a damaged block cannot be decompressed safely and neither can anything after it be trusted
+		auto data = m_Source->View(header.StoredSize);
+		if (data == nullptr) {
+			m_Stored.resize(header.StoredSize);
+			m_Source->Read(m_Stored.data(), header.StoredSize);
+			data = m_Stored.data();
+		}
+
+		if (Hindsight::Checksum::Crc32::Update(data, header.StoredSize, 0) != header.Crc32) {
+			m_Damaged = true;
+			break;
+		}
+
+		m_Blocks.push_back({ m_Size, position, header.RawSize, header.StoredSize, header.Method });
+		m_Size	 += header.RawSize;
+		position += header.StoredSize;
+	}
+}
+
+/// <summary>
+/// Make the block containing the decompressed offset <paramref name="position"/> the current block.
+/// </summary>
+/// <param name="position">An offset after the file header.</param>
+/// <returns>A const reference to the current block.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when <paramref name="position"/> is past the end, or when the block cannot be decompressed.</exception>
+const CompressedBinaryLogSource::Block& CompressedBinaryLogSource::Load(size_t position) {
+	if (m_Current < m_Blocks.size()) {
+		const auto& current = m_Blocks[m_Current];
+		if (position >= current.Offset && position < current.Offset + current.RawSize)
+			return current;
+	}
+
+	if (position >= m_Size)
+		throw std::runtime_error("unexpected end of compressed binary log file");
+
+	// find the last block that starts at or before the position, empty blocks are never selected
+	auto it = std::upper_bound(m_Blocks.begin(), m_Blocks.end(), position, [](size_t value, const Block& block) { return value < block.Offset; });
+	const auto& block = *(it - 1);
+
+	m_Current = m_Blocks.size();
+
+	m_Source->Seek(block.Position);
+	auto data = m_Source->View(block.StoredSize);
+	if (data == nullptr) {
+		m_Stored.resize(block.StoredSize);
+		m_Source->Read(m_Stored.data(), block.StoredSize);
+		data = m_Stored.data();
+	}
+
+	m_Data.resize(block.RawSize);
+	if (block.Method == BlockStored) {
+		std::memcpy(m_Data.data(), data, block.RawSize);
+	} else {
+		Hindsight::Utilities::Lz::Decompress(data, block.StoredSize, m_Data.data(), block.RawSize);
+	}
+
+	m_Current = static_cast<size_t>(it - 1 - m_Blocks.begin());
+	return block;
+}
+
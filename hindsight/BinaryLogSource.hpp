@@ -0,0 +1,281 @@
+#pragma once
+
+#ifndef binary_log_source_h
+#define binary_log_source_h
+	#include <Windows.h>
+
+	#include "BinaryLogFile.hpp"
+
+	#include <string>
+	#include <fstream>
+	#include <cstdint>
+	#include <memory>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace BinaryLog {
+			/// <summary>
+			/// An interface describing a sequential, seekable source of binary log data. The <see cref="Hindsight::BinaryLog::BinaryLogPlayer"/>
+			/// reads all frames through a source, which allows the bytes to either come from a memory mapping or a regular file stream.
+			/// </summary>
+			class IBinaryLogSource {
+				public:
+					virtual ~IBinaryLogSource() = default;
+
+					/// <summary>
+					/// Determines the total size of the source in bytes.
+					/// </summary>
+					/// <returns>The size of the source.</returns>
+					virtual size_t Size() const = 0;
+
+					/// <summary>
+					/// Determines the current read position in the source.
+					/// </summary>
+					/// <returns>The current read position.</returns>
+					virtual size_t Pos() const = 0;
+
+					/// <summary>
+					/// Move the read position to an absolute offset in the source.
+					/// </summary>
+					/// <param name="position">The new read position.</param>
+					virtual void Seek(size_t position) = 0;
+
+					/// <summary>
+					/// Copy <paramref name="size"/> bytes from the current read position into <paramref name="buffer"/> and advance the read position.
+					/// The caller is responsible for verifying that enough data is left.
+					/// </summary>
+					/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+					/// <param name="size">The number of bytes to read.</param>
+					virtual void Read(char* buffer, size_t size) = 0;
+
+					/// <summary>
+					/// Obtain a view of <paramref name="size"/> bytes at the current read position and advance the read position, without copying
+					/// any data. Sources that cannot provide views return <see langword="nullptr"/> and leave the read position untouched.
+					/// </summary>
+					/// <param name="size">The number of bytes to view.</param>
+					/// <returns>A pointer to the bytes in the source, which remains valid at least until the next read from the source, or <see langword="nullptr"/>.</returns>
+					virtual const char* View(size_t size) = 0;
+			};
+
+			/// <summary>
+			/// A binary log source that reads through a <see cref="::std::ifstream"/>. The read position is tracked by the source itself,
+			/// so that no tellg round-trips are needed for each read.
+			/// </summary>
+			class StreamBinaryLogSource : public IBinaryLogSource {
+				private:
+					std::ifstream	m_Stream;
+					size_t			m_Size;
+					size_t			m_Position;
+
+				public:
+					/// <summary>
+					/// Open the file at <paramref name="path"/> for reading.
+					/// </summary>
+					/// <param name="path">The path to the file.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be opened.</exception>
+					StreamBinaryLogSource(const std::string& path);
+
+					/// <summary>
+					/// Determines the total size of the file in bytes.
+					/// </summary>
+					/// <returns>The size of the file.</returns>
+					size_t Size() const override;
+
+					/// <summary>
+					/// Determines the current read position.
+					/// </summary>
+					/// <returns>The current read position.</returns>
+					size_t Pos() const override;
+
+					/// <summary>
+					/// Move the read position to an absolute offset.
+					/// </summary>
+					/// <param name="position">The new read position.</param>
+					void Seek(size_t position) override;
+
+					/// <summary>
+					/// Copy <paramref name="size"/> bytes from the file into <paramref name="buffer"/> and advance the read position.
+					/// </summary>
+					/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+					/// <param name="size">The number of bytes to read.</param>
+					void Read(char* buffer, size_t size) override;
+
+					/// <summary>
+					/// Streams cannot provide views, this method always returns <see langword="nullptr"/>.
+					/// </summary>
+					/// <param name="size">The number of bytes to view.</param>
+					/// <returns>Always <see langword="nullptr"/>.</returns>
+					const char* View(size_t size) override;
+			};
+
+			/// <summary>
+			/// A binary log source that maps the complete file into memory as read-only. Frames can be parsed in place and views can be
+			/// handed out, which avoids copying and the overhead of going through a stream for each field.
+			/// </summary>
+			class MappedBinaryLogSource : public IBinaryLogSource {
+				private:
+					HANDLE		m_File;
+					HANDLE		m_Mapping;
+					const char*	m_Data;
+					size_t		m_Size;
+					size_t		m_Position;
+
+				public:
+					/// <summary>
+					/// Open and map the file at <paramref name="path"/> for reading.
+					/// </summary>
+					/// <param name="path">The path to the file.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be opened or mapped, for example when it is empty.</exception>
+					MappedBinaryLogSource(const std::string& path);
+
+					/// <summary>
+					/// Unmap the view and close all handles.
+					/// </summary>
+					~MappedBinaryLogSource();
+
+					MappedBinaryLogSource(const MappedBinaryLogSource&) = delete;
+					MappedBinaryLogSource& operator=(const MappedBinaryLogSource&) = delete;
+
+					/// <summary>
+					/// Determines the total size of the mapping in bytes.
+					/// </summary>
+					/// <returns>The size of the mapping.</returns>
+					size_t Size() const override;
+
+					/// <summary>
+					/// Determines the current read position.
+					/// </summary>
+					/// <returns>The current read position.</returns>
+					size_t Pos() const override;
+
+					/// <summary>
+					/// Move the read position to an absolute offset.
+					/// </summary>
+					/// <param name="position">The new read position.</param>
+					void Seek(size_t position) override;
+
+					/// <summary>
+					/// Copy <paramref name="size"/> bytes from the mapping into <paramref name="buffer"/> and advance the read position.
+					/// </summary>
+					/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+					/// <param name="size">The number of bytes to read.</param>
+					void Read(char* buffer, size_t size) override;
+
+					/// <summary>
+					/// Obtain a view of <paramref name="size"/> bytes in the mapping at the current read position and advance the read position.
+					/// </summary>
+					/// <param name="size">The number of bytes to view.</param>
+					/// <returns>A pointer into the mapped file.</returns>
+					const char* View(size_t size) override;
+
+				private:
+					/// <summary>
+					/// Unmap the view and close all handles that were opened so far.
+					/// </summary>
+					void Close();
+			};
+
+			/// <summary>
+			/// A binary log source that reads a compressed binary log file through another source, and presents the data as if the file was 
+			/// not compressed. All block headers are read and all block checksums are verified up front, which stops at the first damaged or 
+			/// incomplete block so that the data before it can still be read. Blocks are decompressed when they are read from, one at a time.
+			/// </summary>
+			class CompressedBinaryLogSource : public IBinaryLogSource {
+				private:
+					/// <summary>
+					/// The location of a block in the decompressed data and in the underlying source.
+					/// </summary>
+					struct Block {
+						size_t	Offset;		/* The offset of the decompressed data */
+						size_t	Position;	/* The offset of the stored data in the underlying source */
+						size_t	RawSize;	/* The size of the decompressed data */
+						size_t	StoredSize;	/* The size of the stored data */
+						uint8_t	Method;		/* How the data is stored, see BlockMethod */
+					};
+
+					std::unique_ptr<IBinaryLogSource>	m_Source;						/* The source of the compressed file */
+					char								m_Header[sizeof(FileHeader)];	/* The uncompressed file header */
+					size_t								m_HeaderSize;					/* The size of the file header, which depends on its version */
+					std::vector<Block>					m_Blocks;						/* All intact blocks, in order */
+					std::vector<char>					m_Data;						/* The decompressed data of the current block */
+					std::vector<char>					m_Stored;						/* The stored data of a block, when the underlying source cannot provide views */
+					size_t								m_Current;						/* The index of the current block, or m_Blocks.size() when there is none */
+					size_t								m_Size;							/* The size of the decompressed file */
+					size_t								m_Position;						/* The read position in the decompressed file */
+					bool								m_Damaged;						/* True when the file does not end with an intact block */
+
+				public:
+					/// <summary>
+					/// Determines if <paramref name="source"/> contains a compressed binary log file, the read position is moved to the start.
+					/// </summary>
+					/// <param name="source">A reference to the source to check.</param>
+					/// <returns>true when the source starts with a <see cref="::Hindsight::BinaryLog::CompressedFileHeader"/> signature.</returns>
+					static bool IsCompressed(IBinaryLogSource& source);
+
+					/// <summary>
+					/// Read the headers of the compressed binary log file in <paramref name="source"/> and verify its blocks.
+					/// </summary>
+					/// <param name="source">The source of the compressed file, which is owned by this source from now on.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file is not a compressed binary log file, or is too short to contain the file header.</exception>
+					CompressedBinaryLogSource(std::unique_ptr<IBinaryLogSource> source);
+
+					/// <summary>
+					/// Determines if the file was cut short or damaged, in which case only the data of the intact blocks before it can be read.
+					/// </summary>
+					/// <returns>true when the file does not end with an intact block.</returns>
+					bool Damaged() const noexcept;
+
+					/// <summary>
+					/// Determines the size of the decompressed file in bytes.
+					/// </summary>
+					/// <returns>The size of the decompressed file.</returns>
+					size_t Size() const override;
+
+					/// <summary>
+					/// Determines the current read position in the decompressed file.
+					/// </summary>
+					/// <returns>The current read position.</returns>
+					size_t Pos() const override;
+
+					/// <summary>
+					/// Move the read position to an absolute offset in the decompressed file.
+					/// </summary>
+					/// <param name="position">The new read position.</param>
+					void Seek(size_t position) override;
+
+					/// <summary>
+					/// Copy <paramref name="size"/> decompressed bytes into <paramref name="buffer"/> and advance the read position, decompressing 
+					/// blocks as needed.
+					/// </summary>
+					/// <param name="buffer">The buffer to read to, it must point to enough memory to hold <paramref name="size"/> bytes.</param>
+					/// <param name="size">The number of bytes to read.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when reading past the end, or when a block cannot be decompressed.</exception>
+					void Read(char* buffer, size_t size) override;
+
+					/// <summary>
+					/// Obtain a view of <paramref name="size"/> decompressed bytes, which is only possible when they are all in the same block.
+					/// </summary>
+					/// <param name="size">The number of bytes to view.</param>
+					/// <returns>A pointer to the decompressed bytes, which is valid until the next read from the source, or <see langword="nullptr"/>.</returns>
+					/// <exception cref="std::runtime_error">This exception is thrown when a block cannot be decompressed.</exception>
+					const char* View(size_t size) override;
+
+				private:
+					/// <summary>
+					/// Read all block headers and verify the checksum of each block, up to the end of the file or the first damaged block.
+					/// </summary>
+					/// <param name="maxBlockSize">The maximum decompressed size of a block according to the file header.</param>
+					void Scan(size_t maxBlockSize);
+
+					/// <summary>
+					/// Make the block containing the decompressed offset <paramref name="position"/> the current block.
+					/// </summary>
+					/// <param name="position">An offset after the file header.</param>
+					/// <returns>A const reference to the current block.</returns>
+					/// <exception cref="std::runtime_error">This exception is thrown when <paramref name="position"/> is past the end, or when the block cannot be decompressed.</exception>
+					const Block& Load(size_t position);
+			};
+		}
+	}
+
+#endif
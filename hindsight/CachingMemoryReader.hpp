@@ -0,0 +1,258 @@
+#pragma once
+
+#ifndef debugger_caching_memory_reader_h
+#define debugger_caching_memory_reader_h
+	#include "DebugBackend.hpp"
+	#include "LruCache.hpp"
+
+	#include <algorithm>
+	#include <cstdint>
+	#include <cstring>
+	#include <string>
+	#include <utility>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace Backend {
+				/// <summary>
+				/// A memory reader that caches the pages of another reader. Walking remote structures such as the RTTI of a C++
+				/// exception takes many small dependent reads that mostly land on the same few pages, so each page is read from
+				/// the process once and every further read is served from the cache. The pages that a batch misses are merged
+				/// into runs of adjacent pages and read with a single <see cref="IMemoryReader::ReadMany"/> call on the source.
+				/// The cache is only valid while the debugged process is stopped, so a reader should not outlive the event it
+				/// was created for (or be <see cref="Invalidate"/>d when the process is continued). This class does not depend
+				/// on any platform API and is not thread-safe.
+				/// </summary>
+				class CachingMemoryReader : public IMemoryReader {
+					public:
+						/// <summary>
+						/// The size of a cached page.
+						/// </summary>
+						static const size_t PageSize = 4096;
+
+						/// <summary>
+						/// The default maximum number of cached pages.
+						/// </summary>
+						static const size_t DefaultCapacity = 64;
+
+					private:
+						struct Page {
+							std::vector<uint8_t>	Data;		/* The page data */
+							size_t					Valid = 0;	/* The number of readable bytes from the start of the page */
+						};
+
+						const IMemoryReader&						m_Source;	/* The reader that pages are read from */
+						mutable Utilities::LruCache<uint64_t, Page>	m_Pages;	/* The cached pages, by page number */
+						mutable size_t								m_Fetches;	/* The number of batches read from the source */
+
+					public:
+						/// <summary>
+						/// Construct a new, empty, CachingMemoryReader.
+						/// </summary>
+						/// <param name="source">The reader that pages are read from, which must outlive this reader.</param>
+						/// <param name="capacity">The maximum number of cached pages.</param>
+						CachingMemoryReader(const IMemoryReader& source, size_t capacity = DefaultCapacity)
+							: m_Source(source), m_Pages(capacity), m_Fetches(0) {
+
+						}
+
+						CachingMemoryReader(const CachingMemoryReader&) = delete;
+						CachingMemoryReader& operator=(const CachingMemoryReader&) = delete;
+
+						/// <summary>
+						/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the debugged process.
+						/// </summary>
+						/// <param name="address">The address in the debugged process.</param>
+						/// <param name="buffer">The buffer that receives the data.</param>
+						/// <param name="size">The number of bytes to read.</param>
+						/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when part of the range is not readable.</returns>
+						size_t Read(uint64_t address, void* buffer, size_t size) const override {
+							MemoryRange range;
+							range.Address	= address;
+							range.Buffer	= buffer;
+							range.Size		= size;
+
+							ReadMany(&range, 1);
+							return range.Read;
+						}
+
+						/// <summary>
+						/// Read a batch of ranges, with all pages that are not cached yet read from the source in one batch.
+						/// </summary>
+						/// <param name="ranges">The ranges to read, the number of bytes read is stored in each range.</param>
+						/// <param name="count">The number of ranges.</param>
+						void ReadMany(MemoryRange* ranges, size_t count) const override {
+							// the pages that are missing from the cache, in order
+							std::vector<uint64_t> missing;
+							for (size_t i = 0; i < count; ++i) {
+								if (ranges[i].Size == 0)
+									continue;
+
+								auto first = ranges[i].Address / PageSize;
+								auto last = (ranges[i].Address + ranges[i].Size - 1) / PageSize;
+
+								for (auto page = first; page <= last; ++page) {
+									if (m_Pages.Find(page) == nullptr)
+										missing.push_back(page);
+								}
+							}
+
+							std::sort(missing.begin(), missing.end());
+							missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+							auto fetched = Fetch(missing);
+
+							// copy out of the fetched pages first, the cache may evict pages while they are inserted
+							for (size_t i = 0; i < count; ++i) {
+								auto& range = ranges[i];
+								range.Read = 0;
+
+								while (range.Read < range.Size) {
+									auto address = range.Address + range.Read;
+									auto number = address / PageSize;
+									auto offset = static_cast<size_t>(address % PageSize);
+
+									auto it = std::lower_bound(fetched.begin(), fetched.end(), number,
+										[](const std::pair<uint64_t, Page>& entry, uint64_t key) { return entry.first < key; });
+
+									auto page = (it != fetched.end() && it->first == number) ? &it->second : m_Pages.Find(number);
+									if (page == nullptr || page->Valid <= offset)
+										break;
+
+									auto length = page->Valid - offset;
+									if (length > range.Size - range.Read)
+										length = range.Size - range.Read;
+
+									std::memcpy(static_cast<uint8_t*>(range.Buffer) + range.Read, page->Data.data() + offset, length);
+									range.Read += length;
+
+									// a partially readable page ends the range
+									if (page->Valid < PageSize && range.Read < range.Size)
+										break;
+								}
+							}
+
+							for (auto& page : fetched)
+								m_Pages.Put(page.first, std::move(page.second));
+						}
+
+						/// <summary>
+						/// Read a value of type <typeparamref name="TRead"/>.
+						/// </summary>
+						/// <param name="address">The address in the debugged process.</param>
+						/// <param name="out">A reference to a value of type <typeparamref name="TRead"/> where the result is stored.</param>
+						/// <typeparam name="TRead">The type to read.</typeparam>
+						/// <returns>When the whole value was read, true is returned.</returns>
+						template <typename TRead>
+						bool Read(uint64_t address, TRead& out) const {
+							return Read(address, &out, sizeof(TRead)) == sizeof(TRead);
+						}
+
+						/// <summary>
+						/// Read a (c-style) string that is terminated by a \0 character.
+						/// </summary>
+						/// <param name="address">The address in the debugged process.</param>
+						/// <param name="maximumLength">The length in bytes at which the scan stops searching for NUL, or 0 for no limit.</param>
+						/// <returns>The resulting string, or "" when no NUL was found before an unreadable address.</returns>
+						std::string ReadNulTerminatedString(uint64_t address, size_t maximumLength = 0) const {
+							std::string result;
+							char chunk[PageSize];
+
+							while (maximumLength == 0 || result.size() < maximumLength) {
+								// scan up to the end of the page, which is read (and cached) as a whole anyway
+								auto length = PageSize - static_cast<size_t>(address % PageSize);
+								if (maximumLength != 0 && length > maximumLength - result.size())
+									length = maximumLength - result.size();
+
+								auto read = Read(address, chunk, length);
+								auto end = static_cast<const char*>(std::memchr(chunk, 0, read));
+
+								if (end != nullptr)
+									return result.append(chunk, static_cast<size_t>(end - chunk));
+
+								if (read < length)
+									return "";
+
+								result.append(chunk, read);
+								address += read;
+							}
+
+							return result;
+						}
+
+						/// <summary>
+						/// Drop all cached pages, which is required after the debugged process has run.
+						/// </summary>
+						void Invalidate() noexcept {
+							m_Pages.Clear();
+						}
+
+						/// <summary>
+						/// Get the number of batches that were read from the source.
+						/// </summary>
+						/// <returns>The number of batches.</returns>
+						size_t Fetches() const noexcept {
+							return m_Fetches;
+						}
+
+					private:
+						/// <summary>
+						/// Read pages from the source, in one batch of runs of adjacent pages.
+						/// </summary>
+						/// <param name="pages">The page numbers to read, sorted and unique.</param>
+						/// <returns>The pages by page number, sorted.</returns>
+						std::vector<std::pair<uint64_t, Page>> Fetch(const std::vector<uint64_t>& pages) const {
+							std::vector<std::pair<uint64_t, Page>> result;
+							if (pages.empty())
+								return result;
+
+							// merge adjacent pages into runs: first page, number of pages
+							std::vector<std::pair<uint64_t, size_t>> runs;
+							for (auto page : pages) {
+								if (!runs.empty() && runs.back().first + runs.back().second == page)
+									++runs.back().second;
+								else
+									runs.emplace_back(page, 1);
+							}
+
+							std::vector<std::vector<uint8_t>> buffers(runs.size());
+							std::vector<MemoryRange> ranges(runs.size());
+
+							for (size_t i = 0; i < runs.size(); ++i) {
+								buffers[i].resize(runs[i].second * PageSize);
+
+								ranges[i].Address	= runs[i].first * PageSize;
+								ranges[i].Buffer	= buffers[i].data();
+								ranges[i].Size		= buffers[i].size();
+							}
+
+							m_Source.ReadMany(ranges.data(), ranges.size());
+							++m_Fetches;
+
+							for (size_t i = 0; i < runs.size(); ++i) {
+								for (size_t j = 0; j < runs[i].second; ++j) {
+									auto offset = j * PageSize;
+
+									// the pages after the first unreadable one were not attempted, those are not cached
+									if (ranges[i].Read < offset)
+										break;
+
+									Page page;
+									page.Valid = ranges[i].Read - offset;
+									if (page.Valid > PageSize)
+										page.Valid = PageSize;
+
+									page.Data.assign(buffers[i].begin() + offset, buffers[i].begin() + offset + page.Valid);
+									result.emplace_back(runs[i].first + j, std::move(page));
+								}
+							}
+
+							return result;
+						}
+				};
+			}
+		}
+	}
+
+#endif
@@ -0,0 +1,187 @@
+#pragma once
+
+#ifndef debugger_debug_backend_h
+#define debugger_debug_backend_h
+	#include <cstdint>
+	#include <cstddef>
+	#include <string>
+	#include <vector>
+	#include <memory>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace Backend {
+				/// <summary>
+				/// The kind of a <see cref="::Hindsight::Debugger::Backend::BackendEvent"/>, which mirrors the debug events that are
+				/// emitted to an <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/>.
+				/// </summary>
+				enum class BackendEventKind {
+					CreateProcess,	/* the debugged process was created or attached to */
+					CreateThread,	/* a thread was created */
+					ExitThread,		/* a thread has exited */
+					ExitProcess,	/* the debugged process has exited, no further events follow */
+					ModuleLoad,		/* a module was loaded (mapped) */
+					ModuleUnload,	/* a module was unloaded (unmapped) */
+					Breakpoint,		/* a breakpoint was hit */
+					Exception,		/* an exception (or signal) was raised */
+					DebugString		/* the debugged process sent a string to the debugger */
+				};
+
+				/// <summary>
+				/// A platform independent debug event, as produced by an <see cref="::Hindsight::Debugger::Backend::IDebugBackend"/>.
+				/// Only the fields that apply to the kind of event are set.
+				/// </summary>
+				struct BackendEvent {
+					BackendEventKind	Kind = BackendEventKind::Exception;	/* The kind of event. */
+					uint32_t			ProcessId = 0;						/* The ID of the process. */
+					uint32_t			ThreadId = 0;						/* The ID of the thread that caused the event. */
+					uint32_t			Code = 0;							/* The exception code (or signal number) for exceptions, the exit code for exit events. */
+					uint64_t			Address = 0;						/* The address of an exception or breakpoint, or the base address of a module. */
+					uint64_t			Size = 0;							/* The size of a module in memory. */
+					bool				FirstChance = true;					/* Whether the debugged process has not seen the exception yet. */
+					std::string			Path = "";							/* The path of the process image or module, UTF-8 encoded. */
+					std::string			String = "";						/* The debug string, UTF-8 encoded. */
+				};
+
+				/// <summary>
+				/// A module that is loaded in the debugged process.
+				/// </summary>
+				struct BackendModule {
+					uint64_t	Base = 0;	/* The lowest address of the module in memory. */
+					uint64_t	Size = 0;	/* The size of the module in memory, from the lowest to the highest mapped address. */
+					std::string	Path = "";	/* The path of the module, UTF-8 encoded. */
+				};
+
+				/// <summary>
+				/// One range of a batched read, see <see cref="::Hindsight::Debugger::Backend::IMemoryReader::ReadMany"/>.
+				/// </summary>
+				struct MemoryRange {
+					uint64_t	Address = 0;		/* The address in the debugged process. */
+					void*		Buffer = nullptr;	/* The buffer that receives the data. */
+					size_t		Size = 0;			/* The number of bytes to read. */
+					size_t		Read = 0;			/* Receives the number of bytes that were read. */
+				};
+
+				/// <summary>
+				/// Reads memory of the debugged process.
+				/// </summary>
+				class IMemoryReader {
+					public:
+						virtual ~IMemoryReader() {}
+
+						/// <summary>
+						/// Read a batch of ranges in the debugged process. Readers that can gather several ranges in one system call
+						/// override this, the default reads the ranges one by one.
+						/// </summary>
+						/// <param name="ranges">The ranges to read, the number of bytes read is stored in each range.</param>
+						/// <param name="count">The number of ranges.</param>
+						virtual void ReadMany(MemoryRange* ranges, size_t count) const {
+							for (size_t i = 0; i < count; ++i)
+								ranges[i].Read = Read(ranges[i].Address, ranges[i].Buffer, ranges[i].Size);
+						}
+
+						/// <summary>
+						/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the debugged process.
+						/// </summary>
+						/// <param name="address">The address in the debugged process.</param>
+						/// <param name="buffer">The buffer that receives the data.</param>
+						/// <param name="size">The number of bytes to read.</param>
+						/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when part of the range is not readable.</returns>
+						virtual size_t Read(uint64_t address, void* buffer, size_t size) const = 0;
+				};
+
+				/// <summary>
+				/// The registers of a stopped thread, which are needed to walk its stack and are recorded with exceptions.
+				/// </summary>
+				class IRegisterContext {
+					public:
+						virtual ~IRegisterContext() {}
+
+						/// <summary>
+						/// Determine if the thread runs 64-bit code.
+						/// </summary>
+						/// <returns>true for 64-bit code.</returns>
+						virtual bool Is64() const = 0;
+
+						/// <summary>
+						/// Get the program counter (instruction pointer).
+						/// </summary>
+						/// <returns>The address of the current instruction.</returns>
+						virtual uint64_t ProgramCounter() const = 0;
+
+						/// <summary>
+						/// Get the stack pointer.
+						/// </summary>
+						/// <returns>The address of the top of the stack.</returns>
+						virtual uint64_t StackPointer() const = 0;
+
+						/// <summary>
+						/// Get the frame pointer (base pointer).
+						/// </summary>
+						/// <returns>The address of the current stack frame.</returns>
+						virtual uint64_t FramePointer() const = 0;
+
+						/// <summary>
+						/// Get a general purpose register. For x86 the index is the register encoding: rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi
+						/// and r8 to r15 (eax to edi for 32-bit code), on other architectures it is the register number.
+						/// </summary>
+						/// <param name="index">The register index, below 16.</param>
+						/// <returns>The value of the register, or 0 when the architecture has no such register.</returns>
+						virtual uint64_t Register(size_t index) const = 0;
+
+						/// <summary>
+						/// Get the flags register, such as EFLAGS on x86.
+						/// </summary>
+						/// <returns>The flags.</returns>
+						virtual uint64_t Flags() const = 0;
+				};
+
+				/// <summary>
+				/// A debugger backend, the part of the debugger that talks to the operating system: it is the source of debug events,
+				/// reads the memory and registers of the debugged process and enumerates its modules. The debug loop is the same
+				/// for every backend: wait for the next event, inspect the process while it is stopped, emit the event to the
+				/// handlers and continue it.
+				/// </summary>
+				class IDebugBackend : public IMemoryReader {
+					public:
+						virtual ~IDebugBackend() {}
+
+						/// <summary>
+						/// Wait for the next debug event. The process (or at least the thread of the event) is stopped until the
+						/// event is passed to <see cref="Continue"/>.
+						/// </summary>
+						/// <param name="event">A reference to the event that receives the next event.</param>
+						/// <returns>false when the debugging session has ended and no further events will follow.</returns>
+						virtual bool Next(BackendEvent& event) = 0;
+
+						/// <summary>
+						/// Continue after an event that was returned by <see cref="Next"/>.
+						/// </summary>
+						/// <param name="event">A const reference to the event.</param>
+						/// <param name="handled">For exceptions, true suppresses the exception, false passes it on to the debugged process.</param>
+						virtual void Continue(const BackendEvent& event, bool handled) = 0;
+
+						/// <summary>
+						/// Capture the registers of a stopped thread.
+						/// </summary>
+						/// <param name="threadId">The thread ID.</param>
+						/// <returns>The register context, or nullptr when the registers cannot be read.</returns>
+						virtual std::unique_ptr<IRegisterContext> Context(uint32_t threadId) const = 0;
+
+						/// <summary>
+						/// Enumerate the modules that are currently loaded in the debugged process.
+						/// </summary>
+						/// <returns>The modules, ordered by base address.</returns>
+						virtual std::vector<BackendModule> Modules() const = 0;
+
+						/// <summary>
+						/// Get the ID of the debugged process.
+						/// </summary>
+						/// <returns>The process ID.</returns>
+						virtual uint32_t ProcessId() const = 0;
+				};
+			}
+		}
+	}
+
+#endif
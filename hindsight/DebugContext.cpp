@@ -1,7 +1,60 @@
 #include "DebugContext.hpp"
+#include "Process.hpp"
 
 using namespace Hindsight::Debugger;
 
+#ifdef _WIN32
+/// <summary>
+/// The THREAD_BASIC_INFORMATION class of NtQueryInformationThread, which is not declared by the SDK headers.
+/// </summary>
+struct thread_basic_information {
+	LONG		ExitStatus;
+	PVOID		TebBaseAddress;
+	HANDLE		UniqueProcess;
+	HANDLE		UniqueThread;
+	ULONG_PTR	AffinityMask;
+	LONG		Priority;
+	LONG		BasePriority;
+};
+
+using nt_query_information_thread = LONG(NTAPI*)(HANDLE, ULONG, PVOID, ULONG, PULONG);
+
+/// <summary>
+/// Determine the stack base (the highest address) of a thread from its TEB, or from the memory region that contains its stack
+/// pointer when the TEB cannot be read.
+/// </summary>
+/// <param name="hProcess">The process handle.</param>
+/// <param name="hThread">The thread handle.</param>
+/// <param name="wow64">True when the thread runs 32-bit code under WOW64, which has a 32-bit TEB of its own.</param>
+/// <param name="stackPointer">The stack pointer of the thread.</param>
+/// <returns>The stack base, or 0 when it could not be determined.</returns>
+static uint64_t get_stack_base(HANDLE hProcess, HANDLE hThread, bool wow64, uint64_t stackPointer) {
+	static const auto query = reinterpret_cast<nt_query_information_thread>(GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationThread"));
+	thread_basic_information info = { 0 };
+
+	// the NT_TIB starts the TEB and StackBase is its second member, the 32-bit TEB of a WOW64 thread follows its 64-bit TEB
+	if (query != nullptr && query(hThread, 0 /* ThreadBasicInformation */, &info, sizeof(info), nullptr) >= 0 && info.TebBaseAddress != nullptr) {
+		auto teb = reinterpret_cast<uintptr_t>(info.TebBaseAddress);
+
+		if (wow64 && sizeof(void*) == 8) {
+			uint32_t base = 0;
+			if (ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(teb + 0x2000 + 4), &base, sizeof(base), nullptr) && base > stackPointer)
+				return base;
+		} else {
+			ULONG_PTR base = 0;
+			if (ReadProcessMemory(hProcess, reinterpret_cast<LPCVOID>(teb + sizeof(void*)), &base, sizeof(base), nullptr) && base > stackPointer)
+				return base;
+		}
+	}
+
+	// the committed part of the stack is a single region that ends at the stack base
+	MEMORY_BASIC_INFORMATION region = { 0 };
+	if (VirtualQueryEx(hProcess, reinterpret_cast<LPCVOID>(static_cast<uintptr_t>(stackPointer)), &region, sizeof(region)) == 0 || region.State != MEM_COMMIT)
+		return 0;
+
+	return reinterpret_cast<uintptr_t>(region.BaseAddress) + region.RegionSize;
+}
+
 /// <summary>
 /// Construct a new DebugContext instance based on process handle and thread handle, these handles
 /// must be opened with all access. This overload will fetch the thread context based on what mode 
@@ -54,6 +107,7 @@ DebugContext::DebugContext(HANDLE hProcess, HANDLE hThread, const WOW64_CONTEXT&
 
 	X86 = ctx;
 }
+#endif
 
 /// <summary>
 /// Construct a new DebugContext instance based on a <see cref="PROCESS_INFORMATION"/> struct instance and 
@@ -137,3 +191,61 @@ const HANDLE DebugContext::GetProcess() const {
 const HANDLE DebugContext::GetThread() const {
 	return hThread;
 }
+
+#ifdef _WIN32
+/// <summary>
+/// Capture the stack of the thread in a single read of the process, from the stack pointer of this context up to the
+/// stack base in the TEB, but no more than <paramref name="maximum"/> bytes. The stack can then be unwound and scanned
+/// without reading the process again, and it is stored with the exception in a binary log for use at replay.
+/// </summary>
+/// <param name="maximum">The maximum number of bytes to capture.</param>
+/// <returns>true when (part of) the stack was captured.</returns>
+bool DebugContext::CaptureStack(size_t maximum) {
+#ifdef _WIN64
+	uint64_t stackPointer = IsWow64 ? X86.Esp : X64.Rsp;
+#else
+	uint64_t stackPointer = X86.Esp;
+#endif
+
+	Stack.clear();
+	StackAddress = stackPointer;
+
+	auto base = get_stack_base(hProcess, hThread, IsWow64 != FALSE, stackPointer);
+	if (base <= stackPointer || maximum == 0)
+		return false;
+
+	Stack.resize(base - stackPointer < maximum ? static_cast<size_t>(base - stackPointer) : maximum);
+
+	// one ReadProcessMemory call, the reader only falls back to reading page by page when part of the range is not readable
+	Hindsight::Process::ProcessMemoryReader memory(hProcess);
+	Stack.resize(memory.Read(stackPointer, Stack.data(), Stack.size()));
+
+	return !Stack.empty();
+}
+#endif
+
+/// <summary>
+/// Set the stack snapshot of this context, such as one that was read from a binary log.
+/// </summary>
+/// <param name="address">The address of the snapshot in the process.</param>
+/// <param name="stack">The snapshot.</param>
+void DebugContext::SetStack(uint64_t address, std::vector<uint8_t> stack) {
+	StackAddress = address;
+	Stack		 = std::move(stack);
+}
+
+/// <summary>
+/// Get the address of the stack snapshot in the process, which is the stack pointer at the time it was captured.
+/// </summary>
+/// <returns>The address of the stack snapshot.</returns>
+uint64_t DebugContext::GetStackAddress() const noexcept {
+	return StackAddress;
+}
+
+/// <summary>
+/// Get the stack snapshot, see <see cref="CaptureStack"/>.
+/// </summary>
+/// <returns>A const reference to the snapshot, which is empty when none was captured.</returns>
+const std::vector<uint8_t>& DebugContext::GetStack() const noexcept {
+	return Stack;
+}
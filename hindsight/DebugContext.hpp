@@ -2,8 +2,10 @@
 
 #ifndef debugger_debug_context_h
 #define debugger_debug_context_h
-	#include <Windows.h>
-	#include <DbgHelp.h>
+	#include "Win32Types.hpp"
+
+	#include <cstdint>
+	#include <vector>
 
 	namespace Hindsight {
 		namespace Debugger {
@@ -21,10 +23,14 @@
 						WOW64_CONTEXT	X86;
 					};
 
+					uint64_t				StackAddress = 0;	/* The address of the stack snapshot, which is the stack pointer of the context */
+					std::vector<uint8_t>	Stack;				/* The stack snapshot, from the stack pointer up, or empty when none was captured */
+
 				public:
 					const HANDLE hProcess;
 					const HANDLE hThread;
 
+#ifdef _WIN32
 					/// <summary>
 					/// Construct a new DebugContext instance based on process handle and thread handle, these handles
 					/// must be opened with all access. This overload will fetch the thread context based on what mode 
@@ -53,6 +59,7 @@
 					/// <param name="hThread">The thread handle that the <paramref name="ctx"/> belongs to.</param>
 					/// <param name="ctx">The thread context.</param>
 					DebugContext(HANDLE hProcess, HANDLE hThread, const WOW64_CONTEXT& ctx);
+#endif
 
 					/// <summary>
 					/// Construct a new DebugContext instance based on a <see cref="PROCESS_INFORMATION"/> struct instance and 
@@ -115,6 +122,36 @@
 					/// </summary>
 					/// <returns>A thread handle, this handle will be closed by the debugger after processing an event.</returns>
 					const HANDLE GetThread() const;
+
+#ifdef _WIN32
+					/// <summary>
+					/// Capture the stack of the thread in a single read of the process, from the stack pointer of this context up to the
+					/// stack base in the TEB, but no more than <paramref name="maximum"/> bytes. The stack can then be unwound and scanned
+					/// without reading the process again, and it is stored with the exception in a binary log for use at replay.
+					/// </summary>
+					/// <param name="maximum">The maximum number of bytes to capture.</param>
+					/// <returns>true when (part of) the stack was captured.</returns>
+					bool CaptureStack(size_t maximum);
+#endif
+
+					/// <summary>
+					/// Set the stack snapshot of this context, such as one that was read from a binary log.
+					/// </summary>
+					/// <param name="address">The address of the snapshot in the process.</param>
+					/// <param name="stack">The snapshot.</param>
+					void SetStack(uint64_t address, std::vector<uint8_t> stack);
+
+					/// <summary>
+					/// Get the address of the stack snapshot in the process, which is the stack pointer at the time it was captured.
+					/// </summary>
+					/// <returns>The address of the stack snapshot.</returns>
+					uint64_t GetStackAddress() const noexcept;
+
+					/// <summary>
+					/// Get the stack snapshot, see <see cref="CaptureStack"/>.
+					/// </summary>
+					/// <returns>A const reference to the snapshot, which is empty when none was captured.</returns>
+					const std::vector<uint8_t>& GetStack() const noexcept;
 			};
 
 		}
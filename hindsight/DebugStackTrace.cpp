@@ -1,11 +1,76 @@
 #include "DebugStackTrace.hpp"
+#include "RecursionDetector.hpp"
+#include "SnapshotMemoryReader.hpp"
+#ifdef _WIN32
+#include "Process.hpp"
 #include <Windows.h>
 #include <DbgHelp.h>
 #include <Psapi.h>
 #include <distorm.h>
+#endif
 
 using namespace Hindsight::Debugger;
 
+#ifdef _WIN32
+static const size_t stack_window = 64 * 1024;	/* The number of bytes of the stack that are read in one go when the context has no snapshot */
+
+/// <summary>
+/// The memory that <see cref="read_walk_memory"/> serves to StackWalk64, only set while a stack is walked on this thread.
+/// </summary>
+static thread_local const Backend::IMemoryReader* walk_memory = nullptr;
+
+/// <summary>
+/// The ReadMemoryRoutine of StackWalk64, which reads the stack from the copy of the walk instead of from the process.
+/// </summary>
+/// <param name="hProcess">The process handle, which is not used.</param>
+/// <param name="address">The address to read.</param>
+/// <param name="buffer">The buffer that receives the data.</param>
+/// <param name="size">The number of bytes to read.</param>
+/// <param name="read">A pointer that receives the number of bytes that were read.</param>
+/// <returns>TRUE when all bytes were read, like ReadProcessMemory.</returns>
+static BOOL CALLBACK read_walk_memory(HANDLE hProcess, DWORD64 address, PVOID buffer, DWORD size, LPDWORD read) {
+	auto count = walk_memory->Read(address, buffer, size);
+	if (read != nullptr)
+		*read = static_cast<DWORD>(count);
+
+	return count == size;
+}
+
+#ifdef _WIN64
+
+/// <summary>
+/// The integer registers of a 64-bit context, in the encoding order of <see cref="::Hindsight::Debugger::X64UnwindContext::Registers"/>.
+/// </summary>
+static DWORD64 CONTEXT::* const context_registers[16] = {
+	&CONTEXT::Rax, &CONTEXT::Rcx, &CONTEXT::Rdx, &CONTEXT::Rbx, &CONTEXT::Rsp, &CONTEXT::Rbp, &CONTEXT::Rsi, &CONTEXT::Rdi,
+	&CONTEXT::R8, &CONTEXT::R9, &CONTEXT::R10, &CONTEXT::R11, &CONTEXT::R12, &CONTEXT::R13, &CONTEXT::R14, &CONTEXT::R15
+};
+#endif
+#endif
+
+/// <summary>
+/// Compare two keys for equality.
+/// </summary>
+/// <param name="other">The key to compare to.</param>
+/// <returns>true when both keys identify the same block.</returns>
+bool DisassemblyKey::operator==(const DisassemblyKey& other) const noexcept {
+	return Module == other.Module && Offset == other.Offset && Length == other.Length && Count == other.Count && Is64 == other.Is64;
+}
+
+/// <summary>
+/// Compute the hash of a key.
+/// </summary>
+/// <param name="key">The key to hash.</param>
+/// <returns>The hash of <paramref name="key"/>.</returns>
+size_t DisassemblyKeyHash::operator()(const DisassemblyKey& key) const noexcept {
+	// the module base and offset are what tell blocks apart, the other members rarely differ
+	auto hash = std::hash<const void*>()(key.Module);
+	hash ^= std::hash<size_t>()(key.Offset) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<size_t>()((key.Length << 1) | (key.Is64 ? 1 : 0)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+#ifdef _WIN32
 /// <summary>
 /// Construct a new DebugStackTrace based on a thread context, module collection and symbol search path.
 /// </summary>
@@ -22,26 +87,39 @@ DebugStackTrace::DebugStackTrace(
 	size_t max_instruction)
 	: m_Context(context), m_Modules(collection), m_MaxRecursion(max_recursion), m_MaxInstruction(max_instruction) {
 
-	// Set the options for DbgHelp to determine how exactly it should resolve symbols.
-	SymSetOptions(
-		SYMOPT_ALLOW_ABSOLUTE_SYMBOLS | 
-		SYMOPT_DEFERRED_LOADS |
-		SYMOPT_INCLUDE_32BIT_MODULES |
-		SYMOPT_LOAD_LINES |
-		SYMOPT_UNDNAME
-	);
-
-	// If a search path is provided, pass it on to SymInitialize
-	const char* path = nullptr;
-	if (!searchPath.empty())
-		path = searchPath.c_str();
-
-	// Initialize DbgHelp's symbol engine.
-	SymInitialize(context->GetProcess(), path, true);
+	// A session for just this trace, which has to enumerate all modules of the process.
+	SymbolSession session(context->GetProcess(), searchPath, true);
+
+	m_Session = &session;
 	Walk(); /* walk the stack */
+	m_Session = nullptr;
+}
 
-	// Cleanup
-	SymCleanup(context->GetProcess());
+/// <summary>
+/// Construct a new DebugStackTrace based on a thread context, module collection and a symbol session that outlives
+/// this trace. Unlike the constructors that take a search path, this does not initialize the symbol engine for 
+/// each trace and addresses that were resolved for earlier traces are not looked up again.
+/// </summary>
+/// <param name="context">A shared pointer to an instance of <see cref="::Hindsight::Debugger::DebugContext"/>, this context specifies where the trace starts.</param>
+/// <param name="collection">A const reference to an instance of <see cref="::Hindsight::Debugger::ModuleCollection"/> containing all the loaded modules at the time of the trace.</param>
+/// <param name="session">The symbol session of the debugged process.</param>
+/// <param name="max_recursion">The maximum number of recursive calls to show in a trace before cutting it.</param>
+/// <param name="max_instruction">The maximum number of instructions to disassemble at the program count addresses of each trace frame.</param>
+/// <param name="disassembly">An optional cache of disassembled instructions that outlives this trace.</param>
+/// <param name="symbolize">When false, the frames are not resolved and only their module and address are recorded, to be symbolized at replay.</param>
+DebugStackTrace::DebugStackTrace(
+	std::shared_ptr<const DebugContext> context, 
+	const ModuleCollection& collection, 
+	SymbolSession& session,
+	size_t max_recursion,
+	size_t max_instruction,
+	DisassemblyCache* disassembly,
+	bool symbolize)
+	: m_Context(context), m_Modules(collection), m_MaxRecursion(max_recursion), m_MaxInstruction(max_instruction), m_Session(&session), m_Disassembly(disassembly), m_Symbolize(symbolize) {
+
+	Walk(); /* walk the stack */
+	m_Session	  = nullptr;
+	m_Disassembly = nullptr;
 }
 
 /// <summary>
@@ -59,21 +137,22 @@ DebugStackTrace::DebugStackTrace(
 	: DebugStackTrace(context, collection, "", max_recursion, max_instruction) {
 
 }
+#endif
 
 /// <summary>
 /// Construct a new DebugStackTrace based on a context, module collection and a concrete stack trace read from a binary log file.
 /// </summary>
 /// <param name="context">A shared pointer to an instance of <see cref="::Hindsight::Debugger::DebugContext"/>, this context specifies where the trace starts.</param>
 /// <param name="collection">A const reference to an instance of <see cref="::Hindsight::Debugger::ModuleCollection"/> containing all the loaded modules at the time of the trace.</param>
-/// <param name="trace">A const reference to an instance of <see cref="::Hindsight::BinaryLog::StackTraceConcrete"/> containing the full stack trace that needs to be converted.</param>
+/// <param name="trace">An rvalue reference to an instance of <see cref="::Hindsight::BinaryLog::StackTraceConcrete"/> containing the full stack trace that needs to be converted, its strings are moved into this trace.</param>
 DebugStackTrace::DebugStackTrace(
 	std::shared_ptr<const DebugContext> context,
 	const ModuleCollection& collection,
-	const Hindsight::BinaryLog::StackTraceConcrete& trace)
+	Hindsight::BinaryLog::StackTraceConcrete&& trace)
 	: m_Context(context), m_Modules(collection), m_MaxRecursion(trace.MaxRecursion), m_MaxInstruction(trace.MaxInstructions) {
 
 	// Iterate over every concrete StackTraceEntryConcrete instance
-	for (const auto& entryConcrete : trace.Entries) {
+	for (auto& entryConcrete : trace.Entries) {
 		// Create a new stack trace entry and work with its reference
 		auto& entry = m_Trace.emplace_back(); 
 
@@ -89,14 +168,14 @@ DebugStackTrace::DebugStackTrace(
 		entry.AbsoluteAddress		= reinterpret_cast<void*>(entryConcrete.AbsoluteAddress);
 		entry.AbsoluteLineAddress	= reinterpret_cast<void*>(entryConcrete.AbsoluteLineAddress);
 		entry.LineAddress			= reinterpret_cast<void*>(entryConcrete.LineAddress);
-		entry.Name					= entryConcrete.Name;
-		entry.File					= entryConcrete.Path;
+		entry.Name					= std::move(entryConcrete.Name);
+		entry.File					= std::move(entryConcrete.Path);
 		entry.Line					= static_cast<uint32_t>(entryConcrete.LineNumber);
 		entry.Recursion				= entryConcrete.IsRecursion;
 		entry.RecursionCount		= entryConcrete.RecursionCount;
 
 		// Iterate over all disassembled instructions, if any.
-		for (const auto& instructionConcrete : entryConcrete.Instructions) {
+		for (auto& instructionConcrete : entryConcrete.Instructions) {
 			// Create a new instruction entry in place and work with its reference.
 			auto& instruction = entry.Instructions.emplace_back();
 
@@ -104,13 +183,51 @@ DebugStackTrace::DebugStackTrace(
 			instruction.Is64BitAddress		= instructionConcrete.Is64BitAddress;
 			instruction.Offset				= instructionConcrete.Offset;
 			instruction.Size				= instructionConcrete.Size;
-			instruction.InstructionHex		= instructionConcrete.Hex;
-			instruction.InstructionMnemonic = instructionConcrete.Mnemonic;
-			instruction.Operands			= instructionConcrete.Operands;
+			instruction.InstructionHex		= std::move(instructionConcrete.Hex);
+			instruction.InstructionMnemonic = std::move(instructionConcrete.Mnemonic);
+			instruction.Operands			= std::move(instructionConcrete.Operands);
 		}
 	}
 }
 
+#ifdef _WIN32
+/// <summary>
+/// Walk the stack again, starting from another thread context, and replace the frames of this trace. The entries of
+/// the previous walk are recycled, so their strings and instruction vectors are overwritten in place rather than
+/// freed and allocated again. This may only be done when no one else holds a reference to this trace.
+/// </summary>
+/// <param name="context">A shared pointer to an instance of <see cref="::Hindsight::Debugger::DebugContext"/>, this context specifies where the trace starts.</param>
+/// <param name="session">The symbol session of the debugged process.</param>
+/// <param name="max_recursion">The maximum number of recursive calls to show in a trace before cutting it.</param>
+/// <param name="max_instruction">The maximum number of instructions to disassemble at the program count addresses of each trace frame.</param>
+/// <param name="disassembly">An optional cache of disassembled instructions that outlives this trace.</param>
+/// <param name="symbolize">When false, the frames are not resolved and only their module and address are recorded, to be symbolized at replay.</param>
+void DebugStackTrace::Reset(
+	std::shared_ptr<const DebugContext> context,
+	SymbolSession& session,
+	size_t max_recursion,
+	size_t max_instruction,
+	DisassemblyCache* disassembly,
+	bool symbolize) {
+
+	// moving an entry only moves the pointers of its strings and vectors, and both vectors keep their capacity
+	for (auto& entry : m_Trace)
+		m_Spare.push_back(std::move(entry));
+	m_Trace.clear();
+
+	m_Context		 = context;
+	m_MaxRecursion	 = max_recursion;
+	m_MaxInstruction = max_instruction;
+	m_Session		 = &session;
+	m_Disassembly	 = disassembly;
+	m_Symbolize		 = symbolize;
+
+	Walk(); /* walk the stack */
+	m_Session	  = nullptr;
+	m_Disassembly = nullptr;
+}
+#endif
+
 /// <summary>
 /// Count the number of frames in this stack trace.
 /// </summary>
@@ -143,15 +260,21 @@ const size_t& DebugStackTrace::GetMaxInstructions() const {
 	return m_MaxInstruction;
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Walk the stack.
 /// </summary>
 void DebugStackTrace::Walk() {
 	STACKFRAME64 frame = { 0 };						/* The StackWalk64 frame result */
-	std::vector<STACKFRAME64> recursion_backlog;	/* The recursion backlog, used for detecting the maximum recursion (direct recursion). */
 	LPVOID lpContext;								/* A pointer to the thread context to fetch the trace for. */
 	DWORD machineType;								/* The machine type of this trace. */
 
+	// collapses direct and mutual recursion, only the frames that it passes on are resolved
+	RecursionDetector<STACKFRAME64> recursion(
+		[this](const STACKFRAME64& recursive) { AddFrame(recursive); },
+		[this](size_t skipped) { AddRecursion(skipped); },
+		m_MaxRecursion);
+
 	union {
 		CONTEXT			x64;
 		WOW64_CONTEXT	x86;
@@ -187,16 +310,65 @@ void DebugStackTrace::Walk() {
 	}
 #endif 
 
+	// if recursion is not allowed, limit the call stack, otherwise add the frames regularly
+	auto add = [this, &recursion](const STACKFRAME64& next) {
+		if (m_MaxRecursion != SIZE_MAX)
+			recursion.Push(next, next.AddrPC.Offset);
+		else
+			AddFrame(next);
+	};
+
+	// the stack is read once, as the snapshot that was captured with the context or else as a window from the stack pointer up,
+	// and both the unwinder and StackWalk64 read from that copy
+	Hindsight::Process::ProcessMemoryReader process(m_Session->GetProcess());
+	const auto& snapshot = m_Context->GetStack();
+
+	if (snapshot.empty()) {
+		m_Stack.resize(stack_window);
+		m_Stack.resize(process.Read(frame.AddrStack.Offset, m_Stack.data(), m_Stack.size()));
+	}
+
+	Backend::SnapshotMemoryReader memory(
+		snapshot.empty() ? frame.AddrStack.Offset : m_Context->GetStackAddress(),
+		snapshot.empty() ? m_Stack.data() : snapshot.data(),
+		snapshot.empty() ? m_Stack.size() : snapshot.size(),
+		&process);
+
+#ifdef _WIN64
+	// the unwind tables cover most 64-bit frames, StackWalk64 continues from the first frame that they do not cover
+	if (m_Context->Is64()) {
+		auto complete = UnwindTables(context.x64, memory);
+
+		for (const auto& unwound : m_Unwound)
+			add(unwound);
+
+		if (complete) {
+			recursion.Flush();
+			return;
+		}
+
+		frame = { 0 };
+		frame.AddrPC.Offset		= context.x64.Rip;
+		frame.AddrPC.Mode		= AddrModeFlat;
+		frame.AddrFrame.Offset	= context.x64.Rbp;
+		frame.AddrFrame.Mode	= AddrModeFlat;
+		frame.AddrStack.Offset	= context.x64.Rsp;
+		frame.AddrStack.Mode	= AddrModeFlat;
+	}
+#endif
+
+	walk_memory = &memory;
+
 	// Walk the stack, stop only when a next frame is not available.
 	for (int frameNumber = 0;; ++frameNumber) {
 		// get the next stack frame
 		auto result = StackWalk64(
 			machineType,
-			m_Context->GetProcess(),
+			m_Session->GetProcess(), /* the handle the symbol engine was initialized with */
 			m_Context->GetThread(),
 			&frame,
 			lpContext,
-			nullptr,
+			read_walk_memory,
 			SymFunctionTableAccess64,
 			SymGetModuleBase64,
 			nullptr);
@@ -204,76 +376,159 @@ void DebugStackTrace::Walk() {
 		if (!result)
 			break;
 
-		// if recursion is not allowed, limit the call stack
-		if (m_MaxRecursion != SIZE_MAX) {
-			// detect recursive calls, this must be a finite stack we can unwind. Stacks are not infinite.
-			if (frame.AddrPC.Offset == frame.AddrReturn.Offset) {
-				// backlog this frame, we might want to show them all
-				recursion_backlog.push_back(frame);
-				continue;
-			} 
-			
-			// this wasn't a recursive call, but we do have a recursion backlog.
-			else if (!recursion_backlog.empty()) {
-				// if the backlog is larger than the max recursion setting, add a recursion frame and the last frame.
-				if (recursion_backlog.size() >= m_MaxRecursion) {
-					AddRecursion(recursion_backlog);
-				} 
-				
-				// the backlog is not too large, just add all the frames from the backlog.
-				else {
-					for (const auto& backlog_frame : recursion_backlog) 
-						AddFrame(backlog_frame);
-				}
-
-				// clear the backlog and continue
-				recursion_backlog.clear();
-				continue;
-			}
+		add(frame);
+	}
+
+	walk_memory = nullptr;
+	recursion.Flush();
+}
+
+#ifdef _WIN64
+/// <summary>
+/// Unwind a 64-bit stack with the unwind tables of the loaded modules into <see cref="m_Unwound"/>, for as long as
+/// the tables cover the frames. With the stack read in one go, most frames cost no call into the process or DbgHelp
+/// at all.
+/// </summary>
+/// <param name="context">A reference to the context of the first frame, which receives the registers of the first frame that could not be unwound.</param>
+/// <param name="memory">The memory of the process, with the stack served from a copy.</param>
+/// <returns>true when the whole stack was unwound, false when StackWalk64 has to continue from <paramref name="context"/>.</returns>
+bool DebugStackTrace::UnwindTables(CONTEXT& context, const Backend::IMemoryReader& memory) {
+	m_Unwound.clear();
+
+	X64UnwindContext unwind;
+	unwind.Rip = context.Rip;
+	for (size_t i = 0; i < 16; ++i)
+		unwind.Registers[i] = context.*context_registers[i];
+
+	// the return address of the last frame is 0
+	while (unwind.Rip != 0) {
+		// a return address may be the first byte after the module, when its last function does not return
+		auto address = unwind.Interrupted ? unwind.Rip : unwind.Rip - 1;
+		auto module = m_Modules.GetModuleAtAddress(reinterpret_cast<void*>(address));
+		auto table = module != nullptr ? m_Modules.GetUnwindTable(module->Base, memory) : nullptr;
+
+		auto next = unwind;
+		if (table == nullptr || !table->Unwind(memory, next)) {
+			context.Rip = unwind.Rip;
+			for (size_t i = 0; i < 16; ++i)
+				context.*context_registers[i] = unwind.Registers[i];
+
+			return false;
 		}
 
-		// add the frame regularly
-		AddFrame(frame);
+		STACKFRAME64 frame = { 0 };
+		frame.AddrPC.Offset		= unwind.Rip;
+		frame.AddrPC.Mode		= AddrModeFlat;
+		frame.AddrFrame.Offset	= unwind.Registers[X64UnwindContext::Rbp];
+		frame.AddrFrame.Mode	= AddrModeFlat;
+		frame.AddrStack.Offset	= unwind.Registers[X64UnwindContext::Rsp];
+		frame.AddrStack.Mode	= AddrModeFlat;
+		frame.AddrReturn.Offset	= next.Rip;
+		frame.AddrReturn.Mode	= AddrModeFlat;
+		m_Unwound.push_back(frame);
+
+		// every caller has its frame above that of its callee, anything else is a corrupted stack that would not end
+		if (next.Registers[X64UnwindContext::Rsp] <= unwind.Registers[X64UnwindContext::Rsp])
+			break;
+
+		unwind = next;
 	}
+
+	return true;
 }
+#endif
 
 /// <summary>
-/// Disassemble the instructions at the PC address of a certain stack frame.
+/// Add an entry to the end of the trace, which is a recycled entry when one is available. All fields of the entry are
+/// reset, except for its instructions, which are overwritten by <see cref="DisassembleFrame"/> or cleared by the caller.
+/// </summary>
+/// <returns>A reference to the new entry.</returns>
+DebugStackTraceEntry& DebugStackTrace::NextEntry() {
+	if (m_Spare.empty())
+		return m_Trace.emplace_back();
+
+	auto& entry = m_Trace.emplace_back(std::move(m_Spare.back()));
+	m_Spare.pop_back();
+
+	// clear() keeps the capacity of the strings, so assigning to them later does not allocate
+	entry.Module.Base		  = nullptr;
+	entry.Module.Size		  = 0;
+	entry.Module.Path.clear();
+	entry.ModuleBase		  = nullptr;
+	entry.Address			  = nullptr;
+	entry.AbsoluteAddress	  = nullptr;
+	entry.AbsoluteLineAddress = nullptr;
+	entry.LineAddress		  = nullptr;
+	entry.Name.clear();
+	entry.File.clear();
+	entry.Line				  = 0;
+	entry.Recursion			  = false;
+	entry.RecursionCount	  = 0;
+
+	return entry;
+}
+
+/// <summary>
+/// Disassemble the instructions at the PC address of a certain stack frame. When a disassembly cache is available and 
+/// the address is in a loaded module, the cached instructions are used if present.
 /// </summary>
 /// <param name="frame">A const reference to the <see cref="STACKFRAME64"/> instance with information about the address to disassemble.</param>
-/// <param name="symbol">A const reference to the <see cref="SYMBOL_INFO"/> instance with information about the symbol at the address.</param>
+/// <param name="symbolSize">The size of the symbol at the address, or 0 when unknown.</param>
 /// <param name="entry">A reference to the <see cref="::Hindsight::Debugger::DebugStackTraceEntry"/> to fill with information about the disassembled code.</param>
-void DebugStackTrace::DisassembleFrame(const STACKFRAME64& frame, const SYMBOL_INFO& symbol, DebugStackTraceEntry& entry) {
+void DebugStackTrace::DisassembleFrame(const STACKFRAME64& frame, size_t symbolSize, DebugStackTraceEntry& entry) {
 	const size_t maxInstructions = m_MaxInstruction;
-	const size_t symbolSize		 = (symbol.Size != 0 ? symbol.Size : 30);
+	symbolSize = (symbolSize != 0 ? symbolSize : 30);
 	SIZE_T read = 0;
 
+	// Only code in loaded modules is cached, anything else (such as JIT compiled code) may change between traces.
+	const Module* module = nullptr;
+	DisassemblyKey key;
+
+	if (m_Disassembly != nullptr)
+		module = m_Modules.GetModuleAtAddress(reinterpret_cast<const void*>(frame.AddrPC.Offset));
+
+	if (module != nullptr) {
+		key.Module = module->Base;
+		key.Offset = static_cast<size_t>(frame.AddrPC.Offset - reinterpret_cast<DWORD64>(module->Base));
+		key.Length = symbolSize;
+		key.Count  = maxInstructions;
+		key.Is64   = m_Context->Is64();
+
+		if (auto cached = m_Disassembly->Find(key)) {
+			entry.Instructions = *cached; /* copy assignment reuses the strings of a recycled entry */
+			return;
+		}
+	}
+
 	#pragma warning ( push )
 	#pragma warning ( disable: 26812 ) /* unscoped enum complaint, third party code, ignore warning */
 	_OffsetType					offset = frame.AddrPC.Offset;
 	std::vector<_DecodedInst>	instructions(maxInstructions);
-	std::vector<char>			code(symbolSize);
 	uint32_t					instructionCount; 
 	_DecodeType					dt = (m_Context->Is64() ? _DecodeType::Decode64Bits : _DecodeType::Decode32Bits);
 	#pragma warning ( pop )
 
-	if (!ReadProcessMemory(m_Context->GetProcess(), reinterpret_cast<LPCVOID>(frame.AddrPC.Offset), reinterpret_cast<LPVOID>(&code[0]), symbolSize, &read) && read == 0)
+	m_Code.resize(symbolSize);
+
+	if (!ReadProcessMemory(m_Context->GetProcess(), reinterpret_cast<LPCVOID>(frame.AddrPC.Offset), reinterpret_cast<LPVOID>(&m_Code[0]), symbolSize, &read) && read == 0) {
+		entry.Instructions.clear();
 		return;
+	}
 
 	// Disassemble, we're going to ignore the result as it does not indicate nothing was decoded.
 	static_cast<void>(distorm_decode(
 		offset, 
-		reinterpret_cast<const unsigned char*>(&code[0]), 
+		reinterpret_cast<const unsigned char*>(&m_Code[0]), 
 		static_cast<int>(read),
 		dt, 
 		&instructions[0], 
 		static_cast<unsigned int>(maxInstructions), 
 		&instructionCount));
 
-	// Process disassembled instructions
+	// Process disassembled instructions, the instructions of a recycled entry are overwritten in place
+	entry.Instructions.resize(instructionCount);
 	for (uint32_t i = 0; i < instructionCount; i++) {
-		// Create a new DebugStackTraceInstruction instance in place and work with the reference
-		auto& instruction = entry.Instructions.emplace_back();
+		auto& instruction = entry.Instructions[i];
 
 		instruction.Is64BitAddress		= (dt == _DecodeType::Decode64Bits);
 		instruction.Offset				= instructions[i].offset;
@@ -282,78 +537,90 @@ void DebugStackTrace::DisassembleFrame(const STACKFRAME64& frame, const SYMBOL_I
 		instruction.InstructionMnemonic = reinterpret_cast<char*>(instructions[i].mnemonic.p);
 		instruction.Operands			= reinterpret_cast<char*>(instructions[i].operands.p);
 	}
+
+	if (module != nullptr)
+		m_Disassembly->Put(key, entry.Instructions);
 }
 
 /// <summary>
 /// Process a <see cref="StalkWalk64"/> frame for symbol names, source files and line numbers and add the results to the stack trace. 
-/// This method optionally disassembles instructions from the stack frame as well.
+/// This method optionally disassembles instructions from the stack frame as well. When symbols are not resolved, only the module 
+/// that contains the frame address is looked up.
 /// </summary>
 /// <param name="frame">A const reference to a <see cref="STACKFRAME64"/> instance containing address information about the frame.</param>
 void DebugStackTrace::AddFrame(const STACKFRAME64& frame) {
-	DWORD64 dwSymbolDisplacement;
-	DWORD   dwLineDisplacement;
+	auto address = frame.AddrPC.Offset;
+	auto& entry  = NextEntry(); /* create new stack trace entry and work with its reference */
 
-	// Reserve enough bytes of memory to hold the SYMBOL_INFO struct and the symbol name
-	uint8_t symbol[sizeof(SYMBOL_INFO) + MAX_SYM_NAME] = {};
+	entry.Address = reinterpret_cast<void*>(address);
 
-	auto pSymbol = reinterpret_cast<PSYMBOL_INFO>(symbol);
-	auto address = frame.AddrPC.Offset;
-	auto& entry  = m_Trace.emplace_back(); /* create new stack trace entry and work with its reference */
+	// Raw frames only need their module, the offset into it is resolved at replay through the identity of the module.
+	if (!m_Symbolize) {
+		auto module = m_Modules.GetModuleAtAddress(reinterpret_cast<const void*>(address));
+
+		if (module != nullptr) {
+			entry.Module	 = *module;
+			entry.ModuleBase = module->Base;
+		}
+
+		if (m_MaxInstruction != 0)
+			DisassembleFrame(frame, 0, entry);
+		else
+			entry.Instructions.clear();
 
-	pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
-	pSymbol->MaxNameLen   = MAX_SYM_NAME;
-	entry.Address         = reinterpret_cast<void*>(address);
+		return;
+	}
+
+	// Get symbol information (name, which module it came from, addresses) and the line association, which is an approximation
+	const auto& resolved = m_Session->Resolve(address);
 
-	// Get symbol information (name, which module it came from, addresses)
-	if (SymFromAddr(m_Context->GetProcess(), address, &dwSymbolDisplacement, pSymbol)) {
+	if (resolved.HasSymbol) {
 		// Try to find the loaded module this address belongs to.
-		auto module = m_Modules.GetModuleAtAddress(reinterpret_cast<const void*>(pSymbol->Address)); 
+		auto module = m_Modules.GetModuleAtAddress(reinterpret_cast<const void*>(resolved.SymbolAddress)); 
 
 		if (module != nullptr) {
 			entry.Module = *module;
 
-			if (!pSymbol->ModBase) {
+			if (!resolved.ModuleBase) {
 				entry.ModuleBase = reinterpret_cast<void*>(module->Base);
 			} else {
-				entry.ModuleBase = reinterpret_cast<void*>(pSymbol->ModBase);
+				entry.ModuleBase = reinterpret_cast<void*>(resolved.ModuleBase);
 			}
 		} else {
-			entry.ModuleBase = reinterpret_cast<void*>(pSymbol->ModBase);
+			entry.ModuleBase = reinterpret_cast<void*>(resolved.ModuleBase);
 		}
 
-		entry.AbsoluteAddress = reinterpret_cast<void*>(address + dwSymbolDisplacement);
-		entry.Name			  = "";
+		entry.AbsoluteAddress = reinterpret_cast<void*>(address + resolved.Displacement);
+		entry.Name			  = resolved.Name;
+	}
 
-		if (pSymbol->NameLen) /* convert the name to an std::string */
-			entry.Name = std::string((const char*)&pSymbol->Name[0], pSymbol->NameLen);
+	if (resolved.HasLine) {
+		entry.AbsoluteLineAddress = reinterpret_cast<void*>(frame.AddrPC.Offset + resolved.LineDisplacement);
+		entry.LineAddress		  = reinterpret_cast<void*>(resolved.LineAddress);
+		entry.File				  = resolved.File;
+		entry.Line				  = resolved.Line;
 	}
 
 	if (m_MaxInstruction != 0) /* Disassemble the instructions at the address of this symbol */
-		DisassembleFrame(frame, *pSymbol, entry);
-
-	// Get the symbol line association, which is an approximation
-	IMAGEHLP_LINEW64 line = { sizeof(IMAGEHLP_LINEW64), 0, 0, 0, 0 };
-	if (SymGetLineFromAddrW64(m_Context->GetProcess(), frame.AddrPC.Offset, &dwLineDisplacement, &line)) {
-		entry.AbsoluteLineAddress = reinterpret_cast<void*>(frame.AddrPC.Offset + dwLineDisplacement);
-		entry.LineAddress		  = reinterpret_cast<void*>(line.Address);
-		entry.File				  = line.FileName;
-		entry.Line				  = line.LineNumber;
-	}
+		DisassembleFrame(frame, static_cast<size_t>(resolved.SymbolSize), entry);
+	else
+		entry.Instructions.clear();
 }
 
 /// <summary>
-/// Add a recursion entry to the stack trace, which will add an indicator of the recursion
-/// 	with the number of frames that are skippedand the last frame.This would effectively
-/// 	allow you to generate a print out in the form :
+/// Add a recursion entry to the stack trace, which indicates the number of recursive frames that were skipped. It is
+/// preceded by the first repetition(s) of the recursion and followed by the last one. This would effectively allow you
+/// to generate a print out in the form :
 /// 
 /// #5: recursive call @ some address
 /// 	... recursion of X frames ...
 /// #5 + x: recursive call @ some address
 /// </summary>
-/// <param name="backlog">A const reference to a vector of <see cref="STACKFRAME64"/> instances that describes the backlog.</param>
-void DebugStackTrace::AddRecursion(const std::vector<STACKFRAME64>& backlog) {
-	auto& entry = m_Trace.emplace_back();
+/// <param name="count">The number of recursive frames that were skipped.</param>
+void DebugStackTrace::AddRecursion(size_t count) {
+	auto& entry = NextEntry();
+	entry.Instructions.clear();
 	entry.Recursion = true;
-	entry.RecursionCount = backlog.size();
-	AddFrame(backlog.back()); 
-}
\ No newline at end of file
+	entry.RecursionCount = count;
+}
+#endif
\ No newline at end of file
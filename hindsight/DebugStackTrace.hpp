@@ -2,12 +2,15 @@
 
 #ifndef debugger_stack_trace_h
 #define debugger_stack_trace_h
-	#include <Windows.h>
-	#include <DbgHelp.h>
+	#include "Win32Types.hpp"
 
 	#include "DebugContext.hpp"
 	#include "ModuleCollection.hpp"
+	#ifdef _WIN32
+		#include "SymbolSession.hpp"
+	#endif
 	#include "BinaryLogFile.hpp"
+	#include "LruCache.hpp"
 
 	#include <memory>
 	#include <vector>
@@ -30,7 +33,7 @@
 			/// Describes one stack trace entry.
 			/// </summary>
 			struct DebugStackTraceEntry {
-				Module	Module;							/* The module that contains the address of this stack frame. */
+				Debugger::Module	Module;				/* The module that contains the address of this stack frame. */
 
 				void*	ModuleBase = nullptr;			/* The module base address, if this address is nullptr then the module instance should be ignored. */
 				void*	Address = nullptr;				/* The stack frame address. */
@@ -49,7 +52,46 @@
 			};
 
 			/// <summary>
-			/// A stack trace built up using StackWalk64, starting from a specific thread context.
+			/// Identifies a block of disassembled instructions by the module that contains it and the offset within that module, 
+			/// together with the parameters that were used to decode it.
+			/// </summary>
+			struct DisassemblyKey {
+				ModulePointer	Module = nullptr;	/* The base address of the module that contains the code. */
+				size_t			Offset = 0;			/* The offset of the first instruction relative to the module base. */
+				size_t			Length = 0;			/* The number of bytes that were decoded. */
+				size_t			Count = 0;			/* The maximum number of instructions that were decoded. */
+				bool			Is64 = false;		/* True when the code was decoded as 64-bit code. */
+
+				/// <summary>
+				/// Compare two keys for equality.
+				/// </summary>
+				/// <param name="other">The key to compare to.</param>
+				/// <returns>true when both keys identify the same block.</returns>
+				bool operator==(const DisassemblyKey& other) const noexcept;
+			};
+
+			/// <summary>
+			/// The hash function for <see cref="::Hindsight::Debugger::DisassemblyKey"/>.
+			/// </summary>
+			struct DisassemblyKeyHash {
+				/// <summary>
+				/// Compute the hash of a key.
+				/// </summary>
+				/// <param name="key">The key to hash.</param>
+				/// <returns>The hash of <paramref name="key"/>.</returns>
+				size_t operator()(const DisassemblyKey& key) const noexcept;
+			};
+
+			/// <summary>
+			/// A bounded cache of disassembled instructions. The code of image-backed modules does not change while the module is 
+			/// loaded, so a return address that shows up in many traces only has to be read and decoded once. The entries of a 
+			/// module have to be removed when it is unloaded.
+			/// </summary>
+			using DisassemblyCache = Hindsight::Utilities::LruCache<DisassemblyKey, std::vector<DebugStackTraceInstruction>, DisassemblyKeyHash>;
+
+			/// <summary>
+			/// A stack trace built up from a specific thread context, with the unwind tables of the modules for 64-bit code and
+			/// StackWalk64 for everything those do not cover.
 			/// This trace will contain, if available, symbol names, file paths of source files and line numbers.
 			/// Aside from this, each entry in the stack trace can be resolved to the module the address comes from.
 			/// </summary>
@@ -60,8 +102,20 @@
 					std::vector<DebugStackTraceEntry>	m_Trace;
 					size_t								m_MaxRecursion;
 					size_t								m_MaxInstruction;
+#ifdef _WIN32
+					SymbolSession*						m_Session = nullptr;	/* The symbol session used while walking the stack, only set during construction */
+#endif
+					DisassemblyCache*					m_Disassembly = nullptr;	/* The disassembly cache used while walking the stack, if any, only set during construction */
+					bool								m_Symbolize = true;	/* False when frames are recorded as module + offset only, without resolving symbols */
+					std::vector<DebugStackTraceEntry>	m_Spare;	/* Entries of an earlier walk, recycled so that their strings and instruction vectors keep their memory */
+					std::vector<char>					m_Code;		/* The code read for disassembly, kept to reuse its memory */
+					std::vector<uint8_t>				m_Stack;	/* The stack read for walking when the context has no snapshot, kept to reuse its memory */
+#ifdef _WIN32
+					std::vector<STACKFRAME64>			m_Unwound;	/* The frames unwound with the unwind tables of the modules, kept to reuse its memory */
+#endif
 
 				public:
+#ifdef _WIN32
 					/// <summary>
 					/// Construct a new DebugStackTrace based on a thread context, module collection and symbol search path.
 					/// </summary>
@@ -77,6 +131,27 @@
 						size_t max_recursion = 10,
 						size_t max_instruction = 0);
 
+					/// <summary>
+					/// Construct a new DebugStackTrace based on a thread context, module collection and a symbol session that outlives
+					/// this trace. Unlike the constructors that take a search path, this does not initialize the symbol engine for 
+					/// each trace and addresses that were resolved for earlier traces are not looked up again.
+					/// </summary>
+					/// <param name="context">A shared pointer to an instance of <see cref="::Hindsight::Debugger::DebugContext"/>, this context specifies where the trace starts.</param>
+					/// <param name="collection">A const reference to an instance of <see cref="::Hindsight::Debugger::ModuleCollection"/> containing all the loaded modules at the time of the trace.</param>
+					/// <param name="session">The symbol session of the debugged process.</param>
+					/// <param name="max_recursion">The maximum number of recursive calls to show in a trace before cutting it.</param>
+					/// <param name="max_instruction">The maximum number of instructions to disassemble at the program count addresses of each trace frame.</param>
+					/// <param name="disassembly">An optional cache of disassembled instructions that outlives this trace.</param>
+					/// <param name="symbolize">When false, the frames are not resolved and only their module and address are recorded, to be symbolized at replay.</param>
+					DebugStackTrace(
+						std::shared_ptr<const DebugContext> context, 
+						const ModuleCollection& collection, 
+						SymbolSession& session,
+						size_t max_recursion = 10,
+						size_t max_instruction = 0,
+						DisassemblyCache* disassembly = nullptr,
+						bool symbolize = true);
+
 					/// <summary>
 					/// Construct a new DebugStackTrace based on a thread context and module collection.
 					/// </summary>
@@ -89,17 +164,39 @@
 						const ModuleCollection& collection, 
 						size_t max_recursion = 10,
 						size_t max_instruction = 0);
+#endif
 
 					/// <summary>
 					/// Construct a new DebugStackTrace based on a context, module collection and a concrete stack trace read from a binary log file.
 					/// </summary>
 					/// <param name="context">A shared pointer to an instance of <see cref="::Hindsight::Debugger::DebugContext"/>, this context specifies where the trace starts.</param>
 					/// <param name="collection">A const reference to an instance of <see cref="::Hindsight::Debugger::ModuleCollection"/> containing all the loaded modules at the time of the trace.</param>
-					/// <param name="trace">A const reference to an instance of <see cref="::Hindsight::BinaryLog::StackTraceConcrete"/> containing the full stack trace that needs to be converted.</param>
+					/// <param name="trace">An rvalue reference to an instance of <see cref="::Hindsight::BinaryLog::StackTraceConcrete"/> containing the full stack trace that needs to be converted, its strings are moved into this trace.</param>
 					DebugStackTrace(
 						std::shared_ptr<const DebugContext> context,
 						const ModuleCollection& collection,
-						const Hindsight::BinaryLog::StackTraceConcrete& trace);
+						Hindsight::BinaryLog::StackTraceConcrete&& trace);
+
+#ifdef _WIN32
+					/// <summary>
+					/// Walk the stack again, starting from another thread context, and replace the frames of this trace. The entries of
+					/// the previous walk are recycled, so their strings and instruction vectors are overwritten in place rather than
+					/// freed and allocated again. This may only be done when no one else holds a reference to this trace.
+					/// </summary>
+					/// <param name="context">A shared pointer to an instance of <see cref="::Hindsight::Debugger::DebugContext"/>, this context specifies where the trace starts.</param>
+					/// <param name="session">The symbol session of the debugged process.</param>
+					/// <param name="max_recursion">The maximum number of recursive calls to show in a trace before cutting it.</param>
+					/// <param name="max_instruction">The maximum number of instructions to disassemble at the program count addresses of each trace frame.</param>
+					/// <param name="disassembly">An optional cache of disassembled instructions that outlives this trace.</param>
+					/// <param name="symbolize">When false, the frames are not resolved and only their module and address are recorded, to be symbolized at replay.</param>
+					void Reset(
+						std::shared_ptr<const DebugContext> context,
+						SymbolSession& session,
+						size_t max_recursion,
+						size_t max_instruction,
+						DisassemblyCache* disassembly = nullptr,
+						bool symbolize = true);
+#endif
 
 					/// <summary>
 					/// Count the number of frames in this stack trace.
@@ -125,37 +222,60 @@
 					/// <returns>The maximum number of disassembled instructions per frame.</returns>
 					const size_t& GetMaxInstructions() const;
 				private:
+#ifdef _WIN32
 					/// <summary>
 					/// Walk the stack.
 					/// </summary>
 					void Walk();
 
+#ifdef _WIN64
+					/// <summary>
+					/// Unwind a 64-bit stack with the unwind tables of the loaded modules into <see cref="m_Unwound"/>, for as long as
+					/// the tables cover the frames. With the stack read in one go, most frames cost no call into the process or DbgHelp
+					/// at all.
+					/// </summary>
+					/// <param name="context">A reference to the context of the first frame, which receives the registers of the first frame that could not be unwound.</param>
+					/// <param name="memory">The memory of the process, with the stack served from a copy.</param>
+					/// <returns>true when the whole stack was unwound, false when StackWalk64 has to continue from <paramref name="context"/>.</returns>
+					bool UnwindTables(CONTEXT& context, const Backend::IMemoryReader& memory);
+#endif
+
+					/// <summary>
+					/// Add an entry to the end of the trace, which is a recycled entry when one is available. All fields of the entry are
+					/// reset, except for its instructions, which are overwritten by <see cref="DisassembleFrame"/> or cleared by the caller.
+					/// </summary>
+					/// <returns>A reference to the new entry.</returns>
+					DebugStackTraceEntry& NextEntry();
+
 					/// <summary>
-					/// Disassemble the instructions at the PC address of a certain stack frame.
+					/// Disassemble the instructions at the PC address of a certain stack frame. When a disassembly cache is available and 
+					/// the address is in a loaded module, the cached instructions are used if present.
 					/// </summary>
 					/// <param name="frame">A const reference to the <see cref="STACKFRAME64"/> instance with information about the address to disassemble.</param>
-					/// <param name="symbol">A const reference to the <see cref="SYMBOL_INFO"/> instance with information about the symbol at the address.</param>
+					/// <param name="symbolSize">The size of the symbol at the address, or 0 when unknown.</param>
 					/// <param name="entry">A reference to the <see cref="::Hindsight::Debugger::DebugStackTraceEntry"/> to fill with information about the disassembled code.</param>
-					void DisassembleFrame(const STACKFRAME64& frame, const SYMBOL_INFO& symbol, DebugStackTraceEntry& entry);
+					void DisassembleFrame(const STACKFRAME64& frame, size_t symbolSize, DebugStackTraceEntry& entry);
 
 					/// <summary>
 					/// Process a <see cref="StalkWalk64"/> frame for symbol names, source files and line numbers and add the results to the stack trace. 
-					/// This method optionally disassembles instructions from the stack frame as well.
+					/// This method optionally disassembles instructions from the stack frame as well. When symbols are not resolved, only the module 
+					/// that contains the frame address is looked up.
 					/// </summary>
 					/// <param name="frame">A const reference to a <see cref="STACKFRAME64"/> instance containing address information about the frame.</param>
 					void AddFrame(const STACKFRAME64& frame);
 
 					/// <summary>
-					/// Add a recursion entry to the stack trace, which will add an indicator of the recursion
-					/// 	with the number of frames that are skippedand the last frame.This would effectively
-					/// 	allow you to generate a print out in the form :
+					/// Add a recursion entry to the stack trace, which indicates the number of recursive frames that were skipped. It is
+					/// preceded by the first repetition(s) of the recursion and followed by the last one. This would effectively allow you
+					/// to generate a print out in the form :
 					/// 
 					/// #5: recursive call @ some address
 					/// 	... recursion of X frames ...
 					/// #5 + x: recursive call @ some address
 					/// </summary>
-					/// <param name="backlog">A const reference to a vector of <see cref="STACKFRAME64"/> instances that describes the backlog.</param>
-					void AddRecursion(const std::vector<STACKFRAME64>& backlog);
+					/// <param name="count">The number of recursive frames that were skipped.</param>
+					void AddRecursion(size_t count);
+#endif
 			};
 
 		}
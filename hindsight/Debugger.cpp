@@ -20,13 +20,40 @@ using namespace Hindsight::Exceptions;
 using namespace Hindsight::Utilities;
 using namespace Hindsight::Debugger::CxxExceptions;
 
+/// <summary>
+/// Open a process handle with all access for the handle table.
+/// </summary>
+/// <param name="id">The process ID.</param>
+/// <returns>The process handle, or nullptr on failure.</returns>
+static HANDLE open_process(uint32_t id) {
+	return OpenProcess(PROCESS_ALL_ACCESS, false, id);
+}
+
+/// <summary>
+/// Open a thread handle with all access for the handle table.
+/// </summary>
+/// <param name="id">The thread ID.</param>
+/// <returns>The thread handle, or nullptr on failure.</returns>
+static HANDLE open_thread(uint32_t id) {
+	return OpenThread(THREAD_ALL_ACCESS, false, id);
+}
+
+/// <summary>
+/// Close a handle that was opened for the handle table.
+/// </summary>
+/// <param name="handle">The handle.</param>
+static void close_handle(HANDLE handle) {
+	CloseHandle(handle);
+}
+
 /// <summary>
 /// Construct a new Debugger instance for real-time debugging.
 /// </summary>
 /// <param name="process">A shared pointer to a <see cref="Hindsight::Process::Process"/> instance containing information about the process to be debugged.</param>
 /// <param name="state">The hindsight program argument state.</param>
 Debugger::Debugger(std::shared_ptr<Hindsight::Process::Process> process, const Cli::HindsightCli& state)
-	: m_Process(process), m_State(state), m_SubState(state[state.get_chosen_subcommand_name()]) {
+	: m_Process(process), m_State(state), m_SubState(state[state.get_chosen_subcommand_name()]), m_Disassembly(DisassemblyCacheSize),
+	  m_Handles(open_process, open_thread, close_handle) {
 
 	// process must be running.
 	if (!m_Process->Running())
@@ -41,7 +68,8 @@ Debugger::Debugger(std::shared_ptr<Hindsight::Process::Process> process, const C
 /// <param name="jitEvent">The event handle copied into the hindsight process, so that WER can be signaled to let the debugged process continue.</param>
 /// <param name="jit">An address in the debugged process address space pointing to a <see cref="JIT_DEBUG_INFO"/> instance.</param>
 Debugger::Debugger(std::shared_ptr<Hindsight::Process::Process> process, const Cli::HindsightCli& state, HANDLE jitEvent, void* jit)
-	: m_Process(process), m_State(state), m_SubState(state[state.get_chosen_subcommand_name()]) {
+	: m_Process(process), m_State(state), m_SubState(state[state.get_chosen_subcommand_name()]), m_Disassembly(DisassemblyCacheSize),
+	  m_Handles(open_process, open_thread, close_handle) {
 
 	m_Jit = std::make_shared<JitDebuggerInfo>();
 	m_Jit->JitEvent = jitEvent;
@@ -79,6 +107,9 @@ bool Debugger::Attach(bool killOnDetach) {
 	std::shared_ptr<DebugStackTrace>	initialStackTrace;	/* Used for postmortem attach, nullptr by default for regular debugging */
 	auto time = std::time(nullptr); /* Time of initialization */
 
+	// Compile the options once, the debug loop only reads the result.
+	m_Config = std::make_unique<const DebuggerConfig>(Configure());
+
 	if (m_Jit != nullptr) { /* Postmortem, dump exception + traces */
 		// Initialize the event handlers.
 		for (auto handler : m_Handlers)
@@ -87,11 +118,6 @@ bool Debugger::Attach(bool killOnDetach) {
 		// Enumerate all loaded modules and simulate a LOAD_DLL_DEBUG_EVENT for each of them.
 		EnumerateProcessModules(m_Process->hProcess);
 
-		// Add the process image path to the search path if specified in the flags.
-		auto pdbSearchPaths = m_SubState.get<std::vector<std::string>>(Cli::Descriptors::NAME_PDBSEARCH);
-		if (m_SubState.isset(Cli::Descriptors::NAME_PDBSELF))
-			pdbSearchPaths.push_back(Path::GetModulePath(m_Process->hProcess, NULL));
-		
 		union {
 			WOW64_CONTEXT	ctx32;
 			CONTEXT			ctx64 = { 0 };
@@ -106,11 +132,16 @@ bool Debugger::Attach(bool killOnDetach) {
 			initialContext = std::make_shared<DebugContext>(m_Process->hProcess, m_Process->hThread, ctx64);
 		}
 
+		if (m_Config->StackSnapshot != 0)
+			initialContext->CaptureStack(m_Config->StackSnapshot);
+
 		// Get stack trace.
 		initialStackTrace = std::make_shared<DebugStackTrace>(
-			initialContext, m_LoadedModules, String::Join(pdbSearchPaths, ";"), 
-			m_SubState.get<size_t>(Cli::Descriptors::NAME_MAX_RECURSION), 
-			m_SubState.get<size_t>(Cli::Descriptors::NAME_MAX_INSTRUCTION));
+			initialContext, m_LoadedModules, Symbols(), 
+			m_Config->MaxRecursion, 
+			m_Config->MaxInstructions,
+			&m_Disassembly,
+			!m_Config->RawFrames);
 
 		// Construct the exception object.
 		EXCEPTION_DEBUG_INFO exception;
@@ -169,6 +200,43 @@ void Debugger::AddHandler(std::shared_ptr<EventHandler::IDebuggerEventHandler> h
 	m_Handlers.push_back(handler);
 }
 
+/// <summary>
+/// Compile the program arguments that the debug loop needs into a <see cref="::Hindsight::Debugger::DebuggerConfig"/>,
+/// so that no options have to be looked up by name while events are processed.
+/// </summary>
+/// <returns>The configuration of this session.</returns>
+DebuggerConfig Debugger::Configure() const {
+	DebuggerConfig config;
+
+	config.MaxRecursion	   = m_SubState.get<size_t>(Cli::Descriptors::NAME_MAX_RECURSION);
+	config.MaxInstructions = m_SubState.get<size_t>(Cli::Descriptors::NAME_MAX_INSTRUCTION);
+
+	// 0 means unlimited recursion.
+	if (config.MaxRecursion == 0)
+		config.MaxRecursion = SIZE_MAX;
+
+	// The break options are not available in every subcommand.
+	config.BreakOnBreakpoint	= m_SubState.exists(Cli::Descriptors::NAME_BREAKB) && m_SubState.isset(Cli::Descriptors::NAME_BREAKB);
+	config.BreakOnException		= m_SubState.exists(Cli::Descriptors::NAME_BREAKE) && m_SubState.isset(Cli::Descriptors::NAME_BREAKE);
+	config.BreakFirstChanceOnly = m_SubState.exists(Cli::Descriptors::NAME_BREAKF) && m_SubState.isset(Cli::Descriptors::NAME_BREAKF);
+
+	// Raw frames are resolved at replay, which needs the identity of every module.
+	config.RawFrames = m_SubState.exists(Cli::Descriptors::NAME_RAWFRAMES) && m_SubState.isset(Cli::Descriptors::NAME_RAWFRAMES);
+
+	// The stack snapshot size is given in KiB.
+	if (m_SubState.exists(Cli::Descriptors::NAME_STACKSNAPSHOT))
+		config.StackSnapshot = m_SubState.get<size_t>(Cli::Descriptors::NAME_STACKSNAPSHOT) * 1024;
+
+	// Add the process module's path to the PDB search list if the -S option was used.
+	auto pdbSearchPaths = m_SubState.get<std::vector<std::string>>(Cli::Descriptors::NAME_PDBSEARCH);
+	if (m_SubState.isset(Cli::Descriptors::NAME_PDBSELF))
+		pdbSearchPaths.push_back(Path::GetModulePath(m_Process->hProcess, NULL));
+
+	config.SymbolSearchPath = String::Join(pdbSearchPaths, ";");
+
+	return config;
+}
+
 /// <summary>
 /// Enumerate all the loaded modules for a specific process and simulate the LOAD_DLL debug event to all the handlers,
 /// but also track the collection of loaded modules so that address resolution will work properly in those handlers.
@@ -202,6 +270,8 @@ void Debugger::EnumerateProcessModules(HANDLE hProcess) {
 			// Only add the module and trigger the event when we can fetch the information we need on the module.
 			if (GetModuleInformation(hProcess, hMods[i], &modInfo, sizeof(MODULEINFO))) {
 				m_LoadedModules.Load(modName, reinterpret_cast<ModulePointer>(modInfo.lpBaseOfDll), modInfo.SizeOfImage);
+				Identify(modName, reinterpret_cast<ModulePointer>(modInfo.lpBaseOfDll));
+				Symbols().Load(modName, reinterpret_cast<ModulePointer>(modInfo.lpBaseOfDll), modInfo.SizeOfImage);
 
 				for (auto handler : m_Handlers) {
 					di.lpBaseOfDll = modInfo.lpBaseOfDll;
@@ -214,6 +284,36 @@ void Debugger::EnumerateProcessModules(HANDLE hProcess) {
 	}
 }
 
+/// <summary>
+/// Get the symbol engine session for the debugged process, which is initialized on first use with the PDB search 
+/// paths from the program arguments. Modules are added to and removed from the session as they are loaded and 
+/// unloaded, so that every stack trace can use the same session.
+/// </summary>
+/// <returns>A reference to the symbol session.</returns>
+SymbolSession& Debugger::Symbols() {
+	if (!m_Symbols)
+		m_Symbols = std::make_unique<SymbolSession>(m_Process->hProcess, m_Config->SymbolSearchPath);
+
+	return *m_Symbols;
+}
+
+/// <summary>
+/// Read the identity of a module that was just loaded and store it in the module collection, so that the writers can 
+/// record it. This is only done when stack frames are recorded raw, without an identity those cannot be symbolized.
+/// </summary>
+/// <param name="path">The module path.</param>
+/// <param name="base">The module base address.</param>
+void Debugger::Identify(const std::wstring& path, ModulePointer base) {
+	if (!m_Config->RawFrames || m_LoadedModules.GetIdentity(path) != nullptr)
+		return;
+
+	Hindsight::Process::ProcessMemoryReader memory(m_Process->hProcess);
+	ModuleIdentity identity;
+
+	if (ModuleIdentity::Read(memory, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(base)), identity))
+		m_LoadedModules.SetIdentity(path, identity);
+}
+
 /// <summary>
 /// Emit the postmortem/JIT exception to a handler.
 /// </summary>
@@ -230,6 +330,43 @@ void Debugger::EmitJitException(std::shared_ptr<EventHandler::IDebuggerEventHand
 	handler->OnException(std::time(nullptr), exception, m_Process->GetProcessInformation(), static_cast<bool>(exception.dwFirstChance), name, context, trace, m_LoadedModules, ertti);
 }
 
+/// <summary>
+/// Add the process and thread handles that are delivered by creation events to the handle table, before the
+/// handles of the event are looked up.
+/// </summary>
+/// <param name="event">A const reference to the debug event.</param>
+void Debugger::TrackHandles(const DEBUG_EVENT& event) {
+	switch (event.dwDebugEventCode) {
+		case CREATE_PROCESS_DEBUG_EVENT:
+			if (event.u.CreateProcessInfo.hProcess)
+				m_Handles.AddProcess(event.dwProcessId, event.u.CreateProcessInfo.hProcess);
+			if (event.u.CreateProcessInfo.hThread)
+				m_Handles.AddThread(event.dwProcessId, event.dwThreadId, event.u.CreateProcessInfo.hThread);
+			break;
+
+		case CREATE_THREAD_DEBUG_EVENT:
+			if (event.u.CreateThread.hThread)
+				m_Handles.AddThread(event.dwProcessId, event.dwThreadId, event.u.CreateThread.hThread);
+			break;
+	}
+}
+
+/// <summary>
+/// Retire the handles of processes and threads that have exited from the handle table, before the event is continued.
+/// </summary>
+/// <param name="event">A const reference to the debug event.</param>
+void Debugger::RetireHandles(const DEBUG_EVENT& event) {
+	switch (event.dwDebugEventCode) {
+		case EXIT_THREAD_DEBUG_EVENT:
+			m_Handles.RemoveThread(event.dwThreadId);
+			break;
+
+		case EXIT_PROCESS_DEBUG_EVENT:
+			m_Handles.RemoveProcess(event.dwProcessId);
+			break;
+	}
+}
+
 /// <summary>
 /// Wait for the next debug event and emit it to all the handlers.
 /// </summary>
@@ -245,20 +382,21 @@ bool Debugger::Tick() {
 	if (!WaitForDebugEventEx(&event, INFINITE))
 		return stay;
 
-	// Open the process and thread of the event.
+	// Look up the process and thread of the event, creation events deliver their handles.
+	TrackHandles(event);
+
 	pi.dwProcessId = event.dwProcessId;
 	pi.dwThreadId  = event.dwThreadId;
 
-	pi.hProcess = OpenProcess(PROCESS_ALL_ACCESS, false, pi.dwProcessId);
+	pi.hProcess = m_Handles.Process(pi.dwProcessId);
 	if (!pi.hProcess) {
 		std::cout << "error: cannot open process: 0x" << std::hex << pi.dwProcessId << std::dec << std::endl;
 		return stay;
 	}
 
-	pi.hThread = OpenThread(THREAD_ALL_ACCESS, false, pi.dwThreadId);
+	pi.hThread = m_Handles.Thread(pi.dwProcessId, pi.dwThreadId);
 	if (!pi.hThread) {
 		std::cout << "error: cannot open thread: 0x" << std::hex << pi.dwThreadId << std::dec << std::endl;
-		CloseHandle(pi.hProcess);
 		return stay;
 	}
 
@@ -272,17 +410,11 @@ bool Debugger::Tick() {
 			// This debugger does not handle events, it records them.
 			continueStatus = DBG_EXCEPTION_NOT_HANDLED;
 
-			// Add the process module's path to the PDB search list if the -S option was used.
-			auto pdbSearchPaths = m_SubState.get<std::vector<std::string>>(Cli::Descriptors::NAME_PDBSEARCH);
-			if (m_SubState.isset(Cli::Descriptors::NAME_PDBSELF))
-				pdbSearchPaths.push_back(Path::GetModulePath(m_Process->hProcess, NULL));
+			// Construct a thread context for this state and construct a stack trace from that context, reusing a pooled trace if possible.
+			auto snapshot = m_Snapshots.Capture(pi, m_LoadedModules, Symbols(), *m_Config, &m_Disassembly);
 
-			// Construct a thread context for this state and construct a stack trace from that context.
-			auto context = std::make_shared<DebugContext>(pi.hProcess, pi.hThread);
-			auto trace   = std::make_shared<DebugStackTrace>(
-				context, m_LoadedModules, String::Join(pdbSearchPaths, ";"), 
-				m_SubState.get<size_t>(Cli::Descriptors::NAME_MAX_RECURSION),
-				m_SubState.get<size_t>(Cli::Descriptors::NAME_MAX_INSTRUCTION));
+			auto& context = snapshot.Context;
+			auto& trace   = snapshot.Trace;
 
 			// Differentiate exceptions from breakpoints. Single-step exceptions are just walked over as regular exceptions.
 			switch (event.u.Exception.ExceptionRecord.ExceptionCode) {
@@ -292,7 +424,7 @@ bool Debugger::Tick() {
 						handler->OnBreakpointHit(time, event.u.Exception, pi, context, trace, m_LoadedModules);
 
 					// Should we break?
-					if (m_SubState.isset(Cli::Descriptors::NAME_BREAKB))
+					if (m_Config->BreakOnBreakpoint)
 						HandleBreakpointOptions();
 
 					break;
@@ -315,7 +447,7 @@ bool Debugger::Tick() {
 						handler->OnException(time, event.u.Exception, pi, static_cast<bool>(event.u.Exception.dwFirstChance), name, context, trace, m_LoadedModules, ertti);
 
 					// Should we break?
-					if (m_SubState.isset(Cli::Descriptors::NAME_BREAKE) && (!m_SubState.isset(Cli::Descriptors::NAME_BREAKF) || event.u.Exception.dwFirstChance))
+					if (m_Config->ShouldBreakOnException(event.u.Exception.dwFirstChance != 0))
 						HandleBreakpointOptions();
 
 					break;
@@ -330,6 +462,10 @@ bool Debugger::Tick() {
 		case CREATE_PROCESS_DEBUG_EVENT: {
 			auto fullPath = Path::GetPathFromFileHandleW(event.u.CreateProcessInfo.hFile);
 			m_LoadedModules.Load(pi.hProcess, fullPath, event.u.CreateProcessInfo.lpBaseOfImage);
+			Identify(fullPath, event.u.CreateProcessInfo.lpBaseOfImage);
+
+			auto module = m_LoadedModules.GetModuleAtAddress(event.u.CreateProcessInfo.lpBaseOfImage);
+			Symbols().Load(fullPath, event.u.CreateProcessInfo.lpBaseOfImage, module ? module->Size : 0);
 
 			for (auto handler : m_Handlers)
 				handler->OnCreateProcess(time, event.u.CreateProcessInfo, pi, fullPath, m_LoadedModules);
@@ -365,6 +501,10 @@ bool Debugger::Tick() {
 		case LOAD_DLL_DEBUG_EVENT: {
 			auto fullPath = Path::GetPathFromFileHandleW(event.u.LoadDll.hFile);
 			m_LoadedModules.Load(pi.hProcess, fullPath, event.u.LoadDll.lpBaseOfDll);
+			Identify(fullPath, event.u.LoadDll.lpBaseOfDll);
+
+			auto module = m_LoadedModules.GetModuleAtAddress(event.u.LoadDll.lpBaseOfDll);
+			Symbols().Load(fullPath, event.u.LoadDll.lpBaseOfDll, module ? module->Size : 0);
 
 			for (auto handler : m_Handlers)
 				handler->OnDllLoad(time, event.u.LoadDll, pi, fullPath, m_LoadedModules.GetIndex(fullPath), m_LoadedModules);
@@ -405,6 +545,13 @@ bool Debugger::Tick() {
 			for (auto handler : m_Handlers)
 				handler->OnDllUnload(time, event.u.UnloadDll, pi, fullPath, m_LoadedModules.GetIndex(fullPath), m_LoadedModules);
 
+			auto module = m_LoadedModules.GetModuleAtAddress(event.u.UnloadDll.lpBaseOfDll);
+			Symbols().Unload(event.u.UnloadDll.lpBaseOfDll, module ? module->Size : 0);
+
+			// Another module may be loaded at the same base address later on.
+			auto base = event.u.UnloadDll.lpBaseOfDll;
+			m_Disassembly.EraseIf([base](const DisassemblyKey& key) { return key.Module == base; });
+
 			m_LoadedModules.Unload(event.u.UnloadDll.lpBaseOfDll);
 
 			break;
@@ -414,9 +561,8 @@ bool Debugger::Tick() {
 			OutputDebugString(L"Uknown Event");
 	}
 
-	// Close thread and process handles.
-	CloseHandle(pi.hThread);
-	CloseHandle(pi.hProcess);
+	// Retire the handles of exited threads and processes, the system closes delivered handles when the exit event is continued.
+	RetireHandles(event);
 
 	// Continue
 	ContinueDebugEvent(event.dwProcessId, event.dwThreadId, continueStatus);
@@ -8,6 +8,11 @@
 	#include "Process.hpp"
 	#include "DebuggerExceptions.hpp"
 	#include "ModuleCollection.hpp"
+	#include "SymbolSession.hpp"
+	#include "DebugStackTrace.hpp"
+	#include "ExceptionSnapshot.hpp"
+	#include "DebuggerConfig.hpp"
+	#include "HandleTable.hpp"
 	#include "IDebuggerEventHandler.hpp"
 	#include "ExceptionRtti.hpp"
 
@@ -60,7 +65,27 @@
 					// The currently loaded modules in the debugged process.
 					ModuleCollection m_LoadedModules;
 
+					// The symbol engine session for the debugged process, created on first use.
+					std::unique_ptr<SymbolSession> m_Symbols;
+
+					// The disassembled instructions of recent stack frames.
+					DisassemblyCache m_Disassembly;
+
+					// The stack traces that are reused between exceptions.
+					ExceptionSnapshotPool m_Snapshots;
+
+					// The options of this session, compiled from the program arguments in Attach.
+					std::unique_ptr<const DebuggerConfig> m_Config;
+
+					// The process and thread handles of the debugged processes, by ID.
+					HandleTable<HANDLE> m_Handles;
+
 				public:
+					/// <summary>
+					/// The maximum number of disassembled stack frames that are cached.
+					/// </summary>
+					static const size_t DisassemblyCacheSize = 4096;
+
 					/// <summary>
 					/// Construct a new Debugger instance for real-time debugging.
 					/// </summary>
@@ -101,6 +126,13 @@
 					/// <param name="handler">The debug event handler.</param>
 					void AddHandler(std::shared_ptr<EventHandler::IDebuggerEventHandler> handler);
 				private:
+					/// <summary>
+					/// Compile the program arguments that the debug loop needs into a <see cref="::Hindsight::Debugger::DebuggerConfig"/>,
+					/// so that no options have to be looked up by name while events are processed.
+					/// </summary>
+					/// <returns>The configuration of this session.</returns>
+					DebuggerConfig Configure() const;
+
 					/// <summary>
 					/// Enumerate all the loaded modules for a specific process and simulate the LOAD_DLL debug event to all the handlers,
 					/// but also track the collection of loaded modules so that address resolution will work properly in those handlers.
@@ -108,6 +140,22 @@
 					/// <param name="hProcess">The handle to the debugged process.</param>
 					void EnumerateProcessModules(HANDLE hProcess);
 
+					/// <summary>
+					/// Get the symbol engine session for the debugged process, which is initialized on first use with the PDB search 
+					/// paths from the program arguments. Modules are added to and removed from the session as they are loaded and 
+					/// unloaded, so that every stack trace can use the same session.
+					/// </summary>
+					/// <returns>A reference to the symbol session.</returns>
+					SymbolSession& Symbols();
+
+					/// <summary>
+					/// Read the identity of a module that was just loaded and store it in the module collection, so that the writers can 
+					/// record it. This is only done when stack frames are recorded raw, without an identity those cannot be symbolized.
+					/// </summary>
+					/// <param name="path">The module path.</param>
+					/// <param name="base">The module base address.</param>
+					void Identify(const std::wstring& path, ModulePointer base);
+
 					/// <summary>
 					/// Emit the postmortem/JIT exception to a handler.
 					/// </summary>
@@ -119,6 +167,19 @@
 					/// <param name="ertti">A shared pointer to the run-time type information about the exception.</param>
 					void EmitJitException(std::shared_ptr<EventHandler::IDebuggerEventHandler> handler, const JIT_DEBUG_INFO& info, const EXCEPTION_DEBUG_INFO& exception, std::shared_ptr<DebugContext> context, std::shared_ptr<DebugStackTrace> trace, std::shared_ptr<CxxExceptions::ExceptionRunTimeTypeInformation> ertti);
 
+					/// <summary>
+					/// Add the process and thread handles that are delivered by creation events to the handle table, before the
+					/// handles of the event are looked up.
+					/// </summary>
+					/// <param name="event">A const reference to the debug event.</param>
+					void TrackHandles(const DEBUG_EVENT& event);
+
+					/// <summary>
+					/// Retire the handles of processes and threads that have exited from the handle table, before the event is continued.
+					/// </summary>
+					/// <param name="event">A const reference to the debug event.</param>
+					void RetireHandles(const DEBUG_EVENT& event);
+
 					/// <summary>
 					/// Wait for the next debug event and emit it to all the handlers.
 					/// </summary>
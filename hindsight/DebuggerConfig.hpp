@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef debugger_config_h
+#define debugger_config_h
+	#include <cstddef>
+	#include <cstdint>
+	#include <string>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The options of a debugging session, compiled once from the program arguments when the debugger attaches. The
+			/// debug loop reads these plain fields for every event instead of looking options up by name, and nothing in here
+			/// depends on the command line parser. A configuration is never modified after it has been built.
+			/// </summary>
+			struct DebuggerConfig {
+				size_t		MaxRecursion = SIZE_MAX;		/* The maximum number of recursive frames in a stack trace before it is cut, SIZE_MAX for unlimited. */
+				size_t		MaxInstructions = 0;			/* The maximum number of instructions to disassemble per stack frame, 0 to disable. */
+				bool		RawFrames = false;				/* True when stack frames are recorded as module + offset only, to be symbolized at replay. */
+				size_t		StackSnapshot = 0;				/* The maximum number of bytes of the stack that are captured with each exception, 0 to disable. */
+				bool		BreakOnBreakpoint = false;		/* True when the debugger waits for the user on breakpoints. */
+				bool		BreakOnException = false;		/* True when the debugger waits for the user on exceptions. */
+				bool		BreakFirstChanceOnly = false;	/* True when BreakOnException only applies to first-chance exceptions. */
+				std::string	SymbolSearchPath = "";			/* The search paths for .PDB files, separated by ';'. */
+
+				/// <summary>
+				/// Determine if the debugger should wait for the user after an exception.
+				/// </summary>
+				/// <param name="firstChance">Whether the exception is a first-chance exception.</param>
+				/// <returns>true when the debugger should break.</returns>
+				bool ShouldBreakOnException(bool firstChance) const noexcept {
+					return BreakOnException && (!BreakFirstChanceOnly || firstChance);
+				}
+			};
+		}
+	}
+
+#endif
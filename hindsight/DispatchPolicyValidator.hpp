@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef dispatch_policy_validator_h
+#define dispatch_policy_validator_h
+	#include "CLI11.hpp"
+
+	#include <set>
+	#include <vector>
+	#include <string>
+
+	namespace Hindsight {
+		namespace Cli {
+			namespace CliValidator {
+				/// <summary>
+				/// A simple validator for <see cref="::CLI::App"/> that validates the choice of backpressure policy
+				/// for the event handlers with --dispatch. This struct can be used to check if the user chose a valid
+				/// policy name.
+				/// </summary>
+				struct DispatchPolicyValidator : public CLI::Validator {
+					/// <summary>
+					/// A static collection of valid policy names.
+					/// </summary>
+					static std::set<std::string> Valid;
+
+					/// <summary>
+					/// The static instance of the validator, for convenience.
+					/// </summary>
+					static DispatchPolicyValidator Validator;
+
+					/// <summary>
+					/// Construct a new DispatchPolicyValidator
+					/// </summary>
+					DispatchPolicyValidator();
+
+					/// <summary>
+					/// Get a comma-separated list of valid options for this validator.
+					/// </summary>
+					/// <returns>A comma-separated list of policy names.</returns>
+					static std::string GetValid();
+				};
+			}
+		}
+	}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "DispatchingDebuggerEventHandler.hpp"
+
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::EventHandler;
+
+/// <summary>
+/// Construct a new DispatchChannel and start its worker thread.
+/// </summary>
+/// <param name="handler">The handler that receives the events.</param>
+/// <param name="policy">Determines what happens when the queue is full.</param>
+/// <param name="capacity">The maximum number of queued events, which must be at least 1.</param>
+DispatchChannel::DispatchChannel(std::shared_ptr<IDebuggerEventHandler> handler, BackpressurePolicy policy, size_t capacity)
+	: m_Handler(handler), m_Policy(policy), m_Capacity(capacity != 0 ? capacity : 1),
+	  m_Busy(false), m_Stopping(false), m_Failed(false), m_Error(nullptr), m_Pressure(0), m_Dropped(0) {
+
+	m_Thread = std::thread(&DispatchChannel::Run, this);
+}
+
+/// <summary>
+/// Deliver all remaining events and stop the worker thread.
+/// </summary>
+DispatchChannel::~DispatchChannel() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_Produced.notify_one();
+
+	if (m_Thread.joinable())
+		m_Thread.join();
+}
+
+/// <summary>
+/// Queue <paramref name="event"/> for the handler, applying the backpressure policy when the queue is full.
+/// </summary>
+/// <param name="event">The event snapshot.</param>
+/// <exception cref="std::exception">The exception that the handler threw while processing an earlier event is rethrown here, once.</exception>
+void DispatchChannel::Post(std::shared_ptr<const DispatchedEvent> event) {
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (m_Failed) {
+		RethrowError();
+		return;
+	}
+
+	if (m_Queue.size() >= m_Capacity) {
+		if (m_Policy == BackpressurePolicy::DropOldest) {
+			// make room by discarding the oldest event that may be discarded, if there is one
+			for (auto it = m_Queue.begin(); it != m_Queue.end(); ++it) {
+				if (!(*it)->Essential) {
+					m_Queue.erase(it);
+					++m_Dropped;
+					break;
+				}
+			}
+		} else if (m_Policy == BackpressurePolicy::Sample && !event->Essential) {
+			if (++m_Pressure % SampleInterval != 0) {
+				++m_Dropped;
+				return;
+			}
+		}
+
+		// all that is left is to wait for the handler
+		m_Consumed.wait(lock, [this]() { return m_Queue.size() < m_Capacity || m_Failed; });
+
+		if (m_Failed) {
+			RethrowError();
+			return;
+		}
+	}
+
+	m_Queue.push_back(std::move(event));
+	lock.unlock();
+
+	m_Produced.notify_one();
+}
+
+/// <summary>
+/// Wait until the handler has processed all queued events.
+/// </summary>
+/// <exception cref="std::exception">The exception that the handler threw while processing an earlier event is rethrown here, once.</exception>
+void DispatchChannel::Drain() {
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Consumed.wait(lock, [this]() { return (m_Queue.empty() && !m_Busy) || m_Failed; });
+
+	RethrowError();
+}
+
+/// <summary>
+/// Get the number of events that were discarded because of the backpressure policy.
+/// </summary>
+/// <returns>The number of discarded events.</returns>
+uint64_t DispatchChannel::Dropped() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Dropped;
+}
+
+/// <summary>
+/// The worker thread, which delivers queued events until the channel stops.
+/// </summary>
+void DispatchChannel::Run() {
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	for (;;) {
+		m_Produced.wait(lock, [this]() { return !m_Queue.empty() || m_Stopping; });
+
+		if (m_Queue.empty())
+			return;
+
+		auto event = std::move(m_Queue.front());
+		m_Queue.pop_front();
+		m_Busy = true;
+
+		lock.unlock();
+		m_Consumed.notify_all();
+
+		std::exception_ptr error = nullptr;
+		try {
+			event->Deliver(*m_Handler);
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		lock.lock();
+		m_Busy = false;
+
+		if (error) {
+			// the handler is in an unknown state, so it does not receive any further events
+			m_Failed = true;
+			m_Error  = error;
+			m_Queue.clear();
+		}
+
+		m_Consumed.notify_all();
+	}
+}
+
+/// <summary>
+/// Rethrow the exception of the handler when it was not rethrown yet, the lock on <see cref="m_Mutex"/> must be held.
+/// </summary>
+void DispatchChannel::RethrowError() {
+	if (!m_Error)
+		return;
+
+	auto error = m_Error;
+	m_Error = nullptr;
+	std::rethrow_exception(error);
+}
+
+/// <summary>
+/// Construct a new DispatchingDebuggerEventHandler without any handlers.
+/// </summary>
+/// <param name="policy">The backpressure policy for handlers that are added without one.</param>
+/// <param name="capacity">The maximum number of queued events per handler.</param>
+DispatchingDebuggerEventHandler::DispatchingDebuggerEventHandler(BackpressurePolicy policy, size_t capacity)
+	: m_Policy(policy), m_Capacity(capacity), m_Collection(nullptr), m_Source(nullptr), m_Generation(0) {
+
+}
+
+/// <summary>
+/// Deliver all remaining events to all handlers and stop the worker threads.
+/// </summary>
+DispatchingDebuggerEventHandler::~DispatchingDebuggerEventHandler() {
+	// the channels are stopped in order, which delivers everything that is still queued
+	m_Channels.clear();
+}
+
+/// <summary>
+/// Add a handler with the default backpressure policy.
+/// </summary>
+/// <param name="handler">The handler, which is only called from its own worker thread from now on.</param>
+void DispatchingDebuggerEventHandler::AddHandler(std::shared_ptr<IDebuggerEventHandler> handler) {
+	AddHandler(handler, m_Policy);
+}
+
+/// <summary>
+/// Add a handler with a specific backpressure policy, for example <see cref="::Hindsight::Debugger::EventHandler::BackpressurePolicy::Block"/>
+/// for handlers that must not lose any event.
+/// </summary>
+/// <param name="handler">The handler, which is only called from its own worker thread from now on.</param>
+/// <param name="policy">Determines what happens when the queue of the handler is full.</param>
+void DispatchingDebuggerEventHandler::AddHandler(std::shared_ptr<IDebuggerEventHandler> handler, BackpressurePolicy policy) {
+	m_Channels.push_back(std::make_unique<DispatchChannel>(handler, policy, m_Capacity));
+}
+
+/// <summary>
+/// Wait until all handlers have processed all queued events.
+/// </summary>
+void DispatchingDebuggerEventHandler::Drain() {
+	for (auto& channel : m_Channels)
+		channel->Drain();
+}
+
+/// <summary>
+/// Get the total number of events that were discarded because of the backpressure policies.
+/// </summary>
+/// <returns>The number of discarded events, summed over all handlers.</returns>
+uint64_t DispatchingDebuggerEventHandler::Dropped() {
+	uint64_t dropped = 0;
+	for (auto& channel : m_Channels)
+		dropped += channel->Dropped();
+	return dropped;
+}
+
+/// <summary>
+/// Post the initialization event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="p">The process being debugged.</param>
+void DispatchingDebuggerEventHandler::OnInitialization(time_t time, const std::shared_ptr<const Hindsight::Process::Process> p) {
+	Post(true, [time, p](IDebuggerEventHandler& handler) {
+		handler.OnInitialization(time, p);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the breakpoint event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance, which is shared by the snapshot.</param>
+/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance, which is shared by the snapshot.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnBreakpointHit(time_t time, const EXCEPTION_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, std::shared_ptr<const DebugContext> context, std::shared_ptr<const DebugStackTrace> trace, const ModuleCollection& collection) {
+	Post(false, [time, info, pi, context, trace, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnBreakpointHit(time, info, pi, context, trace, *modules);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the exception event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="firstChance">Whether this is a first chance exception.</param>
+/// <param name="name">The name of the exception code.</param>
+/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance, which is shared by the snapshot.</param>
+/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance, which is shared by the snapshot.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+/// <param name="ertti">A shared pointer to the C++ exception run-time type information, or nullptr.</param>
+void DispatchingDebuggerEventHandler::OnException(time_t time, const EXCEPTION_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, bool firstChance, const std::wstring& name, std::shared_ptr<const DebugContext> context, std::shared_ptr<const DebugStackTrace> trace, const ModuleCollection& collection, std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation> ertti) {
+	Post(false, [time, info, pi, firstChance, name, context, trace, modules = Snapshot(collection), ertti](IDebuggerEventHandler& handler) {
+		handler.OnException(time, info, pi, firstChance, name, context, trace, *modules, ertti);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the process creation event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="path">The module path.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnCreateProcess(time_t time, const CREATE_PROCESS_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, const std::wstring& path, const ModuleCollection& collection) {
+	Post(true, [time, info, pi, path, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnCreateProcess(time, info, pi, path, *modules);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the thread creation event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnCreateThread(time_t time, const CREATE_THREAD_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, const ModuleCollection& collection) {
+	Post(false, [time, info, pi, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnCreateThread(time, info, pi, *modules);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the process exit event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnExitProcess(time_t time, const EXIT_PROCESS_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, const ModuleCollection& collection) {
+	Post(true, [time, info, pi, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnExitProcess(time, info, pi, *modules);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the thread exit event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnExitThread(time_t time, const EXIT_THREAD_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, const ModuleCollection& collection) {
+	Post(false, [time, info, pi, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnExitThread(time, info, pi, *modules);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the module load event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="path">The module path.</param>
+/// <param name="moduleIndex">The index of the module in the collection.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnDllLoad(time_t time, const LOAD_DLL_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, const std::wstring& path, int moduleIndex, const ModuleCollection& collection) {
+	Post(true, [time, info, pi, path, moduleIndex, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnDllLoad(time, info, pi, path, moduleIndex, *modules);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the debug string event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="string">The debug string.</param>
+void DispatchingDebuggerEventHandler::OnDebugString(time_t time, const OUTPUT_DEBUG_STRING_INFO& info, const PROCESS_INFORMATION& pi, const std::string& string) {
+	Post(false, [time, info, pi, string](IDebuggerEventHandler& handler) {
+		handler.OnDebugString(time, info, pi, string);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the wide debug string event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="string">The debug string.</param>
+void DispatchingDebuggerEventHandler::OnDebugStringW(time_t time, const OUTPUT_DEBUG_STRING_INFO& info, const PROCESS_INFORMATION& pi, const std::wstring& string) {
+	Post(false, [time, info, pi, string](IDebuggerEventHandler& handler) {
+		handler.OnDebugStringW(time, info, pi, string);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the RIP event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="errorMessage">The error message of the RIP event.</param>
+void DispatchingDebuggerEventHandler::OnRip(time_t time, const RIP_INFO& info, const PROCESS_INFORMATION& pi, const std::wstring& errorMessage) {
+	Post(false, [time, info, pi, errorMessage](IDebuggerEventHandler& handler) {
+		handler.OnRip(time, info, pi, errorMessage);
+	});
+}
+
+/// <summary>
+/// Post a snapshot of the module unload event to all handlers.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="path">The module path.</param>
+/// <param name="moduleIndex">The index of the module in the collection.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnDllUnload(time_t time, const UNLOAD_DLL_DEBUG_INFO& info, const PROCESS_INFORMATION& pi, const std::wstring& path, int moduleIndex, const ModuleCollection& collection) {
+	Post(true, [time, info, pi, path, moduleIndex, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnDllUnload(time, info, pi, path, moduleIndex, *modules);
+	});
+}
+
+/// <summary>
+/// Post the completion of the module collection to all handlers and wait until all handlers have processed it, this is the last event of a session.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void DispatchingDebuggerEventHandler::OnModuleCollectionComplete(time_t time, const ModuleCollection& collection) {
+	Post(true, [time, modules = Snapshot(collection)](IDebuggerEventHandler& handler) {
+		handler.OnModuleCollectionComplete(time, *modules);
+	});
+
+	Drain();
+}
+
+/// <summary>
+/// Get an immutable snapshot of <paramref name="collection"/>, the previous snapshot is reused when the
+/// collection has not changed since.
+/// </summary>
+/// <param name="collection">The module collection of the debugger or player.</param>
+/// <returns>A shared pointer to the snapshot.</returns>
+std::shared_ptr<const ModuleCollection> DispatchingDebuggerEventHandler::Snapshot(const ModuleCollection& collection) {
+	if (m_Collection == nullptr || m_Source != &collection || m_Generation != collection.Generation()) {
+		m_Collection = std::make_shared<const ModuleCollection>(collection);
+		m_Source	 = &collection;
+		m_Generation = collection.Generation();
+	}
+
+	return m_Collection;
+}
+
+/// <summary>
+/// Post an event to the queues of all handlers.
+/// </summary>
+/// <param name="essential">True when the event may never be discarded.</param>
+/// <param name="deliver">Calls the event method of a handler with the snapshot data.</param>
+void DispatchingDebuggerEventHandler::Post(bool essential, std::function<void(IDebuggerEventHandler&)> deliver) {
+	auto event = std::make_shared<DispatchedEvent>();
+	event->Essential = essential;
+	event->Deliver	 = std::move(deliver);
+
+	std::shared_ptr<const DispatchedEvent> snapshot = event;
+	for (auto& channel : m_Channels)
+		channel->Post(snapshot);
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#ifndef dispatching_debugger_event_handler_h
+#define dispatching_debugger_event_handler_h
+	#include "IDebuggerEventHandler.hpp"
+	#include <deque>
+	#include <mutex>
+	#include <thread>
+	#include <condition_variable>
+	#include <functional>
+	#include <exception>
+	#include <memory>
+	#include <vector>
+	#include <cstdint>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace EventHandler {
+				/// <summary>
+				/// Describes what a <see cref="::Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler"/> does with a new
+				/// event when the queue of a handler is full. Events that describe the process or its modules (initialization, process
+				/// creation and exit, module loads and unloads and the completion of the module collection) are never discarded,
+				/// because every event after them depends on them.
+				/// </summary>
+				enum class BackpressurePolicy {
+					Block,		/* wait until the handler has made room in its queue */
+					DropOldest,	/* discard the oldest queued event that may be discarded */
+					Sample		/* discard new events while the queue is full, except every SampleInterval-th event, which waits for room */
+				};
+
+				/// <summary>
+				/// An immutable snapshot of one debug event, which is shared by the queues of all handlers. All arguments of the
+				/// event are copied (or shared, when they are already immutable and reference counted) into the snapshot, so the
+				/// debugger can continue while the handlers are still processing the event.
+				/// </summary>
+				struct DispatchedEvent {
+					bool Essential = false;										/* True when the event is never discarded */
+					std::function<void(IDebuggerEventHandler&)> Deliver;		/* Calls the event method of a handler with the snapshot data */
+				};
+
+				/// <summary>
+				/// The queue and worker thread of one handler of a <see cref="::Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler"/>.
+				/// The worker delivers the queued events to the handler one at a time and in order.
+				/// </summary>
+				class DispatchChannel {
+					private:
+						std::shared_ptr<IDebuggerEventHandler>				m_Handler;		/* The handler that receives the events */
+						BackpressurePolicy									m_Policy;		/* Determines what happens when the queue is full */
+						size_t												m_Capacity;		/* The maximum number of queued events */
+
+						std::deque<std::shared_ptr<const DispatchedEvent>>	m_Queue;		/* The events that were not delivered yet, oldest first */
+						std::mutex											m_Mutex;		/* Guards all members below */
+						std::condition_variable								m_Produced;		/* Signalled when an event is queued or the channel stops */
+						std::condition_variable								m_Consumed;		/* Signalled when the worker takes an event or finishes one */
+						bool												m_Busy;			/* True while the worker is delivering an event */
+						bool												m_Stopping;		/* Signals the worker to stop once the queue is empty */
+						bool												m_Failed;		/* True when the handler has thrown, no further events are delivered */
+						std::exception_ptr									m_Error;		/* The exception thrown by the handler, until it is rethrown to the producer */
+						uint64_t											m_Pressure;		/* The number of events that arrived at a full queue with BackpressurePolicy::Sample */
+						uint64_t											m_Dropped;		/* The number of discarded events */
+						std::thread											m_Thread;		/* The worker thread */
+
+					public:
+						/// <summary>
+						/// With <see cref="::Hindsight::Debugger::EventHandler::BackpressurePolicy::Sample"/>, one in this many events that
+						/// arrive at a full queue is kept.
+						/// </summary>
+						static const uint64_t SampleInterval = 8;
+
+						/// <summary>
+						/// Construct a new DispatchChannel and start its worker thread.
+						/// </summary>
+						/// <param name="handler">The handler that receives the events.</param>
+						/// <param name="policy">Determines what happens when the queue is full.</param>
+						/// <param name="capacity">The maximum number of queued events, which must be at least 1.</param>
+						DispatchChannel(std::shared_ptr<IDebuggerEventHandler> handler, BackpressurePolicy policy, size_t capacity);
+
+						/// <summary>
+						/// Deliver all remaining events and stop the worker thread.
+						/// </summary>
+						~DispatchChannel();
+
+						DispatchChannel(const DispatchChannel&) = delete;
+						DispatchChannel& operator=(const DispatchChannel&) = delete;
+
+						/// <summary>
+						/// Queue <paramref name="event"/> for the handler, applying the backpressure policy when the queue is full.
+						/// </summary>
+						/// <param name="event">The event snapshot.</param>
+						/// <exception cref="std::exception">The exception that the handler threw while processing an earlier event is rethrown here, once.</exception>
+						void Post(std::shared_ptr<const DispatchedEvent> event);
+
+						/// <summary>
+						/// Wait until the handler has processed all queued events.
+						/// </summary>
+						/// <exception cref="std::exception">The exception that the handler threw while processing an earlier event is rethrown here, once.</exception>
+						void Drain();
+
+						/// <summary>
+						/// Get the number of events that were discarded because of the backpressure policy.
+						/// </summary>
+						/// <returns>The number of discarded events.</returns>
+						uint64_t Dropped();
+
+					private:
+						/// <summary>
+						/// The worker thread, which delivers queued events until the channel stops.
+						/// </summary>
+						void Run();
+
+						/// <summary>
+						/// Rethrow the exception of the handler when it was not rethrown yet, the lock on <see cref="m_Mutex"/> must be held.
+						/// </summary>
+						void RethrowError();
+				};
+
+				/// <summary>
+				/// An implementation of <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/> that owns other handlers
+				/// and gives each of them its own bounded queue and worker thread, so that a slow handler (such as colorized console
+				/// output) does not hold up the debugged process or the other handlers. Every handler still receives all events it
+				/// is given in the original order. Events are snapshotted once and shared by all queues; the module collection is
+				/// only copied again when a module was loaded or unloaded. Adding this handler to a debugger or player in place of
+				/// the handlers it owns is all that is needed.
+				/// </summary>
+				class DispatchingDebuggerEventHandler : public IDebuggerEventHandler {
+					private:
+						std::vector<std::unique_ptr<DispatchChannel>>	m_Channels;		/* One channel per handler */
+						BackpressurePolicy								m_Policy;		/* The default policy for new handlers */
+						size_t											m_Capacity;		/* The queue size for new handlers */
+
+						std::shared_ptr<const ModuleCollection>			m_Collection;	/* The latest snapshot of the module collection */
+						const ModuleCollection*							m_Source;		/* The collection that m_Collection was copied from */
+						uint64_t										m_Generation;	/* The generation of m_Source when it was copied */
+
+					public:
+						/// <summary>
+						/// The default maximum number of queued events per handler.
+						/// </summary>
+						static const size_t DefaultQueueSize = 1024;
+
+						/// <summary>
+						/// Construct a new DispatchingDebuggerEventHandler without any handlers.
+						/// </summary>
+						/// <param name="policy">The backpressure policy for handlers that are added without one.</param>
+						/// <param name="capacity">The maximum number of queued events per handler.</param>
+						DispatchingDebuggerEventHandler(BackpressurePolicy policy = BackpressurePolicy::Block, size_t capacity = DefaultQueueSize);
+
+						/// <summary>
+						/// Deliver all remaining events to all handlers and stop the worker threads.
+						/// </summary>
+						~DispatchingDebuggerEventHandler();
+
+						/// <summary>
+						/// Add a handler with the default backpressure policy.
+						/// </summary>
+						/// <param name="handler">The handler, which is only called from its own worker thread from now on.</param>
+						void AddHandler(std::shared_ptr<IDebuggerEventHandler> handler);
+
+						/// <summary>
+						/// Add a handler with a specific backpressure policy, for example <see cref="::Hindsight::Debugger::EventHandler::BackpressurePolicy::Block"/>
+						/// for handlers that must not lose any event.
+						/// </summary>
+						/// <param name="handler">The handler, which is only called from its own worker thread from now on.</param>
+						/// <param name="policy">Determines what happens when the queue of the handler is full.</param>
+						void AddHandler(std::shared_ptr<IDebuggerEventHandler> handler, BackpressurePolicy policy);
+
+						/// <summary>
+						/// Wait until all handlers have processed all queued events.
+						/// </summary>
+						void Drain();
+
+						/// <summary>
+						/// Get the total number of events that were discarded because of the backpressure policies.
+						/// </summary>
+						/// <returns>The number of discarded events, summed over all handlers.</returns>
+						uint64_t Dropped();
+
+						/// <summary>
+						/// Post the initialization event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="p">The process being debugged.</param>
+						void OnInitialization(
+							time_t time,
+							const std::shared_ptr<const Hindsight::Process::Process> p) override;
+
+						/// <summary>
+						/// Post a snapshot of the breakpoint event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance, which is shared by the snapshot.</param>
+						/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance, which is shared by the snapshot.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnBreakpointHit(
+							time_t time,
+							const EXCEPTION_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							std::shared_ptr<const DebugContext> context,
+							std::shared_ptr<const DebugStackTrace> trace,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post a snapshot of the exception event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="firstChance">Whether this is a first chance exception.</param>
+						/// <param name="name">The name of the exception code.</param>
+						/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance, which is shared by the snapshot.</param>
+						/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance, which is shared by the snapshot.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						/// <param name="ertti">A shared pointer to the C++ exception run-time type information, or nullptr.</param>
+						void OnException(
+							time_t time,
+							const EXCEPTION_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							bool firstChance,
+							const std::wstring& name,
+							std::shared_ptr<const DebugContext> context,
+							std::shared_ptr<const DebugStackTrace> trace,
+							const ModuleCollection& collection,
+							std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation> ertti) override;
+
+						/// <summary>
+						/// Post a snapshot of the process creation event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="path">The module path.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnCreateProcess(
+							time_t time,
+							const CREATE_PROCESS_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& path,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post a snapshot of the thread creation event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnCreateThread(
+							time_t time,
+							const CREATE_THREAD_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post a snapshot of the process exit event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnExitProcess(
+							time_t time,
+							const EXIT_PROCESS_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post a snapshot of the thread exit event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnExitThread(
+							time_t time,
+							const EXIT_THREAD_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post a snapshot of the module load event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="path">The module path.</param>
+						/// <param name="moduleIndex">The index of the module in the collection.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnDllLoad(
+							time_t time,
+							const LOAD_DLL_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& path,
+							int moduleIndex,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post a snapshot of the debug string event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="string">The debug string.</param>
+						void OnDebugString(
+							time_t time,
+							const OUTPUT_DEBUG_STRING_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::string& string) override;
+
+						/// <summary>
+						/// Post a snapshot of the wide debug string event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="string">The debug string.</param>
+						void OnDebugStringW(
+							time_t time,
+							const OUTPUT_DEBUG_STRING_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& string) override;
+
+						/// <summary>
+						/// Post a snapshot of the RIP event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="errorMessage">The error message of the RIP event.</param>
+						void OnRip(
+							time_t time,
+							const RIP_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& errorMessage) override;
+
+						/// <summary>
+						/// Post a snapshot of the module unload event to all handlers.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the event information, which is copied into the snapshot.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="path">The module path.</param>
+						/// <param name="moduleIndex">The index of the module in the collection.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnDllUnload(
+							time_t time,
+							const UNLOAD_DLL_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& path,
+							int moduleIndex,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Post the completion of the module collection to all handlers and wait until all handlers have processed it, this is the last event of a session.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnModuleCollectionComplete(
+							time_t time,
+							const ModuleCollection& collection) override;
+
+					private:
+						/// <summary>
+						/// Get an immutable snapshot of <paramref name="collection"/>, the previous snapshot is reused when the
+						/// collection has not changed since.
+						/// </summary>
+						/// <param name="collection">The module collection of the debugger or player.</param>
+						/// <returns>A shared pointer to the snapshot.</returns>
+						std::shared_ptr<const ModuleCollection> Snapshot(const ModuleCollection& collection);
+
+						/// <summary>
+						/// Post an event to the queues of all handlers.
+						/// </summary>
+						/// <param name="essential">True when the event may never be discarded.</param>
+						/// <param name="deliver">Calls the event method of a handler with the snapshot data.</param>
+						void Post(bool essential, std::function<void(IDebuggerEventHandler&)> deliver);
+				};
+			}
+		}
+	}
+
+#endif
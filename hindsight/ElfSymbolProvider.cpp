@@ -0,0 +1,754 @@
+#include "ElfSymbolProvider.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Hindsight::Debugger;
+
+static const uint32_t segment_load			= 1;
+static const uint32_t section_symtab		= 2;
+static const uint32_t section_note			= 7;
+static const uint32_t section_nobits		= 8;
+static const uint32_t section_dynsym		= 11;
+static const uint64_t section_compressed	= 0x800;
+static const uint32_t note_gnu_build_id		= 3;
+static const uint32_t no_file				= UINT32_MAX;
+
+/// <summary>
+/// Read a value of type <typeparamref name="TRead"/> and advance the position.
+/// </summary>
+/// <param name="data">The data to read from.</param>
+/// <param name="position">A reference to the read position.</param>
+/// <typeparam name="TRead">The type to read.</typeparam>
+/// <returns>The value.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when the data ends before the value.</exception>
+template <typename TRead>
+static TRead read_value(const std::vector<uint8_t>& data, size_t& position) {
+	if (position > data.size() || data.size() - position < sizeof(TRead))
+		throw std::runtime_error("unexpected end of ELF data");
+
+	TRead value;
+	std::memcpy(&value, data.data() + position, sizeof(TRead));
+	position += sizeof(TRead);
+	return value;
+}
+
+/// <summary>
+/// Read a word of the ELF class: 8 bytes for ELFCLASS64, 4 bytes for ELFCLASS32.
+/// </summary>
+/// <param name="data">The data to read from.</param>
+/// <param name="position">A reference to the read position.</param>
+/// <param name="is64">true for ELFCLASS64.</param>
+/// <returns>The value.</returns>
+static uint64_t read_word(const std::vector<uint8_t>& data, size_t& position, bool is64) {
+	return is64 ? read_value<uint64_t>(data, position) : read_value<uint32_t>(data, position);
+}
+
+/// <summary>
+/// Read a DWARF offset: 8 bytes in the 64-bit DWARF format, 4 bytes in the 32-bit format.
+/// </summary>
+/// <param name="data">The data to read from.</param>
+/// <param name="position">A reference to the read position.</param>
+/// <param name="dwarf64">true for the 64-bit DWARF format.</param>
+/// <returns>The value.</returns>
+static uint64_t read_offset(const std::vector<uint8_t>& data, size_t& position, bool dwarf64) {
+	return dwarf64 ? read_value<uint64_t>(data, position) : read_value<uint32_t>(data, position);
+}
+
+/// <summary>
+/// Read an unsigned LEB128 value.
+/// </summary>
+/// <param name="data">The data to read from.</param>
+/// <param name="position">A reference to the read position.</param>
+/// <returns>The value.</returns>
+static uint64_t read_uleb(const std::vector<uint8_t>& data, size_t& position) {
+	uint64_t result = 0;
+	unsigned shift = 0;
+	uint8_t byte;
+
+	do {
+		byte = read_value<uint8_t>(data, position);
+		if (shift < 64)
+			result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	return result;
+}
+
+/// <summary>
+/// Read a signed LEB128 value.
+/// </summary>
+/// <param name="data">The data to read from.</param>
+/// <param name="position">A reference to the read position.</param>
+/// <returns>The value.</returns>
+static int64_t read_sleb(const std::vector<uint8_t>& data, size_t& position) {
+	uint64_t result = 0;
+	unsigned shift = 0;
+	uint8_t byte;
+
+	do {
+		byte = read_value<uint8_t>(data, position);
+		if (shift < 64)
+			result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	if (shift < 64 && (byte & 0x40))
+		result |= ~static_cast<uint64_t>(0) << shift;
+
+	return static_cast<int64_t>(result);
+}
+
+/// <summary>
+/// Read a string that is terminated by a \0 character and advance the position past it.
+/// </summary>
+/// <param name="data">The data to read from.</param>
+/// <param name="position">A reference to the read position.</param>
+/// <returns>The string.</returns>
+static std::string read_string(const std::vector<uint8_t>& data, size_t& position) {
+	if (position >= data.size())
+		throw std::runtime_error("unexpected end of ELF data");
+
+	auto start = reinterpret_cast<const char*>(data.data() + position);
+	auto end = static_cast<const char*>(std::memchr(start, 0, data.size() - position));
+	if (end == nullptr)
+		throw std::runtime_error("unterminated string in ELF data");
+
+	position += static_cast<size_t>(end - start) + 1;
+	return std::string(start, end);
+}
+
+/// <summary>
+/// Get the string at <paramref name="offset"/> in a string table.
+/// </summary>
+/// <param name="table">The string table.</param>
+/// <param name="offset">The offset of the string.</param>
+/// <returns>The string, or "" when the offset is outside of the table.</returns>
+static std::string string_at(const std::vector<uint8_t>& table, uint64_t offset) {
+	if (offset >= table.size())
+		return "";
+
+	auto position = static_cast<size_t>(offset);
+	return read_string(table, position);
+}
+
+/// <summary>
+/// Join a DWARF directory and file name.
+/// </summary>
+/// <param name="directory">The directory, which may be "".</param>
+/// <param name="name">The file name, which is used as is when it is absolute.</param>
+/// <returns>The path.</returns>
+static std::string join_path(const std::string& directory, const std::string& name) {
+	if (directory.empty() || name.empty() || name[0] == '/' || (name.size() > 1 && name[1] == ':'))
+		return name;
+
+	return directory.back() == '/' ? directory + name : directory + "/" + name;
+}
+
+/// <summary>
+/// Read the symbols and line tables of an ELF image.
+/// </summary>
+/// <param name="path">The path of the image, or of its separate debug file.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be read or is not a little-endian ELF image.</exception>
+ElfSymbolProvider::ElfSymbolProvider(const std::string& path)
+	: m_Path(path), m_File(path, std::ios::in | std::ios::binary), m_Is64(false), m_Bias(0) {
+
+	if (!m_File.is_open())
+		throw std::runtime_error("cannot open file for reading: " + path);
+
+	auto ident = ReadAt(0, 16);
+	if (ident[0] != 0x7f || ident[1] != 'E' || ident[2] != 'L' || ident[3] != 'F' || (ident[4] != 1 && ident[4] != 2))
+		throw std::runtime_error("file is not an ELF image: " + path);
+
+	if (ident[5] != 1)
+		throw std::runtime_error("big-endian ELF images are not supported: " + path);
+
+	m_Is64 = ident[4] == 2;
+
+	// skip e_ident, e_type, e_machine and e_version
+	auto header = ReadAt(0, m_Is64 ? 64 : 52);
+	size_t position = 24;
+
+	read_word(header, position, m_Is64);
+	auto programOffset		= read_word(header, position, m_Is64);
+	auto sectionOffset		= read_word(header, position, m_Is64);
+	read_value<uint32_t>(header, position);
+	read_value<uint16_t>(header, position);
+	auto programEntrySize	= read_value<uint16_t>(header, position);
+	auto programCount		= read_value<uint16_t>(header, position);
+	auto sectionEntrySize	= read_value<uint16_t>(header, position);
+	auto sectionCount		= read_value<uint16_t>(header, position);
+	auto sectionNames		= read_value<uint16_t>(header, position);
+
+	ReadSegments(programOffset, programEntrySize, programCount);
+	ReadSections(sectionOffset, sectionEntrySize, sectionCount, sectionNames);
+
+	for (const auto& section : m_Sections) {
+		if (section.Type == section_symtab || section.Type == section_dynsym)
+			ReadSymbols(section);
+	}
+
+	// aliases share an address, the largest one wins the lookup
+	std::sort(m_Symbols.begin(), m_Symbols.end(), [](const Symbol& a, const Symbol& b) {
+		return a.Address != b.Address ? a.Address < b.Address : a.Size < b.Size;
+	});
+
+	ReadBuildId();
+	ReadLines();
+
+	m_File.close();
+}
+
+/// <summary>
+/// Look up the symbol and source line of an address in the module.
+/// </summary>
+/// <param name="rva">The address, relative to the module base, which is the start of the lowest mapping of the image.</param>
+/// <param name="record">A reference to the record that receives the result.</param>
+/// <returns>true when a symbol or a source line was found.</returns>
+bool ElfSymbolProvider::Lookup(uint64_t rva, SymbolRecord& record) {
+	auto address = m_Bias + rva;
+
+	auto symbol = std::upper_bound(m_Symbols.begin(), m_Symbols.end(), address, [](uint64_t value, const Symbol& entry) {
+		return value < entry.Address;
+	});
+
+	if (symbol != m_Symbols.begin()) {
+		--symbol;
+
+		// a symbol without a size only covers its own address
+		if (address - symbol->Address < (symbol->Size != 0 ? symbol->Size : 1)) {
+			record.HasSymbol  = true;
+			record.Name		  = symbol->Name;
+			record.SymbolRva  = symbol->Address - m_Bias;
+			record.SymbolSize = symbol->Size;
+		}
+	}
+
+	auto row = std::upper_bound(m_Rows.begin(), m_Rows.end(), address, [](uint64_t value, const Row& entry) {
+		return value < entry.Address;
+	});
+
+	// the row before the address covers it, unless it ends a sequence
+	if (row != m_Rows.begin()) {
+		--row;
+
+		if (!row->End && row->File != no_file) {
+			record.HasLine = true;
+			record.File	   = m_Files[row->File];
+			record.Line	   = row->Line;
+			record.LineRva = row->Address - m_Bias;
+		}
+	}
+
+	return record.HasSymbol || record.HasLine;
+}
+
+/// <summary>
+/// Get the GNU build ID of the image.
+/// </summary>
+/// <returns>The build ID in hexadecimal, or "" when the image has none.</returns>
+const std::string& ElfSymbolProvider::BuildId() const noexcept {
+	return m_BuildId;
+}
+
+/// <summary>
+/// Get a string that identifies this build of the image, such as for a symbol cache.
+/// </summary>
+/// <returns>The identity string, or "" when the image has no build ID.</returns>
+std::string ElfSymbolProvider::Key() const {
+	return m_BuildId.empty() ? "" : "elf:" + m_BuildId;
+}
+
+/// <summary>
+/// Read the program headers, for the module base and the loaded address ranges.
+/// </summary>
+/// <param name="offset">The offset of the program header table.</param>
+/// <param name="entrySize">The size of a program header.</param>
+/// <param name="count">The number of program headers.</param>
+void ElfSymbolProvider::ReadSegments(uint64_t offset, uint16_t entrySize, uint16_t count) {
+	if (count == 0 || entrySize < (m_Is64 ? 56 : 32))
+		return;
+
+	auto table = ReadAt(offset, static_cast<uint64_t>(entrySize) * count);
+	bool first = true;
+
+	for (uint16_t i = 0; i < count; ++i) {
+		size_t position = static_cast<size_t>(i) * entrySize;
+		uint64_t address = 0, size = 0;
+
+		auto type = read_value<uint32_t>(table, position);
+		if (m_Is64) {
+			position += 4 + 8;
+			address = read_value<uint64_t>(table, position);
+			position += 8 + 8;
+			size = read_value<uint64_t>(table, position);
+		} else {
+			position += 4;
+			address = read_value<uint32_t>(table, position);
+			position += 4 + 4;
+			size = read_value<uint32_t>(table, position);
+		}
+
+		if (type != segment_load)
+			continue;
+
+		m_Loads.emplace_back(address, address + size);
+
+		// the module base is the start of the page of the lowest segment, where the image is mapped from
+		auto page = address & ~static_cast<uint64_t>(0xfff);
+		if (first || page < m_Bias)
+			m_Bias = page;
+
+		first = false;
+	}
+}
+
+/// <summary>
+/// Read the section headers and their names.
+/// </summary>
+/// <param name="offset">The offset of the section header table.</param>
+/// <param name="entrySize">The size of a section header.</param>
+/// <param name="count">The number of section headers.</param>
+/// <param name="names">The index of the section name string table.</param>
+void ElfSymbolProvider::ReadSections(uint64_t offset, uint16_t entrySize, uint16_t count, uint16_t names) {
+	if (count == 0 || entrySize < (m_Is64 ? 64 : 40))
+		return;
+
+	auto table = ReadAt(offset, static_cast<uint64_t>(entrySize) * count);
+	std::vector<uint32_t> nameOffsets;
+
+	for (uint16_t i = 0; i < count; ++i) {
+		size_t position = static_cast<size_t>(i) * entrySize;
+		Section section;
+
+		nameOffsets.push_back(read_value<uint32_t>(table, position));
+		section.Type	= read_value<uint32_t>(table, position);
+		section.Flags	= read_word(table, position, m_Is64);
+		read_word(table, position, m_Is64);
+		section.Offset	= read_word(table, position, m_Is64);
+		section.Size	= read_word(table, position, m_Is64);
+		section.Link	= read_value<uint32_t>(table, position);
+
+		m_Sections.push_back(section);
+	}
+
+	if (names >= m_Sections.size())
+		return;
+
+	auto strings = ReadSection(&m_Sections[names]);
+	for (size_t i = 0; i < m_Sections.size(); ++i)
+		m_Sections[i].Name = string_at(strings, nameOffsets[i]);
+}
+
+/// <summary>
+/// Read the function symbols of a symbol table section.
+/// </summary>
+/// <param name="section">The symbol table section.</param>
+void ElfSymbolProvider::ReadSymbols(const Section& section) {
+	if (section.Link >= m_Sections.size())
+		return;
+
+	auto symbols = ReadSection(&section);
+	auto strings = ReadSection(&m_Sections[section.Link]);
+	size_t entrySize = m_Is64 ? 24 : 16;
+
+	for (size_t position = 0; position + entrySize <= symbols.size(); ) {
+		uint32_t name = 0;
+		uint8_t info = 0;
+		uint16_t index = 0;
+		uint64_t value = 0, size = 0;
+
+		name = read_value<uint32_t>(symbols, position);
+		if (m_Is64) {
+			info  = read_value<uint8_t>(symbols, position);
+			read_value<uint8_t>(symbols, position);
+			index = read_value<uint16_t>(symbols, position);
+			value = read_value<uint64_t>(symbols, position);
+			size  = read_value<uint64_t>(symbols, position);
+		} else {
+			value = read_value<uint32_t>(symbols, position);
+			size  = read_value<uint32_t>(symbols, position);
+			info  = read_value<uint8_t>(symbols, position);
+			read_value<uint8_t>(symbols, position);
+			index = read_value<uint16_t>(symbols, position);
+		}
+
+		// STT_FUNC and STT_GNU_IFUNC that are defined in this image
+		auto type = info & 0xf;
+		if ((type != 2 && type != 10) || index == 0 || value == 0)
+			continue;
+
+		auto text = string_at(strings, name);
+		if (!text.empty())
+			m_Symbols.push_back({ value, size, text });
+	}
+}
+
+/// <summary>
+/// Read the GNU build ID note, if any.
+/// </summary>
+void ElfSymbolProvider::ReadBuildId() {
+	static const char digits[] = "0123456789abcdef";
+
+	for (const auto& section : m_Sections) {
+		if (section.Type != section_note)
+			continue;
+
+		auto notes = ReadSection(&section);
+		size_t position = 0;
+
+		// a note is the name size, descriptor size and type followed by the name and descriptor, each aligned to 4 bytes
+		while (position + 12 <= notes.size()) {
+			auto nameSize = read_value<uint32_t>(notes, position);
+			auto descSize = read_value<uint32_t>(notes, position);
+			auto type	  = read_value<uint32_t>(notes, position);
+			auto name	  = position;
+			auto desc	  = name + ((static_cast<size_t>(nameSize) + 3) & ~static_cast<size_t>(3));
+
+			if (desc + descSize > notes.size())
+				break;
+
+			if (type == note_gnu_build_id && nameSize == 4 && std::memcmp(notes.data() + name, "GNU", 4) == 0) {
+				for (size_t i = 0; i < descSize; ++i) {
+					m_BuildId += digits[notes[desc + i] >> 4];
+					m_BuildId += digits[notes[desc + i] & 0xf];
+				}
+
+				return;
+			}
+
+			position = desc + ((static_cast<size_t>(descSize) + 3) & ~static_cast<size_t>(3));
+		}
+	}
+}
+
+/// <summary>
+/// Run the line number programs of all units in .debug_line.
+/// </summary>
+void ElfSymbolProvider::ReadLines() {
+	auto lines		 = ReadSection(FindSection(".debug_line"));
+	auto strings	 = ReadSection(FindSection(".debug_str"));
+	auto lineStrings = ReadSection(FindSection(".debug_line_str"));
+
+	std::unordered_map<std::string, uint32_t> files;
+	size_t position = 0;
+
+	while (position + 4 <= lines.size()) {
+		uint64_t length = read_value<uint32_t>(lines, position);
+		bool dwarf64 = length == 0xffffffff;
+
+		if (dwarf64)
+			length = read_value<uint64_t>(lines, position);
+
+		if (length > lines.size() - position)
+			break;
+
+		auto end = position + static_cast<size_t>(length);
+
+		// a unit that cannot be read only loses its own lines
+		try {
+			ReadLineUnit(lines, position, end, dwarf64, strings, lineStrings, files);
+		} catch (const std::runtime_error&) {
+
+		}
+
+		position = end;
+	}
+
+	// sequences may come in any order, a sequence that ends where the next one starts yields to it
+	std::stable_sort(m_Rows.begin(), m_Rows.end(), [](const Row& a, const Row& b) {
+		return a.Address != b.Address ? a.Address < b.Address : a.End && !b.End;
+	});
+}
+
+/// <summary>
+/// Run the line number program of one unit in .debug_line.
+/// </summary>
+/// <param name="lines">The contents of .debug_line.</param>
+/// <param name="position">The offset of the unit, after its length.</param>
+/// <param name="end">The offset of the end of the unit.</param>
+/// <param name="dwarf64">true for the 64-bit DWARF format.</param>
+/// <param name="strings">The contents of .debug_str.</param>
+/// <param name="lineStrings">The contents of .debug_line_str.</param>
+/// <param name="files">The indices in <see cref="m_Files"/> by path, shared by all units.</param>
+void ElfSymbolProvider::ReadLineUnit(const std::vector<uint8_t>& lines, size_t position, size_t end, bool dwarf64,
+	const std::vector<uint8_t>& strings, const std::vector<uint8_t>& lineStrings, std::unordered_map<std::string, uint32_t>& files) {
+
+	auto version = read_value<uint16_t>(lines, position);
+	if (version < 2 || version > 5)
+		return;
+
+	// skip the address and segment selector sizes, DW_LNE_set_address carries its own size
+	if (version >= 5)
+		position += 2;
+
+	auto headerLength = read_offset(lines, position, dwarf64);
+	if (headerLength > end - position)
+		return;
+
+	auto program			= position + static_cast<size_t>(headerLength);
+	auto minimumLength		= read_value<uint8_t>(lines, position);
+	if (version >= 4)
+		read_value<uint8_t>(lines, position);
+	read_value<uint8_t>(lines, position);
+	auto lineBase			= static_cast<int8_t>(read_value<uint8_t>(lines, position));
+	auto lineRange			= read_value<uint8_t>(lines, position);
+	auto opcodeBase			= read_value<uint8_t>(lines, position);
+
+	if (lineRange == 0 || opcodeBase == 0)
+		return;
+
+	std::vector<uint8_t> opcodeLengths;
+	for (uint8_t i = 1; i < opcodeBase; ++i)
+		opcodeLengths.push_back(read_value<uint8_t>(lines, position));
+
+	std::vector<std::string> directories;
+	std::vector<uint32_t> fileIndices;
+
+	auto add_file = [this, &files, &fileIndices](const std::string& path) {
+		auto it = files.find(path);
+		if (it == files.end()) {
+			it = files.emplace(path, static_cast<uint32_t>(m_Files.size())).first;
+			m_Files.push_back(path);
+		}
+
+		fileIndices.push_back(it->second);
+	};
+
+	auto directory_of = [&directories](uint64_t index) {
+		return index < directories.size() ? directories[static_cast<size_t>(index)] : std::string();
+	};
+
+	if (version >= 5) {
+		// DWARF 5 describes the directory and file entries with a list of (content type, form) pairs
+		auto read_entries = [&](bool isFile) {
+			std::vector<std::pair<uint64_t, uint64_t>> formats(read_value<uint8_t>(lines, position));
+			for (auto& format : formats) {
+				format.first  = read_uleb(lines, position);
+				format.second = read_uleb(lines, position);
+			}
+
+			auto count = read_uleb(lines, position);
+			for (uint64_t i = 0; i < count; ++i) {
+				std::string name;
+				uint64_t directory = 0;
+
+				for (const auto& format : formats) {
+					std::string text;
+					uint64_t number = 0;
+
+					switch (format.second) {
+						case 0x08: text = read_string(lines, position); break;									// DW_FORM_string
+						case 0x0e: text = string_at(strings, read_offset(lines, position, dwarf64)); break;		// DW_FORM_strp
+						case 0x1f: text = string_at(lineStrings, read_offset(lines, position, dwarf64)); break;	// DW_FORM_line_strp
+						case 0x0b: number = read_value<uint8_t>(lines, position); break;						// DW_FORM_data1
+						case 0x05: number = read_value<uint16_t>(lines, position); break;						// DW_FORM_data2
+						case 0x06: number = read_value<uint32_t>(lines, position); break;						// DW_FORM_data4
+						case 0x07: number = read_value<uint64_t>(lines, position); break;						// DW_FORM_data8
+						case 0x0f: number = read_uleb(lines, position); break;									// DW_FORM_udata
+						case 0x1e: position += 16; break;														// DW_FORM_data16
+						case 0x09: position += static_cast<size_t>(read_uleb(lines, position)); break;			// DW_FORM_block
+						default: throw std::runtime_error("unsupported DWARF form in line table header");
+					}
+
+					// DW_LNCT_path and DW_LNCT_directory_index
+					if (format.first == 1)
+						name = text;
+					else if (format.first == 2)
+						directory = number;
+				}
+
+				if (isFile)
+					add_file(join_path(directory_of(directory), name));
+				else
+					directories.push_back(name);
+			}
+		};
+
+		read_entries(false);
+		read_entries(true);
+	} else {
+		// the compilation directory is entry 0, which is not part of the table
+		directories.push_back("");
+		for (auto name = read_string(lines, position); !name.empty(); name = read_string(lines, position))
+			directories.push_back(name);
+
+		// files are numbered from 1
+		fileIndices.push_back(no_file);
+		for (auto name = read_string(lines, position); !name.empty(); name = read_string(lines, position)) {
+			auto directory = read_uleb(lines, position);
+			read_uleb(lines, position);
+			read_uleb(lines, position);
+
+			add_file(join_path(directory_of(directory), name));
+		}
+	}
+
+	// run the state machine, the rows of a sequence are kept when the sequence is part of the loaded image
+	std::vector<Row> sequence;
+	uint64_t address = 0;
+	uint64_t file = 1;
+	int64_t line = 1;
+
+	auto emit = [&](bool isEnd) {
+		auto index = file < fileIndices.size() ? fileIndices[static_cast<size_t>(file)] : no_file;
+		sequence.push_back({ address, index, static_cast<uint32_t>(line), isEnd });
+	};
+
+	position = program;
+	while (position < end) {
+		auto opcode = read_value<uint8_t>(lines, position);
+
+		if (opcode >= opcodeBase) {
+			auto adjusted = static_cast<uint8_t>(opcode - opcodeBase);
+			address += static_cast<uint64_t>(adjusted / lineRange) * minimumLength;
+			line += lineBase + adjusted % lineRange;
+			emit(false);
+			continue;
+		}
+
+		switch (opcode) {
+			case 0: {
+				auto length = read_uleb(lines, position);
+				if (length > end - position)
+					throw std::runtime_error("extended opcode exceeds the line table");
+
+				auto next = position + static_cast<size_t>(length);
+				if (length == 0)
+					break;
+
+				switch (read_value<uint8_t>(lines, position)) {
+					case 1:	// DW_LNE_end_sequence
+						// rows at the end address cover no instructions
+						while (!sequence.empty() && sequence.back().Address == address)
+							sequence.pop_back();
+
+						emit(true);
+						if (IsLoaded(sequence.front().Address))
+							m_Rows.insert(m_Rows.end(), sequence.begin(), sequence.end());
+
+						sequence.clear();
+						address = 0;
+						file = 1;
+						line = 1;
+						break;
+
+					case 2:	// DW_LNE_set_address
+						address = length - 1 == 8 ? read_value<uint64_t>(lines, position) : length - 1 == 4 ? read_value<uint32_t>(lines, position) : 0;
+						break;
+
+					case 3: {	// DW_LNE_define_file
+						auto name = read_string(lines, position);
+						auto directory = read_uleb(lines, position);
+						add_file(join_path(directory_of(directory), name));
+						break;
+					}
+
+					default:
+						break;
+				}
+
+				position = next;
+				break;
+			}
+
+			case 1:		// DW_LNS_copy
+				emit(false);
+				break;
+
+			case 2:		// DW_LNS_advance_pc
+				address += read_uleb(lines, position) * minimumLength;
+				break;
+
+			case 3:		// DW_LNS_advance_line
+				line += read_sleb(lines, position);
+				break;
+
+			case 4:		// DW_LNS_set_file
+				file = read_uleb(lines, position);
+				break;
+
+			case 8:		// DW_LNS_const_add_pc
+				address += static_cast<uint64_t>((255 - opcodeBase) / lineRange) * minimumLength;
+				break;
+
+			case 9:		// DW_LNS_fixed_advance_pc
+				address += read_value<uint16_t>(lines, position);
+				break;
+
+			default:
+				// skip the operands of all other standard opcodes, known or not
+				for (uint8_t i = 0; i < opcodeLengths[opcode - 1]; ++i)
+					read_uleb(lines, position);
+				break;
+		}
+	}
+}
+
+/// <summary>
+/// Find a section by name.
+/// </summary>
+/// <param name="name">The section name.</param>
+/// <returns>The section, or nullptr when the image has no (uncompressed) section by that name.</returns>
+const ElfSymbolProvider::Section* ElfSymbolProvider::FindSection(const std::string& name) const {
+	for (const auto& section : m_Sections) {
+		if (section.Name == name)
+			return (section.Flags & section_compressed) ? nullptr : &section;
+	}
+
+	return nullptr;
+}
+
+/// <summary>
+/// Read the contents of a section.
+/// </summary>
+/// <param name="section">The section, or nullptr.</param>
+/// <returns>The contents, empty for a null section or one without data in the file.</returns>
+std::vector<uint8_t> ElfSymbolProvider::ReadSection(const Section* section) {
+	if (section == nullptr || section->Type == section_nobits || section->Size == 0 || (section->Flags & section_compressed))
+		return std::vector<uint8_t>();
+
+	return ReadAt(section->Offset, section->Size);
+}
+
+/// <summary>
+/// Read <paramref name="size"/> bytes at <paramref name="offset"/> in the file.
+/// </summary>
+/// <param name="offset">The offset in the file.</param>
+/// <param name="size">The number of bytes to read.</param>
+/// <returns>The data.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when the file is too short.</exception>
+std::vector<uint8_t> ElfSymbolProvider::ReadAt(uint64_t offset, uint64_t size) {
+	m_File.clear();
+	m_File.seekg(0, std::ios::end);
+
+	auto length = static_cast<uint64_t>(m_File.tellg());
+	if (offset > length || size > length - offset)
+		throw std::runtime_error("unexpected end of file: " + m_Path);
+
+	std::vector<uint8_t> data(static_cast<size_t>(size));
+	m_File.seekg(static_cast<std::streamoff>(offset));
+	m_File.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size));
+
+	if (static_cast<uint64_t>(m_File.gcount()) != size)
+		throw std::runtime_error("cannot read file: " + m_Path);
+
+	return data;
+}
+
+/// <summary>
+/// Determine if an address in the image is part of a loaded segment.
+/// </summary>
+/// <param name="address">The address in the image.</param>
+/// <returns>true when the address is loaded.</returns>
+bool ElfSymbolProvider::IsLoaded(uint64_t address) const {
+	// the line tables of functions that the linker discarded point at address 0 (or another tombstone)
+	for (const auto& load : m_Loads) {
+		if (address >= load.first && address < load.second)
+			return true;
+	}
+
+	return m_Loads.empty();
+}
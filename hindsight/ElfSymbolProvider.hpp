@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef debugger_elf_symbol_provider_h
+#define debugger_elf_symbol_provider_h
+	#include "SymbolProvider.hpp"
+
+	#include <cstdint>
+	#include <fstream>
+	#include <string>
+	#include <unordered_map>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The debug information of an ELF image: function symbols from .symtab and .dynsym, source lines from the DWARF line
+			/// tables in .debug_line (DWARF 2 to 5). Everything is read from the file once, when the provider is constructed, and
+			/// kept in sorted tables. Only little-endian images are supported and compressed debug sections are ignored. Names are
+			/// reported as they are stored, C++ names are not demangled. This class does not depend on any platform API, it is the
+			/// reference provider of the <see cref="::Hindsight::Debugger::OfflineSymbolizer"/> for the modules of a Linux process.
+			/// </summary>
+			class ElfSymbolProvider : public ISymbolProvider {
+				private:
+					struct Symbol {
+						uint64_t	Address;	/* The address of the symbol in the image */
+						uint64_t	Size;		/* The size of the symbol */
+						std::string	Name;		/* The symbol name */
+					};
+
+					struct Row {
+						uint64_t	Address;	/* The address of the row in the image */
+						uint32_t	File;		/* The index of the source file */
+						uint32_t	Line;		/* The line number */
+						bool		End;		/* True for the end of a sequence, which has no line */
+					};
+
+					struct Section {
+						std::string	Name;		/* The section name */
+						uint32_t	Type;		/* The section type */
+						uint64_t	Flags;		/* The section flags */
+						uint64_t	Offset;		/* The offset of the section in the file */
+						uint64_t	Size;		/* The size of the section */
+						uint32_t	Link;		/* The index of the linked section */
+					};
+
+					std::string									m_Path;		/* The path of the image */
+					std::ifstream								m_File;		/* The image, while it is being read */
+					bool										m_Is64;		/* True for ELFCLASS64 */
+					uint64_t									m_Bias;		/* The address in the image of the module base */
+					std::vector<std::pair<uint64_t, uint64_t>>	m_Loads;	/* The address ranges of the PT_LOAD segments */
+					std::vector<Section>						m_Sections;	/* The section headers */
+					std::string									m_BuildId;	/* The GNU build ID in hexadecimal, or "" */
+					std::vector<Symbol>							m_Symbols;	/* The function symbols, by address */
+					std::vector<Row>							m_Rows;		/* The line table rows of all units, by address */
+					std::vector<std::string>					m_Files;	/* The source files of the rows */
+
+				public:
+					/// <summary>
+					/// Read the symbols and line tables of an ELF image.
+					/// </summary>
+					/// <param name="path">The path of the image, or of its separate debug file.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be read or is not a little-endian ELF image.</exception>
+					ElfSymbolProvider(const std::string& path);
+
+					/// <summary>
+					/// Look up the symbol and source line of an address in the module.
+					/// </summary>
+					/// <param name="rva">The address, relative to the module base, which is the start of the lowest mapping of the image.</param>
+					/// <param name="record">A reference to the record that receives the result.</param>
+					/// <returns>true when a symbol or a source line was found.</returns>
+					bool Lookup(uint64_t rva, SymbolRecord& record) override;
+
+					/// <summary>
+					/// Get the GNU build ID of the image.
+					/// </summary>
+					/// <returns>The build ID in hexadecimal, or "" when the image has none.</returns>
+					const std::string& BuildId() const noexcept;
+
+					/// <summary>
+					/// Get a string that identifies this build of the image, such as for a symbol cache.
+					/// </summary>
+					/// <returns>The identity string, or "" when the image has no build ID.</returns>
+					std::string Key() const;
+
+				private:
+					/// <summary>
+					/// Read the program headers, for the module base and the loaded address ranges.
+					/// </summary>
+					/// <param name="offset">The offset of the program header table.</param>
+					/// <param name="entrySize">The size of a program header.</param>
+					/// <param name="count">The number of program headers.</param>
+					void ReadSegments(uint64_t offset, uint16_t entrySize, uint16_t count);
+
+					/// <summary>
+					/// Read the section headers and their names.
+					/// </summary>
+					/// <param name="offset">The offset of the section header table.</param>
+					/// <param name="entrySize">The size of a section header.</param>
+					/// <param name="count">The number of section headers.</param>
+					/// <param name="names">The index of the section name string table.</param>
+					void ReadSections(uint64_t offset, uint16_t entrySize, uint16_t count, uint16_t names);
+
+					/// <summary>
+					/// Read the function symbols of a symbol table section.
+					/// </summary>
+					/// <param name="section">The symbol table section.</param>
+					void ReadSymbols(const Section& section);
+
+					/// <summary>
+					/// Read the GNU build ID note, if any.
+					/// </summary>
+					void ReadBuildId();
+
+					/// <summary>
+					/// Run the line number programs of all units in .debug_line.
+					/// </summary>
+					void ReadLines();
+
+					/// <summary>
+					/// Run the line number program of one unit in .debug_line.
+					/// </summary>
+					/// <param name="lines">The contents of .debug_line.</param>
+					/// <param name="position">The offset of the unit, after its length.</param>
+					/// <param name="end">The offset of the end of the unit.</param>
+					/// <param name="dwarf64">true for the 64-bit DWARF format.</param>
+					/// <param name="strings">The contents of .debug_str.</param>
+					/// <param name="lineStrings">The contents of .debug_line_str.</param>
+					/// <param name="files">The indices in <see cref="m_Files"/> by path, shared by all units.</param>
+					void ReadLineUnit(const std::vector<uint8_t>& lines, size_t position, size_t end, bool dwarf64,
+						const std::vector<uint8_t>& strings, const std::vector<uint8_t>& lineStrings, std::unordered_map<std::string, uint32_t>& files);
+
+					/// <summary>
+					/// Find a section by name.
+					/// </summary>
+					/// <param name="name">The section name.</param>
+					/// <returns>The section, or nullptr when the image has no (uncompressed) section by that name.</returns>
+					const Section* FindSection(const std::string& name) const;
+
+					/// <summary>
+					/// Read the contents of a section.
+					/// </summary>
+					/// <param name="section">The section, or nullptr.</param>
+					/// <returns>The contents, empty for a null section or one without data in the file.</returns>
+					std::vector<uint8_t> ReadSection(const Section* section);
+
+					/// <summary>
+					/// Read <paramref name="size"/> bytes at <paramref name="offset"/> in the file.
+					/// </summary>
+					/// <param name="offset">The offset in the file.</param>
+					/// <param name="size">The number of bytes to read.</param>
+					/// <returns>The data.</returns>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file is too short.</exception>
+					std::vector<uint8_t> ReadAt(uint64_t offset, uint64_t size);
+
+					/// <summary>
+					/// Determine if an address in the image is part of a loaded segment.
+					/// </summary>
+					/// <param name="address">The address in the image.</param>
+					/// <returns>true when the address is loaded.</returns>
+					bool IsLoaded(uint64_t address) const;
+			};
+		}
+	}
+
+#endif
@@ -3,12 +3,23 @@
 #include <stdexcept>
 
 using namespace Hindsight::Debugger::CxxExceptions;
+using namespace Hindsight::Debugger::Backend;
 using namespace Hindsight::Utilities;
 
+/// <summary>
+/// Convert a pointer into the address space of the debugged process to an address for a memory reader.
+/// </summary>
+/// <param name="pointer">The pointer, which is not valid in the address space of hindsight.</param>
+/// <returns>The address.</returns>
+static uint64_t remote(const void* pointer) {
+	return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+}
+
 /// <summary>
 /// Process the RTTI as a 64-bit structure using RVA (relative to module base).
 /// </summary>
-void ExceptionRunTimeTypeInformation::Process64() const noexcept {
+/// <param name="memory">The reader for the memory of the debugged process.</param>
+void ExceptionRunTimeTypeInformation::Process64(const CachingMemoryReader& memory) const noexcept {
 	auto parameters = reinterpret_cast<const EHParameters64*>(&m_Record->ExceptionInformation[0]);
 	if (parameters == nullptr)
 		return;
@@ -25,11 +36,10 @@ void ExceptionRunTimeTypeInformation::Process64() const noexcept {
 
 	// Prepare the structs we will be reading from the process' memory space
 	ThrowInfo64      throwInfo;
-	CatchableType64  catchableType;
 	TypeDescriptor64 typeDescriptor;
 
 	// Read the throw info from the debugged process.
-	if (!m_Process->Read(parameters->pThrowInfo, throwInfo))
+	if (!memory.Read(remote(parameters->pThrowInfo), throwInfo))
 		return;
 
 	// Determine the address of the catchable type array
@@ -39,7 +49,7 @@ void ExceptionRunTimeTypeInformation::Process64() const noexcept {
 
 	// Attempt to read the type array size, otherwise we cannot fetch each catchable type from the array.
 	auto typeArraySize = 0;
-	if (!m_Process->Read(reinterpret_cast<const void*>(typeArrayAddress), typeArraySize))
+	if (!memory.Read(remote(typeArrayAddress), typeArraySize))
 		return;
 
 	// Calculate the length of the catchable type array, on x64 this is an array of ints (RVA offsets) + 1 int with the count.
@@ -48,21 +58,36 @@ void ExceptionRunTimeTypeInformation::Process64() const noexcept {
 	auto typeArray             = reinterpret_cast<const CatchableTypeArray64*>(&typeArrayBuffer[0]); // reinterpret it.
 
 	// Try to read the whole catchable type array 
-	if (!m_Process->Read(static_cast<const void*>(typeArrayAddress), typeArrayBufferLength, static_cast<void*>(&typeArrayBuffer[0])))
+	if (memory.Read(remote(typeArrayAddress), static_cast<void*>(&typeArrayBuffer[0]), typeArrayBufferLength) != typeArrayBufferLength)
 		return;
 
-	// Process each catchable type.
-	auto containsStdException = false;
+	// Read the catchable types in one batch, up to the first one without an address.
+	auto catchableTypes      = std::vector<CatchableType64>(static_cast<size_t>(typeArraySize));
+	auto catchableTypeRanges = std::vector<MemoryRange>();
 	for (auto i = 0; i < typeArraySize; ++i) {
 		// Determine the address of the catchable type instance. 
 		auto catchableTypeAddress = parameters->rva_to_va<const CatchableType64*>(typeArray->arrayOfCatchableTypes[i]);
 		if (catchableTypeAddress == nullptr)
-			return;
+			break;
 
-		// Try to read the catchable type.
-		if (!m_Process->Read(reinterpret_cast<const void*>(catchableTypeAddress), catchableType))
+		MemoryRange range;
+		range.Address = remote(catchableTypeAddress);
+		range.Buffer  = &catchableTypes[i];
+		range.Size    = sizeof(CatchableType64);
+		catchableTypeRanges.push_back(range);
+	}
+
+	memory.ReadMany(catchableTypeRanges.data(), catchableTypeRanges.size());
+
+	// Process each catchable type.
+	auto containsStdException = false;
+	for (auto i = 0; i < typeArraySize; ++i) {
+		// Stop at a catchable type without an address, or one that could not be read.
+		if (static_cast<size_t>(i) >= catchableTypeRanges.size() || catchableTypeRanges[i].Read != sizeof(CatchableType64))
 			return;
 
+		auto& catchableType = catchableTypes[i];
+
 		// Fetch the addresses for the type descriptor (and name member)
 		auto typeDescriptorAddress = parameters->rva_to_va<const CatchableType64*>(catchableType.pType);
 		auto typeNameAddress       = parameters->rva_to_va<const char*>(catchableType.pType + offsetof(TypeDescriptor64, name));
@@ -72,11 +97,11 @@ void ExceptionRunTimeTypeInformation::Process64() const noexcept {
 			return;
 
 		// Try to read the descriptor, excluding the name.
-		if (!m_Process->Read(reinterpret_cast<const void*>(typeDescriptorAddress), typeDescriptor))
+		if (!memory.Read(remote(typeDescriptorAddress), typeDescriptor))
 			return;
 
 		// Try to read the decorated name.
-		auto decoratedName = m_Process->ReadNulTerminatedString(typeNameAddress);
+		auto decoratedName = memory.ReadNulTerminatedString(remote(typeNameAddress));
 		if (decoratedName.empty())
 			return;
 
@@ -99,9 +124,9 @@ void ExceptionRunTimeTypeInformation::Process64() const noexcept {
 	// Try to fetch the full exception message if it is there, limited at 1024 characters.
 	if (containsStdException) {
 		const char* what = nullptr;
-		if (m_Process->Read(static_cast<uint8_t*>(parameters->pExceptionObject) + 8, what)) {
+		if (memory.Read(remote(static_cast<uint8_t*>(parameters->pExceptionObject) + 8), what)) {
 			if (what != nullptr) {
-				auto message = m_Process->ReadNulTerminatedString(what, 1024);
+				auto message = memory.ReadNulTerminatedString(remote(what), 1024);
 				if (!message.empty())
 					m_ExceptionMessage = message;
 			}
@@ -112,7 +137,8 @@ void ExceptionRunTimeTypeInformation::Process64() const noexcept {
 /// <summary>
 /// Process the RTTI as a 32-bit structure using VA (non-relative, 32-bit address space).
 /// </summary>
-void ExceptionRunTimeTypeInformation::Process32() const noexcept {
+/// <param name="memory">The reader for the memory of the debugged process.</param>
+void ExceptionRunTimeTypeInformation::Process32(const CachingMemoryReader& memory) const noexcept {
 	auto parameters = EHParameters32 {
 		static_cast<unsigned long>(m_Record->ExceptionInformation[0]),
 		reinterpret_cast<void*>(m_Record->ExceptionInformation[1]),
@@ -131,11 +157,10 @@ void ExceptionRunTimeTypeInformation::Process32() const noexcept {
 
 	// Prepare the structs we will be reading from the process' memory space
 	ThrowInfo32      throwInfo;
-	CatchableType32  catchableType;
 	TypeDescriptor32 typeDescriptor;
 
 	// Read the throw info from the debugged process.
-	if (!m_Process->Read(parameters.pThrowInfo, throwInfo))
+	if (!memory.Read(remote(parameters.pThrowInfo), throwInfo))
 		return;
 
 	// Determine the address of the catchable type array
@@ -145,7 +170,7 @@ void ExceptionRunTimeTypeInformation::Process32() const noexcept {
 
 	// Attempt to read the type array size, otherwise we cannot fetch each catchable type from the array.
 	auto typeArraySize = 0;
-	if (!m_Process->Read(reinterpret_cast<const void*>(typeArrayAddress), typeArraySize))
+	if (!memory.Read(remote(typeArrayAddress), typeArraySize))
 		return;
 
 	// Calculate the length of the catchable type array, on x86 this is an array of ints (32-bit VAs) + 1 int with the count.
@@ -154,21 +179,36 @@ void ExceptionRunTimeTypeInformation::Process32() const noexcept {
 	auto typeArray             = reinterpret_cast<const CatchableTypeArray32*>(&typeArrayBuffer[0]); // reinterpret it.
 
 	// Try to read the whole catchable type array 
-	if (!m_Process->Read(static_cast<const void*>(typeArrayAddress), typeArrayBufferLength, static_cast<void*>(&typeArrayBuffer[0])))
+	if (memory.Read(remote(typeArrayAddress), static_cast<void*>(&typeArrayBuffer[0]), typeArrayBufferLength) != typeArrayBufferLength)
 		return;
 
-	// Process each catchable type.
-	auto containsStdException = false;
+	// Read the catchable types in one batch, up to the first one without an address.
+	auto catchableTypes      = std::vector<CatchableType32>(static_cast<size_t>(typeArraySize));
+	auto catchableTypeRanges = std::vector<MemoryRange>();
 	for (auto i = 0; i < typeArraySize; ++i) {
 		// Determine the address of the catchable type instance. 
 		auto catchableTypeAddress = reinterpret_cast<const CatchableType32*>(static_cast<uintptr_t>(typeArray->arrayOfCatchableTypes[i]));
 		if (catchableTypeAddress == nullptr)
-			return;
+			break;
+
+		MemoryRange range;
+		range.Address = remote(catchableTypeAddress);
+		range.Buffer  = &catchableTypes[i];
+		range.Size    = sizeof(CatchableType32);
+		catchableTypeRanges.push_back(range);
+	}
 
-		// Try to read the catchable type.
-		if (!m_Process->Read(reinterpret_cast<const void*>(catchableTypeAddress), catchableType))
+	memory.ReadMany(catchableTypeRanges.data(), catchableTypeRanges.size());
+
+	// Process each catchable type.
+	auto containsStdException = false;
+	for (auto i = 0; i < typeArraySize; ++i) {
+		// Stop at a catchable type without an address, or one that could not be read.
+		if (static_cast<size_t>(i) >= catchableTypeRanges.size() || catchableTypeRanges[i].Read != sizeof(CatchableType32))
 			return;
 
+		auto& catchableType = catchableTypes[i];
+
 		// Fetch the addresses for the type descriptor (and name member)
 		auto typeDescriptorAddress = reinterpret_cast<const CatchableType64*>(static_cast<uintptr_t>(catchableType.pType));
 		auto typeNameAddress       = reinterpret_cast<const char*>(static_cast<uintptr_t>(catchableType.pType) + static_cast<uintptr_t>(offsetof(TypeDescriptor32, name)));
@@ -178,11 +218,11 @@ void ExceptionRunTimeTypeInformation::Process32() const noexcept {
 			return;
 
 		// Try to read the descriptor, excluding the name.
-		if (!m_Process->Read(reinterpret_cast<const void*>(typeDescriptorAddress), typeDescriptor))
+		if (!memory.Read(remote(typeDescriptorAddress), typeDescriptor))
 			return;
 
 		// Try to read the decorated name.
-		auto decoratedName = m_Process->ReadNulTerminatedString(typeNameAddress);
+		auto decoratedName = memory.ReadNulTerminatedString(remote(typeNameAddress));
 		if (decoratedName.empty())
 			return;
 
@@ -209,9 +249,9 @@ void ExceptionRunTimeTypeInformation::Process32() const noexcept {
 	// Try to fetch the full exception message if it is there, limited at 1024 characters.
 	if (containsStdException) {
 		int what = 0;
-		if (m_Process->Read(static_cast<uint8_t*>(parameters.pExceptionObject) + 4, what)) {
+		if (memory.Read(remote(static_cast<uint8_t*>(parameters.pExceptionObject) + 4), what)) {
 			if (what != 0) {
-				auto message = m_Process->ReadNulTerminatedString(reinterpret_cast<const void*>(what), 1024);
+				auto message = memory.ReadNulTerminatedString(static_cast<uint32_t>(what), 1024);
 				if (!message.empty())
 					m_ExceptionMessage = message;
 			}
@@ -219,6 +259,7 @@ void ExceptionRunTimeTypeInformation::Process32() const noexcept {
 	}
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Construct a new ExceptionRunTimeTypeInformation from a currently debugged process, an exception record and a module collection.
 /// </summary>
@@ -234,12 +275,17 @@ ExceptionRunTimeTypeInformation::ExceptionRunTimeTypeInformation(std::shared_ptr
 	if (record.ExceptionInformation[0] != static_cast<ULONG_PTR>(EH_MAGIC_NUMBER1))
 		throw std::invalid_argument("provided exception record does not contain the EH_MAGIC_NUMBER1 magic number as its EHParameters magic field.");
 
+	// The RTTI is a chain of small dependent reads that mostly land on the same few pages of the throwing module.
+	Hindsight::Process::ProcessMemoryReader source(process->hProcess);
+	CachingMemoryReader memory(source);
+
 	if (process->Is64()) {
-		Process64();
+		Process64(memory);
 	} else {
-		Process32();
+		Process32(memory);
 	}
 }
+#endif
 
 /// <summary>
 /// Construct a new ExceptionRunTimeTypeInformation from previously known RTTI (i.e. from a binary log file).
@@ -5,6 +5,7 @@
 
 #include "Process.hpp"
 #include "ModuleCollection.hpp"
+#include "CachingMemoryReader.hpp"
 
 #include <memory>
 #include <vector>
@@ -232,14 +233,17 @@ namespace Hindsight::Debugger::CxxExceptions {
 			/// <summary>
 			/// Process the RTTI as a 64-bit structure using RVA (relative to module base).
 			/// </summary>
-			void Process64() const noexcept;
+			/// <param name="memory">The reader for the memory of the debugged process.</param>
+			void Process64(const Hindsight::Debugger::Backend::CachingMemoryReader& memory) const noexcept;
 
 			/// <summary>
 			/// Process the RTTI as a 32-bit structure using VA (non-relative, 32-bit address space).
 			/// </summary>
-			void Process32() const noexcept;
+			/// <param name="memory">The reader for the memory of the debugged process.</param>
+			void Process32(const Hindsight::Debugger::Backend::CachingMemoryReader& memory) const noexcept;
 
 		public:
+#ifdef _WIN32
 			/// <summary>
 			/// Construct a new ExceptionRunTimeTypeInformation from a currently debugged process, an exception record and a module collection.
 			/// </summary>
@@ -247,6 +251,7 @@ namespace Hindsight::Debugger::CxxExceptions {
 			/// <param name="record">The exception record that was obtained at the exact state <paramref name="process"/> is suspended in.</param>
 			/// <param name="loadedModules">The collection of loaded modules at the time of the exception.</param>
 			ExceptionRunTimeTypeInformation(std::shared_ptr<Hindsight::Process::Process> process, const EXCEPTION_RECORD& record, const Hindsight::Debugger::ModuleCollection& loadedModules);
+#endif
 
 			/// <summary>
 			/// Construct a new ExceptionRunTimeTypeInformation from previously known RTTI (i.e. from a binary log file).
@@ -0,0 +1,58 @@
+#include "ExceptionSnapshot.hpp"
+#include <atomic>
+
+using namespace Hindsight::Debugger;
+
+/// <summary>
+/// Construct a new, empty, ExceptionSnapshotPool.
+/// </summary>
+/// <param name="capacity">The maximum number of pooled traces, traces created while all of them are in use are not pooled.</param>
+ExceptionSnapshotPool::ExceptionSnapshotPool(size_t capacity)
+	: m_Capacity(capacity) {
+
+	m_Traces.reserve(m_Capacity);
+}
+
+/// <summary>
+/// Capture the thread context of the thread in <paramref name="pi"/> and walk its stack, reusing a pooled trace
+/// when one is available.
+/// </summary>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of the debugger, which must outlive the pool.</param>
+/// <param name="session">The symbol session of the debugged process.</param>
+/// <param name="config">The configuration of the debugger, which determines how recursion is cut, how many instructions are disassembled and whether frames are symbolized.</param>
+/// <param name="disassembly">An optional cache of disassembled instructions that outlives the pool.</param>
+/// <returns>The snapshot.</returns>
+ExceptionSnapshot ExceptionSnapshotPool::Capture(
+	const PROCESS_INFORMATION& pi,
+	const ModuleCollection& collection,
+	SymbolSession& session,
+	const DebuggerConfig& config,
+	DisassemblyCache* disassembly) {
+
+	ExceptionSnapshot snapshot;
+	snapshot.Context = std::make_shared<DebugContext>(pi.hProcess, pi.hThread);
+
+	// the stack is read once here, the walk and the handlers use the copy
+	if (config.StackSnapshot != 0)
+		snapshot.Context->CaptureStack(config.StackSnapshot);
+
+	// a trace that is only referenced by the pool is not in use by any handler
+	for (auto& trace : m_Traces) {
+		if (trace.use_count() == 1) {
+			// pairs with the release of the last reference on another thread, such as a dispatcher worker
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			trace->Reset(snapshot.Context, session, config.MaxRecursion, config.MaxInstructions, disassembly, !config.RawFrames);
+			snapshot.Trace = trace;
+			return snapshot;
+		}
+	}
+
+	snapshot.Trace = std::make_shared<DebugStackTrace>(snapshot.Context, collection, session, config.MaxRecursion, config.MaxInstructions, disassembly, !config.RawFrames);
+
+	if (m_Traces.size() < m_Capacity)
+		m_Traces.push_back(snapshot.Trace);
+
+	return snapshot;
+}
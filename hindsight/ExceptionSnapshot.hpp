@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef debugger_exception_snapshot_h
+#define debugger_exception_snapshot_h
+	#include <Windows.h>
+
+	#include "DebugContext.hpp"
+	#include "DebugStackTrace.hpp"
+	#include "ModuleCollection.hpp"
+	#include "SymbolSession.hpp"
+	#include "DebuggerConfig.hpp"
+
+	#include <memory>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The thread context and stack trace captured for one exception or breakpoint, as handed to the event handlers.
+			/// </summary>
+			struct ExceptionSnapshot {
+				std::shared_ptr<DebugContext>		Context = nullptr;	/* The thread context at the time of the event. */
+				std::shared_ptr<DebugStackTrace>	Trace = nullptr;	/* The stack trace starting from Context. */
+			};
+
+			/// <summary>
+			/// A pool of stack traces that are reused between exceptions. A trace holds a vector of entries with strings and
+			/// vectors of disassembled instructions, so building one from scratch for every exception allocates (and later frees)
+			/// memory for every frame; during an exception storm that is most of the work the debugger does. A pooled trace that
+			/// no handler holds on to anymore is walked again in place, which overwrites the strings and instructions of its
+			/// entries without allocating once they are large enough. Handlers that keep a trace (for example through a
+			/// <see cref="::Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler"/>) are safe, because only traces
+			/// that are referenced by the pool alone are reused.
+			/// </summary>
+			class ExceptionSnapshotPool {
+				private:
+					std::vector<std::shared_ptr<DebugStackTrace>>	m_Traces;	/* The pooled traces */
+					size_t											m_Capacity;	/* The maximum number of pooled traces */
+
+				public:
+					/// <summary>
+					/// The default maximum number of pooled traces.
+					/// </summary>
+					static const size_t DefaultCapacity = 4;
+
+					/// <summary>
+					/// Construct a new, empty, ExceptionSnapshotPool.
+					/// </summary>
+					/// <param name="capacity">The maximum number of pooled traces, traces created while all of them are in use are not pooled.</param>
+					ExceptionSnapshotPool(size_t capacity = DefaultCapacity);
+
+					ExceptionSnapshotPool(const ExceptionSnapshotPool&) = delete;
+					ExceptionSnapshotPool& operator=(const ExceptionSnapshotPool&) = delete;
+
+					/// <summary>
+					/// Capture the thread context of the thread in <paramref name="pi"/> and walk its stack, reusing a pooled trace
+					/// when one is available.
+					/// </summary>
+					/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+					/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of the debugger, which must outlive the pool.</param>
+					/// <param name="session">The symbol session of the debugged process.</param>
+					/// <param name="config">The configuration of the debugger, which determines how recursion is cut, how many instructions are disassembled and whether frames are symbolized.</param>
+					/// <param name="disassembly">An optional cache of disassembled instructions that outlives the pool.</param>
+					/// <returns>The snapshot.</returns>
+					ExceptionSnapshot Capture(
+						const PROCESS_INFORMATION& pi,
+						const ModuleCollection& collection,
+						SymbolSession& session,
+						const DebuggerConfig& config,
+						DisassemblyCache* disassembly = nullptr);
+			};
+		}
+	}
+
+#endif
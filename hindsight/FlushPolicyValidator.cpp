@@ -0,0 +1,37 @@
+#include "FlushPolicyValidator.hpp"
+#include "String.hpp"
+
+using namespace Hindsight::Cli::CliValidator;
+
+/// <summary>
+/// A static collection of valid policy names.
+/// </summary>
+std::set<std::string> FlushPolicyValidator::Valid = {
+	"event", "size", "exit"
+};
+
+/// <summary>
+/// The static instance of the validator, for convenience.
+/// </summary>
+FlushPolicyValidator FlushPolicyValidator::Validator = FlushPolicyValidator();
+
+/// <summary>
+/// Construct a new FlushPolicyValidator
+/// </summary>
+FlushPolicyValidator::FlushPolicyValidator() {
+	tname = "POLICY";
+	func = [](const std::string& str) -> std::string {
+		if (!Valid.count(str))
+			return "Invalid flush policy specified: " + str;
+		return std::string();
+	};
+}
+
+/// <summary>
+/// Get a comma-separated list of valid options for this validator.
+/// </summary>
+/// <returns>A comma-separated list of policy names.</returns>
+std::string FlushPolicyValidator::GetValid() {
+	std::vector<std::string> validList(Valid.begin(), Valid.end());
+	return Utilities::String::Join(validList, ", ");
+}
\ No newline at end of file
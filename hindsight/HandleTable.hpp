@@ -0,0 +1,233 @@
+#pragma once
+
+#ifndef debugger_handle_table_h
+#define debugger_handle_table_h
+	#include <cstdint>
+	#include <cstddef>
+	#include <functional>
+	#include <unordered_map>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// A table of the process and thread handles of a debugging session, by process and thread ID. Handles that are
+			/// delivered by process and thread creation events are borrowed: the system closes them after the matching exit event.
+			/// Handles for IDs that were never announced are opened once, on first use, and closed when they are retired or the
+			/// table is destroyed. This class does not depend on any platform API, the operations that open and close handles
+			/// are supplied by the owner, so the bookkeeping can be tested against a fake operating system.
+			/// </summary>
+			/// <typeparam name="THandle">The handle type, a value-initialized handle is the invalid handle.</typeparam>
+			template <typename THandle>
+			class HandleTable {
+				public:
+					/// <summary>
+					/// Opens a handle for a process or thread ID, returning the invalid handle on failure.
+					/// </summary>
+					using Opener = std::function<THandle(uint32_t)>;
+
+					/// <summary>
+					/// Closes a handle that was returned by an <see cref="Opener"/>.
+					/// </summary>
+					using Closer = std::function<void(THandle)>;
+
+				private:
+					struct Entry {
+						THandle		Handle = THandle();	/* The handle. */
+						bool		Owned = false;		/* True when the handle was opened by this table and has to be closed by it. */
+						uint32_t	ProcessId = 0;		/* The process the thread belongs to, only used for threads. */
+					};
+
+					Opener								m_OpenProcess;	/* Opens a process handle on a miss */
+					Opener								m_OpenThread;	/* Opens a thread handle on a miss */
+					Closer								m_Close;		/* Closes owned handles */
+					std::unordered_map<uint32_t, Entry>	m_Processes;	/* The process handles, by process ID */
+					std::unordered_map<uint32_t, Entry>	m_Threads;		/* The thread handles, by thread ID */
+					size_t								m_Hits;			/* The number of lookups served from the table */
+					size_t								m_Opens;		/* The number of handles opened by the table */
+
+				public:
+					/// <summary>
+					/// Construct a new, empty, HandleTable.
+					/// </summary>
+					/// <param name="openProcess">Opens a process handle for a process ID that is not in the table.</param>
+					/// <param name="openThread">Opens a thread handle for a thread ID that is not in the table.</param>
+					/// <param name="close">Closes the handles that were opened by the table.</param>
+					HandleTable(Opener openProcess, Opener openThread, Closer close)
+						: m_OpenProcess(std::move(openProcess)), m_OpenThread(std::move(openThread)), m_Close(std::move(close)), m_Hits(0), m_Opens(0) {
+
+					}
+
+					/// <summary>
+					/// Close all handles that were opened by the table.
+					/// </summary>
+					~HandleTable() {
+						for (auto& thread : m_Threads)
+							Release(thread.second);
+
+						for (auto& process : m_Processes)
+							Release(process.second);
+					}
+
+					HandleTable(const HandleTable&) = delete;
+					HandleTable& operator=(const HandleTable&) = delete;
+
+					/// <summary>
+					/// Add the process handle that was delivered by a process creation event, replacing any handle for the same ID.
+					/// </summary>
+					/// <param name="processId">The process ID.</param>
+					/// <param name="handle">The borrowed process handle.</param>
+					void AddProcess(uint32_t processId, THandle handle) {
+						Put(m_Processes, processId, handle, processId);
+					}
+
+					/// <summary>
+					/// Add the thread handle that was delivered by a process or thread creation event, replacing any handle for the same ID.
+					/// </summary>
+					/// <param name="processId">The ID of the process that the thread belongs to.</param>
+					/// <param name="threadId">The thread ID.</param>
+					/// <param name="handle">The borrowed thread handle.</param>
+					void AddThread(uint32_t processId, uint32_t threadId, THandle handle) {
+						Put(m_Threads, threadId, handle, processId);
+					}
+
+					/// <summary>
+					/// Get the handle of a process, which is opened when the process is not in the table yet.
+					/// </summary>
+					/// <param name="processId">The process ID.</param>
+					/// <returns>The process handle, or the invalid handle when it could not be opened.</returns>
+					THandle Process(uint32_t processId) {
+						return Get(m_Processes, m_OpenProcess, processId, processId);
+					}
+
+					/// <summary>
+					/// Get the handle of a thread, which is opened when the thread is not in the table yet.
+					/// </summary>
+					/// <param name="processId">The ID of the process that the thread belongs to.</param>
+					/// <param name="threadId">The thread ID.</param>
+					/// <returns>The thread handle, or the invalid handle when it could not be opened.</returns>
+					THandle Thread(uint32_t processId, uint32_t threadId) {
+						return Get(m_Threads, m_OpenThread, threadId, processId);
+					}
+
+					/// <summary>
+					/// Retire the handle of a thread that has exited, which must be done before the exit event is continued.
+					/// </summary>
+					/// <param name="threadId">The thread ID.</param>
+					void RemoveThread(uint32_t threadId) {
+						auto it = m_Threads.find(threadId);
+						if (it == m_Threads.end())
+							return;
+
+						Release(it->second);
+						m_Threads.erase(it);
+					}
+
+					/// <summary>
+					/// Retire the handle of a process that has exited and the handles of all of its threads, which must be done
+					/// before the exit event is continued.
+					/// </summary>
+					/// <param name="processId">The process ID.</param>
+					void RemoveProcess(uint32_t processId) {
+						for (auto it = m_Threads.begin(); it != m_Threads.end();) {
+							if (it->second.ProcessId == processId) {
+								Release(it->second);
+								it = m_Threads.erase(it);
+							} else {
+								++it;
+							}
+						}
+
+						auto it = m_Processes.find(processId);
+						if (it == m_Processes.end())
+							return;
+
+						Release(it->second);
+						m_Processes.erase(it);
+					}
+
+					/// <summary>
+					/// Get the number of handles in the table.
+					/// </summary>
+					/// <returns>The number of process and thread handles.</returns>
+					size_t size() const noexcept {
+						return m_Processes.size() + m_Threads.size();
+					}
+
+					/// <summary>
+					/// Get the number of lookups that were served from the table.
+					/// </summary>
+					/// <returns>The number of hits.</returns>
+					size_t Hits() const noexcept {
+						return m_Hits;
+					}
+
+					/// <summary>
+					/// Get the number of handles that the table had to open itself.
+					/// </summary>
+					/// <returns>The number of opened handles.</returns>
+					size_t Opens() const noexcept {
+						return m_Opens;
+					}
+
+				private:
+					/// <summary>
+					/// Close <paramref name="entry"/> when it is owned by the table.
+					/// </summary>
+					/// <param name="entry">The entry to release.</param>
+					void Release(Entry& entry) {
+						if (entry.Owned && entry.Handle != THandle())
+							m_Close(entry.Handle);
+
+						entry.Owned = false;
+					}
+
+					/// <summary>
+					/// Add a borrowed handle to <paramref name="map"/>, releasing the entry it replaces.
+					/// </summary>
+					/// <param name="map">The map of processes or threads.</param>
+					/// <param name="id">The process or thread ID.</param>
+					/// <param name="handle">The borrowed handle.</param>
+					/// <param name="processId">The process ID the handle belongs to.</param>
+					void Put(std::unordered_map<uint32_t, Entry>& map, uint32_t id, THandle handle, uint32_t processId) {
+						auto& entry = map[id];
+						Release(entry);
+
+						entry.Handle	= handle;
+						entry.Owned		= false;
+						entry.ProcessId = processId;
+					}
+
+					/// <summary>
+					/// Look up a handle in <paramref name="map"/>, or open and add it when it is not there.
+					/// </summary>
+					/// <param name="map">The map of processes or threads.</param>
+					/// <param name="open">Opens a handle on a miss.</param>
+					/// <param name="id">The process or thread ID.</param>
+					/// <param name="processId">The process ID the handle belongs to.</param>
+					/// <returns>The handle, or the invalid handle when it could not be opened.</returns>
+					THandle Get(std::unordered_map<uint32_t, Entry>& map, const Opener& open, uint32_t id, uint32_t processId) {
+						auto it = map.find(id);
+						if (it != map.end() && it->second.Handle != THandle()) {
+							++m_Hits;
+							return it->second.Handle;
+						}
+
+						// failures are not remembered, the ID may become valid later
+						auto handle = open(id);
+						if (handle == THandle())
+							return handle;
+
+						++m_Opens;
+
+						auto& entry		= map[id];
+						entry.Handle	= handle;
+						entry.Owned		= true;
+						entry.ProcessId = processId;
+
+						return handle;
+					}
+			};
+		}
+	}
+
+#endif
@@ -2,8 +2,7 @@
 
 #ifndef debugger_event_handler_h
 #define debugger_event_handler_h
-	#include <Windows.h>
-	#include <DbgHelp.h>
+	#include "Win32Types.hpp"
 
 	#include <string>
 	#include <memory>
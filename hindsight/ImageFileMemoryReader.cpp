@@ -0,0 +1,143 @@
+#include "ImageFileMemoryReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+using namespace Hindsight::Debugger::Backend;
+
+static const size_t section_header_size = 40;
+
+/// <summary>
+/// Read a little-endian value from the contents of an image file.
+/// </summary>
+/// <param name="file">The contents of the image file.</param>
+/// <param name="offset">The file offset of the value.</param>
+/// <returns>The value.</returns>
+/// <exception cref="std::runtime_error">This exception is thrown when the value is not inside of the file.</exception>
+template <typename T>
+static T file_value(const std::vector<uint8_t>& file, size_t offset) {
+	if (offset > file.size() || file.size() - offset < sizeof(T))
+		throw std::runtime_error("unexpected end of image file, not a PE image");
+
+	T value;
+	std::memcpy(&value, file.data() + offset, sizeof(T));
+	return value;
+}
+
+/// <summary>
+/// Construct a new ImageFileMemoryReader by reading and mapping the PE image at <paramref name="path"/>.
+/// </summary>
+/// <param name="path">The path of the image file.</param>
+/// <param name="base">The address to map the image at, 0 for its preferred base.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be read or is not a PE image.</exception>
+ImageFileMemoryReader::ImageFileMemoryReader(const std::string& path, uint64_t base)
+	: m_Base(0) {
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		throw std::runtime_error("cannot open image file " + path);
+
+	std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	if (stream.bad())
+		throw std::runtime_error("cannot read image file " + path);
+
+	Map(file, base);
+}
+
+/// <summary>
+/// Construct a new ImageFileMemoryReader by mapping the PE image in <paramref name="file"/>.
+/// </summary>
+/// <param name="file">The contents of the image file.</param>
+/// <param name="base">The address to map the image at, 0 for its preferred base.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when <paramref name="file"/> is not a PE image.</exception>
+ImageFileMemoryReader::ImageFileMemoryReader(const std::vector<uint8_t>& file, uint64_t base)
+	: m_Base(0) {
+	Map(file, base);
+}
+
+/// <summary>
+/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the mapped image.
+/// </summary>
+/// <param name="address">The address in the mapped image.</param>
+/// <param name="buffer">The buffer that receives the data.</param>
+/// <param name="size">The number of bytes to read.</param>
+/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when the range leaves the image.</returns>
+size_t ImageFileMemoryReader::Read(uint64_t address, void* buffer, size_t size) const {
+	if (address < m_Base || address - m_Base >= m_Image.size())
+		return 0;
+
+	auto offset = static_cast<size_t>(address - m_Base);
+	auto length = std::min(size, m_Image.size() - offset);
+	std::memcpy(buffer, m_Image.data() + offset, length);
+
+	return length;
+}
+
+/// <summary>
+/// Get the address the image is mapped at.
+/// </summary>
+/// <returns>The base address.</returns>
+uint64_t ImageFileMemoryReader::Base() const noexcept {
+	return m_Base;
+}
+
+/// <summary>
+/// Get the size of the mapped image.
+/// </summary>
+/// <returns>The size of the image in bytes.</returns>
+size_t ImageFileMemoryReader::size() const noexcept {
+	return m_Image.size();
+}
+
+/// <summary>
+/// Map the PE image in <paramref name="file"/> into m_Image.
+/// </summary>
+/// <param name="file">The contents of the image file.</param>
+/// <param name="base">The address to map the image at, 0 for its preferred base.</param>
+void ImageFileMemoryReader::Map(const std::vector<uint8_t>& file, uint64_t base) {
+	if (file_value<uint16_t>(file, 0) != 0x5a4d)
+		throw std::runtime_error("invalid DOS header, not a PE image");
+
+	auto nt = file_value<uint32_t>(file, 0x3c);
+	if (file_value<uint32_t>(file, nt) != 0x00004550)
+		throw std::runtime_error("invalid NT header signature, not a PE image");
+
+	// the file header is followed by the optional header, whose size differs between PE32 and PE32+
+	auto sections = file_value<uint16_t>(file, nt + 6);
+	auto optional = static_cast<size_t>(nt) + 24;
+	auto magic = file_value<uint16_t>(file, optional);
+	auto imageSize = file_value<uint32_t>(file, optional + 56);
+	auto headersSize = file_value<uint32_t>(file, optional + 60);
+
+	if (magic == 0x20b)
+		m_Base = base != 0 ? base : file_value<uint64_t>(file, optional + 24);
+	else if (magic == 0x10b)
+		m_Base = base != 0 ? base : file_value<uint32_t>(file, optional + 28);
+	else
+		throw std::runtime_error("invalid optional header, not a PE image");
+
+	if (imageSize == 0 || imageSize > MaxImageSize)
+		throw std::runtime_error("invalid size of image, PE image damaged");
+
+	m_Image.assign(imageSize, 0);
+	std::memcpy(m_Image.data(), file.data(), std::min<size_t>({ headersSize, file.size(), m_Image.size() }));
+
+	auto table = optional + file_value<uint16_t>(file, nt + 20);
+	for (size_t i = 0; i < sections; ++i) {
+		auto header = table + i * section_header_size;
+		auto virtualSize = file_value<uint32_t>(file, header + 8);
+		auto address = file_value<uint32_t>(file, header + 12);
+		auto rawSize = file_value<uint32_t>(file, header + 16);
+		auto rawOffset = file_value<uint32_t>(file, header + 20);
+
+		// the raw data is padded to the file alignment, only the part that is inside of the section is mapped
+		size_t length = virtualSize != 0 ? std::min(virtualSize, rawSize) : rawSize;
+		if (address >= m_Image.size() || rawOffset >= file.size())
+			continue;
+
+		length = std::min({ length, m_Image.size() - address, file.size() - rawOffset });
+		std::memcpy(m_Image.data() + address, file.data() + rawOffset, length);
+	}
+}
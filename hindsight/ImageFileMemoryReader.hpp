@@ -0,0 +1,81 @@
+#pragma once
+
+#ifndef debugger_image_file_memory_reader_h
+#define debugger_image_file_memory_reader_h
+	#include "DebugBackend.hpp"
+
+	#include <cstdint>
+	#include <string>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace Backend {
+				/// <summary>
+				/// A memory reader that serves a PE image from a file on disk, laid out the way the loader maps it: the headers at
+				/// the base address and every section at its RVA, with the gaps and the uninitialized tails of sections filled with
+				/// zeroes. Relocations are not applied, so the image reads as if it was mapped at its preferred base. This makes the
+				/// unwind information of an image available without a process, to inspect modules offline and to test the unwinder
+				/// against real images. This class does not depend on any platform API.
+				/// </summary>
+				class ImageFileMemoryReader : public IMemoryReader {
+					private:
+						uint64_t				m_Base;		/* The address the image is mapped at */
+						std::vector<uint8_t>	m_Image;	/* The mapped image, SizeOfImage bytes */
+
+					public:
+						/// <summary>
+						/// The largest SizeOfImage that is mapped, anything larger is taken for a damaged header.
+						/// </summary>
+						static constexpr size_t MaxImageSize = 1 << 30;
+
+						/// <summary>
+						/// Construct a new ImageFileMemoryReader by reading and mapping the PE image at <paramref name="path"/>.
+						/// </summary>
+						/// <param name="path">The path of the image file.</param>
+						/// <param name="base">The address to map the image at, 0 for its preferred base.</param>
+						/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be read or is not a PE image.</exception>
+						ImageFileMemoryReader(const std::string& path, uint64_t base = 0);
+
+						/// <summary>
+						/// Construct a new ImageFileMemoryReader by mapping the PE image in <paramref name="file"/>.
+						/// </summary>
+						/// <param name="file">The contents of the image file.</param>
+						/// <param name="base">The address to map the image at, 0 for its preferred base.</param>
+						/// <exception cref="std::runtime_error">This exception is thrown when <paramref name="file"/> is not a PE image.</exception>
+						ImageFileMemoryReader(const std::vector<uint8_t>& file, uint64_t base = 0);
+
+						/// <summary>
+						/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the mapped image.
+						/// </summary>
+						/// <param name="address">The address in the mapped image.</param>
+						/// <param name="buffer">The buffer that receives the data.</param>
+						/// <param name="size">The number of bytes to read.</param>
+						/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when the range leaves the image.</returns>
+						size_t Read(uint64_t address, void* buffer, size_t size) const override;
+
+						/// <summary>
+						/// Get the address the image is mapped at.
+						/// </summary>
+						/// <returns>The base address.</returns>
+						uint64_t Base() const noexcept;
+
+						/// <summary>
+						/// Get the size of the mapped image.
+						/// </summary>
+						/// <returns>The size of the image in bytes.</returns>
+						size_t size() const noexcept;
+
+					private:
+						/// <summary>
+						/// Map the PE image in <paramref name="file"/> into m_Image.
+						/// </summary>
+						/// <param name="file">The contents of the image file.</param>
+						/// <param name="base">The address to map the image at, 0 for its preferred base.</param>
+						void Map(const std::vector<uint8_t>& file, uint64_t base);
+				};
+			}
+		}
+	}
+
+#endif
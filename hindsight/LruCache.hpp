@@ -0,0 +1,143 @@
+#pragma once
+
+#ifndef util_lru_cache_h
+#define util_lru_cache_h
+	#include <list>
+	#include <unordered_map>
+	#include <utility>
+	#include <cstddef>
+	#include <functional>
+
+	namespace Hindsight {
+		namespace Utilities {
+			/// <summary>
+			/// A bounded cache that evicts the least recently used entry when it is full. Lookups and insertions are constant
+			/// time on average. This class does not depend on any platform API and is not thread-safe.
+			/// </summary>
+			/// <typeparam name="TKey">The key type.</typeparam>
+			/// <typeparam name="TValue">The value type.</typeparam>
+			/// <typeparam name="THash">The hash function for <typeparamref name="TKey"/>.</typeparam>
+			template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
+			class LruCache {
+				private:
+					using Entry = std::pair<TKey, TValue>;
+
+					std::list<Entry>													m_Entries;	/* The entries, most recently used first */
+					std::unordered_map<TKey, typename std::list<Entry>::iterator, THash>	m_Index;	/* The entries by key */
+					size_t																m_Capacity;	/* The maximum number of entries */
+					size_t																m_Hits;		/* The number of successful lookups */
+					size_t																m_Misses;	/* The number of failed lookups */
+
+				public:
+					/// <summary>
+					/// Construct a new, empty, LruCache.
+					/// </summary>
+					/// <param name="capacity">The maximum number of entries, which must be at least 1.</param>
+					LruCache(size_t capacity)
+						: m_Capacity(capacity != 0 ? capacity : 1), m_Hits(0), m_Misses(0) {
+
+					}
+
+					/// <summary>
+					/// Look up the value for <paramref name="key"/> and mark it as most recently used.
+					/// </summary>
+					/// <param name="key">The key to look up.</param>
+					/// <returns>A pointer to the value, which is valid until the cache is modified, or nullptr when the key is not cached.</returns>
+					const TValue* Find(const TKey& key) {
+						auto it = m_Index.find(key);
+						if (it == m_Index.end()) {
+							++m_Misses;
+							return nullptr;
+						}
+
+						++m_Hits;
+						m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+						return &it->second->second;
+					}
+
+					/// <summary>
+					/// Insert or replace the value for <paramref name="key"/>, evicting the least recently used entry when the
+					/// cache is full.
+					/// </summary>
+					/// <param name="key">The key.</param>
+					/// <param name="value">The value.</param>
+					/// <returns>A const reference to the cached value, which is valid until the cache is modified.</returns>
+					const TValue& Put(const TKey& key, TValue value) {
+						auto it = m_Index.find(key);
+						if (it != m_Index.end()) {
+							it->second->second = std::move(value);
+							m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+							return it->second->second;
+						}
+
+						if (m_Entries.size() >= m_Capacity) {
+							m_Index.erase(m_Entries.back().first);
+							m_Entries.pop_back();
+						}
+
+						m_Entries.emplace_front(key, std::move(value));
+						m_Index.emplace(key, m_Entries.begin());
+						return m_Entries.front().second;
+					}
+
+					/// <summary>
+					/// Remove all entries for which <paramref name="predicate"/> returns true.
+					/// </summary>
+					/// <param name="predicate">A callable that receives a key and returns true when its entry must be removed.</param>
+					/// <typeparam name="TPredicate">The type of the callable.</typeparam>
+					template <typename TPredicate>
+					void EraseIf(TPredicate predicate) {
+						for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+							if (predicate(it->first)) {
+								m_Index.erase(it->first);
+								it = m_Entries.erase(it);
+							} else {
+								++it;
+							}
+						}
+					}
+
+					/// <summary>
+					/// Remove all entries.
+					/// </summary>
+					void Clear() noexcept {
+						m_Index.clear();
+						m_Entries.clear();
+					}
+
+					/// <summary>
+					/// Get the number of cached entries.
+					/// </summary>
+					/// <returns>The number of entries.</returns>
+					size_t size() const noexcept {
+						return m_Entries.size();
+					}
+
+					/// <summary>
+					/// Get the maximum number of cached entries.
+					/// </summary>
+					/// <returns>The capacity.</returns>
+					size_t Capacity() const noexcept {
+						return m_Capacity;
+					}
+
+					/// <summary>
+					/// Get the number of successful lookups.
+					/// </summary>
+					/// <returns>The number of cache hits.</returns>
+					size_t Hits() const noexcept {
+						return m_Hits;
+					}
+
+					/// <summary>
+					/// Get the number of failed lookups.
+					/// </summary>
+					/// <returns>The number of cache misses.</returns>
+					size_t Misses() const noexcept {
+						return m_Misses;
+					}
+			};
+		}
+	}
+
+#endif
@@ -0,0 +1,197 @@
+#include "Lz.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace Hindsight::Utilities;
+
+/// <summary>
+/// The number of bytes at the end of a block that are always literals, so that matching never reads past the end.
+/// </summary>
+static const size_t LastLiterals = 5;
+
+/// <summary>
+/// A match cannot start in the last bytes of a block.
+/// </summary>
+static const size_t MatchGuard = 12;
+
+/// <summary>
+/// Read 4 unaligned bytes.
+/// </summary>
+/// <param name="p">A pointer to the bytes.</param>
+/// <returns>The bytes as an integer.</returns>
+static uint32_t read32(const char* p) {
+	uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+/// <summary>
+/// Append a length that did not fit in its nibble, as a run of 255 bytes terminated by the remainder.
+/// </summary>
+/// <param name="length">The part of the length that exceeds the nibble.</param>
+/// <param name="output">A reference to the vector that receives the bytes.</param>
+static void write_length(size_t length, std::vector<char>& output) {
+	for (; length >= 255; length -= 255)
+		output.push_back(static_cast<char>(255));
+	output.push_back(static_cast<char>(length));
+}
+
+/// <summary>
+/// Read the remainder of a length whose nibble was 15.
+/// </summary>
+/// <param name="data">A reference to the read cursor.</param>
+/// <param name="end">The end of the compressed data.</param>
+/// <returns>The extra length.</returns>
+static size_t read_length(const uint8_t*& data, const uint8_t* end) {
+	size_t length = 0;
+	uint8_t byte;
+
+	do {
+		if (data == end)
+			throw std::runtime_error("compressed block ends unexpectedly");
+		byte = *data++;
+		length += byte;
+	} while (byte == 255);
+
+	return length;
+}
+
+/// <summary>
+/// Append one sequence: a literal run followed by an optional back reference.
+/// </summary>
+/// <param name="literals">A pointer to the literal bytes.</param>
+/// <param name="literalLength">The number of literal bytes.</param>
+/// <param name="offset">The distance of the back reference, ignored when <paramref name="matchLength"/> is 0.</param>
+/// <param name="matchLength">The length of the back reference, or 0 for the last sequence.</param>
+/// <param name="output">A reference to the vector that receives the sequence.</param>
+static void write_sequence(const char* literals, size_t literalLength, size_t offset, size_t matchLength, std::vector<char>& output) {
+	auto extra = matchLength != 0 ? matchLength - Lz::MinMatch : 0;
+	auto token = static_cast<uint8_t>(((literalLength < 15 ? literalLength : 15) << 4) | (extra < 15 ? extra : 15));
+
+	output.push_back(static_cast<char>(token));
+	if (literalLength >= 15)
+		write_length(literalLength - 15, output);
+
+	output.insert(output.end(), literals, literals + literalLength);
+	if (matchLength == 0)
+		return;
+
+	output.push_back(static_cast<char>(offset & 0xff));
+	output.push_back(static_cast<char>(offset >> 8));
+	if (extra >= 15)
+		write_length(extra - 15, output);
+}
+/// <summary>
+/// Compress <paramref name="size"/> bytes at <paramref name="data"/> and append the result to <paramref name="output"/>. 
+/// Incompressible data grows slightly, so the caller should store the data as-is when the result is not smaller.
+/// </summary>
+/// <param name="data">A pointer to the data to compress.</param>
+/// <param name="size">The number of bytes to compress.</param>
+/// <param name="output">A reference to the vector that receives the compressed data.</param>
+/// <returns>The number of bytes appended to <paramref name="output"/>.</returns>
+size_t Lz::Compress(const char* data, size_t size, std::vector<char>& output) {
+	auto start = output.size();
+
+	// small blocks get a small table, so that compressing a single event does not clear 256 KiB of memory
+	unsigned bits = 8;
+	while (bits < 16 && (static_cast<size_t>(1) << bits) < size)
+		++bits;
+
+	std::vector<uint32_t> table(static_cast<size_t>(1) << bits, 0);
+
+	size_t anchor = 0, position = 0;
+	size_t limit  = size > MatchGuard ? size - MatchGuard : 0;
+
+	while (position < limit) {
+		auto sequence  = read32(data + position);
+		auto hash	   = (sequence * 2654435761u) >> (32 - bits);
+		auto candidate = static_cast<size_t>(table[hash]);
+
+		table[hash] = static_cast<uint32_t>(position);
+
+		// a stale or colliding table entry is ruled out by comparing the bytes
+		if (candidate >= position || position - candidate > MaxOffset || read32(data + candidate) != sequence) {
+			++position;
+			continue;
+		}
+
+		auto length = MinMatch;
+		while (position + length < size - LastLiterals && data[candidate + length] == data[position + length])
+			++length;
+
+		write_sequence(data + anchor, position - anchor, position - candidate, length, output);
+
+		position += length;
+		anchor	  = position;
+	}
+
+	write_sequence(data + anchor, size - anchor, 0, 0, output);
+	return output.size() - start;
+}
+
+/// <summary>
+/// Decompress <paramref name="size"/> bytes at <paramref name="data"/> into exactly <paramref name="rawSize"/> bytes at 
+/// <paramref name="output"/>. The input is not trusted, it is never read or written out of bounds.
+/// </summary>
+/// <param name="data">A pointer to the compressed data.</param>
+/// <param name="size">The number of compressed bytes.</param>
+/// <param name="output">A pointer to <paramref name="rawSize"/> bytes of memory that receives the decompressed data.</param>
+/// <param name="rawSize">The size of the data before it was compressed.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the compressed data is invalid.</exception>
+void Lz::Decompress(const char* data, size_t size, char* output, size_t rawSize) {
+	auto in	 = reinterpret_cast<const uint8_t*>(data);
+	auto end = in + size;
+	size_t written = 0;
+
+	while (true) {
+		if (in == end)
+			throw std::runtime_error("compressed block ends unexpectedly");
+
+		auto token	 = *in++;
+		size_t count = token >> 4;
+		if (count == 15)
+			count += read_length(in, end);
+
+		if (count > static_cast<size_t>(end - in) || count > rawSize - written)
+			throw std::runtime_error("compressed block has an invalid literal run");
+
+		// the output may be empty (and null) when the block only has an empty literal run
+		if (count != 0)
+			std::memcpy(output + written, in, count);
+		in		+= count;
+		written += count;
+
+		// the last sequence has no back reference
+		if (in == end)
+			break;
+
+		if (end - in < 2)
+			throw std::runtime_error("compressed block ends unexpectedly");
+
+		size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+		in += 2;
+
+		count = (token & 0x0f);
+		if (count == 15)
+			count += read_length(in, end);
+		count += MinMatch;
+
+		if (offset == 0 || offset > written || count > rawSize - written)
+			throw std::runtime_error("compressed block has an invalid back reference");
+
+		// the reference may overlap the bytes it produces, so it is copied byte by byte in that case
+		auto source = output + written - offset;
+		if (offset >= count) {
+			std::memcpy(output + written, source, count);
+		} else {
+			for (size_t i = 0; i < count; ++i)
+				output[written + i] = source[i];
+		}
+
+		written += count;
+	}
+
+	if (written != rawSize)
+		throw std::runtime_error("compressed block does not match its size");
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef util_lz_h
+#define util_lz_h
+	#include <vector>
+	#include <cstddef>
+	#include <cstdint>
+
+	namespace Hindsight {
+		namespace Utilities {
+			/// <summary>
+			/// A small LZ77 block compressor in the spirit of LZ4: a block is a sequence of literal runs and back references of at least 
+			/// <see cref="MinMatch"/> bytes within the previous 64 KiB, found through a single hash table lookup per position. It trades ratio 
+			/// for speed, which suits binary logs that are written while a process is being debugged. This class does not depend on any 
+			/// platform API.
+			/// </summary>
+			/// <remarks>
+			///		Each sequence starts with a token byte: the high nibble is the literal length and the low nibble the match length minus 
+			///		<see cref="MinMatch"/>. A nibble of 15 is followed by bytes that are added to it until a byte other than 255. The literals 
+			///		follow, then a 16-bit little endian offset and the extra match length bytes. The last sequence only has literals.
+			/// </remarks>
+			class Lz {
+				public:
+					/// <summary>
+					/// The minimum length of a back reference.
+					/// </summary>
+					static const size_t MinMatch = 4;
+
+					/// <summary>
+					/// The maximum distance of a back reference.
+					/// </summary>
+					static const size_t MaxOffset = 0xffff;
+
+					/// <summary>
+					/// Compress <paramref name="size"/> bytes at <paramref name="data"/> and append the result to <paramref name="output"/>. 
+					/// Incompressible data grows slightly, so the caller should store the data as-is when the result is not smaller.
+					/// </summary>
+					/// <param name="data">A pointer to the data to compress.</param>
+					/// <param name="size">The number of bytes to compress.</param>
+					/// <param name="output">A reference to the vector that receives the compressed data.</param>
+					/// <returns>The number of bytes appended to <paramref name="output"/>.</returns>
+					static size_t Compress(const char* data, size_t size, std::vector<char>& output);
+
+					/// <summary>
+					/// Decompress <paramref name="size"/> bytes at <paramref name="data"/> into exactly <paramref name="rawSize"/> bytes at 
+					/// <paramref name="output"/>. The input is not trusted, it is never read or written out of bounds.
+					/// </summary>
+					/// <param name="data">A pointer to the compressed data.</param>
+					/// <param name="size">The number of compressed bytes.</param>
+					/// <param name="output">A pointer to <paramref name="rawSize"/> bytes of memory that receives the decompressed data.</param>
+					/// <param name="rawSize">The size of the data before it was compressed.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the compressed data is invalid.</exception>
+					static void Decompress(const char* data, size_t size, char* output, size_t rawSize);
+			};
+		}
+	}
+
+#endif
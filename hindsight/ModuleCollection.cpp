@@ -1,4 +1,9 @@
 #include "ModuleCollection.hpp"
+#include "CachingMemoryReader.hpp"
+
+#ifdef _WIN32
+	#include "Process.hpp"
+#endif
 
 using namespace Hindsight::Debugger;
 
@@ -14,6 +19,7 @@ Module::Module(const ModulePointer& base, const size_t& size, const std::wstring
 
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Construct a new Module instance without knowing its size, this constructor will try to retrieve that 
 /// from the debugged process by processing the image headers.
@@ -25,6 +31,7 @@ Module::Module(HANDLE hProcess, const ModulePointer& base, const std::wstring& p
 	: Base(base), Size(GetRemoteModuleSize(hProcess, base)), Path(path) {
 
 }
+#endif
 
 /// <summary>
 /// Default constructor for default initialization, used in structs.
@@ -40,6 +47,7 @@ inline bool Module::ContainsAddress(const void* addr) const {
 	return (addr >= Base && addr < ((uint8_t*)Base + Size));
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Resolve the module size by reading the image headers from the debugged process.
 /// </summary>
@@ -47,34 +55,40 @@ inline bool Module::ContainsAddress(const void* addr) const {
 /// <param name="base">Module base address.</param>
 /// <returns>The module size, or 0 when something went wrong.</returns>
 const size_t Module::GetRemoteModuleSize(HANDLE hProcess, const ModulePointer& base) {
-	SIZE_T read;
 	uint32_t offset;
 	uint16_t machine;
 
 	IMAGE_NT_HEADERS32 pe32;
 	IMAGE_NT_HEADERS64 pe64;
 
+	// The headers are read through a page cache, they normally fit in the first page of the image which is then read only once.
+	Hindsight::Process::ProcessMemoryReader source(hProcess);
+	Backend::CachingMemoryReader memory(source, 2);
+
+	auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(base));
+
 	// Read the offset to the PE header from the DOS stub header
-	if (!ReadProcessMemory(hProcess, (LPCVOID)((uint8_t*)base + 0x3c), &offset, sizeof(uint32_t), &read))
+	if (!memory.Read(address + 0x3c, offset))
 		return 0;
 
 	// Read the machine type from the PE header
-	if (!ReadProcessMemory(hProcess, (LPCVOID)((uint8_t*)base + offset + 4), &machine, sizeof(uint16_t), &read))
+	if (!memory.Read(address + offset + 4, machine))
 		return 0;
 
 	switch (machine) {
 		case IMAGE_FILE_MACHINE_AMD64: /* read the AMD64 NT headers */
-			if (!ReadProcessMemory(hProcess, (LPCVOID)((uint8_t*)base + offset), &pe64, sizeof(IMAGE_NT_HEADERS64), &read))
+			if (!memory.Read(address + offset, pe64))
 				return 0;
 			return pe64.OptionalHeader.SizeOfImage;
 		case IMAGE_FILE_MACHINE_I386:  /* read the I386 NT headers*/
-			if (!ReadProcessMemory(hProcess, (LPCVOID)((uint8_t*)base + offset), &pe32, sizeof(IMAGE_NT_HEADERS32), &read))
+			if (!memory.Read(address + offset, pe32))
 				return 0;
 			return pe32.OptionalHeader.SizeOfImage;
 		default:
 			return 0;
 	}
 }
+#endif
 
 /// <summary>
 /// Determines if a module with a certain path has been seen (loaded) before during the lifetime of this object.
@@ -103,6 +117,7 @@ bool ModuleCollection::Active(ModulePointer moduleHandle) const {
 	return m_ModuleMap.count(moduleHandle);
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Indicate that a module has been loaded, the size of the module will be retrieved from the process that 
 /// loaded it.
@@ -118,7 +133,9 @@ void ModuleCollection::Load(HANDLE hProcess, const std::wstring& path, ModulePoi
 
 	m_ModuleMap.try_emplace(moduleHandle, hProcess, moduleHandle, path);
 	m_ModuleHandleMap[path].insert(moduleHandle);
+	++m_Generation;
 }
+#endif
 
 /// <summary>
 /// Indicate that a module has been loaded, the size is known so no further information has to be retrieved
@@ -135,6 +152,7 @@ void ModuleCollection::Load(const std::wstring& path, ModulePointer moduleHandle
 
 	m_ModuleMap.try_emplace(moduleHandle, moduleHandle, size, path);
 	m_ModuleHandleMap[path].insert(moduleHandle);
+	++m_Generation;
 }
 
 /// <summary>
@@ -149,6 +167,8 @@ void ModuleCollection::Unload(ModulePointer moduleHandle) {
 
 	m_ModuleHandleMap.at(m_ModuleMap.at(moduleHandle).Path).erase(moduleHandle);
 	m_ModuleMap.erase(moduleHandle);
+	m_UnwindTables.erase(moduleHandle);
+	++m_Generation;
 }
 
 /// <summary>
@@ -200,14 +220,21 @@ const int ModuleCollection::GetIndex(const std::wstring& path) const {
 
 /// <summary>
 /// Try to resolve an address of a symbol or instruction to the module that contains that address.
+/// The module map is ordered by base address and loaded modules never overlap, which means that the
+/// only candidate is the module with the greatest base address that is not above the address itself.
 /// </summary>
 /// <param name="address">The address to resolve.</param>
 /// <returns>A pointer to a <see cref="::Hindsight::Debugger::Module"/> instance, or <see langword="nullptr"/> when the address cannot be resolved.</returns>
 const Module* ModuleCollection::GetModuleAtAddress(const void* address) const {
-	for (const auto& m : m_ModuleMap) {
-		if (m.second.ContainsAddress(address))
-			return &m.second;
-	}
+	// find the first module with a base address strictly greater than the address
+	auto it = m_ModuleMap.upper_bound(const_cast<ModulePointer>(address));
+	if (it == m_ModuleMap.begin())
+		return nullptr;
+
+	// the preceding module is the only one that could contain the address
+	--it;
+	if (it->second.ContainsAddress(address))
+		return &it->second;
 
 	return nullptr;
 }
@@ -219,4 +246,60 @@ const Module* ModuleCollection::GetModuleAtAddress(const void* address) const {
 /// <returns>A list of seen module paths.</returns>
 const std::vector<std::wstring> ModuleCollection::GetModules() const {
 	return m_Modules;
+}
+
+/// <summary>
+/// Store the identity of the image at <paramref name="path"/>, which is kept after the module is unloaded, just like
+/// its index.
+/// </summary>
+/// <param name="path">The module path.</param>
+/// <param name="identity">The identity of the image.</param>
+void ModuleCollection::SetIdentity(const std::wstring& path, const ModuleIdentity& identity) {
+	m_Identities[path] = identity;
+	++m_Generation;
+}
+
+/// <summary>
+/// Get the identity of the image at <paramref name="path"/>.
+/// </summary>
+/// <param name="path">The module path.</param>
+/// <returns>A pointer to the identity, or <see langword="nullptr"/> when it was not read.</returns>
+const ModuleIdentity* ModuleCollection::GetIdentity(const std::wstring& path) const {
+	auto it = m_Identities.find(path);
+	return it != m_Identities.end() ? &it->second : nullptr;
+}
+
+/// <summary>
+/// Get the x64 unwind table of a loaded module. The table is read from the process the first time it is needed
+/// and kept until the module is unloaded, so the exception directory of a module is parsed once rather than for
+/// every stack walk. Like the rest of this collection, this is not thread-safe, even though it is const.
+/// </summary>
+/// <param name="moduleHandle">The module base address.</param>
+/// <param name="memory">The memory of the process that loaded the module.</param>
+/// <returns>A pointer to the table, or <see langword="nullptr"/> when the module is not loaded or is not an x64 image with unwind information.</returns>
+const X64UnwindTable* ModuleCollection::GetUnwindTable(ModulePointer moduleHandle, const Backend::IMemoryReader& memory) const {
+	if (!Active(moduleHandle))
+		return nullptr;
+
+	auto it = m_UnwindTables.find(moduleHandle);
+	if (it == m_UnwindTables.end()) {
+		// a module that has no table is remembered as well, it is not read again either
+		auto table = std::make_shared<X64UnwindTable>();
+		if (!X64UnwindTable::Read(memory, reinterpret_cast<uintptr_t>(moduleHandle), *table))
+			table.reset();
+
+		it = m_UnwindTables.emplace(moduleHandle, std::move(table)).first;
+	}
+
+	return it->second.get();
+}
+
+/// <summary>
+/// Get the generation of this collection, which changes whenever a module is loaded or unloaded. Two equal
+/// generations of the same collection describe the same set of loaded modules, so a copy only has to be
+/// made again when the generation has changed.
+/// </summary>
+/// <returns>The generation of this collection.</returns>
+uint64_t ModuleCollection::Generation() const noexcept {
+	return m_Generation;
 }
\ No newline at end of file
@@ -6,7 +6,15 @@
 	#include <string>
 	#include <map>
 	#include <set>
-	#include <Windows.h>
+	#include <memory>
+	#include <cstdint>
+
+	#ifdef _WIN32
+		#include <Windows.h>
+	#endif
+
+	#include "ModuleIdentity.hpp"
+	#include "X64UnwindTable.hpp"
 
 	namespace Hindsight {
 		namespace Debugger {
@@ -34,6 +42,7 @@
 				/// <param name="path">Module filepath.</param>
 				Module(const ModulePointer& base, const size_t& size, const std::wstring& path);
 
+#ifdef _WIN32
 				/// <summary>
 				/// Construct a new Module instance without knowing its size, this constructor will try to retrieve that 
 				/// from the debugged process by processing the image headers.
@@ -42,6 +51,7 @@
 				/// <param name="base">Module base address.</param>
 				/// <param name="path">Module filepath.</param>
 				Module(HANDLE hProcess, const ModulePointer& base, const std::wstring& path);
+#endif
 
 				/// <summary>
 				/// Default constructor for default initialization, used in structs.
@@ -55,6 +65,7 @@
 				/// <returns>true is returned when this module contains the address.</returns>
 				inline bool ContainsAddress(const void* addr) const;
 
+#ifdef _WIN32
 				/// <summary>
 				/// Resolve the module size by reading the image headers from the debugged process.
 				/// </summary>
@@ -62,6 +73,7 @@
 				/// <param name="base">Module base address.</param>
 				/// <returns>The module size, or 0 when something went wrong.</returns>
 				static const size_t GetRemoteModuleSize(HANDLE hProcess, const ModulePointer& base);
+#endif
 			};
 
 			/// <summary>
@@ -74,6 +86,9 @@
 					std::map<std::wstring, std::set<ModulePointer>>		m_ModuleHandleMap;
 					std::map<ModulePointer, Module>						m_ModuleMap;
 					std::map<std::wstring, size_t>						m_ModuleIndexMap;
+					std::map<std::wstring, ModuleIdentity>				m_Identities;	/* The identity of each module path, when it was read */
+					mutable std::map<ModulePointer, std::shared_ptr<const X64UnwindTable>> m_UnwindTables;	/* The unwind table of each loaded module that was unwound through, nullptr when it has none */
+					uint64_t											m_Generation = 0;
 
 				public:
 					/// <summary>
@@ -97,6 +112,7 @@
 					/// <returns>true is returned when the module is currently active/loaded.</returns>
 					bool Active(ModulePointer moduleHandle) const;
 
+#ifdef _WIN32
 					/// <summary>
 					/// Indicate that a module has been loaded, the size of the module will be retrieved from the process that 
 					/// loaded it.
@@ -105,6 +121,7 @@
 					/// <param name="path">The module path.</param>
 					/// <param name="moduleHandle">The module base address.</param>
 					void Load(HANDLE hProcess, const std::wstring& path, ModulePointer moduleHandle);
+#endif
 
 					/// <summary>
 					/// Indicate that a module has been loaded, the size is known so no further information has to be retrieved
@@ -154,6 +171,7 @@
 
 					/// <summary>
 					/// Try to resolve an address of a symbol or instruction to the module that contains that address.
+					/// The lookup is logarithmic in the number of loaded modules.
 					/// </summary>
 					/// <param name="address">The address to resolve.</param>
 					/// <returns>A pointer to a <see cref="::Hindsight::Debugger::Module"/> instance, or <see langword="nullptr"/> when the address cannot be resolved.</returns>
@@ -165,6 +183,39 @@
 					/// </summary>
 					/// <returns>A list of seen module paths.</returns>
 					const std::vector<std::wstring> GetModules() const;
+
+					/// <summary>
+					/// Store the identity of the image at <paramref name="path"/>, which is kept after the module is unloaded, just like
+					/// its index.
+					/// </summary>
+					/// <param name="path">The module path.</param>
+					/// <param name="identity">The identity of the image.</param>
+					void SetIdentity(const std::wstring& path, const ModuleIdentity& identity);
+
+					/// <summary>
+					/// Get the identity of the image at <paramref name="path"/>.
+					/// </summary>
+					/// <param name="path">The module path.</param>
+					/// <returns>A pointer to the identity, or <see langword="nullptr"/> when it was not read.</returns>
+					const ModuleIdentity* GetIdentity(const std::wstring& path) const;
+
+					/// <summary>
+					/// Get the x64 unwind table of a loaded module. The table is read from the process the first time it is needed
+					/// and kept until the module is unloaded, so the exception directory of a module is parsed once rather than for
+					/// every stack walk. Like the rest of this collection, this is not thread-safe, even though it is const.
+					/// </summary>
+					/// <param name="moduleHandle">The module base address.</param>
+					/// <param name="memory">The memory of the process that loaded the module.</param>
+					/// <returns>A pointer to the table, or <see langword="nullptr"/> when the module is not loaded or is not an x64 image with unwind information.</returns>
+					const X64UnwindTable* GetUnwindTable(ModulePointer moduleHandle, const Backend::IMemoryReader& memory) const;
+
+					/// <summary>
+					/// Get the generation of this collection, which changes whenever a module is loaded or unloaded. Two equal
+					/// generations of the same collection describe the same set of loaded modules, so a copy only has to be
+					/// made again when the generation has changed.
+					/// </summary>
+					/// <returns>The generation of this collection.</returns>
+					uint64_t Generation() const noexcept;
 			};
 		}
 	}
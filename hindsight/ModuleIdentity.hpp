@@ -0,0 +1,147 @@
+#pragma once
+
+#ifndef debugger_module_identity_h
+#define debugger_module_identity_h
+	#include "DebugBackend.hpp"
+	#include "CachingMemoryReader.hpp"
+
+	#include <cstdint>
+	#include <cstring>
+	#include <string>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// Identifies the exact build of a PE image, which is what a symbol store indexes images and PDB files by: the image by
+			/// its link time stamp and size, the PDB by the GUID and age of the CodeView record in the debug directory. Stack frames
+			/// that are recorded as module + offset can be symbolized on another machine with nothing more than this.
+			/// </summary>
+			struct ModuleIdentity {
+				uint16_t	Machine = 0;			/* The machine type of the image. */
+				uint32_t	TimeDateStamp = 0;		/* The link time stamp from the file header. */
+				uint32_t	SizeOfImage = 0;		/* The size of the image in memory from the optional header. */
+				bool		HasPdb = false;			/* True when the image has an RSDS CodeView record. */
+				uint8_t		PdbGuid[16] = {};		/* The GUID of the PDB file. */
+				uint32_t	PdbAge = 0;				/* The age of the PDB file. */
+				std::string	PdbPath = "";			/* The path of the PDB file when the image was linked. */
+
+				/// <summary>
+				/// The longest PDB path that is read from a CodeView record.
+				/// </summary>
+				static const size_t MaxPdbPath = 1024;
+
+				/// <summary>
+				/// Read the identity of an image that is mapped at <paramref name="base"/>. Only the headers, the debug directory and
+				/// the CodeView record are read, through a small page cache so that the headers are read once. This function does not
+				/// depend on any platform API.
+				/// </summary>
+				/// <param name="memory">The memory of the process that mapped the image.</param>
+				/// <param name="base">The base address of the image.</param>
+				/// <param name="identity">A reference to the identity that receives the result.</param>
+				/// <returns>false when the headers cannot be read or are not those of a PE image, an image without a CodeView record still yields true.</returns>
+				static bool Read(const Backend::IMemoryReader& memory, uint64_t base, ModuleIdentity& identity) {
+					Backend::CachingMemoryReader reader(memory, 4);
+
+					uint16_t dosMagic = 0, magic = 0;
+					uint32_t offset = 0, signature = 0, directories = 0, debugAddress = 0, debugSize = 0;
+
+					// the DOS header points to the NT headers
+					if (!reader.Read(base, dosMagic) || dosMagic != 0x5a4d || !reader.Read(base + 0x3c, offset))
+						return false;
+
+					auto nt = base + offset;
+					if (!reader.Read(nt, signature) || signature != 0x00004550)
+						return false;
+
+					// the file header follows the signature, the optional header follows the file header
+					auto optional = nt + 24;
+					if (!reader.Read(nt + 4, identity.Machine) || !reader.Read(nt + 8, identity.TimeDateStamp) || !reader.Read(optional, magic))
+						return false;
+
+					if (magic != 0x10b && magic != 0x20b)
+						return false;
+
+					if (!reader.Read(optional + 56, identity.SizeOfImage))
+						return false;
+
+					// the data directories are 16 bytes further out in PE32+, the debug directory is the seventh
+					auto count = optional + (magic == 0x20b ? 108 : 92);
+					auto debug = optional + (magic == 0x20b ? 112 : 96) + 6 * 8;
+
+					if (!reader.Read(count, directories) || directories <= 6)
+						return true;
+
+					if (!reader.Read(debug, debugAddress) || !reader.Read(debug + 4, debugSize) || debugAddress == 0)
+						return true;
+
+					// walk the IMAGE_DEBUG_DIRECTORY entries for the CodeView one
+					for (uint32_t entry = 0; entry + 28 <= debugSize && entry < 28 * 32; entry += 28) {
+						uint32_t type = 0, size = 0, address = 0, cv = 0;
+						auto directory = base + debugAddress + entry;
+
+						if (!reader.Read(directory + 12, type) || !reader.Read(directory + 16, size) || !reader.Read(directory + 20, address))
+							break;
+
+						// IMAGE_DEBUG_TYPE_CODEVIEW with an RSDS (PDB 7.0) record
+						if (type != 2 || address == 0 || size < 24)
+							continue;
+
+						if (!reader.Read(base + address, cv) || cv != 0x53445352)
+							continue;
+
+						if (reader.Read(base + address + 4, identity.PdbGuid, sizeof(identity.PdbGuid)) != sizeof(identity.PdbGuid) ||
+							!reader.Read(base + address + 20, identity.PdbAge))
+							continue;
+
+						identity.HasPdb	 = true;
+						identity.PdbPath = reader.ReadNulTerminatedString(base + address + 24, size - 24 < MaxPdbPath ? size - 24 : MaxPdbPath);
+						break;
+					}
+
+					return true;
+				}
+
+				/// <summary>
+				/// Get the file name of the PDB path, which is the name that a symbol store indexes the PDB file by.
+				/// </summary>
+				/// <returns>The PDB file name.</returns>
+				std::string PdbName() const {
+					auto separator = PdbPath.find_last_of("\\/");
+					return separator == std::string::npos ? PdbPath : PdbPath.substr(separator + 1);
+				}
+
+				/// <summary>
+				/// Get a string that identifies this build of the image, such as for a symbol cache. The PDB GUID and age identify
+				/// the debug information best, an image without a CodeView record falls back to its time stamp and size.
+				/// </summary>
+				/// <returns>The identity string.</returns>
+				std::string Key() const {
+					static const char digits[] = "0123456789abcdef";
+					std::string key = HasPdb ? "pdb:" : "pe:";
+
+					auto hex = [&key](uint64_t value, int width) {
+						for (int shift = (width - 1) * 4; shift >= 0; shift -= 4)
+							key += digits[(value >> shift) & 0xf];
+					};
+
+					if (HasPdb) {
+						for (auto byte : PdbGuid)
+							hex(byte, 2);
+
+						key += ':';
+						hex(PdbAge, 8);
+					} else {
+						hex(Machine, 4);
+						key += ':';
+						hex(TimeDateStamp, 8);
+						key += ':';
+						hex(SizeOfImage, 8);
+					}
+
+					return key;
+				}
+			};
+		}
+	}
+
+#endif
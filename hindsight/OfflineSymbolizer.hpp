@@ -0,0 +1,118 @@
+#pragma once
+
+#ifndef debugger_offline_symbolizer_h
+#define debugger_offline_symbolizer_h
+	#include "SymbolProvider.hpp"
+	#include "PersistentSymbolCache.hpp"
+
+	#include <cstdint>
+	#include <map>
+	#include <memory>
+	#include <string>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// Resolves addresses recorded in another process to symbols and source lines, at replay. Every module that is loaded
+			/// into the symbolizer comes with an <see cref="::Hindsight::Debugger::ISymbolProvider"/> for its debug information and,
+			/// when its exact build is known, an identity string. An address is resolved to (module, RVA), which is looked up in
+			/// the <see cref="::Hindsight::Debugger::PersistentSymbolCache"/> first and only passed to the provider on a miss, so the
+			/// debug information of a module is not even loaded when all of its frames are cached. This class does not depend on
+			/// any platform API and is not thread-safe.
+			/// </summary>
+			class OfflineSymbolizer {
+				private:
+					struct Module {
+						uint64_t							Size;		/* The size of the module in memory */
+						uint64_t							Key;		/* The key of the module in the cache */
+						bool								Cacheable;	/* True when the module has an identity */
+						std::unique_ptr<ISymbolProvider>	Provider;	/* The debug information of the module */
+					};
+
+					std::shared_ptr<PersistentSymbolCache>	m_Cache;		/* The persistent cache, or nullptr */
+					std::map<uint64_t, Module>				m_Modules;		/* The modules, by base address */
+					size_t									m_Lookups;		/* The number of addresses passed to a provider */
+
+				public:
+					/// <summary>
+					/// Construct a new OfflineSymbolizer.
+					/// </summary>
+					/// <param name="cache">The persistent cache, or nullptr to always use the providers.</param>
+					OfflineSymbolizer(std::shared_ptr<PersistentSymbolCache> cache)
+						: m_Cache(std::move(cache)), m_Lookups(0) {
+
+					}
+
+					/// <summary>
+					/// Load a module, replacing any module at the same base address.
+					/// </summary>
+					/// <param name="base">The module base address.</param>
+					/// <param name="size">The module size in memory, or 0 when unknown.</param>
+					/// <param name="identity">The identity string of the build of the module, or "" when it is unknown and the module cannot be cached.</param>
+					/// <param name="provider">The debug information of the module.</param>
+					void Load(uint64_t base, uint64_t size, const std::string& identity, std::unique_ptr<ISymbolProvider> provider) {
+						Module module;
+						module.Size		 = size;
+						module.Key		 = identity.empty() ? 0 : PersistentSymbolCache::ModuleKey(identity);
+						module.Cacheable = !identity.empty();
+						module.Provider	 = std::move(provider);
+
+						m_Modules[base] = std::move(module);
+					}
+
+					/// <summary>
+					/// Unload the module at <paramref name="base"/>.
+					/// </summary>
+					/// <param name="base">The module base address.</param>
+					void Unload(uint64_t base) {
+						m_Modules.erase(base);
+					}
+
+					/// <summary>
+					/// Resolve an address to the symbol and source line of the module that contains it.
+					/// </summary>
+					/// <param name="address">The address to resolve.</param>
+					/// <param name="record">A reference to the record that receives the result, relative to <paramref name="base"/>.</param>
+					/// <param name="base">A reference that receives the base address of the module.</param>
+					/// <returns>true when a symbol or a source line was found.</returns>
+					bool Resolve(uint64_t address, SymbolRecord& record, uint64_t& base) {
+						auto it = m_Modules.upper_bound(address);
+						if (it == m_Modules.begin())
+							return false;
+
+						// a module of unknown size extends up to the next module
+						--it;
+						if (it->second.Size != 0 && address - it->first >= it->second.Size)
+							return false;
+
+						auto& module = it->second;
+						auto rva = address - it->first;
+						base = it->first;
+
+						if (m_Cache && module.Cacheable && m_Cache->Find(module.Key, rva, record))
+							return true;
+
+						++m_Lookups;
+						record = SymbolRecord();
+						if (!module.Provider || !module.Provider->Lookup(rva, record))
+							return false;
+
+						// only results are cached, symbols that are missing here may well be found on the next run
+						if (m_Cache && module.Cacheable)
+							m_Cache->Insert(module.Key, rva, record);
+
+						return true;
+					}
+
+					/// <summary>
+					/// Get the number of addresses that were passed to a provider, because they were not cached.
+					/// </summary>
+					/// <returns>The number of provider lookups.</returns>
+					size_t Lookups() const noexcept {
+						return m_Lookups;
+					}
+			};
+		}
+	}
+
+#endif
@@ -2,6 +2,8 @@
 #include <Windows.h>
 #include <Psapi.h>
 #include <filesystem>
+#include <algorithm>
+#include <cctype>
 
 namespace fs = std::filesystem;
 
@@ -117,4 +119,70 @@ bool Path::EnsureParentExists(const std::string& path) {
 	if (!fs::is_directory(parent))
 		return fs::create_directories(parent);
 	return true;
+}
+
+/// <summary>
+/// Determines if <paramref name="name"/> matches the wildcard <paramref name="pattern"/>, where '*' matches any
+/// sequence of characters and '?' matches exactly one character. The comparison is case-insensitive, like the
+/// Windows shell.
+/// </summary>
+/// <param name="pattern">The wildcard pattern.</param>
+/// <param name="name">The name to match against the pattern.</param>
+/// <returns>When <paramref name="name"/> matches <paramref name="pattern"/>, true is returned.</returns>
+bool Path::MatchWildcard(const std::string& pattern, const std::string& name) {
+	size_t p = 0, n = 0;
+	size_t star = std::string::npos, resume = 0;
+
+	// greedy matching with backtracking to the last '*', which is linear for patterns with a single '*'
+	while (n < name.size()) {
+		if (p < pattern.size() && (pattern[p] == '?' || std::tolower((unsigned char)pattern[p]) == std::tolower((unsigned char)name[n]))) {
+			++p;
+			++n;
+		} else if (p < pattern.size() && pattern[p] == '*') {
+			star   = p++;
+			resume = n;
+		} else if (star != std::string::npos) {
+			p = star + 1;
+			n = ++resume;
+		} else {
+			return false;
+		}
+	}
+
+	while (p < pattern.size() && pattern[p] == '*')
+		++p;
+
+	return p == pattern.size();
+}
+
+/// <summary>
+/// Expands <paramref name="path"/> to a sorted list of files. A directory expands to all files with extension
+/// <paramref name="extension"/> in it and its subdirectories, a path with wildcards in its filename expands to
+/// all matching files in the parent directory and any other existing file expands to itself.
+/// </summary>
+/// <param name="path">The directory, wildcard pattern or file path to expand.</param>
+/// <param name="extension">The extension, including the dot, of the files to collect from directories.</param>
+/// <returns>The sorted list of files, which is empty when nothing matched.</returns>
+std::vector<std::string> Path::Expand(const std::string& path, const std::string& extension) {
+	std::vector<std::string> result;
+	fs::path p(path);
+
+	if (fs::is_directory(p)) {
+		for (const auto& entry : fs::recursive_directory_iterator(p, fs::directory_options::skip_permission_denied))
+			if (entry.is_regular_file() && MatchWildcard("*" + extension, entry.path().filename().string()))
+				result.push_back(entry.path().string());
+	} else if (p.filename().string().find_first_of("*?") != std::string::npos) {
+		auto parent = p.has_parent_path() ? p.parent_path() : fs::path(".");
+		auto pattern = p.filename().string();
+
+		if (fs::is_directory(parent))
+			for (const auto& entry : fs::directory_iterator(parent, fs::directory_options::skip_permission_denied))
+				if (entry.is_regular_file() && MatchWildcard(pattern, entry.path().filename().string()))
+					result.push_back(entry.path().string());
+	} else if (fs::is_regular_file(p)) {
+		result.push_back(p.string());
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
 }
\ No newline at end of file
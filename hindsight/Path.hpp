@@ -3,6 +3,7 @@
 #ifndef util_path_h
 #define util_path_h
 	#include <string>
+	#include <vector>
 	#include <Windows.h>
 
 	namespace Hindsight {
@@ -55,6 +56,26 @@
 					/// <param name="path">The path of which the parent path must be verified.</param>
 					/// <returns>When successful, true is returned.</returns>
 					static bool	EnsureParentExists(const std::string& path);
+
+					/// <summary>
+					/// Determines if <paramref name="name"/> matches the wildcard <paramref name="pattern"/>, where '*' matches any
+					/// sequence of characters and '?' matches exactly one character. The comparison is case-insensitive, like the
+					/// Windows shell.
+					/// </summary>
+					/// <param name="pattern">The wildcard pattern.</param>
+					/// <param name="name">The name to match against the pattern.</param>
+					/// <returns>When <paramref name="name"/> matches <paramref name="pattern"/>, true is returned.</returns>
+					static bool MatchWildcard(const std::string& pattern, const std::string& name);
+
+					/// <summary>
+					/// Expands <paramref name="path"/> to a sorted list of files. A directory expands to all files with extension
+					/// <paramref name="extension"/> in it and its subdirectories, a path with wildcards in its filename expands to
+					/// all matching files in the parent directory and any other existing file expands to itself.
+					/// </summary>
+					/// <param name="path">The directory, wildcard pattern or file path to expand.</param>
+					/// <param name="extension">The extension, including the dot, of the files to collect from directories.</param>
+					/// <returns>The sorted list of files, which is empty when nothing matched.</returns>
+					static std::vector<std::string> Expand(const std::string& path, const std::string& extension);
 			};
 		}
 	}
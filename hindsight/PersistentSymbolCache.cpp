@@ -0,0 +1,476 @@
+#include "PersistentSymbolCache.hpp"
+
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <sys/file.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace Hindsight::Debugger;
+
+static const char		cache_signature[4]	= { 'H', 'S', 'Y', 'C' };
+static const uint32_t	flag_symbol			= 1;
+static const uint32_t	flag_line			= 2;
+static const size_t		initial_data_size	= 1024 * 1024;
+
+/// <summary>
+/// Round <paramref name="size"/> up to a multiple of 8, so that every record is aligned.
+/// </summary>
+/// <param name="size">The size.</param>
+/// <returns>The aligned size.</returns>
+static size_t align_record(size_t size) {
+	return (size + 7) & ~static_cast<size_t>(7);
+}
+
+/// <summary>
+/// Determine the bucket of an address in a module.
+/// </summary>
+/// <param name="module">The module key.</param>
+/// <param name="rva">The address, relative to the module base.</param>
+/// <param name="buckets">The number of buckets, a power of two.</param>
+/// <returns>The bucket index.</returns>
+static size_t bucket_of(uint64_t module, uint64_t rva, uint32_t buckets) {
+	auto hash = module ^ (rva * 0x9e3779b97f4a7c15ull);
+	hash ^= hash >> 32;
+	hash *= 0xd6e8feb86659fd93ull;
+	hash ^= hash >> 32;
+
+	return static_cast<size_t>(hash & (buckets - 1));
+}
+
+/// <summary>
+/// Open a cache file, which is created when it does not exist yet.
+/// </summary>
+/// <param name="path">The path of the cache file.</param>
+/// <param name="buckets">The number of buckets when the file is created, a power of two.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be opened or mapped, or is not a symbol cache of this version.</exception>
+PersistentSymbolCache::PersistentSymbolCache(const std::string& path, uint32_t buckets)
+	: m_Path(path),
+	#ifdef _WIN32
+	  m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL),
+	#else
+	  m_File(-1),
+	#endif
+	  m_Data(nullptr), m_Size(0), m_Hits(0), m_Misses(0) {
+
+	if (buckets == 0 || (buckets & (buckets - 1)) != 0)
+		throw std::runtime_error("the number of buckets of a symbol cache must be a power of two");
+
+	uint64_t size = 0;
+
+#ifdef _WIN32
+	m_File = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("cannot open symbol cache: " + path);
+#else
+	m_File = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (m_File < 0)
+		throw std::runtime_error("cannot open symbol cache: " + path);
+#endif
+
+	// the first process to lock an empty file initializes it, the others wait for it and map the result
+	Lock(true);
+
+	try {
+	#ifdef _WIN32
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(static_cast<HANDLE>(m_File), &fileSize))
+			throw std::runtime_error("cannot determine the size of symbol cache: " + path);
+
+		size = static_cast<uint64_t>(fileSize.QuadPart);
+	#else
+		struct stat status;
+		if (fstat(m_File, &status) != 0)
+			throw std::runtime_error("cannot determine the size of symbol cache: " + path);
+
+		size = static_cast<uint64_t>(status.st_size);
+	#endif
+
+		if (size != 0 && size < sizeof(SymbolCacheHeader))
+			throw std::runtime_error("file is not a symbol cache: " + path);
+
+		if (size != 0)
+			Map(static_cast<size_t>(size));
+
+		// a process that died while initializing the file leaves it without a signature
+		static const char none[sizeof(cache_signature)] = { 0 };
+		auto header = reinterpret_cast<const SymbolCacheHeader*>(m_Data);
+
+		if (size == 0 || std::memcmp(header->Signature, none, sizeof(none)) == 0) {
+			Initialize(buckets);
+		} else {
+			auto start = sizeof(SymbolCacheHeader) + static_cast<uint64_t>(header->Buckets) * sizeof(uint64_t);
+
+			if (std::memcmp(header->Signature, cache_signature, sizeof(cache_signature)) != 0)
+				throw std::runtime_error("file is not a symbol cache: " + path);
+
+			if (header->Version != FormatVersion || header->Buckets == 0 || (header->Buckets & (header->Buckets - 1)) != 0 ||
+				header->Used < start || header->Used > header->Capacity || header->Capacity > size)
+				throw std::runtime_error("symbol cache was written by another version of hindsight or is damaged, delete it to start a new cache: " + path);
+
+			Refresh();
+		}
+	} catch (...) {
+		Unlock();
+		Close();
+		throw;
+	}
+
+	Unlock();
+}
+
+/// <summary>
+/// Unmap and close the cache file.
+/// </summary>
+PersistentSymbolCache::~PersistentSymbolCache() {
+	Close();
+}
+
+/// <summary>
+/// Get the key that identifies a module in the cache, which is a hash of a string that identifies the exact build
+/// of the module (see <see cref="::Hindsight::Debugger::ModuleIdentity::Key"/>).
+/// </summary>
+/// <param name="identity">The identity string of the module.</param>
+/// <returns>The module key.</returns>
+uint64_t PersistentSymbolCache::ModuleKey(const std::string& identity) {
+	// 64-bit FNV-1a, which is stable across platforms and compilers unlike std::hash
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (auto ch : identity) {
+		hash ^= static_cast<uint8_t>(ch);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+/// <summary>
+/// Look up the record of an address.
+/// </summary>
+/// <param name="module">The module key.</param>
+/// <param name="rva">The address, relative to the module base.</param>
+/// <param name="record">A reference to the record that receives the result.</param>
+/// <returns>true when the address is in the cache.</returns>
+bool PersistentSymbolCache::Find(uint64_t module, uint64_t rva, SymbolRecord& record) {
+	bool found = false;
+
+	Lock(false);
+
+	try {
+		Refresh();
+
+		auto offset = Locate(module, rva);
+		if (offset != 0) {
+			auto header = reinterpret_cast<const SymbolCacheHeader*>(m_Data);
+			auto entry = reinterpret_cast<const SymbolCacheRecord*>(m_Data + offset);
+			auto strings = reinterpret_cast<const char*>(entry + 1);
+
+			// a record that claims more than the used size is damaged, which is treated as a miss
+			if (offset + sizeof(SymbolCacheRecord) + entry->NameLength + entry->FileLength <= header->Used) {
+				record.HasSymbol	= (entry->Flags & flag_symbol) != 0;
+				record.Name			= std::string(strings, entry->NameLength);
+				record.SymbolRva	= entry->SymbolRva;
+				record.SymbolSize	= entry->SymbolSize;
+				record.HasLine		= (entry->Flags & flag_line) != 0;
+				record.File			= std::string(strings + entry->NameLength, entry->FileLength);
+				record.Line			= entry->Line;
+				record.LineRva		= entry->LineRva;
+
+				found = true;
+			}
+		}
+	} catch (...) {
+		Unlock();
+		throw;
+	}
+
+	Unlock();
+
+	if (found)
+		++m_Hits;
+	else
+		++m_Misses;
+
+	return found;
+}
+
+/// <summary>
+/// Add the record of an address, unless another process added it first.
+/// </summary>
+/// <param name="module">The module key.</param>
+/// <param name="rva">The address, relative to the module base.</param>
+/// <param name="record">A const reference to the record.</param>
+/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be grown.</exception>
+void PersistentSymbolCache::Insert(uint64_t module, uint64_t rva, const SymbolRecord& record) {
+	auto nameLength = record.Name.size() < MaxStringLength ? record.Name.size() : MaxStringLength;
+	auto fileLength = record.File.size() < MaxStringLength ? record.File.size() : MaxStringLength;
+	auto size		= align_record(sizeof(SymbolCacheRecord) + nameLength + fileLength);
+
+	Lock(true);
+
+	try {
+		Refresh();
+
+		if (Locate(module, rva) == 0) {
+			auto header = reinterpret_cast<SymbolCacheHeader*>(m_Data);
+
+			if (header->Used + size > header->Capacity) {
+				auto capacity = header->Capacity * 2;
+				while (capacity < header->Used + size)
+					capacity *= 2;
+
+				Grow(static_cast<size_t>(capacity));
+				header = reinterpret_cast<SymbolCacheHeader*>(m_Data);
+			}
+
+			auto offset  = header->Used;
+			auto& head	 = reinterpret_cast<uint64_t*>(m_Data + sizeof(SymbolCacheHeader))[bucket_of(module, rva, header->Buckets)];
+			auto entry	 = reinterpret_cast<SymbolCacheRecord*>(m_Data + offset);
+			auto strings = reinterpret_cast<char*>(entry + 1);
+
+			entry->Next			= head;
+			entry->Module		= module;
+			entry->Rva			= rva;
+			entry->SymbolRva	= record.SymbolRva;
+			entry->SymbolSize	= record.SymbolSize;
+			entry->LineRva		= record.LineRva;
+			entry->Line			= record.Line;
+			entry->Flags		= (record.HasSymbol ? flag_symbol : 0) | (record.HasLine ? flag_line : 0);
+			entry->NameLength	= static_cast<uint32_t>(nameLength);
+			entry->FileLength	= static_cast<uint32_t>(fileLength);
+
+			std::memcpy(strings, record.Name.data(), nameLength);
+			std::memcpy(strings + nameLength, record.File.data(), fileLength);
+
+			// the used size covers the record before it is linked, see the class documentation
+			header->Used = offset + size;
+			++header->Records;
+			head = offset;
+		}
+	} catch (...) {
+		Unlock();
+		throw;
+	}
+
+	Unlock();
+}
+
+/// <summary>
+/// Get the number of records in the file.
+/// </summary>
+/// <returns>The number of records.</returns>
+uint64_t PersistentSymbolCache::Records() {
+	Lock(false);
+
+	uint64_t records = 0;
+	try {
+		Refresh();
+		records = reinterpret_cast<const SymbolCacheHeader*>(m_Data)->Records;
+	} catch (...) {
+		Unlock();
+		throw;
+	}
+
+	Unlock();
+	return records;
+}
+
+/// <summary>
+/// Get the number of lookups that found a record.
+/// </summary>
+/// <returns>The number of cache hits.</returns>
+size_t PersistentSymbolCache::Hits() const noexcept {
+	return m_Hits;
+}
+
+/// <summary>
+/// Get the number of lookups that did not find a record.
+/// </summary>
+/// <returns>The number of cache misses.</returns>
+size_t PersistentSymbolCache::Misses() const noexcept {
+	return m_Misses;
+}
+
+/// <summary>
+/// Lock the file against other processes.
+/// </summary>
+/// <param name="exclusive">true for an exclusive (write) lock, false for a shared (read) lock.</param>
+void PersistentSymbolCache::Lock(bool exclusive) {
+#ifdef _WIN32
+	// lock a byte far beyond the data, locked ranges of a file cannot be read or written through other handles
+	OVERLAPPED overlapped = { 0 };
+	overlapped.OffsetHigh = 0x7fffffff;
+
+	if (!LockFileEx(static_cast<HANDLE>(m_File), exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &overlapped))
+		throw std::runtime_error("cannot lock symbol cache: " + m_Path);
+#else
+	// flock locks belong to the open file, so caches in the same process exclude each other too
+	while (flock(m_File, exclusive ? LOCK_EX : LOCK_SH) != 0) {
+		if (errno != EINTR)
+			throw std::runtime_error("cannot lock symbol cache: " + m_Path);
+	}
+#endif
+}
+
+/// <summary>
+/// Release the lock taken by <see cref="Lock"/>.
+/// </summary>
+void PersistentSymbolCache::Unlock() {
+#ifdef _WIN32
+	OVERLAPPED overlapped = { 0 };
+	overlapped.OffsetHigh = 0x7fffffff;
+
+	UnlockFileEx(static_cast<HANDLE>(m_File), 0, 1, 0, &overlapped);
+#else
+	flock(m_File, LOCK_UN);
+#endif
+}
+
+/// <summary>
+/// Map the file again when another process has grown it, which requires a lock.
+/// </summary>
+void PersistentSymbolCache::Refresh() {
+	auto capacity = reinterpret_cast<const SymbolCacheHeader*>(m_Data)->Capacity;
+	if (capacity != m_Size)
+		Map(static_cast<size_t>(capacity));
+}
+
+/// <summary>
+/// Grow the file to <paramref name="size"/> bytes and map it again, which requires an exclusive lock.
+/// </summary>
+/// <param name="size">The new size of the file.</param>
+void PersistentSymbolCache::Grow(size_t size) {
+#ifndef _WIN32
+	// a file mapping on Windows grows the file by itself
+	if (ftruncate(m_File, static_cast<off_t>(size)) != 0)
+		throw std::runtime_error("cannot grow symbol cache: " + m_Path);
+#endif
+
+	Map(size);
+	reinterpret_cast<SymbolCacheHeader*>(m_Data)->Capacity = size;
+}
+
+/// <summary>
+/// Map <paramref name="size"/> bytes of the file, replacing the current view.
+/// </summary>
+/// <param name="size">The number of bytes to map.</param>
+void PersistentSymbolCache::Map(size_t size) {
+	Unmap();
+
+#ifdef _WIN32
+	ULARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = size;
+
+	m_Mapping = CreateFileMappingA(static_cast<HANDLE>(m_File), NULL, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, NULL);
+	if (m_Mapping == NULL)
+		throw std::runtime_error("cannot create file mapping: " + m_Path);
+
+	m_Data = static_cast<uint8_t*>(MapViewOfFile(static_cast<HANDLE>(m_Mapping), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size));
+	if (m_Data == nullptr)
+		throw std::runtime_error("cannot map view of file: " + m_Path);
+#else
+	auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+	if (data == MAP_FAILED)
+		throw std::runtime_error("cannot map view of file: " + m_Path);
+
+	m_Data = static_cast<uint8_t*>(data);
+#endif
+
+	m_Size = size;
+}
+
+/// <summary>
+/// Unmap the current view, if any.
+/// </summary>
+void PersistentSymbolCache::Unmap() {
+#ifdef _WIN32
+	if (m_Data != nullptr)
+		UnmapViewOfFile(m_Data);
+
+	if (m_Mapping != NULL) {
+		CloseHandle(static_cast<HANDLE>(m_Mapping));
+		m_Mapping = NULL;
+	}
+#else
+	if (m_Data != nullptr)
+		munmap(m_Data, m_Size);
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+/// <summary>
+/// Write the header and the empty bucket table of a new file, which requires an exclusive lock.
+/// </summary>
+/// <param name="buckets">The number of buckets.</param>
+void PersistentSymbolCache::Initialize(uint32_t buckets) {
+	auto start = sizeof(SymbolCacheHeader) + static_cast<size_t>(buckets) * sizeof(uint64_t);
+
+	// the file is zero filled, which leaves all buckets empty
+	Grow(start + initial_data_size);
+
+	auto header = reinterpret_cast<SymbolCacheHeader*>(m_Data);
+	header->Version		= FormatVersion;
+	header->Buckets		= buckets;
+	header->Reserved	= 0;
+	header->Used		= start;
+	header->Records		= 0;
+
+	// the signature goes last, a file without one is initialized again
+	std::memcpy(header->Signature, cache_signature, sizeof(cache_signature));
+}
+
+/// <summary>
+/// Find the record of an address in the mapped file, which requires a lock.
+/// </summary>
+/// <param name="module">The module key.</param>
+/// <param name="rva">The address, relative to the module base.</param>
+/// <returns>The file offset of the record, or 0 when there is none.</returns>
+uint64_t PersistentSymbolCache::Locate(uint64_t module, uint64_t rva) const {
+	auto header  = reinterpret_cast<const SymbolCacheHeader*>(m_Data);
+	auto buckets = reinterpret_cast<const uint64_t*>(m_Data + sizeof(SymbolCacheHeader));
+	auto start	 = sizeof(SymbolCacheHeader) + static_cast<uint64_t>(header->Buckets) * sizeof(uint64_t);
+	auto used	 = header->Used < m_Size ? header->Used : m_Size;
+	auto offset	 = buckets[bucket_of(module, rva, header->Buckets)];
+
+	// a damaged chain ends the lookup, rather than leaving the file or going around in circles
+	for (uint64_t hops = 0; offset != 0 && hops <= header->Records; ++hops) {
+		if (offset < start || offset % 8 != 0 || offset > used || used - offset < sizeof(SymbolCacheRecord))
+			return 0;
+
+		auto entry = reinterpret_cast<const SymbolCacheRecord*>(m_Data + offset);
+		if (entry->Module == module && entry->Rva == rva)
+			return offset;
+
+		offset = entry->Next;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Close all handles that were opened so far.
+/// </summary>
+void PersistentSymbolCache::Close() {
+	Unmap();
+
+#ifdef _WIN32
+	if (m_File != INVALID_HANDLE_VALUE) {
+		CloseHandle(static_cast<HANDLE>(m_File));
+		m_File = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_File >= 0) {
+		close(m_File);
+		m_File = -1;
+	}
+#endif
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#ifndef debugger_persistent_symbol_cache_h
+#define debugger_persistent_symbol_cache_h
+	#include "SymbolProvider.hpp"
+
+	#include <cstddef>
+	#include <cstdint>
+	#include <string>
+
+	namespace Hindsight {
+		namespace Debugger {
+			#pragma pack(push, 1)
+			/// <summary>
+			/// The header of a symbol cache file, which is followed by the bucket table: one file offset (uint64_t) per bucket
+			/// of the first record in its chain, or 0 for an empty bucket.
+			/// </summary>
+			struct SymbolCacheHeader {
+				char		Signature[4];	/* The file signature, always 'HSYC'. */
+				uint32_t	Version;		/* The version of the file format. */
+				uint32_t	Buckets;		/* The number of buckets, a power of two. */
+				uint32_t	Reserved;		/* Reserved, always 0. */
+				uint64_t	Used;			/* The number of bytes in use, new records are appended here. */
+				uint64_t	Capacity;		/* The size of the file, which is grown ahead of the used size. */
+				uint64_t	Records;		/* The number of records. */
+			};
+
+			/// <summary>
+			/// A record of a symbol cache file, which is followed by the name and the file (not terminated) and padded to 8 bytes.
+			/// </summary>
+			struct SymbolCacheRecord {
+				uint64_t	Next;			/* The file offset of the next record in the bucket, or 0. */
+				uint64_t	Module;			/* The module key. */
+				uint64_t	Rva;			/* The address, relative to the module base. */
+				uint64_t	SymbolRva;		/* The start of the symbol. */
+				uint64_t	SymbolSize;		/* The size of the symbol. */
+				uint64_t	LineRva;		/* The first instruction of the line. */
+				uint32_t	Line;			/* The line number. */
+				uint32_t	Flags;			/* 1 when the record has a symbol, 2 when it has a line. */
+				uint32_t	NameLength;		/* The length of the name in bytes. */
+				uint32_t	FileLength;		/* The length of the file in bytes. */
+			};
+			#pragma pack(pop)
+
+			/// <summary>
+			/// A symbol cache in a memory mapped file, which maps (module identity, RVA) to a <see cref="::Hindsight::Debugger::SymbolRecord"/>
+			/// and is shared by all processes that open the same file. Repeated triage of the same build resolves its frames from
+			/// the cache instead of loading and parsing the debug information again.
+			///
+			/// The file is a header, a fixed table of buckets and the records, which are only ever appended and chained per bucket.
+			/// All values are little-endian and all references are file offsets, so the file does not depend on the platform or
+			/// the address at which it is mapped. Lookups hold a shared lock on the file and inserts an exclusive one, a process
+			/// that finds the file grown by another process maps it again. A record is linked into its bucket only after the used
+			/// size covers it, so a process that dies while inserting leaves unreachable bytes at worst.
+			/// </summary>
+			class PersistentSymbolCache {
+				public:
+					/// <summary>
+					/// The version of the file format.
+					/// </summary>
+					static const uint32_t FormatVersion = 1;
+
+					/// <summary>
+					/// The number of buckets of a new file.
+					/// </summary>
+					static const uint32_t DefaultBuckets = 64 * 1024;
+
+					/// <summary>
+					/// The longest name or file that is stored, longer strings are truncated.
+					/// </summary>
+					static const size_t MaxStringLength = 4096;
+
+				private:
+					std::string	m_Path;		/* The path of the cache file */
+				#ifdef _WIN32
+					void*		m_File;		/* The file handle */
+					void*		m_Mapping;	/* The file mapping handle */
+				#else
+					int			m_File;		/* The file descriptor */
+				#endif
+					uint8_t*	m_Data;		/* The mapped view of the file */
+					size_t		m_Size;		/* The size of the mapped view */
+					size_t		m_Hits;		/* The number of lookups that found a record */
+					size_t		m_Misses;	/* The number of lookups that did not */
+
+				public:
+					/// <summary>
+					/// Open a cache file, which is created when it does not exist yet.
+					/// </summary>
+					/// <param name="path">The path of the cache file.</param>
+					/// <param name="buckets">The number of buckets when the file is created, a power of two.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be opened or mapped, or is not a symbol cache of this version.</exception>
+					PersistentSymbolCache(const std::string& path, uint32_t buckets = DefaultBuckets);
+
+					/// <summary>
+					/// Unmap and close the cache file.
+					/// </summary>
+					~PersistentSymbolCache();
+
+					PersistentSymbolCache(const PersistentSymbolCache&) = delete;
+					PersistentSymbolCache& operator=(const PersistentSymbolCache&) = delete;
+
+					/// <summary>
+					/// Get the key that identifies a module in the cache, which is a hash of a string that identifies the exact build
+					/// of the module (see <see cref="::Hindsight::Debugger::ModuleIdentity::Key"/>).
+					/// </summary>
+					/// <param name="identity">The identity string of the module.</param>
+					/// <returns>The module key.</returns>
+					static uint64_t ModuleKey(const std::string& identity);
+
+					/// <summary>
+					/// Look up the record of an address.
+					/// </summary>
+					/// <param name="module">The module key.</param>
+					/// <param name="rva">The address, relative to the module base.</param>
+					/// <param name="record">A reference to the record that receives the result.</param>
+					/// <returns>true when the address is in the cache.</returns>
+					bool Find(uint64_t module, uint64_t rva, SymbolRecord& record);
+
+					/// <summary>
+					/// Add the record of an address, unless another process added it first.
+					/// </summary>
+					/// <param name="module">The module key.</param>
+					/// <param name="rva">The address, relative to the module base.</param>
+					/// <param name="record">A const reference to the record.</param>
+					/// <exception cref="std::runtime_error">This exception is thrown when the file cannot be grown.</exception>
+					void Insert(uint64_t module, uint64_t rva, const SymbolRecord& record);
+
+					/// <summary>
+					/// Get the number of records in the file.
+					/// </summary>
+					/// <returns>The number of records.</returns>
+					uint64_t Records();
+
+					/// <summary>
+					/// Get the number of lookups that found a record.
+					/// </summary>
+					/// <returns>The number of cache hits.</returns>
+					size_t Hits() const noexcept;
+
+					/// <summary>
+					/// Get the number of lookups that did not find a record.
+					/// </summary>
+					/// <returns>The number of cache misses.</returns>
+					size_t Misses() const noexcept;
+
+				private:
+					/// <summary>
+					/// Lock the file against other processes.
+					/// </summary>
+					/// <param name="exclusive">true for an exclusive (write) lock, false for a shared (read) lock.</param>
+					void Lock(bool exclusive);
+
+					/// <summary>
+					/// Release the lock taken by <see cref="Lock"/>.
+					/// </summary>
+					void Unlock();
+
+					/// <summary>
+					/// Map the file again when another process has grown it, which requires a lock.
+					/// </summary>
+					void Refresh();
+
+					/// <summary>
+					/// Grow the file to <paramref name="size"/> bytes and map it again, which requires an exclusive lock.
+					/// </summary>
+					/// <param name="size">The new size of the file.</param>
+					void Grow(size_t size);
+
+					/// <summary>
+					/// Map <paramref name="size"/> bytes of the file, replacing the current view.
+					/// </summary>
+					/// <param name="size">The number of bytes to map.</param>
+					void Map(size_t size);
+
+					/// <summary>
+					/// Unmap the current view, if any.
+					/// </summary>
+					void Unmap();
+
+					/// <summary>
+					/// Write the header and the empty bucket table of a new file, which requires an exclusive lock.
+					/// </summary>
+					/// <param name="buckets">The number of buckets.</param>
+					void Initialize(uint32_t buckets);
+
+					/// <summary>
+					/// Find the record of an address in the mapped file, which requires a lock.
+					/// </summary>
+					/// <param name="module">The module key.</param>
+					/// <param name="rva">The address, relative to the module base.</param>
+					/// <returns>The file offset of the record, or 0 when there is none.</returns>
+					uint64_t Locate(uint64_t module, uint64_t rva) const;
+
+					/// <summary>
+					/// Close all handles that were opened so far.
+					/// </summary>
+					void Close();
+			};
+		}
+	}
+
+#endif
@@ -4,6 +4,7 @@
 #include "rang.hpp"
 
 #include <sstream>
+#include <cstring>
 #include <ctime>
 #include <algorithm>
 #include <iterator>
@@ -11,6 +12,8 @@
 #include <iostream>
 #include <ios>
 
+static const size_t max_stack_memory_slots = 32;	/* The largest number of stack slots that is printed for a stack snapshot */
+
 /// <summary>
 /// When colorization is enabled, rang_color will switch to the color defined in c
 /// </summary>
@@ -237,8 +240,10 @@ void PrintingDebuggerEventHandler::OnBreakpointHit(
 
 	rang_reset();
 
-	if (m_PrintContext)
+	if (m_PrintContext) {
 		PrintContext(context);
+		PrintStackMemory(context, collection);
+	}
 
 	PrintStackTrace(pi, context, trace, collection);
 }
@@ -296,8 +301,10 @@ void PrintingDebuggerEventHandler::OnException(
 	if (ertti != nullptr)
 		PrintRtti(ertti);
 
-	if (m_PrintContext)
+	if (m_PrintContext) {
 		PrintContext(context);
+		PrintStackMemory(context, collection);
+	}
 
 	PrintStackTrace(pi, context, trace, collection);
 }
@@ -778,6 +785,43 @@ void PrintingDebuggerEventHandler::PrintContext(std::shared_ptr<const DebugConte
 	m_WStream << std::endl;
 }
 
+/// <summary>
+/// Print the stack slots of the stack snapshot of a thread context that point into a loaded module, which are the return addresses 
+/// and function pointers that a stack walk may have missed. Nothing is printed when the context has no snapshot.
+/// </summary>
+/// <param name="context">A shared pointer to the thread context at the time of the event.</param>
+/// <param name="collection">A const reference to a <see cref="::Hindsight::Debugger::ModuleCollection"/> instance.</param>
+void PrintingDebuggerEventHandler::PrintStackMemory(std::shared_ptr<const DebugContext> context, const ModuleCollection& collection) const {
+	const auto& stack = context->GetStack();
+	if (stack.empty())
+		return;
+
+	rang_color_wstream(rang::fgB::magenta)
+		<< L"[STKMEM] ";
+	rang_color_wstream(rang::fg::green)
+		<< stack.size() << L" bytes @ 0x" << std::hex << context->GetStackAddress() << std::dec << std::endl;
+	rang_reset();
+
+	size_t pointerSize = context->Is64() ? 8 : 4, found = 0;
+	for (size_t offset = 0; offset + pointerSize <= stack.size() && found < max_stack_memory_slots; offset += pointerSize) {
+		uint64_t value = 0;
+		std::memcpy(&value, stack.data() + offset, pointerSize);
+
+		if (value == 0 || collection.GetModuleAtAddress(reinterpret_cast<const void*>(value)) == nullptr)
+			continue;
+
+		rang_color_wstream(rang::fg::cyan)
+			<< L"\t+0x" << std::hex << std::setw(4) << std::setfill(L'0') << offset << std::dec << std::setw(0);
+		rang_color_wstream(rang::fg::yellow)
+			<< GetAddressDescriptor(reinterpret_cast<const void*>(value), collection) << std::endl;
+		rang_reset();
+
+		++found;
+	}
+
+	RestoreFlags();
+}
+
 /// <summary>
 /// Print a single RTTI class entity.
 /// </summary>
@@ -297,6 +297,14 @@
 						/// <param name="context">A shared pointer to the thread context at the time of the event.</param>
 						void PrintContext(std::shared_ptr<const DebugContext> context) const;
 
+						/// <summary>
+						/// Print the stack slots of the stack snapshot of a thread context that point into a loaded module, which are the return addresses 
+						/// and function pointers that a stack walk may have missed. Nothing is printed when the context has no snapshot.
+						/// </summary>
+						/// <param name="context">A shared pointer to the thread context at the time of the event.</param>
+						/// <param name="collection">A const reference to a <see cref="::Hindsight::Debugger::ModuleCollection"/> instance.</param>
+						void PrintStackMemory(std::shared_ptr<const DebugContext> context, const ModuleCollection& collection) const;
+
 						/// <summary>
 						/// Print a single RTTI class entity.
 						/// </summary>
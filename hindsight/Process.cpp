@@ -1,6 +1,46 @@
 #include "Process.hpp"
 using namespace Hindsight::Process;
 
+#ifdef _WIN32
+/// <summary>
+/// Construct a new ProcessMemoryReader for a process handle.
+/// </summary>
+/// <param name="hProcess">A process handle with PROCESS_VM_READ access, which must outlive the reader.</param>
+ProcessMemoryReader::ProcessMemoryReader(HANDLE hProcess) : m_Process(hProcess) {
+
+}
+
+/// <summary>
+/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the process.
+/// </summary>
+/// <param name="address">The address in the process.</param>
+/// <param name="buffer">The buffer that receives the data.</param>
+/// <param name="size">The number of bytes to read.</param>
+/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when part of the range is not readable.</returns>
+size_t ProcessMemoryReader::Read(uint64_t address, void* buffer, size_t size) const {
+	SIZE_T read = 0;
+
+	if (ReadProcessMemory(m_Process, reinterpret_cast<LPCVOID>(static_cast<uintptr_t>(address)), buffer, size, &read))
+		return static_cast<size_t>(read);
+
+	// ReadProcessMemory fails as a whole when any page of the range is not readable, so read the readable prefix page by page
+	size_t total = 0;
+	while (total < size) {
+		auto length = 0x1000 - static_cast<size_t>((address + total) & 0xfff);
+		if (length > size - total)
+			length = size - total;
+
+		read = 0;
+		if (!ReadProcessMemory(m_Process, reinterpret_cast<LPCVOID>(static_cast<uintptr_t>(address + total)), static_cast<uint8_t*>(buffer) + total, length, &read))
+			break;
+
+		total += static_cast<size_t>(read);
+	}
+
+	return total;
+}
+#endif
+
 /// <summary>
 /// Construct a new process based on a const reference to a <see cref="PROCESS_INFORMATION"/> instance, a path, a working directory and program arguments.
 /// </summary>
@@ -28,7 +68,9 @@ Process::Process(
 /// The destructor which closes the process and thread handles.
 /// </summary>
 Process::~Process() {
+#ifdef _WIN32
 	Close();
+#endif
 }
 
 /// <summary>
@@ -44,6 +86,7 @@ PROCESS_INFORMATION Process::GetProcessInformation() {
 	};
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Resume the main thread.
 /// </summary>
@@ -199,4 +242,5 @@ std::string Process::ReadNulTerminatedString(const void* address, size_t maximum
 	}
 
 	return std::string(data.begin(), data.end());
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -2,13 +2,42 @@
 
 #ifndef process_process_h
 #define process_process_h
-	#include <Windows.h>
-	#include <DbgHelp.h>
+	#include "Win32Types.hpp"
 	#include <string>
 	#include <vector>
 
+	#include "DebugBackend.hpp"
+
 	namespace Hindsight {
 		namespace Process {
+#ifdef _WIN32
+			/// <summary>
+			/// Reads the memory of a process through a process handle. Windows has no scatter-gather variant of
+			/// ReadProcessMemory, so batches are read range by range; wrap this reader in a
+			/// <see cref="::Hindsight::Debugger::Backend::CachingMemoryReader"/> to merge them into page runs.
+			/// </summary>
+			class ProcessMemoryReader : public Hindsight::Debugger::Backend::IMemoryReader {
+				private:
+					HANDLE m_Process; /* The process handle, which is not owned */
+
+				public:
+					/// <summary>
+					/// Construct a new ProcessMemoryReader for a process handle.
+					/// </summary>
+					/// <param name="hProcess">A process handle with PROCESS_VM_READ access, which must outlive the reader.</param>
+					ProcessMemoryReader(HANDLE hProcess);
+
+					/// <summary>
+					/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the process.
+					/// </summary>
+					/// <param name="address">The address in the process.</param>
+					/// <param name="buffer">The buffer that receives the data.</param>
+					/// <param name="size">The number of bytes to read.</param>
+					/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when part of the range is not readable.</returns>
+					size_t Read(uint64_t address, void* buffer, size_t size) const override;
+			};
+#endif
+
 			/// <summary>
 			/// The process class describes a non-dead process that can be debugged.
 			/// </summary>
@@ -69,6 +98,7 @@
 					/// <returns>A <see cref="PROCESS_INFORMATION"/> struct.</returns>
 					PROCESS_INFORMATION GetProcessInformation();
 
+#ifdef _WIN32
 					/// <summary>
 					/// Resume the main thread.
 					/// </summary>
@@ -169,6 +199,7 @@
 					/// <param name="maximumLength">The length in bytes at which the scan should stop searching for NUL.</param>
 					/// <returns>The resulting string, or "" when something went wrong.</returns>
 					std::string ReadNulTerminatedString(const void* address, size_t maximumLength = 0) const;
+#endif
 			};
 
 		}
@@ -0,0 +1,577 @@
+#include "PtraceDebugBackend.hpp"
+
+#ifdef __linux__
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <sys/user.h>
+#include <elf.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+using namespace Hindsight::Debugger::Backend;
+
+/// <summary>
+/// Resume a stopped thread.
+/// </summary>
+/// <param name="tid">The thread ID.</param>
+/// <param name="signal">The signal to deliver, 0 for none.</param>
+static void resume_thread(pid_t tid, int signal) {
+	// fails when the thread was killed in the meantime, its exit is reported by waitpid
+	ptrace(PTRACE_CONT, tid, nullptr, reinterpret_cast<void*>(static_cast<intptr_t>(signal)));
+}
+
+/// <summary>
+/// Resolve the image path of a process.
+/// </summary>
+/// <param name="pid">The process ID.</param>
+/// <returns>The path, or an empty string when it cannot be resolved.</returns>
+static std::string image_path(pid_t pid) {
+	char path[PATH_MAX];
+	auto length = readlink(("/proc/" + std::to_string(pid) + "/exe").c_str(), path, sizeof(path) - 1);
+
+	if (length < 0)
+		return "";
+
+	return std::string(path, static_cast<size_t>(length));
+}
+
+/// <summary>
+/// Order modules by base address, then by path.
+/// </summary>
+/// <param name="a">The first module.</param>
+/// <param name="b">The second module.</param>
+/// <returns>true when <paramref name="a"/> orders before <paramref name="b"/>.</returns>
+static bool module_less(const BackendModule& a, const BackendModule& b) {
+	if (a.Base != b.Base)
+		return a.Base < b.Base;
+
+	return a.Path < b.Path;
+}
+
+/// <summary>
+/// Construct a new PtraceRegisterContext.
+/// </summary>
+/// <param name="is64">Whether the thread runs 64-bit code.</param>
+/// <param name="pc">The program counter.</param>
+/// <param name="sp">The stack pointer.</param>
+/// <param name="fp">The frame pointer.</param>
+/// <param name="flags">The flags register.</param>
+/// <param name="registers">The general purpose registers, see <see cref="::Hindsight::Debugger::Backend::IRegisterContext::Register"/>.</param>
+PtraceRegisterContext::PtraceRegisterContext(bool is64, uint64_t pc, uint64_t sp, uint64_t fp, uint64_t flags, const uint64_t (&registers)[16])
+	: m_Is64(is64), m_ProgramCounter(pc), m_StackPointer(sp), m_FramePointer(fp), m_Flags(flags) {
+
+	std::copy(registers, registers + 16, m_Registers);
+}
+
+/// <summary>
+/// Determine if the thread runs 64-bit code.
+/// </summary>
+/// <returns>true for 64-bit code.</returns>
+bool PtraceRegisterContext::Is64() const {
+	return m_Is64;
+}
+
+/// <summary>
+/// Get the program counter.
+/// </summary>
+/// <returns>The address of the current instruction.</returns>
+uint64_t PtraceRegisterContext::ProgramCounter() const {
+	return m_ProgramCounter;
+}
+
+/// <summary>
+/// Get the stack pointer.
+/// </summary>
+/// <returns>The address of the top of the stack.</returns>
+uint64_t PtraceRegisterContext::StackPointer() const {
+	return m_StackPointer;
+}
+
+/// <summary>
+/// Get the frame pointer.
+/// </summary>
+/// <returns>The address of the current stack frame.</returns>
+uint64_t PtraceRegisterContext::FramePointer() const {
+	return m_FramePointer;
+}
+
+/// <summary>
+/// Get a general purpose register.
+/// </summary>
+/// <param name="index">The register index, below 16.</param>
+/// <returns>The value of the register.</returns>
+uint64_t PtraceRegisterContext::Register(size_t index) const {
+	return index < 16 ? m_Registers[index] : 0;
+}
+
+/// <summary>
+/// Get the flags register.
+/// </summary>
+/// <returns>The flags.</returns>
+uint64_t PtraceRegisterContext::Flags() const {
+	return m_Flags;
+}
+
+/// <summary>
+/// Launch a process under the debugger, which is stopped until the first event is continued.
+/// </summary>
+/// <param name="path">The path of the program.</param>
+/// <param name="args">The program arguments, excluding the program path.</param>
+PtraceDebugBackend::PtraceDebugBackend(const std::string& path, const std::vector<std::string>& args)
+	: m_Process(-1), m_Path(path), m_Exited(true) {
+
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(path.c_str()));
+	for (auto& arg : args)
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	m_Process = fork();
+	if (m_Process < 0)
+		throw std::runtime_error("unable to fork the debugger");
+
+	if (m_Process == 0) {
+		// the child stops with SIGTRAP once execv has replaced its image
+		ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+		execv(path.c_str(), argv.data());
+		_exit(127);
+	}
+
+	int status = 0;
+	if (waitpid(m_Process, &status, __WALL) != m_Process || !WIFSTOPPED(status))
+		throw std::runtime_error("unable to launch " + path);
+
+	m_Exited = false;
+
+	long options = PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC | PTRACE_O_EXITKILL;
+	if (ptrace(PTRACE_SETOPTIONS, m_Process, nullptr, reinterpret_cast<void*>(options)) < 0)
+		throw std::runtime_error("unable to set the ptrace options");
+
+	auto image = image_path(m_Process);
+	if (!image.empty())
+		m_Path = image;
+
+	m_Threads.insert(m_Process);
+
+	auto created = MakeEvent(BackendEventKind::CreateProcess, m_Process);
+	created.Path = m_Path;
+	m_Pending.push_back(created);
+
+	Rescan(m_Process);
+
+	// the process image is announced by the creation event rather than by a module load, as on Windows
+	for (auto it = m_Pending.begin() + 1; it != m_Pending.end(); ++it) {
+		if (it->Path == m_Path) {
+			m_Pending.front().Address = it->Address;
+			m_Pending.front().Size = it->Size;
+			m_Pending.erase(it);
+			break;
+		}
+	}
+
+	m_Resume.emplace_back(m_Process, 0);
+}
+
+/// <summary>
+/// Kill the debugged process when it has not exited yet.
+/// </summary>
+PtraceDebugBackend::~PtraceDebugBackend() {
+	if (m_Exited)
+		return;
+
+	kill(m_Process, SIGKILL);
+
+	// reap every thread, so that no zombie is left behind
+	int status = 0;
+	while (waitpid(-1, &status, __WALL) > 0 || errno == EINTR) {}
+}
+
+/// <summary>
+/// Wait for the next debug event. The thread of the event is stopped until the event is passed to <see cref="Continue"/>.
+/// </summary>
+/// <param name="event">A reference to the event that receives the next event.</param>
+/// <returns>false when the process has exited and no further events will follow.</returns>
+bool PtraceDebugBackend::Next(BackendEvent& event) {
+	Wait();
+
+	if (m_Pending.empty())
+		return false;
+
+	event = std::move(m_Pending.front());
+	m_Pending.pop_front();
+	return true;
+}
+
+/// <summary>
+/// Continue after an event that was returned by <see cref="Next"/>. The stopped thread is resumed after the
+/// last event of its stop is continued, an unhandled exception delivers its signal to the thread.
+/// </summary>
+/// <param name="event">A const reference to the event.</param>
+/// <param name="handled">For exceptions, true suppresses the signal, false delivers it to the debugged process.</param>
+void PtraceDebugBackend::Continue(const BackendEvent& event, bool handled) {
+	if (!handled && (event.Kind == BackendEventKind::Exception || event.Kind == BackendEventKind::Breakpoint)) {
+		for (auto& resume : m_Resume) {
+			if (resume.first == static_cast<pid_t>(event.ThreadId))
+				resume.second = static_cast<int>(event.Code);
+		}
+	}
+
+	if (!m_Pending.empty())
+		return;
+
+	for (auto& resume : m_Resume)
+		resume_thread(resume.first, resume.second);
+
+	m_Resume.clear();
+}
+
+/// <summary>
+/// Capture the registers of a stopped thread.
+/// </summary>
+/// <param name="threadId">The thread ID.</param>
+/// <returns>The register context, or nullptr when the registers cannot be read or the architecture is not supported.</returns>
+std::unique_ptr<IRegisterContext> PtraceDebugBackend::Context(uint32_t threadId) const {
+#if defined(__x86_64__) || defined(__aarch64__)
+	user_regs_struct regs = {};
+	iovec io = { &regs, sizeof(regs) };
+
+	if (ptrace(PTRACE_GETREGSET, static_cast<pid_t>(threadId), reinterpret_cast<void*>(NT_PRSTATUS), &io) < 0)
+		return nullptr;
+
+#if defined(__x86_64__)
+	// a 32-bit thread gets the (smaller) i386 register set: ebx, ecx, edx, esi, edi, ebp, eax, 4 segments, orig_eax, eip, cs, eflags and esp
+	if (io.iov_len < sizeof(regs)) {
+		auto regs32 = reinterpret_cast<const uint32_t*>(&regs);
+		const uint64_t registers[16] = { regs32[6], regs32[1], regs32[2], regs32[0], regs32[15], regs32[5], regs32[3], regs32[4] };
+		return std::make_unique<PtraceRegisterContext>(false, regs32[12], regs32[15], regs32[5], regs32[14], registers);
+	}
+
+	const uint64_t registers[16] = {
+		regs.rax, regs.rcx, regs.rdx, regs.rbx, regs.rsp, regs.rbp, regs.rsi, regs.rdi,
+		regs.r8, regs.r9, regs.r10, regs.r11, regs.r12, regs.r13, regs.r14, regs.r15
+	};
+	return std::make_unique<PtraceRegisterContext>(true, regs.rip, regs.rsp, regs.rbp, regs.eflags, registers);
+#else
+	uint64_t registers[16];
+	std::copy(regs.regs, regs.regs + 16, registers);
+	return std::make_unique<PtraceRegisterContext>(true, regs.pc, regs.sp, regs.regs[29], regs.pstate, registers);
+#endif
+#else
+	return nullptr;
+#endif
+}
+
+/// <summary>
+/// Enumerate the file mappings of the debugged process, one module per file.
+/// </summary>
+/// <returns>The modules, ordered by base address.</returns>
+std::vector<BackendModule> PtraceDebugBackend::Modules() const {
+	std::map<std::string, BackendModule> modules;
+	std::ifstream maps("/proc/" + std::to_string(m_Process) + "/maps");
+	std::string line;
+
+	// a line reads: start-end perms offset dev inode path
+	while (std::getline(maps, line)) {
+		unsigned long long start = 0, end = 0;
+		int offset = 0;
+
+		if (std::sscanf(line.c_str(), "%llx-%llx %*s %*s %*s %*s %n", &start, &end, &offset) < 2 || offset <= 0)
+			continue;
+
+		// anonymous memory, the stack, the heap and the vdso are not modules
+		if (static_cast<size_t>(offset) >= line.size() || line[offset] != '/')
+			continue;
+
+		auto path = line.substr(static_cast<size_t>(offset));
+		auto it = modules.find(path);
+
+		if (it == modules.end()) {
+			modules[path] = { start, end - start, path };
+		} else {
+			auto high = it->second.Base + it->second.Size;
+			if (start < it->second.Base)
+				it->second.Base = start;
+			if (end > high)
+				high = end;
+			it->second.Size = high - it->second.Base;
+		}
+	}
+
+	std::vector<BackendModule> result;
+	result.reserve(modules.size());
+	for (auto& module : modules)
+		result.push_back(std::move(module.second));
+
+	std::sort(result.begin(), result.end(), module_less);
+	return result;
+}
+
+/// <summary>
+/// Get the ID of the debugged process.
+/// </summary>
+/// <returns>The process ID.</returns>
+uint32_t PtraceDebugBackend::ProcessId() const {
+	return static_cast<uint32_t>(m_Process);
+}
+
+/// <summary>
+/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the debugged process.
+/// </summary>
+/// <param name="address">The address in the debugged process.</param>
+/// <param name="buffer">The buffer that receives the data.</param>
+/// <param name="size">The number of bytes to read.</param>
+/// <returns>The number of bytes that were read.</returns>
+size_t PtraceDebugBackend::Read(uint64_t address, void* buffer, size_t size) const {
+	iovec local = { buffer, size };
+	iovec remote = { reinterpret_cast<void*>(static_cast<uintptr_t>(address)), size };
+
+	auto read = process_vm_readv(m_Process, &local, 1, &remote, 1, 0);
+	if (read >= 0)
+		return static_cast<size_t>(read);
+
+	// process_vm_readv does not split a range, so read the readable prefix page by page
+	static const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+	size_t total = 0;
+	while (total < size) {
+		auto length = page - static_cast<size_t>((address + total) % page);
+		if (length > size - total)
+			length = size - total;
+
+		local = { static_cast<uint8_t*>(buffer) + total, length };
+		remote = { reinterpret_cast<void*>(static_cast<uintptr_t>(address + total)), length };
+
+		read = process_vm_readv(m_Process, &local, 1, &remote, 1, 0);
+		if (read <= 0)
+			break;
+
+		total += static_cast<size_t>(read);
+	}
+
+	return total;
+}
+
+/// <summary>
+/// Read a batch of ranges with scatter-gather process_vm_readv calls, one per IOV_MAX ranges when every
+/// range is readable.
+/// </summary>
+/// <param name="ranges">The ranges to read, the number of bytes read is stored in each range.</param>
+/// <param name="count">The number of ranges.</param>
+void PtraceDebugBackend::ReadMany(MemoryRange* ranges, size_t count) const {
+	std::vector<iovec> local, remote;
+	size_t first = 0;
+
+	while (first < count) {
+		auto last = first + IOV_MAX < count ? first + IOV_MAX : count;
+
+		local.clear();
+		remote.clear();
+		for (auto i = first; i < last; ++i) {
+			local.push_back({ ranges[i].Buffer, ranges[i].Size });
+			remote.push_back({ reinterpret_cast<void*>(static_cast<uintptr_t>(ranges[i].Address)), ranges[i].Size });
+		}
+
+		auto read = process_vm_readv(m_Process, local.data(), local.size(), remote.data(), remote.size(), 0);
+		auto total = read < 0 ? size_t(0) : static_cast<size_t>(read);
+
+		// the transfer stops at the first range that is not completely readable
+		auto i = first;
+		for (; i < last && total >= ranges[i].Size; ++i) {
+			ranges[i].Read = ranges[i].Size;
+			total -= ranges[i].Size;
+		}
+
+		// read the failing range on its own, which yields its readable prefix, and gather the rest again
+		if (i < last) {
+			ranges[i].Read = Read(ranges[i].Address, ranges[i].Buffer, ranges[i].Size);
+			++i;
+		}
+
+		first = i;
+	}
+}
+
+/// <summary>
+/// Wait for the next stop or exit of any thread and queue its events.
+/// </summary>
+void PtraceDebugBackend::Wait() {
+	while (m_Pending.empty() && !m_Exited) {
+		int status = 0;
+		auto tid = waitpid(-1, &status, __WALL);
+
+		if (tid < 0) {
+			if (errno == EINTR)
+				continue;
+
+			// no traced thread is left
+			m_Exited = true;
+			break;
+		}
+
+		if (WIFSTOPPED(status))
+			Stopped(tid, status);
+		else if (WIFEXITED(status) || WIFSIGNALED(status))
+			Exited(tid, status);
+	}
+}
+
+/// <summary>
+/// Queue the events of a stopped thread.
+/// </summary>
+/// <param name="tid">The thread ID.</param>
+/// <param name="status">The status returned by waitpid.</param>
+void PtraceDebugBackend::Stopped(pid_t tid, int status) {
+	auto signal = WSTOPSIG(status);
+	auto stop = status >> 16;
+
+	if (signal == SIGTRAP && stop == PTRACE_EVENT_CLONE) {
+		unsigned long child = 0;
+		ptrace(PTRACE_GETEVENTMSG, tid, nullptr, &child);
+
+		auto thread = static_cast<pid_t>(child);
+		m_Threads.insert(thread);
+
+		Rescan(tid);
+		m_Pending.push_back(MakeEvent(BackendEventKind::CreateThread, thread));
+
+		// the new thread starts with a SIGSTOP, which may already have been reported
+		if (m_Unannounced.erase(thread))
+			m_Resume.emplace_back(thread, 0);
+		else
+			m_Expected.insert(thread);
+
+		m_Resume.emplace_back(tid, 0);
+		return;
+	}
+
+	if (signal == SIGTRAP && stop == PTRACE_EVENT_EXEC) {
+		// the other threads are gone and the thread that called exec took over the process ID
+		auto image = image_path(m_Process);
+		if (!image.empty())
+			m_Path = image;
+
+		Rescan(tid);
+		m_Resume.emplace_back(tid, 0);
+		return;
+	}
+
+	if (signal == SIGSTOP) {
+		if (m_Expected.erase(tid)) {
+			resume_thread(tid, 0);
+			return;
+		}
+
+		if (!m_Threads.count(tid)) {
+			m_Unannounced.insert(tid);
+			return;
+		}
+	}
+
+	siginfo_t info = {};
+	if (ptrace(PTRACE_GETSIGINFO, tid, nullptr, &info) < 0) {
+		// a group-stop, which is not an event, restarting it is all ptrace allows without PTRACE_SEIZE
+		resume_thread(tid, 0);
+		return;
+	}
+
+	Rescan(tid);
+
+	auto event = MakeEvent(signal == SIGTRAP ? BackendEventKind::Breakpoint : BackendEventKind::Exception, tid);
+	event.Code = static_cast<uint32_t>(signal);
+
+	// faults raised by the kernel carry the faulting address, everything else is reported at the current instruction
+	auto fault = signal == SIGSEGV || signal == SIGBUS || signal == SIGILL || signal == SIGFPE;
+	if (fault && info.si_code > 0) {
+		event.Address = reinterpret_cast<uintptr_t>(info.si_addr);
+	} else {
+		auto context = Context(static_cast<uint32_t>(tid));
+		if (context)
+			event.Address = context->ProgramCounter();
+	}
+
+	m_Pending.push_back(event);
+	m_Resume.emplace_back(tid, 0);
+}
+
+/// <summary>
+/// Queue the events of a thread that has exited or was killed.
+/// </summary>
+/// <param name="tid">The thread ID.</param>
+/// <param name="status">The status returned by waitpid.</param>
+void PtraceDebugBackend::Exited(pid_t tid, int status) {
+	m_Expected.erase(tid);
+	m_Unannounced.erase(tid);
+
+	// a process that was killed by a signal reports the exit code of a shell
+	auto code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+	if (tid == m_Process) {
+		// the main thread is reported last, after all other threads
+		auto event = MakeEvent(BackendEventKind::ExitProcess, tid);
+		event.Code = static_cast<uint32_t>(code);
+		m_Pending.push_back(event);
+
+		m_Threads.clear();
+		m_Exited = true;
+		return;
+	}
+
+	if (m_Threads.erase(tid)) {
+		auto event = MakeEvent(BackendEventKind::ExitThread, tid);
+		event.Code = static_cast<uint32_t>(code);
+		m_Pending.push_back(event);
+	}
+}
+
+/// <summary>
+/// Compare the modules with those of the last stop and queue a load or unload event for every difference.
+/// </summary>
+/// <param name="tid">The ID of the stopped thread, which is reported as the thread of the events.</param>
+void PtraceDebugBackend::Rescan(pid_t tid) {
+	auto current = Modules();
+
+	std::vector<BackendModule> unloaded, loaded;
+	std::set_difference(m_Modules.begin(), m_Modules.end(), current.begin(), current.end(), std::back_inserter(unloaded), module_less);
+	std::set_difference(current.begin(), current.end(), m_Modules.begin(), m_Modules.end(), std::back_inserter(loaded), module_less);
+
+	for (auto& module : unloaded) {
+		auto event = MakeEvent(BackendEventKind::ModuleUnload, tid);
+		event.Address = module.Base;
+		event.Size = module.Size;
+		event.Path = module.Path;
+		m_Pending.push_back(std::move(event));
+	}
+
+	for (auto& module : loaded) {
+		auto event = MakeEvent(BackendEventKind::ModuleLoad, tid);
+		event.Address = module.Base;
+		event.Size = module.Size;
+		event.Path = module.Path;
+		m_Pending.push_back(std::move(event));
+	}
+
+	m_Modules = std::move(current);
+}
+
+/// <summary>
+/// Create an event of <paramref name="kind"/> for a thread.
+/// </summary>
+/// <param name="kind">The kind of event.</param>
+/// <param name="tid">The thread ID.</param>
+/// <returns>The event.</returns>
+BackendEvent PtraceDebugBackend::MakeEvent(BackendEventKind kind, pid_t tid) const {
+	BackendEvent event;
+	event.Kind = kind;
+	event.ProcessId = static_cast<uint32_t>(m_Process);
+	event.ThreadId = static_cast<uint32_t>(tid);
+	return event;
+}
+#endif
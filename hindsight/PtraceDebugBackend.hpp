@@ -0,0 +1,207 @@
+#pragma once
+
+#ifndef debugger_ptrace_debug_backend_h
+#define debugger_ptrace_debug_backend_h
+	#ifdef __linux__
+	#include "DebugBackend.hpp"
+
+	#include <sys/types.h>
+	#include <cstdint>
+	#include <deque>
+	#include <set>
+	#include <string>
+	#include <utility>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace Backend {
+				/// <summary>
+				/// The registers of a stopped thread, as read through ptrace.
+				/// </summary>
+				class PtraceRegisterContext : public IRegisterContext {
+					private:
+						bool		m_Is64;				/* True for 64-bit code */
+						uint64_t	m_ProgramCounter;	/* The program counter */
+						uint64_t	m_StackPointer;		/* The stack pointer */
+						uint64_t	m_FramePointer;		/* The frame pointer */
+						uint64_t	m_Flags;			/* The flags register */
+						uint64_t	m_Registers[16];	/* The general purpose registers, see IRegisterContext::Register */
+
+					public:
+						/// <summary>
+						/// Construct a new PtraceRegisterContext.
+						/// </summary>
+						/// <param name="is64">Whether the thread runs 64-bit code.</param>
+						/// <param name="pc">The program counter.</param>
+						/// <param name="sp">The stack pointer.</param>
+						/// <param name="fp">The frame pointer.</param>
+						/// <param name="flags">The flags register.</param>
+						/// <param name="registers">The general purpose registers, see <see cref="::Hindsight::Debugger::Backend::IRegisterContext::Register"/>.</param>
+						PtraceRegisterContext(bool is64, uint64_t pc, uint64_t sp, uint64_t fp, uint64_t flags, const uint64_t (&registers)[16]);
+
+						/// <summary>
+						/// Determine if the thread runs 64-bit code.
+						/// </summary>
+						/// <returns>true for 64-bit code.</returns>
+						bool Is64() const override;
+
+						/// <summary>
+						/// Get the program counter.
+						/// </summary>
+						/// <returns>The address of the current instruction.</returns>
+						uint64_t ProgramCounter() const override;
+
+						/// <summary>
+						/// Get the stack pointer.
+						/// </summary>
+						/// <returns>The address of the top of the stack.</returns>
+						uint64_t StackPointer() const override;
+
+						/// <summary>
+						/// Get the frame pointer.
+						/// </summary>
+						/// <returns>The address of the current stack frame.</returns>
+						uint64_t FramePointer() const override;
+
+						/// <summary>
+						/// Get a general purpose register.
+						/// </summary>
+						/// <param name="index">The register index, below 16.</param>
+						/// <returns>The value of the register.</returns>
+						uint64_t Register(size_t index) const override;
+
+						/// <summary>
+						/// Get the flags register.
+						/// </summary>
+						/// <returns>The flags.</returns>
+						uint64_t Flags() const override;
+				};
+
+				/// <summary>
+				/// A debugger backend for Linux that launches the debugged process under ptrace and turns the stops reported by
+				/// waitpid into debug events: clone becomes a thread creation, a new file mapping (after exec or a dlopen)
+				/// becomes a module load, a signal becomes an exception and SIGTRAP a breakpoint. Linux has no event for mmap, so
+				/// the mappings are compared at every stop and a module that appeared in between is reported just before the event
+				/// of that stop, which is before any exception it could be involved in. Only the thread of an event is stopped,
+				/// the other threads keep running.
+				/// </summary>
+				class PtraceDebugBackend : public IDebugBackend {
+					private:
+						pid_t								m_Process;		/* The process ID, which is also the ID of the main thread */
+						std::string							m_Path;			/* The path of the process image */
+						std::set<pid_t>						m_Threads;		/* The threads that have been announced */
+						std::set<pid_t>						m_Expected;		/* Announced threads whose initial SIGSTOP has not been seen yet */
+						std::set<pid_t>						m_Unannounced;	/* Threads that stopped before their creation was reported, kept stopped */
+						std::deque<BackendEvent>			m_Pending;		/* The events of the current stop that have not been returned yet */
+						std::vector<std::pair<pid_t, int>>	m_Resume;		/* The threads to resume, with the signal to deliver, once all events of the stop are continued */
+						std::vector<BackendModule>			m_Modules;		/* The modules as of the last stop */
+						bool								m_Exited;		/* True when the process has exited */
+
+					public:
+						/// <summary>
+						/// Launch a process under the debugger, which is stopped until the first event is continued.
+						/// </summary>
+						/// <param name="path">The path of the program.</param>
+						/// <param name="args">The program arguments, excluding the program path.</param>
+						PtraceDebugBackend(const std::string& path, const std::vector<std::string>& args);
+
+						/// <summary>
+						/// Kill the debugged process when it has not exited yet.
+						/// </summary>
+						~PtraceDebugBackend();
+
+						PtraceDebugBackend(const PtraceDebugBackend&) = delete;
+						PtraceDebugBackend& operator=(const PtraceDebugBackend&) = delete;
+
+						/// <summary>
+						/// Wait for the next debug event. The thread of the event is stopped until the event is passed to <see cref="Continue"/>.
+						/// </summary>
+						/// <param name="event">A reference to the event that receives the next event.</param>
+						/// <returns>false when the process has exited and no further events will follow.</returns>
+						bool Next(BackendEvent& event) override;
+
+						/// <summary>
+						/// Continue after an event that was returned by <see cref="Next"/>. The stopped thread is resumed after the
+						/// last event of its stop is continued, an unhandled exception delivers its signal to the thread.
+						/// </summary>
+						/// <param name="event">A const reference to the event.</param>
+						/// <param name="handled">For exceptions, true suppresses the signal, false delivers it to the debugged process.</param>
+						void Continue(const BackendEvent& event, bool handled) override;
+
+						/// <summary>
+						/// Capture the registers of a stopped thread.
+						/// </summary>
+						/// <param name="threadId">The thread ID.</param>
+						/// <returns>The register context, or nullptr when the registers cannot be read or the architecture is not supported.</returns>
+						std::unique_ptr<IRegisterContext> Context(uint32_t threadId) const override;
+
+						/// <summary>
+						/// Enumerate the file mappings of the debugged process, one module per file.
+						/// </summary>
+						/// <returns>The modules, ordered by base address.</returns>
+						std::vector<BackendModule> Modules() const override;
+
+						/// <summary>
+						/// Get the ID of the debugged process.
+						/// </summary>
+						/// <returns>The process ID.</returns>
+						uint32_t ProcessId() const override;
+
+						/// <summary>
+						/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the debugged process.
+						/// </summary>
+						/// <param name="address">The address in the debugged process.</param>
+						/// <param name="buffer">The buffer that receives the data.</param>
+						/// <param name="size">The number of bytes to read.</param>
+						/// <returns>The number of bytes that were read.</returns>
+						size_t Read(uint64_t address, void* buffer, size_t size) const override;
+
+						/// <summary>
+						/// Read a batch of ranges with scatter-gather process_vm_readv calls, one per IOV_MAX ranges when every
+						/// range is readable.
+						/// </summary>
+						/// <param name="ranges">The ranges to read, the number of bytes read is stored in each range.</param>
+						/// <param name="count">The number of ranges.</param>
+						void ReadMany(MemoryRange* ranges, size_t count) const override;
+
+					private:
+						/// <summary>
+						/// Wait for the next stop or exit of any thread and queue its events.
+						/// </summary>
+						void Wait();
+
+						/// <summary>
+						/// Queue the events of a stopped thread.
+						/// </summary>
+						/// <param name="tid">The thread ID.</param>
+						/// <param name="status">The status returned by waitpid.</param>
+						void Stopped(pid_t tid, int status);
+
+						/// <summary>
+						/// Queue the events of a thread that has exited or was killed.
+						/// </summary>
+						/// <param name="tid">The thread ID.</param>
+						/// <param name="status">The status returned by waitpid.</param>
+						void Exited(pid_t tid, int status);
+
+						/// <summary>
+						/// Compare the modules with those of the last stop and queue a load or unload event for every difference.
+						/// </summary>
+						/// <param name="tid">The ID of the stopped thread, which is reported as the thread of the events.</param>
+						void Rescan(pid_t tid);
+
+						/// <summary>
+						/// Create an event of <paramref name="kind"/> for a thread.
+						/// </summary>
+						/// <param name="kind">The kind of event.</param>
+						/// <param name="tid">The thread ID.</param>
+						/// <returns>The event.</returns>
+						BackendEvent MakeEvent(BackendEventKind kind, pid_t tid) const;
+				};
+			}
+		}
+	}
+	#endif
+
+#endif
@@ -0,0 +1,189 @@
+#pragma once
+
+#ifndef debugger_recursion_detector_h
+#define debugger_recursion_detector_h
+	#include <array>
+	#include <cstddef>
+	#include <cstdint>
+	#include <deque>
+	#include <functional>
+	#include <utility>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// Collapses recursion in a stream of stack frames, from the innermost frame outwards. A recursion is a cycle of
+			/// return addresses with a period of up to <see cref="MaxPeriod"/> frames, which covers direct recursion (A, A, A)
+			/// as well as mutual recursion (A, B, A, B). A cycle is detected once two full repetitions have been seen. After
+			/// that, its frames are passed on until <c>limit</c> frames of the cycle have been passed on. The remaining frames
+			/// are counted, and only the last repetition is kept. When the cycle ends, the number of skipped frames is reported
+			/// followed by that last repetition, so a stack overflow of tens of thousands of frames yields only a few frames to
+			/// resolve. The detector keeps O(<see cref="MaxPeriod"/>) frames, however deep the recursion is. This class does not
+			/// depend on any platform API.
+			/// </summary>
+			/// <typeparam name="TFrame">The frame type.</typeparam>
+			template <typename TFrame>
+			class RecursionDetector {
+				public:
+					/// <summary>
+					/// The longest cycle, in frames, that is detected.
+					/// </summary>
+					static const size_t MaxPeriod = 32;
+
+					/// <summary>
+					/// Receives a frame that is part of the trace.
+					/// </summary>
+					using Emitter = std::function<void(const TFrame&)>;
+
+					/// <summary>
+					/// Receives the number of recursive frames that were skipped, which is followed by the last repetition.
+					/// </summary>
+					using Cutter = std::function<void(size_t)>;
+
+				private:
+					using Item = std::pair<uint64_t, TFrame>;
+
+					Emitter								m_Emit;		/* Receives the frames of the trace */
+					Cutter								m_Cut;		/* Receives the number of skipped frames */
+					size_t								m_Limit;	/* The number of frames of a cycle that are passed on before it is cut */
+					std::deque<Item>					m_Window;	/* The frames that have not been passed on yet, at most 2 * MaxPeriod outside of a cycle */
+					std::array<size_t, MaxPeriod + 1>	m_Runs;		/* For every period, the number of trailing frames that match the frame one period earlier */
+					std::vector<uint64_t>				m_Pattern;	/* The keys of one repetition of the current cycle, empty outside of a cycle */
+					size_t								m_Length;	/* The number of frames in the current cycle */
+					size_t								m_Skipped;	/* The number of frames of the current cycle that were skipped */
+					std::deque<Item>					m_Tail;		/* The most recent frames of the current cycle that were not passed on, at most one period */
+
+				public:
+					/// <summary>
+					/// Construct a new RecursionDetector.
+					/// </summary>
+					/// <param name="emit">Receives the frames of the trace.</param>
+					/// <param name="cut">Receives the number of skipped frames when a recursion is cut.</param>
+					/// <param name="limit">The number of frames of a cycle that are passed on before it is cut, at least one repetition is always passed on.</param>
+					RecursionDetector(Emitter emit, Cutter cut, size_t limit)
+						: m_Emit(std::move(emit)), m_Cut(std::move(cut)), m_Limit(limit), m_Length(0), m_Skipped(0) {
+
+						m_Runs.fill(0);
+					}
+
+					/// <summary>
+					/// Add the next (outer) frame.
+					/// </summary>
+					/// <param name="frame">The frame.</param>
+					/// <param name="key">The key that identifies the call site of the frame, such as its return address.</param>
+					void Push(const TFrame& frame, uint64_t key) {
+						if (!m_Pattern.empty()) {
+							if (m_Pattern[m_Length % m_Pattern.size()] == key) {
+								CycleFrame(Item(key, frame));
+								return;
+							}
+
+							EndCycle();
+						}
+
+						m_Window.emplace_back(key, frame);
+
+						// count, for every period, how long the frames have been repeating with that period
+						auto last = m_Window.size() - 1;
+						for (size_t period = 1; period <= MaxPeriod; ++period) {
+							if (period <= last && m_Window[last - period].first == key)
+								++m_Runs[period];
+							else
+								m_Runs[period] = 0;
+						}
+
+						// two full repetitions of the shortest period make a cycle
+						for (size_t period = 1; period <= MaxPeriod; ++period) {
+							if (m_Runs[period] >= period) {
+								BeginCycle(period);
+								return;
+							}
+						}
+
+						if (m_Window.size() > 2 * MaxPeriod) {
+							m_Emit(m_Window.front().second);
+							m_Window.pop_front();
+						}
+					}
+
+					/// <summary>
+					/// Pass on all frames that are held back, which must be called after the last frame.
+					/// </summary>
+					void Flush() {
+						if (!m_Pattern.empty())
+							EndCycle();
+
+						for (const auto& item : m_Window)
+							m_Emit(item.second);
+
+						m_Window.clear();
+						m_Runs.fill(0);
+					}
+
+				private:
+					/// <summary>
+					/// Start a cycle of <paramref name="period"/> frames, which are the last two repetitions in the window.
+					/// </summary>
+					/// <param name="period">The period of the cycle.</param>
+					void BeginCycle(size_t period) {
+						auto start = m_Window.size() - 2 * period;
+
+						// the frames before the cycle are not part of it
+						for (size_t i = 0; i < start; ++i)
+							m_Emit(m_Window[i].second);
+
+						m_Pattern.clear();
+						for (size_t i = 0; i < period; ++i)
+							m_Pattern.push_back(m_Window[start + i].first);
+
+						m_Length  = 0;
+						m_Skipped = 0;
+
+						for (size_t i = start; i < m_Window.size(); ++i)
+							CycleFrame(m_Window[i]);
+
+						m_Window.clear();
+						m_Runs.fill(0);
+					}
+
+					/// <summary>
+					/// Add a frame that continues the current cycle.
+					/// </summary>
+					/// <param name="item">The frame and its key.</param>
+					void CycleFrame(const Item& item) {
+						auto limit = m_Limit > m_Pattern.size() ? m_Limit : m_Pattern.size();
+
+						if (m_Length < limit) {
+							m_Emit(item.second);
+						} else {
+							m_Tail.push_back(item);
+							if (m_Tail.size() > m_Pattern.size()) {
+								m_Tail.pop_front();
+								++m_Skipped;
+							}
+						}
+
+						++m_Length;
+					}
+
+					/// <summary>
+					/// End the current cycle: report the skipped frames and pass on the last repetition.
+					/// </summary>
+					void EndCycle() {
+						if (m_Skipped != 0)
+							m_Cut(m_Skipped);
+
+						for (const auto& item : m_Tail)
+							m_Emit(item.second);
+
+						m_Tail.clear();
+						m_Pattern.clear();
+						m_Length  = 0;
+						m_Skipped = 0;
+					}
+			};
+		}
+	}
+
+#endif
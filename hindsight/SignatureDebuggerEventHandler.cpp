@@ -0,0 +1,412 @@
+#include "SignatureDebuggerEventHandler.hpp"
+#include "String.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <cwctype>
+
+namespace fs = std::filesystem;
+
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::EventHandler;
+
+/// <summary>
+/// Format a module and the offset of <paramref name="address"/> in it as "name+0xoffset". The module name is the lowercase 
+/// file name, so that the result is the same regardless of where the module was loaded from or at which base address.
+/// </summary>
+/// <param name="ss">The stream to write to.</param>
+/// <param name="module">The module containing <paramref name="address"/>, or nullptr when it is unknown.</param>
+/// <param name="address">The address to format.</param>
+static void module_offset(std::ostringstream& ss, const Module* module, const void* address) {
+	if (module == nullptr || module->Base == nullptr) {
+		// an absolute address outside any module differs between runs, so it cannot be part of a signature
+		ss << "?";
+		return;
+	}
+
+	auto name = fs::path(module->Path).filename().wstring();
+	std::transform(name.begin(), name.end(), name.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+
+	ss << Hindsight::Utilities::String::ToString(name) << "+0x" << std::hex
+		<< (reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(module->Base)) << std::dec;
+}
+
+/// <summary>
+/// Construct a new, empty, SignatureAggregator.
+/// </summary>
+/// <param name="frames">The number of top stack frames that are included in each signature.</param>
+SignatureAggregator::SignatureAggregator(size_t frames) 
+	: m_Frames(frames), m_Events(0) {
+
+}
+
+/// <summary>
+/// Get the number of top stack frames that are included in each signature.
+/// </summary>
+/// <returns>The number of frames.</returns>
+size_t SignatureAggregator::Frames() const noexcept {
+	return m_Frames;
+}
+
+/// <summary>
+/// Get the total number of exceptions that were added to this aggregator.
+/// </summary>
+/// <returns>The number of exceptions.</returns>
+size_t SignatureAggregator::Events() const noexcept {
+	return m_Events;
+}
+
+/// <summary>
+/// Get the number of distinct signatures in this aggregator.
+/// </summary>
+/// <returns>The number of buckets.</returns>
+size_t SignatureAggregator::size() const noexcept {
+	return m_Buckets.size();
+}
+
+/// <summary>
+/// Count one exception with the normalized signature <paramref name="signature"/>.
+/// </summary>
+/// <param name="signature">The normalized signature text.</param>
+/// <param name="source">The source of the exception, which may become the representative of its bucket.</param>
+void SignatureAggregator::Add(const std::string& signature, const std::string& source) {
+	auto& bucket = m_Buckets[signature];
+
+	if (bucket.Count == 0) {
+		bucket.Hash			  = Hash(signature);
+		bucket.Signature	  = signature;
+		bucket.Representative = source;
+	} else if (source < bucket.Representative) {
+		bucket.Representative = source;
+	}
+
+	++bucket.Count;
+	++m_Events;
+}
+
+/// <summary>
+/// Add all the buckets of <paramref name="other"/> to this aggregator. The representative of a bucket is the 
+/// lowest source in lexicographical order, so that the result does not depend on the order of merging.
+/// </summary>
+/// <param name="other">The aggregator to merge into this one.</param>
+void SignatureAggregator::Merge(const SignatureAggregator& other) {
+	for (const auto& [signature, theirs] : other.m_Buckets) {
+		auto& bucket = m_Buckets[signature];
+
+		if (bucket.Count == 0) {
+			bucket = theirs;
+		} else {
+			bucket.Count += theirs.Count;
+			if (theirs.Representative < bucket.Representative)
+				bucket.Representative = theirs.Representative;
+		}
+	}
+
+	m_Events += other.m_Events;
+}
+
+/// <summary>
+/// Get all buckets sorted by descending count, and by signature for equal counts.
+/// </summary>
+/// <returns>A vector of pointers to the buckets, which are valid until the aggregator is modified.</returns>
+std::vector<const SignatureBucket*> SignatureAggregator::Sorted() const {
+	std::vector<const SignatureBucket*> result;
+	result.reserve(m_Buckets.size());
+
+	for (const auto& [signature, bucket] : m_Buckets)
+		result.push_back(&bucket);
+
+	std::sort(result.begin(), result.end(), [](const SignatureBucket* a, const SignatureBucket* b) {
+		if (a->Count != b->Count)
+			return a->Count > b->Count;
+		return a->Signature < b->Signature;
+	});
+
+	return result;
+}
+
+/// <summary>
+/// Compute the normalized signature text of an exception. The signature consists of the exception code, the 
+/// module and offset of the exception address, the module and offset of the top stack frames and the 
+/// C++ exception type chain (if any). Modules are identified by their lowercase file name rather than their 
+/// index or base address, as both differ between runs.
+/// </summary>
+/// <param name="info">The exception debug info.</param>
+/// <param name="firstChance">A boolean indicating that this is the first encounter with this specific exception instance, or not.</param>
+/// <param name="trace">The stack trace of the exception, or nullptr.</param>
+/// <param name="collection">The collection of modules loaded at the time of the exception.</param>
+/// <param name="ertti">The C++ exception type information, or nullptr.</param>
+/// <param name="frames">The number of top stack frames to include.</param>
+/// <returns>The normalized signature text.</returns>
+std::string SignatureAggregator::Normalize(
+	const EXCEPTION_DEBUG_INFO& info,
+	bool firstChance,
+	const std::shared_ptr<const DebugStackTrace>& trace,
+	const ModuleCollection& collection,
+	const std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation>& ertti,
+	size_t frames) {
+
+	std::ostringstream ss;
+
+	ss << std::hex << std::setw(8) << std::setfill('0') << info.ExceptionRecord.ExceptionCode << std::dec << std::setfill(' ');
+	ss << (firstChance ? " first " : " second ");
+	module_offset(ss, collection.GetModuleAtAddress(info.ExceptionRecord.ExceptionAddress), info.ExceptionRecord.ExceptionAddress);
+
+	ss << " |";
+	if (trace) {
+		size_t count = 0;
+		for (const auto& entry : trace->list()) {
+			if (count == frames)
+				break;
+
+			// recursion cut frames only depend on the configured recursion limit
+			if (entry.Recursion)
+				continue;
+
+			// frames without symbols carry no module, so the module is resolved from the collection like the exception address
+			ss << " ";
+			module_offset(ss, collection.GetModuleAtAddress(entry.Address), entry.Address);
+			++count;
+		}
+	}
+
+	ss << " |";
+	if (ertti)
+		for (const auto& type : ertti->exception_type_names())
+			ss << " " << type;
+
+	return ss.str();
+}
+
+/// <summary>
+/// Compute the 64-bit FNV-1a hash of a signature.
+/// </summary>
+/// <param name="signature">The signature text.</param>
+/// <returns>The hash of <paramref name="signature"/>.</returns>
+uint64_t SignatureAggregator::Hash(const std::string& signature) noexcept {
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (auto c : signature) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+/// <summary>
+/// Construct a new SignatureDebuggerEventHandler.
+/// </summary>
+/// <param name="aggregator">The aggregator that counts the signatures, which must outlive the handler.</param>
+/// <param name="source">The source of the events, such as the path of the replayed log file.</param>
+SignatureDebuggerEventHandler::SignatureDebuggerEventHandler(SignatureAggregator& aggregator, const std::string& source)
+	: m_Aggregator(aggregator), m_Source(source) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="p">The process being debugged.</param>
+void SignatureDebuggerEventHandler::OnInitialization(
+	time_t time,
+	const std::shared_ptr<const Hindsight::Process::Process> p) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="EXCEPTION_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
+/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnBreakpointHit(
+	time_t time,
+	const EXCEPTION_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	std::shared_ptr<const DebugContext> context,
+	std::shared_ptr<const DebugStackTrace> trace,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// Compute the crash signature of the exception and add it to the aggregator. Breakpoint exceptions are reported
+/// through OnBreakpointHit instead and never contribute to a signature.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="EXCEPTION_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="firstChance">A boolean indicating that this is the first encounter with this specific exception instance, or not.</param>
+/// <param name="name">A name of a known exception, or an empty string.</param>
+/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
+/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+/// <param name="ertti">A shared pointer to a const <see cref="::Hindsight::Debugger::CxxExceptions::ExceptionRtti"/> instance.</param>
+void SignatureDebuggerEventHandler::OnException(
+	time_t time,
+	const EXCEPTION_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	bool firstChance,
+	const std::wstring& name,
+	std::shared_ptr<const DebugContext> context,
+	std::shared_ptr<const DebugStackTrace> trace,
+	const ModuleCollection& collection,
+	std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation> ertti) {
+	m_Aggregator.Add(SignatureAggregator::Normalize(info, firstChance, trace, collection, ertti, m_Aggregator.Frames()), m_Source);
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="CREATE_PROCESS_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="path">The full path to the loaded module on file system.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnCreateProcess(
+	time_t time,
+	const CREATE_PROCESS_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const std::wstring& path,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="CREATE_THREAD_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnCreateThread(
+	time_t time,
+	const CREATE_THREAD_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="EXIT_PROCESS_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnExitProcess(
+	time_t time,
+	const EXIT_PROCESS_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="EXIT_THREAD_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnExitThread(
+	time_t time,
+	const EXIT_THREAD_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="EXIT_THREAD_DEBUG_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="path">The full unicode path to the DLL that was loaded.</param>
+/// <param name="moduleIndex">The index in the module collection of this module, it might have been loaded before.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnDllLoad(
+	time_t time,
+	const LOAD_DLL_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const std::wstring& path,
+	int moduleIndex,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="OUTPUT_DEBUG_STRING_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="string">The ANSI debug string.</param>
+void SignatureDebuggerEventHandler::OnDebugString(
+	time_t time,
+	const OUTPUT_DEBUG_STRING_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const std::string& string) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="OUTPUT_DEBUG_STRING_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="string">The Unicode debug string.</param>
+void SignatureDebuggerEventHandler::OnDebugStringW(
+	time_t time,
+	const OUTPUT_DEBUG_STRING_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const std::wstring& string) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="info">A const reference to the <see cref="RIP_INFO"/> struct instance with event information.</param>
+/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+/// <param name="errorMessage">A string describing the <see cref="RIP_INFO::dwError"/> member, or an empty string if no description is available.</param>
+void SignatureDebuggerEventHandler::OnRip(
+	time_t time,
+	const RIP_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const std::wstring& errorMessage) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored.
+/// </summary>
+void SignatureDebuggerEventHandler::OnDllUnload(
+	time_t time,
+	const UNLOAD_DLL_DEBUG_INFO& info,
+	const PROCESS_INFORMATION& pi,
+	const std::wstring& path,
+	int moduleIndex,
+	const ModuleCollection& collection) {
+
+}
+
+/// <summary>
+/// This event does not contribute to crash signatures and is ignored, the aggregator outlives the handler.
+/// </summary>
+/// <param name="time">The time of the event.</param>
+/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+void SignatureDebuggerEventHandler::OnModuleCollectionComplete(
+	time_t time,
+	const ModuleCollection& collection) {
+
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+#pragma once
+
+#ifndef signature_debugger_event_handler_h
+#define signature_debugger_event_handler_h
+	#include "IDebuggerEventHandler.hpp"
+	#include <unordered_map>
+	#include <string>
+	#include <vector>
+	#include <cstdint>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace EventHandler {
+				/// <summary>
+				/// One bucket of the <see cref="::Hindsight::Debugger::EventHandler::SignatureAggregator"/>, which groups all exceptions
+				/// that share the same normalized crash signature.
+				/// </summary>
+				struct SignatureBucket {
+					uint64_t	Hash = 0;				/* The 64-bit FNV-1a hash of the signature, a short identifier for display only. */
+					std::string	Signature = "";			/* The normalized signature text. */
+					size_t		Count = 0;				/* The number of exceptions with this signature. */
+					std::string	Representative = "";	/* The source (i.e. log file) of one of the exceptions, for further inspection. */
+				};
+
+				/// <summary>
+				/// Counts exceptions by crash signature. Only one bucket is kept per distinct signature, so the memory used by the 
+				/// aggregator depends on the number of distinct crashes and not on the number of exceptions or log files. 
+				/// An aggregator is not thread-safe, use one per thread and <see cref="::Hindsight::Debugger::EventHandler::SignatureAggregator::Merge"/> 
+				/// them when done.
+				/// </summary>
+				class SignatureAggregator {
+					private:
+						std::unordered_map<std::string, SignatureBucket> m_Buckets;	/* The buckets, by signature text, as distinct signatures may share a hash */
+						size_t m_Frames;												/* The number of top stack frames included in a signature */
+						size_t m_Events;												/* The total number of exceptions added */
+
+					public:
+						/// <summary>
+						/// The default number of top stack frames that are included in a signature.
+						/// </summary>
+						static const size_t DefaultFrames = 5;
+
+						/// <summary>
+						/// Construct a new, empty, SignatureAggregator.
+						/// </summary>
+						/// <param name="frames">The number of top stack frames that are included in each signature.</param>
+						SignatureAggregator(size_t frames = DefaultFrames);
+
+						/// <summary>
+						/// Get the number of top stack frames that are included in each signature.
+						/// </summary>
+						/// <returns>The number of frames.</returns>
+						size_t Frames() const noexcept;
+
+						/// <summary>
+						/// Get the total number of exceptions that were added to this aggregator.
+						/// </summary>
+						/// <returns>The number of exceptions.</returns>
+						size_t Events() const noexcept;
+
+						/// <summary>
+						/// Get the number of distinct signatures in this aggregator.
+						/// </summary>
+						/// <returns>The number of buckets.</returns>
+						size_t size() const noexcept;
+
+						/// <summary>
+						/// Count one exception with the normalized signature <paramref name="signature"/>.
+						/// </summary>
+						/// <param name="signature">The normalized signature text.</param>
+						/// <param name="source">The source of the exception, which may become the representative of its bucket.</param>
+						void Add(const std::string& signature, const std::string& source);
+
+						/// <summary>
+						/// Add all the buckets of <paramref name="other"/> to this aggregator. The representative of a bucket is the 
+						/// lowest source in lexicographical order, so that the result does not depend on the order of merging.
+						/// </summary>
+						/// <param name="other">The aggregator to merge into this one.</param>
+						void Merge(const SignatureAggregator& other);
+
+						/// <summary>
+						/// Get all buckets sorted by descending count, and by signature for equal counts.
+						/// </summary>
+						/// <returns>A vector of pointers to the buckets, which are valid until the aggregator is modified.</returns>
+						std::vector<const SignatureBucket*> Sorted() const;
+
+						/// <summary>
+						/// Compute the normalized signature text of an exception. The signature consists of the exception code, the 
+						/// module and offset of the exception address, the module and offset of the top stack frames and the 
+						/// C++ exception type chain (if any). Modules are identified by their lowercase file name rather than their 
+						/// index or base address, as both differ between runs.
+						/// </summary>
+						/// <param name="info">The exception debug info.</param>
+						/// <param name="firstChance">A boolean indicating that this is the first encounter with this specific exception instance, or not.</param>
+						/// <param name="trace">The stack trace of the exception, or nullptr.</param>
+						/// <param name="collection">The collection of modules loaded at the time of the exception.</param>
+						/// <param name="ertti">The C++ exception type information, or nullptr.</param>
+						/// <param name="frames">The number of top stack frames to include.</param>
+						/// <returns>The normalized signature text.</returns>
+						static std::string Normalize(
+							const EXCEPTION_DEBUG_INFO& info,
+							bool firstChance,
+							const std::shared_ptr<const DebugStackTrace>& trace,
+							const ModuleCollection& collection,
+							const std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation>& ertti,
+							size_t frames);
+
+						/// <summary>
+						/// Compute the 64-bit FNV-1a hash of a signature.
+						/// </summary>
+						/// <param name="signature">The signature text.</param>
+						/// <returns>The hash of <paramref name="signature"/>.</returns>
+						static uint64_t Hash(const std::string& signature) noexcept;
+				};
+
+				/// <summary>
+				/// An implementation of <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/> that computes a 
+				/// normalized crash signature for every exception and counts it in a <see cref="::Hindsight::Debugger::EventHandler::SignatureAggregator"/>. 
+				/// Nothing of the event is retained besides the signature, so a log of any length can be streamed through it.
+				/// </summary>
+				class SignatureDebuggerEventHandler : public IDebuggerEventHandler {
+					private:
+						SignatureAggregator& m_Aggregator;	/* The aggregator that counts the signatures */
+						std::string			 m_Source;		/* The source of the events, such as the log file path */
+
+					public:
+						/// <summary>
+						/// Construct a new SignatureDebuggerEventHandler.
+						/// </summary>
+						/// <param name="aggregator">The aggregator that counts the signatures, which must outlive the handler.</param>
+						/// <param name="source">The source of the events, such as the path of the replayed log file.</param>
+						SignatureDebuggerEventHandler(SignatureAggregator& aggregator, const std::string& source);
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="p">The process being debugged.</param>
+						void OnInitialization(
+							time_t time,
+							const std::shared_ptr<const Hindsight::Process::Process> p) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="EXCEPTION_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
+						/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnBreakpointHit(
+							time_t time,
+							const EXCEPTION_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							std::shared_ptr<const DebugContext> context,
+							std::shared_ptr<const DebugStackTrace> trace,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// Compute the crash signature of the exception and add it to the aggregator. Breakpoint exceptions are reported
+						/// through OnBreakpointHit instead and never contribute to a signature.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="EXCEPTION_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="firstChance">A boolean indicating that this is the first encounter with this specific exception instance, or not.</param>
+						/// <param name="name">A name of a known exception, or an empty string.</param>
+						/// <param name="context">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
+						/// <param name="trace">A shared pointer to a const <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						/// <param name="ertti">A shared pointer to a const <see cref="::Hindsight::Debugger::CxxExceptions::ExceptionRtti"/> instance.</param>
+						void OnException(
+							time_t time,
+							const EXCEPTION_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							bool firstChance,
+							const std::wstring& name,
+							std::shared_ptr<const DebugContext> context,
+							std::shared_ptr<const DebugStackTrace> trace,
+							const ModuleCollection& collection,
+							std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation> ertti) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="CREATE_PROCESS_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="path">The full path to the loaded module on file system.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnCreateProcess(
+							time_t time,
+							const CREATE_PROCESS_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& path,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="CREATE_THREAD_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnCreateThread(
+							time_t time,
+							const CREATE_THREAD_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="EXIT_PROCESS_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnExitProcess(
+							time_t time,
+							const EXIT_PROCESS_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="EXIT_THREAD_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnExitThread(
+							time_t time,
+							const EXIT_THREAD_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="EXIT_THREAD_DEBUG_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="path">The full unicode path to the DLL that was loaded.</param>
+						/// <param name="moduleIndex">The index in the module collection of this module, it might have been loaded before.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnDllLoad(
+							time_t time,
+							const LOAD_DLL_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& path,
+							int moduleIndex,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="OUTPUT_DEBUG_STRING_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="string">The ANSI debug string.</param>
+						void OnDebugString(
+							time_t time,
+							const OUTPUT_DEBUG_STRING_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::string& string) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="OUTPUT_DEBUG_STRING_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="string">The Unicode debug string.</param>
+						void OnDebugStringW(
+							time_t time,
+							const OUTPUT_DEBUG_STRING_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& string) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="info">A const reference to the <see cref="RIP_INFO"/> struct instance with event information.</param>
+						/// <param name="pi">A const reference to the <see cref="PROCESS_INFORMATION"/> struct of the process and thread triggering the event.</param>
+						/// <param name="errorMessage">A string describing the <see cref="RIP_INFO::dwError"/> member, or an empty string if no description is available.</param>
+						void OnRip(
+							time_t time,
+							const RIP_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& errorMessage) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored.
+						/// </summary>
+						void OnDllUnload(
+							time_t time,
+							const UNLOAD_DLL_DEBUG_INFO& info,
+							const PROCESS_INFORMATION& pi,
+							const std::wstring& path,
+							int moduleIndex,
+							const ModuleCollection& collection) override;
+
+						/// <summary>
+						/// This event does not contribute to crash signatures and is ignored, the aggregator outlives the handler.
+						/// </summary>
+						/// <param name="time">The time of the event.</param>
+						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
+						void OnModuleCollectionComplete(
+							time_t time,
+							const ModuleCollection& collection) override;
+				};
+			}
+		}
+	}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef debugger_snapshot_memory_reader_h
+#define debugger_snapshot_memory_reader_h
+	#include "DebugBackend.hpp"
+
+	#include <cstdint>
+	#include <cstring>
+
+	namespace Hindsight {
+		namespace Debugger {
+			namespace Backend {
+				/// <summary>
+				/// A memory reader that serves one range of memory, typically the stack of a thread, from a copy that was read in
+				/// a single call. Reads outside of the copy are passed on to another reader, or fail when there is none, so the
+				/// same unwinder runs against a live process and against a stack that was saved with an exception. This class does
+				/// not depend on any platform API.
+				/// </summary>
+				class SnapshotMemoryReader : public IMemoryReader {
+					private:
+						uint64_t				m_Address;	/* The address of the copy in the debugged process */
+						const uint8_t*			m_Data;		/* The copy, which is not owned */
+						size_t					m_Size;		/* The size of the copy */
+						const IMemoryReader*	m_Source;	/* The reader for everything outside of the copy, or nullptr */
+
+					public:
+						/// <summary>
+						/// Construct a new SnapshotMemoryReader.
+						/// </summary>
+						/// <param name="address">The address of the copy in the debugged process.</param>
+						/// <param name="data">The copy, which must outlive this reader.</param>
+						/// <param name="size">The size of the copy.</param>
+						/// <param name="source">The reader for everything outside of the copy, which must outlive this reader, or nullptr.</param>
+						SnapshotMemoryReader(uint64_t address, const void* data, size_t size, const IMemoryReader* source = nullptr)
+							: m_Address(address), m_Data(static_cast<const uint8_t*>(data)), m_Size(size), m_Source(source) {
+
+						}
+
+						/// <summary>
+						/// Read up to <paramref name="size"/> bytes at <paramref name="address"/> in the debugged process.
+						/// </summary>
+						/// <param name="address">The address in the debugged process.</param>
+						/// <param name="buffer">The buffer that receives the data.</param>
+						/// <param name="size">The number of bytes to read.</param>
+						/// <returns>The number of bytes that were read, which is less than <paramref name="size"/> when part of the range is not readable.</returns>
+						size_t Read(uint64_t address, void* buffer, size_t size) const override {
+							if (address < m_Address || address - m_Address >= m_Size)
+								return m_Source != nullptr ? m_Source->Read(address, buffer, size) : 0;
+
+							auto offset = static_cast<size_t>(address - m_Address);
+							auto length = m_Size - offset < size ? m_Size - offset : size;
+							std::memcpy(buffer, m_Data + offset, length);
+
+							// a range that runs past the end of the copy continues in the source
+							if (length < size && m_Source != nullptr)
+								length += m_Source->Read(address + length, static_cast<uint8_t*>(buffer) + length, size - length);
+
+							return length;
+						}
+				};
+			}
+		}
+	}
+
+#endif
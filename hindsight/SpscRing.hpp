@@ -0,0 +1,94 @@
+#pragma once
+
+#ifndef util_spsc_ring_h
+#define util_spsc_ring_h
+	#include <atomic>
+	#include <vector>
+	#include <cstddef>
+	#include <utility>
+	#include <stdexcept>
+
+	namespace Hindsight {
+		namespace Utilities {
+			/// <summary>
+			/// A bounded, lock-free ring buffer for exactly one producer thread and one consumer thread. The producer only ever writes
+			/// the tail index and the consumer only ever writes the head index, so no locks or compare-and-swap loops are required.
+			/// This class does not depend on any platform API, so it can be used (and tested) on any platform with C++17.
+			/// </summary>
+			/// <typeparam name="T">The element type, which must be default constructible and movable.</typeparam>
+			template <typename T>
+			class SpscRing {
+				private:
+					std::vector<T>			m_Slots;
+					size_t					m_Mask;
+
+					alignas(64) std::atomic<size_t> m_Head;	/* The next slot to pop, written by the consumer */
+					alignas(64) std::atomic<size_t> m_Tail;	/* The next slot to push, written by the producer */
+
+				public:
+					/// <summary>
+					/// Construct a new ring that can hold <paramref name="capacity"/> elements.
+					/// </summary>
+					/// <param name="capacity">The number of slots in the ring, which must be a power of two.</param>
+					/// <exception cref="std::invalid_argument">This exception is thrown when <paramref name="capacity"/> is not a power of two.</exception>
+					SpscRing(size_t capacity)
+						: m_Slots(capacity), m_Mask(capacity - 1), m_Head(0), m_Tail(0) {
+						if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+							throw std::invalid_argument("the capacity of a ring must be a power of two");
+					}
+
+					SpscRing(const SpscRing&) = delete;
+					SpscRing& operator=(const SpscRing&) = delete;
+
+					/// <summary>
+					/// Try to push <paramref name="value"/> to the ring, this may only be called from the producer thread.
+					/// <paramref name="value"/> is only moved from when the push succeeds.
+					/// </summary>
+					/// <param name="value">The value to push.</param>
+					/// <returns>true when the value was pushed, false when the ring is full.</returns>
+					bool TryPush(T&& value) {
+						auto tail = m_Tail.load(std::memory_order_relaxed);
+						if (tail - m_Head.load(std::memory_order_acquire) == m_Slots.size())
+							return false;
+
+						m_Slots[tail & m_Mask] = std::move(value);
+						m_Tail.store(tail + 1, std::memory_order_release);
+						return true;
+					}
+
+					/// <summary>
+					/// Try to pop the oldest value from the ring into <paramref name="value"/>, this may only be called from the
+					/// consumer thread.
+					/// </summary>
+					/// <param name="value">A reference to the variable that receives the value.</param>
+					/// <returns>true when a value was popped, false when the ring is empty.</returns>
+					bool TryPop(T& value) {
+						auto head = m_Head.load(std::memory_order_relaxed);
+						if (head == m_Tail.load(std::memory_order_acquire))
+							return false;
+
+						value = std::move(m_Slots[head & m_Mask]);
+						m_Head.store(head + 1, std::memory_order_release);
+						return true;
+					}
+
+					/// <summary>
+					/// Determines if the ring is empty. The result is only a snapshot when the other thread is active.
+					/// </summary>
+					/// <returns>true when there are no values in the ring.</returns>
+					bool Empty() const {
+						return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+					}
+
+					/// <summary>
+					/// Determines the number of slots in the ring.
+					/// </summary>
+					/// <returns>The capacity of the ring.</returns>
+					size_t Capacity() const noexcept {
+						return m_Slots.size();
+					}
+			};
+		}
+	}
+
+#endif
\ No newline at end of file
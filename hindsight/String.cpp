@@ -4,7 +4,11 @@
 #include <algorithm>
 #include <string>
 #include <cwctype>
+#include <cstdint>
+
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 using namespace Hindsight::Utilities;
 
@@ -222,6 +226,7 @@ std::wstring String::PadRight(const wchar_t* input, size_t count, wchar_t ch) {
 	return PadRight(std::wstring(input), count, ch);
 }
 
+#ifdef _WIN32
 /// <summary>
 /// Convert a <see cref="::std::string"/> to a <see cref="::std::wstring"/>.
 /// </summary>
@@ -266,6 +271,105 @@ std::string String::ToString(const std::wstring& input) {
 
 	return std::string(&buffer[0], charsConverted);
 }
+#else
+/// <summary>
+/// Convert a <see cref="::std::string"/> to a <see cref="::std::wstring"/>, where wchar_t holds UTF-32.
+/// </summary>
+/// <param name="input">The input string.</param>
+/// <returns>The converted string, with U+FFFD for every malformed sequence.</returns>
+std::wstring String::ToWString(const std::string& input) {
+	std::wstring result;
+	result.reserve(input.size());
+
+	for (size_t i = 0; i < input.size();) {
+		auto lead   = static_cast<uint8_t>(input[i]);
+		auto length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xe ? 3 : (lead >> 3) == 0x1e ? 4 : 0;
+		auto code   = static_cast<uint32_t>(length == 1 ? lead : lead & (0x7f >> length));
+
+		auto valid = length != 0 && i + length <= input.size();
+		for (size_t k = 1; valid && k < static_cast<size_t>(length); k++) {
+			auto next = static_cast<uint8_t>(input[i + k]);
+			valid = (next & 0xc0) == 0x80;
+			code  = (code << 6) | (next & 0x3f);
+		}
+
+		// overlong forms and surrogates are as malformed as a broken sequence
+		static const uint32_t minimum[] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if (!valid || code < minimum[length] || code > 0x10ffff || (code >= 0xd800 && code < 0xe000)) {
+			result.push_back(static_cast<wchar_t>(0xfffd));
+			i++;
+			continue;
+		}
+
+		result.push_back(static_cast<wchar_t>(code));
+		i += length;
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Convert a <see cref="::std::wstring"/>, where wchar_t holds UTF-32, to a <see cref="::std::string"/>.
+/// </summary>
+/// <param name="input">The input string.</param>
+/// <returns>The converted string, with '?' for every character that is not a code point.</returns>
+std::string String::ToString(const std::wstring& input) {
+	std::string result;
+	result.reserve(input.size());
+
+	for (auto ch : input) {
+		auto code = static_cast<uint32_t>(ch);
+
+		if (code < 0x80) {
+			result.push_back(static_cast<char>(code));
+		} else if (code < 0x800) {
+			result.push_back(static_cast<char>(0xc0 | (code >> 6)));
+			result.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+		} else if (code > 0x10ffff || (code >= 0xd800 && code < 0xe000)) {
+			result.push_back('?');
+		} else if (code < 0x10000) {
+			result.push_back(static_cast<char>(0xe0 | (code >> 12)));
+			result.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+			result.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+		} else {
+			result.push_back(static_cast<char>(0xf0 | (code >> 18)));
+			result.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+			result.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+			result.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+		}
+	}
+
+	return result;
+}
+#endif
+
+/// <summary>
+/// Convert a <see cref="::std::wstring"/> to the UTF-16 code units that binary log files store strings in. A wchar_t is a
+/// UTF-16 code unit on Windows, elsewhere characters outside of the basic multilingual plane become U+FFFD, so that the
+/// result always has as many code units as <paramref name="input"/> has characters and the lengths written with it hold.
+/// </summary>
+/// <param name="input">The input string.</param>
+/// <returns>The UTF-16 string.</returns>
+std::u16string String::ToUtf16(const std::wstring& input) {
+	std::u16string result(input.size(), u'\0');
+
+	for (size_t i = 0; i < input.size(); i++) {
+		auto code = static_cast<uint32_t>(input[i]);
+		result[i] = static_cast<char16_t>(code > 0xffff ? 0xfffd : code);
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Convert UTF-16 code units, as stored in binary log files, to a <see cref="::std::wstring"/>.
+/// </summary>
+/// <param name="input">The UTF-16 code units.</param>
+/// <param name="length">The number of code units.</param>
+/// <returns>The converted string, with one character per code unit.</returns>
+std::wstring String::FromUtf16(const char16_t* input, size_t length) {
+	return std::wstring(input, input + length);
+}
 
 /// <summary>
 /// Whitespace characters to be trimmed.
@@ -150,6 +150,21 @@
 					/// <returns>The converted string.</returns>
 					static std::string ToString(const std::wstring& input);
 
+					/// <summary>
+					/// Convert a <see cref="::std::wstring"/> to the UTF-16 code units that binary log files store strings in.
+					/// </summary>
+					/// <param name="input">The input string.</param>
+					/// <returns>The UTF-16 string, which has one code unit for every character of <paramref name="input"/>.</returns>
+					static std::u16string ToUtf16(const std::wstring& input);
+
+					/// <summary>
+					/// Convert UTF-16 code units, as stored in binary log files, to a <see cref="::std::wstring"/>.
+					/// </summary>
+					/// <param name="input">The UTF-16 code units.</param>
+					/// <param name="length">The number of code units.</param>
+					/// <returns>The converted string.</returns>
+					static std::wstring FromUtf16(const char16_t* input, size_t length);
+
 					/// <summary>
 					/// Trim all whitespace of the left side of a string and return a new trimmed string.
 					/// </summary>
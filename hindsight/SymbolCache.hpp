@@ -0,0 +1,133 @@
+#pragma once
+
+#ifndef debugger_symbol_cache_h
+#define debugger_symbol_cache_h
+	#include <cstdint>
+	#include <cstddef>
+	#include <string>
+	#include <map>
+	#include <functional>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The symbol and source line information resolved for a single address.
+			/// </summary>
+			struct ResolvedAddress {
+				bool			HasSymbol = false;		/* True when a symbol was found for the address. */
+				std::string		Name = "";				/* The symbol name. */
+				uint64_t		SymbolAddress = 0;		/* The start address of the symbol. */
+				uint64_t		SymbolSize = 0;			/* The size of the symbol in bytes, or 0 when unknown. */
+				uint64_t		ModuleBase = 0;			/* The base address of the module containing the symbol, or 0 when unknown. */
+				uint64_t		Displacement = 0;		/* The displacement of the address from the start of the symbol. */
+
+				bool			HasLine = false;		/* True when a source line was found for the address. */
+				std::wstring	File = L"";				/* The source file. */
+				uint32_t		Line = 0;				/* The line number in the source file. */
+				uint64_t		LineAddress = 0;		/* The address of the first instruction of the line. */
+				uint32_t		LineDisplacement = 0;	/* The displacement of the address from the start of the line. */
+			};
+
+			/// <summary>
+			/// A memo cache of resolved addresses in front of a (slow) symbol resolver. Negative results are cached too, so
+			/// an address that cannot be resolved is not looked up again until the module range that contains it is
+			/// invalidated. This class does not depend on any platform API, the resolver decides where symbols come from.
+			/// </summary>
+			class SymbolCache {
+				public:
+					/// <summary>
+					/// The resolver that is invoked on a cache miss.
+					/// </summary>
+					using Resolver = std::function<ResolvedAddress(uint64_t)>;
+
+					/// <summary>
+					/// The default maximum number of cached addresses.
+					/// </summary>
+					static const size_t DefaultCapacity = 64 * 1024;
+
+				private:
+					Resolver							m_Resolver;	/* The resolver for addresses that are not cached yet */
+					std::map<uint64_t, ResolvedAddress>	m_Entries;	/* The cached addresses, ordered so that module ranges can be invalidated */
+					size_t								m_Capacity;	/* The maximum number of cached addresses */
+					size_t								m_Hits;		/* The number of lookups served from the cache */
+					size_t								m_Misses;	/* The number of lookups passed to the resolver */
+
+				public:
+					/// <summary>
+					/// Construct a new, empty, SymbolCache.
+					/// </summary>
+					/// <param name="resolver">The resolver that is invoked on a cache miss.</param>
+					/// <param name="capacity">The maximum number of cached addresses, the cache is emptied when it is full.</param>
+					SymbolCache(Resolver resolver, size_t capacity = DefaultCapacity)
+						: m_Resolver(std::move(resolver)), m_Capacity(capacity), m_Hits(0), m_Misses(0) {
+
+					}
+
+					/// <summary>
+					/// Resolve <paramref name="address"/>, either from the cache or through the resolver.
+					/// </summary>
+					/// <param name="address">The address to resolve.</param>
+					/// <returns>A const reference to the resolved address, which is valid until the cache is modified.</returns>
+					const ResolvedAddress& Resolve(uint64_t address) {
+						auto it = m_Entries.find(address);
+						if (it != m_Entries.end()) {
+							++m_Hits;
+							return it->second;
+						}
+
+						++m_Misses;
+
+						// a full cache is simply started over, the addresses in a trace are looked up again soon enough
+						if (m_Entries.size() >= m_Capacity)
+							m_Entries.clear();
+
+						return m_Entries.emplace(address, m_Resolver(address)).first->second;
+					}
+
+					/// <summary>
+					/// Remove all cached addresses in the range [<paramref name="base"/>, <paramref name="base"/> + <paramref name="size"/>),
+					/// which should be done whenever a module is loaded or unloaded in that range.
+					/// </summary>
+					/// <param name="base">The start of the range.</param>
+					/// <param name="size">The size of the range in bytes.</param>
+					void Invalidate(uint64_t base, uint64_t size) {
+						// a range that reaches the top of the address space would wrap around
+						auto last = base + size < base ? m_Entries.end() : m_Entries.lower_bound(base + size);
+						m_Entries.erase(m_Entries.lower_bound(base), last);
+					}
+
+					/// <summary>
+					/// Remove all cached addresses.
+					/// </summary>
+					void Clear() noexcept {
+						m_Entries.clear();
+					}
+
+					/// <summary>
+					/// Get the number of cached addresses.
+					/// </summary>
+					/// <returns>The number of cached addresses.</returns>
+					size_t size() const noexcept {
+						return m_Entries.size();
+					}
+
+					/// <summary>
+					/// Get the number of lookups that were served from the cache.
+					/// </summary>
+					/// <returns>The number of cache hits.</returns>
+					size_t Hits() const noexcept {
+						return m_Hits;
+					}
+
+					/// <summary>
+					/// Get the number of lookups that were passed to the resolver.
+					/// </summary>
+					/// <returns>The number of cache misses.</returns>
+					size_t Misses() const noexcept {
+						return m_Misses;
+					}
+			};
+		}
+	}
+
+#endif
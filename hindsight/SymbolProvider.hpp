@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef debugger_symbol_provider_h
+#define debugger_symbol_provider_h
+	#include <cstdint>
+	#include <string>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The symbol and source line of an address in a module. All addresses are relative to the module base (RVA), so
+			/// that a record holds for every process that loads the same build of the module, wherever it is loaded.
+			/// </summary>
+			struct SymbolRecord {
+				bool		HasSymbol = false;	/* True when a symbol was found for the address. */
+				std::string	Name = "";			/* The symbol name, UTF-8 encoded. */
+				uint64_t	SymbolRva = 0;		/* The start of the symbol. */
+				uint64_t	SymbolSize = 0;		/* The size of the symbol in bytes, or 0 when unknown. */
+
+				bool		HasLine = false;	/* True when a source line was found for the address. */
+				std::string	File = "";			/* The source file, UTF-8 encoded. */
+				uint32_t	Line = 0;			/* The line number in the source file. */
+				uint64_t	LineRva = 0;		/* The first instruction of the line. */
+			};
+
+			/// <summary>
+			/// A source of debug information for one module, such as a PDB file or the DWARF sections of an ELF image.
+			/// </summary>
+			class ISymbolProvider {
+				public:
+					virtual ~ISymbolProvider() = default;
+
+					/// <summary>
+					/// Look up the symbol and source line of an address in the module.
+					/// </summary>
+					/// <param name="rva">The address, relative to the module base.</param>
+					/// <param name="record">A reference to the record that receives the result.</param>
+					/// <returns>true when a symbol or a source line was found.</returns>
+					virtual bool Lookup(uint64_t rva, SymbolRecord& record) = 0;
+			};
+		}
+	}
+
+#endif
@@ -0,0 +1,229 @@
+#include "SymbolSession.hpp"
+#include "String.hpp"
+#include <Windows.h>
+#include <DbgHelp.h>
+#include <cstring>
+
+using namespace Hindsight::Debugger;
+
+/// <summary>
+/// Initialize a new symbol engine session for <paramref name="hProcess"/>.
+/// </summary>
+/// <param name="hProcess">A handle to the debugged process, which must remain valid for the lifetime of the session. A session that is 
+/// not tied to a live process (such as when symbolizing at replay) passes any unique value and does not invade.</param>
+/// <param name="searchPath">One or multiple (separated by ';') search paths where DbgHelp can find .PDB files.</param>
+/// <param name="invade">When true, all modules currently loaded in the process are loaded into the session immediately.</param>
+SymbolSession::SymbolSession(HANDLE hProcess, const std::string& searchPath, bool invade)
+	: m_Process(hProcess), m_Initialized(false), m_Cache([this](uint64_t address) { return Lookup(static_cast<DWORD64>(address)); }) {
+
+	// Set the options for DbgHelp to determine how exactly it should resolve symbols.
+	SymSetOptions(
+		SYMOPT_ALLOW_ABSOLUTE_SYMBOLS |
+		SYMOPT_DEFERRED_LOADS |
+		SYMOPT_INCLUDE_32BIT_MODULES |
+		SYMOPT_LOAD_LINES |
+		SYMOPT_UNDNAME
+	);
+
+	// If a search path is provided, pass it on to SymInitialize
+	const char* path = nullptr;
+	if (!searchPath.empty())
+		path = searchPath.c_str();
+
+	// Initialize DbgHelp's symbol engine.
+	m_Initialized = SymInitialize(m_Process, path, invade) != FALSE;
+}
+
+/// <summary>
+/// Clean up the symbol engine session.
+/// </summary>
+SymbolSession::~SymbolSession() {
+	if (m_Initialized)
+		SymCleanup(m_Process);
+}
+
+/// <summary>
+/// Get the process handle the session was initialized with, which has to be passed to the DbgHelp functions
+/// that use this session (such as StackWalk64).
+/// </summary>
+/// <returns>The process handle.</returns>
+HANDLE SymbolSession::GetProcess() const noexcept {
+	return m_Process;
+}
+
+/// <summary>
+/// Load a module into the session. Symbols are loaded deferred, on the first lookup of an address in the module.
+/// </summary>
+/// <param name="path">The full path to the module.</param>
+/// <param name="base">The module base address.</param>
+/// <param name="size">The module size in memory, or 0 when unknown.</param>
+void SymbolSession::Load(const std::wstring& path, ModulePointer base, size_t size) {
+	if (!m_Initialized)
+		return;
+
+	SymLoadModuleExW(m_Process, nullptr, path.c_str(), nullptr, reinterpret_cast<DWORD64>(base), static_cast<DWORD>(size), nullptr, 0);
+
+	// addresses in this range may have been cached as unresolvable before the module was loaded
+	Invalidate(base, size);
+}
+
+/// <summary>
+/// Load a module that was recorded on another machine. The image with the link time stamp and size of <paramref name="identity"/>
+/// is looked up through the search path first, which may be a symbol store, then the PDB file by its GUID and age. When neither 
+/// is found, the module is loaded from its recorded path in case the same build is installed here.
+/// </summary>
+/// <param name="path">The recorded path of the module.</param>
+/// <param name="base">The recorded module base address.</param>
+/// <param name="size">The module size in memory, or 0 when unknown.</param>
+/// <param name="identity">The recorded identity of the module.</param>
+void SymbolSession::Load(const std::wstring& path, ModulePointer base, size_t size, const ModuleIdentity& identity) {
+	if (!m_Initialized)
+		return;
+
+	wchar_t found[MAX_PATH + 1] = { 0 };
+	auto separator = path.find_last_of(L"\\/");
+	auto name = (separator == std::wstring::npos ? path : path.substr(separator + 1));
+
+	// symbol stores index images by time stamp and size, the id is passed by value
+	if (SymFindFileInPathW(m_Process, nullptr, name.c_str(), reinterpret_cast<PVOID>(static_cast<uintptr_t>(identity.TimeDateStamp)), identity.SizeOfImage, 0, SSRVOPT_DWORD, found, nullptr, nullptr)) {
+		Load(found, base, size);
+		return;
+	}
+
+	// and PDB files by GUID and age, DbgHelp can load a PDB without its image
+	if (identity.HasPdb) {
+		GUID guid;
+		std::memcpy(&guid, identity.PdbGuid, sizeof(guid));
+
+		auto pdb = Hindsight::Utilities::String::ToWString(identity.PdbName());
+		if (SymFindFileInPathW(m_Process, nullptr, pdb.c_str(), &guid, identity.PdbAge, 0, SSRVOPT_GUIDPTR, found, nullptr, nullptr)) {
+			Load(found, base, size);
+			return;
+		}
+	}
+
+	Load(path, base, size);
+}
+
+/// <summary>
+/// Unload a module from the session and forget all resolved addresses within it.
+/// </summary>
+/// <param name="base">The module base address.</param>
+/// <param name="size">The module size in memory, or 0 when unknown.</param>
+void SymbolSession::Unload(ModulePointer base, size_t size) {
+	if (!m_Initialized)
+		return;
+
+	SymUnloadModule64(m_Process, reinterpret_cast<DWORD64>(base));
+	Invalidate(base, size);
+}
+
+/// <summary>
+/// Resolve the symbol and source line of <paramref name="address"/>, which is only looked up through DbgHelp
+/// the first time.
+/// </summary>
+/// <param name="address">The address to resolve.</param>
+/// <returns>A const reference to the resolved address, which is valid until the next call to a non-const method.</returns>
+const ResolvedAddress& SymbolSession::Resolve(DWORD64 address) {
+	return m_Cache.Resolve(static_cast<uint64_t>(address));
+}
+
+/// <summary>
+/// Get the cache of resolved addresses, for statistics.
+/// </summary>
+/// <returns>A const reference to the cache.</returns>
+const SymbolCache& SymbolSession::Cache() const noexcept {
+	return m_Cache;
+}
+
+/// <summary>
+/// Look up the symbol and source line of <paramref name="address"/> through DbgHelp.
+/// </summary>
+/// <param name="address">The address to resolve.</param>
+/// <returns>The resolved address.</returns>
+ResolvedAddress SymbolSession::Lookup(DWORD64 address) const {
+	ResolvedAddress result;
+	DWORD64 dwSymbolDisplacement = 0;
+	DWORD   dwLineDisplacement   = 0;
+
+	// Reserve enough bytes of memory to hold the SYMBOL_INFO struct and the symbol name
+	uint8_t symbol[sizeof(SYMBOL_INFO) + MAX_SYM_NAME] = {};
+
+	auto pSymbol = reinterpret_cast<PSYMBOL_INFO>(symbol);
+	pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	pSymbol->MaxNameLen   = MAX_SYM_NAME;
+
+	// Get symbol information (name, which module it came from, addresses)
+	if (SymFromAddr(m_Process, address, &dwSymbolDisplacement, pSymbol)) {
+		result.HasSymbol	 = true;
+		result.SymbolAddress = pSymbol->Address;
+		result.SymbolSize	 = pSymbol->Size;
+		result.ModuleBase	 = pSymbol->ModBase;
+		result.Displacement	 = dwSymbolDisplacement;
+
+		if (pSymbol->NameLen) /* convert the name to an std::string */
+			result.Name = std::string((const char*)&pSymbol->Name[0], pSymbol->NameLen);
+	}
+
+	// Get the symbol line association, which is an approximation
+	IMAGEHLP_LINEW64 line = { sizeof(IMAGEHLP_LINEW64), 0, 0, 0, 0 };
+	if (SymGetLineFromAddrW64(m_Process, address, &dwLineDisplacement, &line)) {
+		result.HasLine			= true;
+		result.File				= line.FileName;
+		result.Line				= line.LineNumber;
+		result.LineAddress		= line.Address;
+		result.LineDisplacement = dwLineDisplacement;
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Forget all resolved addresses in a module, or all resolved addresses when the module size is unknown.
+/// </summary>
+/// <param name="base">The module base address.</param>
+/// <param name="size">The module size in memory, or 0 when unknown.</param>
+void SymbolSession::Invalidate(ModulePointer base, size_t size) {
+	if (size == 0) {
+		m_Cache.Clear();
+	} else {
+		m_Cache.Invalidate(reinterpret_cast<uint64_t>(base), size);
+	}
+}
+
+/// <summary>
+/// Construct a new SymbolSessionProvider.
+/// </summary>
+/// <param name="session">The session that the module is loaded into, which must outlive the provider.</param>
+/// <param name="base">The module base address.</param>
+SymbolSessionProvider::SymbolSessionProvider(SymbolSession& session, ModulePointer base)
+	: m_Session(session), m_Base(base) {
+
+}
+
+/// <summary>
+/// Look up the symbol and source line of an address in the module through the session.
+/// </summary>
+/// <param name="rva">The address, relative to the module base.</param>
+/// <param name="record">A reference to the record that receives the result.</param>
+/// <returns>true when a symbol or a source line was found.</returns>
+bool SymbolSessionProvider::Lookup(uint64_t rva, SymbolRecord& record) {
+	auto base = reinterpret_cast<uint64_t>(m_Base);
+	const auto& resolved = m_Session.Resolve(static_cast<DWORD64>(base + rva));
+
+	if (resolved.HasSymbol) {
+		record.HasSymbol  = true;
+		record.Name		  = resolved.Name;
+		record.SymbolRva  = resolved.SymbolAddress - base;
+		record.SymbolSize = resolved.SymbolSize;
+	}
+
+	if (resolved.HasLine) {
+		record.HasLine = true;
+		record.File	   = Hindsight::Utilities::String::ToString(resolved.File);
+		record.Line	   = resolved.Line;
+		record.LineRva = resolved.LineAddress - base;
+	}
+
+	return record.HasSymbol || record.HasLine;
+}
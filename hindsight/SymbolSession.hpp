@@ -0,0 +1,137 @@
+#pragma once
+
+#ifndef debugger_symbol_session_h
+#define debugger_symbol_session_h
+	#include <Windows.h>
+
+	#include "ModuleCollection.hpp"
+	#include "ModuleIdentity.hpp"
+	#include "SymbolCache.hpp"
+	#include "SymbolProvider.hpp"
+
+	#include <string>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// A DbgHelp symbol engine session for one debugged process, which lives as long as the debugger. Modules are loaded
+			/// into and unloaded from the session as the process loads and unloads them, rather than initializing the symbol
+			/// engine and enumerating all modules for every stack trace. Resolved addresses are kept in a <see cref="::Hindsight::Debugger::SymbolCache"/>.
+			/// </summary>
+			class SymbolSession {
+				private:
+					HANDLE		m_Process;		/* The process handle the session was initialized with */
+					bool		m_Initialized;	/* True when SymInitialize succeeded */
+					SymbolCache	m_Cache;		/* The memo cache of resolved addresses */
+
+				public:
+					/// <summary>
+					/// Initialize a new symbol engine session for <paramref name="hProcess"/>.
+					/// </summary>
+					/// <param name="hProcess">A handle to the debugged process, which must remain valid for the lifetime of the session. A session that is 
+					/// not tied to a live process (such as when symbolizing at replay) passes any unique value and does not invade.</param>
+					/// <param name="searchPath">One or multiple (separated by ';') search paths where DbgHelp can find .PDB files.</param>
+					/// <param name="invade">When true, all modules currently loaded in the process are loaded into the session immediately.</param>
+					SymbolSession(HANDLE hProcess, const std::string& searchPath, bool invade = false);
+
+					/// <summary>
+					/// Clean up the symbol engine session.
+					/// </summary>
+					~SymbolSession();
+
+					SymbolSession(const SymbolSession&) = delete;
+					SymbolSession& operator=(const SymbolSession&) = delete;
+
+					/// <summary>
+					/// Get the process handle the session was initialized with, which has to be passed to the DbgHelp functions
+					/// that use this session (such as StackWalk64).
+					/// </summary>
+					/// <returns>The process handle.</returns>
+					HANDLE GetProcess() const noexcept;
+
+					/// <summary>
+					/// Load a module into the session. Symbols are loaded deferred, on the first lookup of an address in the module.
+					/// </summary>
+					/// <param name="path">The full path to the module.</param>
+					/// <param name="base">The module base address.</param>
+					/// <param name="size">The module size in memory, or 0 when unknown.</param>
+					void Load(const std::wstring& path, ModulePointer base, size_t size);
+
+					/// <summary>
+					/// Load a module that was recorded on another machine. The image with the link time stamp and size of <paramref name="identity"/>
+					/// is looked up through the search path first, which may be a symbol store, then the PDB file by its GUID and age. When neither 
+					/// is found, the module is loaded from its recorded path in case the same build is installed here.
+					/// </summary>
+					/// <param name="path">The recorded path of the module.</param>
+					/// <param name="base">The recorded module base address.</param>
+					/// <param name="size">The module size in memory, or 0 when unknown.</param>
+					/// <param name="identity">The recorded identity of the module.</param>
+					void Load(const std::wstring& path, ModulePointer base, size_t size, const ModuleIdentity& identity);
+
+					/// <summary>
+					/// Unload a module from the session and forget all resolved addresses within it.
+					/// </summary>
+					/// <param name="base">The module base address.</param>
+					/// <param name="size">The module size in memory, or 0 when unknown.</param>
+					void Unload(ModulePointer base, size_t size);
+
+					/// <summary>
+					/// Resolve the symbol and source line of <paramref name="address"/>, which is only looked up through DbgHelp
+					/// the first time.
+					/// </summary>
+					/// <param name="address">The address to resolve.</param>
+					/// <returns>A const reference to the resolved address, which is valid until the next call to a non-const method.</returns>
+					const ResolvedAddress& Resolve(DWORD64 address);
+
+					/// <summary>
+					/// Get the cache of resolved addresses, for statistics.
+					/// </summary>
+					/// <returns>A const reference to the cache.</returns>
+					const SymbolCache& Cache() const noexcept;
+
+				private:
+					/// <summary>
+					/// Look up the symbol and source line of <paramref name="address"/> through DbgHelp.
+					/// </summary>
+					/// <param name="address">The address to resolve.</param>
+					/// <returns>The resolved address.</returns>
+					ResolvedAddress Lookup(DWORD64 address) const;
+
+					/// <summary>
+					/// Forget all resolved addresses in a module, or all resolved addresses when the module size is unknown.
+					/// </summary>
+					/// <param name="base">The module base address.</param>
+					/// <param name="size">The module size in memory, or 0 when unknown.</param>
+					void Invalidate(ModulePointer base, size_t size);
+			};
+
+			/// <summary>
+			/// Provides the symbols of one module of a <see cref="::Hindsight::Debugger::SymbolSession"/> to an
+			/// <see cref="::Hindsight::Debugger::OfflineSymbolizer"/>. The session has to be locked by the caller like any
+			/// other use of DbgHelp.
+			/// </summary>
+			class SymbolSessionProvider : public ISymbolProvider {
+				private:
+					SymbolSession&	m_Session;	/* The session that the module is loaded into */
+					ModulePointer	m_Base;		/* The module base address */
+
+				public:
+					/// <summary>
+					/// Construct a new SymbolSessionProvider.
+					/// </summary>
+					/// <param name="session">The session that the module is loaded into, which must outlive the provider.</param>
+					/// <param name="base">The module base address.</param>
+					SymbolSessionProvider(SymbolSession& session, ModulePointer base);
+
+					/// <summary>
+					/// Look up the symbol and source line of an address in the module through the session.
+					/// </summary>
+					/// <param name="rva">The address, relative to the module base.</param>
+					/// <param name="record">A reference to the record that receives the result.</param>
+					/// <returns>true when a symbol or a source line was found.</returns>
+					bool Lookup(uint64_t rva, SymbolRecord& record) override;
+			};
+		}
+	}
+
+#endif
@@ -39,8 +39,8 @@ examples:
 	#define __str_convert(s) __str_unfold(s)
 
 	#define hindsight_version_major			0
-	#define hindsight_version_minor			6
-	#define hindsight_version_revision		2
+	#define hindsight_version_minor			8
+	#define hindsight_version_revision		0
 	#define hindsight_version_build			0
 	#define hindsight_version_year_s		"2021"
 	#define hindsight_version_appendix		"alpha"
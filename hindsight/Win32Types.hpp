@@ -0,0 +1,280 @@
+#pragma once
+
+#ifndef utilities_win32_types_h
+#define utilities_win32_types_h
+	#ifdef _WIN32
+		#include <Windows.h>
+		#include <DbgHelp.h>
+	#else
+		#include <cstdint>
+		#include <cstddef>
+
+		/// <summary>
+		/// The Win32 types that the debugger events, thread contexts and binary log entries are expressed in, for building the
+		/// portable parts of the debugger on platforms without Windows.h. Only the subset that is used is declared, with the
+		/// exact layout of the x64 Windows SDK, so that contexts and event entries written on either platform are identical.
+		/// </summary>
+
+		typedef uint8_t		BYTE;
+		typedef uint16_t	WORD;
+		typedef uint32_t	DWORD;
+		typedef int32_t		LONG;
+		typedef uint32_t	ULONG;
+		typedef int			BOOL;
+		typedef unsigned	UINT;
+		typedef uint64_t	DWORD64;
+		typedef uint64_t	ULONGLONG;
+		typedef int64_t		LONGLONG;
+		typedef size_t		SIZE_T;
+		typedef uintptr_t	ULONG_PTR;
+		typedef void*		HANDLE;
+		typedef void*		PVOID;
+		typedef void*		LPVOID;
+		typedef char*		LPSTR;
+		typedef void*		LPTHREAD_START_ROUTINE; /* only ever used as an address */
+
+		#ifndef TRUE
+		#define TRUE 1
+		#endif
+
+		#ifndef FALSE
+		#define FALSE 0
+		#endif
+
+		#define EXCEPTION_MAXIMUM_PARAMETERS		15
+
+		#define EXCEPTION_ACCESS_VIOLATION			0xC0000005
+		#define EXCEPTION_BREAKPOINT				0x80000003
+		#define EXCEPTION_SINGLE_STEP				0x80000004
+		#define EXCEPTION_ILLEGAL_INSTRUCTION		0xC000001D
+		#define EXCEPTION_INT_DIVIDE_BY_ZERO		0xC0000094
+		#define EXCEPTION_FLT_INVALID_OPERATION		0xC0000090
+		#define EXCEPTION_IN_PAGE_ERROR				0xC0000006
+		#define EXCEPTION_PRIV_INSTRUCTION			0xC0000096
+		#define EXCEPTION_STACK_OVERFLOW			0xC00000FD
+
+		#define EXCEPTION_DEBUG_EVENT				1
+		#define CREATE_THREAD_DEBUG_EVENT			2
+		#define CREATE_PROCESS_DEBUG_EVENT			3
+		#define EXIT_THREAD_DEBUG_EVENT				4
+		#define EXIT_PROCESS_DEBUG_EVENT			5
+		#define LOAD_DLL_DEBUG_EVENT				6
+		#define UNLOAD_DLL_DEBUG_EVENT				7
+		#define OUTPUT_DEBUG_STRING_EVENT			8
+		#define RIP_EVENT							9
+
+		#define CONTEXT_AMD64						0x00100000L
+		#define CONTEXT_CONTROL						(CONTEXT_AMD64 | 0x1L)
+		#define CONTEXT_INTEGER						(CONTEXT_AMD64 | 0x2L)
+		#define CONTEXT_SEGMENTS					(CONTEXT_AMD64 | 0x4L)
+		#define CONTEXT_FULL						(CONTEXT_CONTROL | CONTEXT_INTEGER)
+
+		#define WOW64_CONTEXT_i386					0x00010000L
+		#define WOW64_CONTEXT_CONTROL				(WOW64_CONTEXT_i386 | 0x1L)
+		#define WOW64_CONTEXT_INTEGER				(WOW64_CONTEXT_i386 | 0x2L)
+		#define WOW64_CONTEXT_SEGMENTS				(WOW64_CONTEXT_i386 | 0x4L)
+		#define WOW64_CONTEXT_FULL					(WOW64_CONTEXT_CONTROL | WOW64_CONTEXT_INTEGER | WOW64_CONTEXT_SEGMENTS)
+
+		typedef struct alignas(16) _M128A {
+			ULONGLONG	Low;
+			LONGLONG	High;
+		} M128A;
+
+		typedef struct alignas(16) _XMM_SAVE_AREA32 {
+			WORD	ControlWord;
+			WORD	StatusWord;
+			BYTE	TagWord;
+			BYTE	Reserved1;
+			WORD	ErrorOpcode;
+			DWORD	ErrorOffset;
+			WORD	ErrorSelector;
+			WORD	Reserved2;
+			DWORD	DataOffset;
+			WORD	DataSelector;
+			WORD	Reserved3;
+			DWORD	MxCsr;
+			DWORD	MxCsr_Mask;
+			M128A	FloatRegisters[8];
+			M128A	XmmRegisters[16];
+			BYTE	Reserved4[96];
+		} XMM_SAVE_AREA32;
+
+		typedef struct alignas(16) _CONTEXT {
+			DWORD64	P1Home;
+			DWORD64	P2Home;
+			DWORD64	P3Home;
+			DWORD64	P4Home;
+			DWORD64	P5Home;
+			DWORD64	P6Home;
+
+			DWORD	ContextFlags;
+			DWORD	MxCsr;
+
+			WORD	SegCs;
+			WORD	SegDs;
+			WORD	SegEs;
+			WORD	SegFs;
+			WORD	SegGs;
+			WORD	SegSs;
+			DWORD	EFlags;
+
+			DWORD64	Dr0;
+			DWORD64	Dr1;
+			DWORD64	Dr2;
+			DWORD64	Dr3;
+			DWORD64	Dr6;
+			DWORD64	Dr7;
+
+			DWORD64	Rax;
+			DWORD64	Rcx;
+			DWORD64	Rdx;
+			DWORD64	Rbx;
+			DWORD64	Rsp;
+			DWORD64	Rbp;
+			DWORD64	Rsi;
+			DWORD64	Rdi;
+			DWORD64	R8;
+			DWORD64	R9;
+			DWORD64	R10;
+			DWORD64	R11;
+			DWORD64	R12;
+			DWORD64	R13;
+			DWORD64	R14;
+			DWORD64	R15;
+			DWORD64	Rip;
+
+			XMM_SAVE_AREA32	FltSave;
+
+			M128A	VectorRegister[26];
+			DWORD64	VectorControl;
+
+			DWORD64	DebugControl;
+			DWORD64	LastBranchToRip;
+			DWORD64	LastBranchFromRip;
+			DWORD64	LastExceptionToRip;
+			DWORD64	LastExceptionFromRip;
+		} CONTEXT;
+
+		typedef struct _WOW64_FLOATING_SAVE_AREA {
+			DWORD	ControlWord;
+			DWORD	StatusWord;
+			DWORD	TagWord;
+			DWORD	ErrorOffset;
+			DWORD	ErrorSelector;
+			DWORD	DataOffset;
+			DWORD	DataSelector;
+			BYTE	RegisterArea[80];
+			DWORD	Cr0NpxState;
+		} WOW64_FLOATING_SAVE_AREA;
+
+		typedef struct _WOW64_CONTEXT {
+			DWORD	ContextFlags;
+
+			DWORD	Dr0;
+			DWORD	Dr1;
+			DWORD	Dr2;
+			DWORD	Dr3;
+			DWORD	Dr6;
+			DWORD	Dr7;
+
+			WOW64_FLOATING_SAVE_AREA FloatSave;
+
+			DWORD	SegGs;
+			DWORD	SegFs;
+			DWORD	SegEs;
+			DWORD	SegDs;
+
+			DWORD	Edi;
+			DWORD	Esi;
+			DWORD	Ebx;
+			DWORD	Edx;
+			DWORD	Ecx;
+			DWORD	Eax;
+
+			DWORD	Ebp;
+			DWORD	Eip;
+			DWORD	SegCs;
+			DWORD	EFlags;
+			DWORD	Esp;
+			DWORD	SegSs;
+
+			BYTE	ExtendedRegisters[512];
+		} WOW64_CONTEXT;
+
+		typedef struct _EXCEPTION_RECORD {
+			DWORD						ExceptionCode;
+			DWORD						ExceptionFlags;
+			struct _EXCEPTION_RECORD*	ExceptionRecord;
+			PVOID						ExceptionAddress;
+			DWORD						NumberParameters;
+			ULONG_PTR					ExceptionInformation[EXCEPTION_MAXIMUM_PARAMETERS];
+		} EXCEPTION_RECORD;
+
+		typedef struct _EXCEPTION_DEBUG_INFO {
+			EXCEPTION_RECORD	ExceptionRecord;
+			DWORD				dwFirstChance;
+		} EXCEPTION_DEBUG_INFO;
+
+		typedef struct _PROCESS_INFORMATION {
+			HANDLE	hProcess;
+			HANDLE	hThread;
+			DWORD	dwProcessId;
+			DWORD	dwThreadId;
+		} PROCESS_INFORMATION;
+
+		typedef struct _CREATE_PROCESS_DEBUG_INFO {
+			HANDLE					hFile;
+			HANDLE					hProcess;
+			HANDLE					hThread;
+			LPVOID					lpBaseOfImage;
+			DWORD					dwDebugInfoFileOffset;
+			DWORD					nDebugInfoSize;
+			LPVOID					lpThreadLocalBase;
+			LPTHREAD_START_ROUTINE	lpStartAddress;
+			LPVOID					lpImageName;
+			WORD					fUnicode;
+		} CREATE_PROCESS_DEBUG_INFO;
+
+		typedef struct _CREATE_THREAD_DEBUG_INFO {
+			HANDLE					hThread;
+			LPVOID					lpThreadLocalBase;
+			LPTHREAD_START_ROUTINE	lpStartAddress;
+		} CREATE_THREAD_DEBUG_INFO;
+
+		typedef struct _EXIT_PROCESS_DEBUG_INFO {
+			DWORD	dwExitCode;
+		} EXIT_PROCESS_DEBUG_INFO;
+
+		typedef struct _EXIT_THREAD_DEBUG_INFO {
+			DWORD	dwExitCode;
+		} EXIT_THREAD_DEBUG_INFO;
+
+		typedef struct _LOAD_DLL_DEBUG_INFO {
+			HANDLE	hFile;
+			LPVOID	lpBaseOfDll;
+			DWORD	dwDebugInfoFileOffset;
+			DWORD	nDebugInfoSize;
+			LPVOID	lpImageName;
+			WORD	fUnicode;
+		} LOAD_DLL_DEBUG_INFO;
+
+		typedef struct _UNLOAD_DLL_DEBUG_INFO {
+			LPVOID	lpBaseOfDll;
+		} UNLOAD_DLL_DEBUG_INFO;
+
+		typedef struct _OUTPUT_DEBUG_STRING_INFO {
+			LPSTR	lpDebugStringData;
+			WORD	fUnicode;
+			WORD	nDebugStringLength;
+		} OUTPUT_DEBUG_STRING_INFO;
+
+		typedef struct _RIP_INFO {
+			DWORD	dwError;
+			DWORD	dwType;
+		} RIP_INFO;
+
+		static_assert(sizeof(XMM_SAVE_AREA32) == 512, "XMM_SAVE_AREA32 must match the Windows SDK");
+		static_assert(sizeof(CONTEXT) == 1232, "CONTEXT must match the x64 Windows SDK");
+		static_assert(sizeof(WOW64_CONTEXT) == 716, "WOW64_CONTEXT must match the Windows SDK");
+	#endif
+#endif
@@ -2,7 +2,9 @@
 #include "BinaryLogFile.hpp"
 #include "String.hpp"
 #include "crc32.hpp"
+#include "Lz.hpp"
 #include <ctime>
+#include <chrono>
 
 using namespace Hindsight::BinaryLog;
 using namespace Hindsight::Debugger;
@@ -12,11 +14,35 @@ using namespace Hindsight::Debugger::EventHandler;
 /// Construct a new WriterDebuggerEventHandler, which will create and write to <paramref name="filepath"/>.
 /// </summary>
 /// <param name="filepath">The path to the file which will contain the logged events.</param>
-WriterDebuggerEventHandler::WriterDebuggerEventHandler(const std::string& filepath) {
+/// <param name="policy">Determines when staged events are flushed to the file.</param>
+/// <param name="flushSize">The number of staged bytes after which the staging buffer is flushed when <paramref name="policy"/> is <see cref="::Hindsight::Debugger::EventHandler::FlushPolicy::Size"/>.</param>
+/// <param name="async">When true, flushed blocks are handed to a background thread that writes them to disk, so that the debug loop never waits for file I/O.</param>
+/// <param name="compact">When true, stack traces are written as <see cref="::Hindsight::BinaryLog::CompactStackTrace"/> frames.</param>
+/// <param name="compress">When true, everything after the file header is written as independently compressed blocks, see <see cref="::Hindsight::BinaryLog::BlockHeader"/>.</param>
+WriterDebuggerEventHandler::WriterDebuggerEventHandler(const std::string& filepath, FlushPolicy policy, size_t flushSize, bool async, bool compact, bool compress)
+	: m_Crc32(0), m_Committed(0), m_FlushPolicy(policy), m_FlushSize(flushSize), m_Position(0), m_Events(0), 
+	  m_Async(async), m_Blocks(AsyncQueueSize), m_Recycled(AsyncQueueSize), m_Stopping(false), m_Compact(compact), m_Compress(compress) {
 	m_Stream.open(filepath, std::ios::binary | std::ios::out);
 
 	if (!m_Stream.is_open())
 		throw std::runtime_error("cannot open file for writing: " + filepath);
+
+	if (m_FlushPolicy == FlushPolicy::Size)
+		m_Buffer.reserve(m_FlushSize);
+}
+
+/// <summary>
+/// Flush any staged data that has not been written yet and stop the writer thread, if any.
+/// </summary>
+WriterDebuggerEventHandler::~WriterDebuggerEventHandler() {
+	// the log was not completed, end the staged events with a checkpoint so that they can be recovered
+	if (m_Committed != 0 && m_Committed == m_Buffer.size())
+		WriteCheckpoint();
+
+	if (m_Thread.joinable())
+		StopWriter();
+	else if (m_Stream.is_open())
+		Flush();
 }
 
 /// <summary>
@@ -29,22 +55,40 @@ void WriterDebuggerEventHandler::OnInitialization(
 	time_t time,
 	const std::shared_ptr<const Hindsight::Process::Process> pi) {
 
-	m_Header.ProcessId				= pi->dwProcessId;
-	m_Header.ThreadId				= pi->dwThreadId;
-	m_Header.PathLength				= pi->Path.size();
-	m_Header.WorkingDirectoryLength	= pi->WorkingDirectory.size();
-	m_Header.Arguments				= pi->Arguments.size();
-	m_Header.StartTime				= std::time(nullptr);
-	m_Header.Crc32					= 0;
+	FileHeader header;
+	header.ProcessId				= pi->dwProcessId;
+	header.ThreadId					= pi->dwThreadId;
+	header.PathLength				= pi->Path.size();
+	header.WorkingDirectoryLength	= pi->WorkingDirectory.size();
+	header.Arguments				= pi->Arguments.size();
+	header.StartTime				= std::time(nullptr);
+	header.Flags					= m_Compact ? FileFlagInternedPaths : FileFlagNone;
+
+	m_Crc32 = 0;
+
+	// a compressed file starts with its own header, the file header follows uncompressed so that its version can be checked first
+	if (m_Compress) {
+		CompressedFileHeader compressed;
+		compressed.MaxBlockSize = static_cast<uint32_t>(CompressedBlockSize);
+		m_Stream.write(reinterpret_cast<const char*>(&compressed), sizeof(CompressedFileHeader));
+	}
+
+	// write the header straight to the stream, it is written once and not part of the checksum. Then stage the path and working directory.
+	m_Stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+	m_Position = sizeof(FileHeader);
 
-	// write header, path and working directory
-	Write((const char*)&m_Header, sizeof(FileHeader), false);
 	Write(pi->Path);
 	Write(pi->WorkingDirectory);
 
 	// write each program argument, prepended with its length
 	for (const auto& argument : pi->Arguments) 
 		Write(argument, true);
+
+	// from here on the writer thread owns the output stream, until it is stopped
+	if (m_Async)
+		m_Thread = std::thread(&WriterDebuggerEventHandler::Drain, this);
+
+	Commit();
 }
 
 /// <summary>
@@ -67,6 +111,8 @@ void WriterDebuggerEventHandler::OnBreakpointHit(
 	// Write this exception event, but only indicate if it is a breakpoint or not.
 	// Both the exception and breakpoint event are exception events.
 	Write(info, pi, context, trace, collection, nullptr, true);
+
+	Commit();
 }
 
 /// <summary>
@@ -96,6 +142,8 @@ void WriterDebuggerEventHandler::OnException(
 	// Write this exception event, but only indicate if it is a breakpoint or not.
 	// Both the exception and breakpoint event are exception events.
 	Write(info, pi, context, trace, collection, ertti, false);
+
+	Commit();
 }
 
 /// <summary>
@@ -117,11 +165,21 @@ void WriterDebuggerEventHandler::OnCreateProcess(
 	auto module = collection.GetModuleAtAddress(info.lpBaseOfImage);
 
 	// Create an EventEntry for this event 
-	CreateProcessEventEntry createProcessEventEntry(pi, path, reinterpret_cast<uint64_t>(module->Base), module->Size);
+	CreateProcessEventEntry createProcessEventEntry(pi, path, reinterpret_cast<uint64_t>(info.lpBaseOfImage), module != nullptr ? module->Size : 0);
+
+	// Write the EventEntry for this event and append the path to it, or refer to the path in the string table.
+	if (m_Compact) {
+		createProcessEventEntry.PathLength = m_Encoder.Intern(path);
+		WriteStrings();
+	}
 
-	// Write the EventEntry for this event and append the path to it.
+	Index(createProcessEventEntry);
 	Write(createProcessEventEntry);
-	Write(path);
+	if (!m_Compact)
+		Write(path);
+	WriteIdentity(path, collection);
+
+	Commit();
 }
 
 /// <summary>
@@ -152,7 +210,10 @@ void WriterDebuggerEventHandler::OnCreateThread(
 	}
 
 	// Write the event
+	Index(createThreadEventEntry);
 	Write(createThreadEventEntry);
+
+	Commit();
 }
 
 /// <summary>
@@ -171,7 +232,10 @@ void WriterDebuggerEventHandler::OnExitProcess(
 	// Create an EventEntry for this event and write it
 	ExitProcessEventEntry exitProcessEventEntry(pi, info.dwExitCode);
 
+	Index(exitProcessEventEntry);
 	Write(exitProcessEventEntry);
+
+	Commit();
 }
 
 /// <summary>
@@ -190,7 +254,10 @@ void WriterDebuggerEventHandler::OnExitThread(
 	// Create an EventEntry for this event and write it
 	ExitThreadEventEntry exitProcessEventEntry(pi, info.dwExitCode);
 
+	Index(exitProcessEventEntry);
 	Write(exitProcessEventEntry);
+
+	Commit();
 }
 
 /// <summary>
@@ -219,9 +286,19 @@ void WriterDebuggerEventHandler::OnDllLoad(
 	// Create an EventEntry for this event 
 	DllLoadEventEntry dllLoadEventEntry(pi, moduleIndex, reinterpret_cast<uint64_t>(info.lpBaseOfDll), moduleSize, path.size());
 
-	// Write the EventEntry and append the module path
+	// Write the EventEntry and append the module path, or refer to the path in the string table.
+	if (m_Compact) {
+		dllLoadEventEntry.ModulePathSize = m_Encoder.Intern(path);
+		WriteStrings();
+	}
+
+	Index(dllLoadEventEntry);
 	Write(dllLoadEventEntry);
-	Write(path);
+	if (!m_Compact)
+		Write(path);
+	WriteIdentity(path, collection);
+
+	Commit();
 }
 
 /// <summary>
@@ -241,8 +318,11 @@ void WriterDebuggerEventHandler::OnDebugString(
 	DebugStringEventEntry debugStringEventEntry(pi, false, string.size());
 
 	// Write the EventEntry and debug string
+	Index(debugStringEventEntry);
 	Write(debugStringEventEntry);
 	Write(string);
+
+	Commit();
 }
 
 /// <summary>
@@ -262,8 +342,11 @@ void WriterDebuggerEventHandler::OnDebugStringW(
 	DebugStringEventEntry debugStringEventEntry(pi, true, string.size());
 
 	// Write the EventEntry and debug string
+	Index(debugStringEventEntry);
 	Write(debugStringEventEntry);
 	Write(string);
+
+	Commit();
 }
 
 /// <summary>
@@ -281,7 +364,10 @@ void WriterDebuggerEventHandler::OnRip(
 
 	// Create an EventEntry for this event and write it
 	RipEventEntry ripEventEntry(pi, info.dwType, info.dwError);
+	Index(ripEventEntry);
 	Write(ripEventEntry);
+
+	Commit();
 }
 
 /// <summary>
@@ -310,11 +396,15 @@ void WriterDebuggerEventHandler::OnDllUnload(
 
 	// Create an EventEntry for this event and write it
 	DllUnloadEventEntry dllUnloadEventEntry(pi, reinterpret_cast<uint64_t>(info.lpBaseOfDll));
+	Index(dllUnloadEventEntry);
 	Write(dllUnloadEventEntry);
+
+	Commit();
 }
 
 /// <summary>
-/// Finalize the binary logging, which will seek back to the header and overwrite it with the updated Crc32 checksum.
+/// Finalize the binary logging, which will append a last checkpoint, the event index and the file footer with the 
+/// checksum of all data after the header.
 /// </summary>
 /// <param name="time">The time of the event.</param>
 /// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
@@ -322,10 +412,24 @@ void WriterDebuggerEventHandler::OnModuleCollectionComplete(
 	time_t time, 
 	const ModuleCollection& collection) {
 
-	// finalize by overwriting the header as the checksum member is now complete
-	m_Stream.seekp(0, std::ios::beg);
-	Write(m_Header);
-	m_Stream.seekp(0, std::ios::end);
+	// end the events with a checkpoint and append the index of all events, followed by the file footer that holds the 
+	// checksum of everything before it. Then write everything that is still staged and wait for the writer thread to write it.
+	FileFooter footer(m_Events, 0);
+
+	WriteCheckpoint();
+	WriteIndex();
+	UpdateChecksum();
+
+	footer.Crc32 = m_Crc32;
+	Write(footer);
+	m_Committed = m_Buffer.size();
+
+	if (m_Thread.joinable())
+		StopWriter();
+	else
+		Flush();
+
+	m_Stream.flush();
 }
 
 /// <summary>
@@ -352,7 +456,13 @@ void WriterDebuggerEventHandler::Write(const std::wstring& s, bool writeLength)
 		Write(reinterpret_cast<const char*>(&size), sizeof(uint32_t));
 	}
 
+#ifdef _WIN32
 	Write((const char*)s.c_str(), s.size() * sizeof(wchar_t));
+#else
+	// the log stores UTF-16 code units, which wchar_t only is on Windows
+	auto units = Hindsight::Utilities::String::ToUtf16(s);
+	Write(reinterpret_cast<const char*>(units.data()), units.size() * sizeof(char16_t));
+#endif
 }
 
 /// <summary>
@@ -373,16 +483,240 @@ void WriterDebuggerEventHandler::Write(const std::string& s, bool writeLength) {
 }
 
 /// <summary>
-/// Write an arbitrarily sized block of data to the output stream and optionally update the internal checksum of
-/// all the written data.
+/// Stage an arbitrarily sized block of data, it becomes part of the checksum and the output stream once 
+/// the event it belongs to is committed.
 /// </summary>
 /// <param name="data">A pointer to <paramref name="size"/> bytes of memory to write.</param>
 /// <param name="size">The amount of bytes to write.</param>
-/// <param name="updateChecksum">When set to true, the internal checksum will be updated.</param>
-void WriterDebuggerEventHandler::Write(const char* data, size_t size, bool updateChecksum) {
-	m_Stream.write(data, size);
-	if (updateChecksum)
-		m_Header.Crc32 = Hindsight::Checksum::Crc32::Update(data, size, m_Header.Crc32);
+void WriterDebuggerEventHandler::Write(const char* data, size_t size) {
+	m_Buffer.insert(m_Buffer.end(), data, data + size);
+	m_Position += size;
+}
+
+/// <summary>
+/// Add an entry to the index for the event entry <paramref name="entry"/>, which is about to be written at the current position.
+/// </summary>
+/// <param name="entry">The event entry that is about to be written.</param>
+/// <param name="flags">A combination of <see cref="::Hindsight::BinaryLog::IndexEntryFlags"/> describing the event.</param>
+void WriterDebuggerEventHandler::Index(const EventEntry& entry, int flags) {
+	IndexEntry index;
+	index.Offset   = m_Position;
+	index.Time     = entry.Time;
+	index.EventId  = entry.EventId;
+	index.ThreadId = entry.ProcessInformation.dwThreadId;
+	index.Flags    = static_cast<uint8_t>(flags);
+	m_Index.push_back(index);
+
+	++m_Events;
+}
+
+/// <summary>
+/// Write the strings that were added to the string table since the previous call as a <see cref="::Hindsight::BinaryLog::StringTableEntry"/> 
+/// frame and add it to the index, when there are any. This is called before the event that refers to them is written.
+/// </summary>
+void WriterDebuggerEventHandler::WriteStrings() {
+	const auto& pending = m_Encoder.Pending();
+	if (pending.empty())
+		return;
+
+	m_Table.Clear();
+	for (const auto& s : pending)
+		m_Table.Raw(s.data(), s.size());
+
+	IndexEntry index;
+	index.Offset = m_Position;
+	index.Flags  = IndexFlagStrings;
+	m_Index.push_back(index);
+
+	StringTableEntry entry(m_Encoder.FirstPending(), static_cast<uint32_t>(pending.size()), static_cast<uint32_t>(m_Table.data().size()));
+
+	Write(entry);
+	Write(m_Table.data().data(), m_Table.data().size());
+
+	m_Encoder.ClearPending();
+}
+
+/// <summary>
+/// Write the index of all events that were written, followed by the index footer that allows a reader to find the index.
+/// </summary>
+void WriterDebuggerEventHandler::WriteIndex() {
+	IndexHeader header;
+	IndexFooter footer;
+
+	header.Count       = m_Index.size();
+	footer.IndexOffset = m_Position;
+
+	Write(header);
+	if (!m_Index.empty())
+		Write(reinterpret_cast<const char*>(m_Index.data()), m_Index.size() * sizeof(IndexEntry));
+	Write(footer);
+
+	m_Index.clear();
+}
+
+/// <summary>
+/// Commit the event that was staged since the previous commit, which updates the internal checksum with all 
+/// of its data at once and flushes the staging buffer when the flush policy requires it. Every flushed block 
+/// ends with a checkpoint, so that all data on disk can be verified even when the log is never completed.
+/// </summary>
+/// <param name="checkpoint">When false, no checkpoint is written before flushing.</param>
+void WriterDebuggerEventHandler::Commit(bool checkpoint) {
+	UpdateChecksum();
+
+	bool flush = false;
+	switch (m_FlushPolicy) {
+		case FlushPolicy::Event:
+			flush = true;
+			break;
+		case FlushPolicy::Size:
+			flush = m_Buffer.size() >= m_FlushSize;
+			break;
+		case FlushPolicy::Exit:
+			break;
+	}
+
+	if (!flush)
+		return;
+
+	if (checkpoint)
+		WriteCheckpoint();
+
+	Flush();
+}
+
+/// <summary>
+/// Update the internal checksum with all data that was staged since the previous update.
+/// </summary>
+void WriterDebuggerEventHandler::UpdateChecksum() {
+	if (m_Buffer.size() > m_Committed) {
+		m_Crc32 = Hindsight::Checksum::Crc32::Update(m_Buffer.data() + m_Committed, m_Buffer.size() - m_Committed, m_Crc32);
+		m_Committed = m_Buffer.size();
+	}
+}
+
+/// <summary>
+/// Stage a checkpoint with the number of events and the checksum of all data written so far, and add it to the checksum.
+/// </summary>
+void WriterDebuggerEventHandler::WriteCheckpoint() {
+	CheckpointEntry checkpoint(m_Events, m_Crc32);
+
+	Write(checkpoint);
+	UpdateChecksum();
+}
+
+/// <summary>
+/// Write all staged data to the output stream and empty the staging buffer.
+/// </summary>
+void WriterDebuggerEventHandler::Flush() {
+	if (m_Buffer.empty()) {
+		if (!m_Thread.joinable())
+			m_Stream.flush();
+		return;
+	}
+
+	if (m_Thread.joinable()) {
+		// the writer thread is behind, wait for a free slot rather than growing without bounds
+		while (!m_Blocks.TryPush(std::move(m_Buffer)))
+			std::this_thread::yield();
+
+		// reuse the memory of a block that was already written, if any
+		if (!m_Recycled.TryPop(m_Buffer))
+			m_Buffer = std::vector<char>();
+
+		m_Buffer.clear();
+	} else {
+		WriteBlock(m_Buffer);
+		m_Buffer.clear();
+	}
+
+	m_Committed = 0;
+}
+
+/// <summary>
+/// Write a block of data to the output stream, this is called from the writer thread in asynchronous mode and 
+/// from the debugger thread otherwise.
+/// </summary>
+/// <param name="block">The block to write.</param>
+void WriterDebuggerEventHandler::WriteBlock(const std::vector<char>& block) {
+	if (m_Compress) {
+		WriteCompressed(block);
+	} else {
+		m_Stream.write(block.data(), block.size());
+	}
+
+	if (m_FlushPolicy != FlushPolicy::Exit)
+		m_Stream.flush();
+}
+
+/// <summary>
+/// Compress a block of data and write it to the output stream as one or more blocks of at most <see cref="CompressedBlockSize"/> bytes, 
+/// each preceeded by a <see cref="::Hindsight::BinaryLog::BlockHeader"/>. Data that does not compress is stored as-is.
+/// </summary>
+/// <param name="block">The block to write.</param>
+void WriterDebuggerEventHandler::WriteCompressed(const std::vector<char>& block) {
+	for (size_t offset = 0; offset < block.size(); offset += CompressedBlockSize) {
+		auto data = block.data() + offset;
+		auto size = block.size() - offset < CompressedBlockSize ? block.size() - offset : CompressedBlockSize;
+
+		BlockHeader header;
+		header.RawSize = static_cast<uint32_t>(size);
+
+		m_Compressed.clear();
+		if (Hindsight::Utilities::Lz::Compress(data, size, m_Compressed) < size) {
+			header.Method = BlockLz;
+			data		  = m_Compressed.data();
+			size		  = m_Compressed.size();
+		}
+
+		header.StoredSize = static_cast<uint32_t>(size);
+		header.Crc32	  = Hindsight::Checksum::Crc32::Update(data, size, 0);
+
+		m_Stream.write(reinterpret_cast<const char*>(&header), sizeof(BlockHeader));
+		m_Stream.write(data, size);
+	}
+}
+
+/// <summary>
+/// The writer thread procedure, which writes all blocks in <see cref="m_Blocks"/> to the output stream until it 
+/// is signaled to stop and no blocks remain.
+/// </summary>
+void WriterDebuggerEventHandler::Drain() {
+	std::vector<char> block;
+	size_t idle = 0;
+
+	while (true) {
+		if (m_Blocks.TryPop(block)) {
+			WriteBlock(block);
+			block.clear();
+			m_Recycled.TryPush(std::move(block));
+			idle = 0;
+			continue;
+		}
+
+		// the producer pushes its last block before signaling, so an empty ring after the signal means we are done
+		if (m_Stopping.load(std::memory_order_acquire)) {
+			if (m_Blocks.Empty())
+				break;
+			continue;
+		}
+
+		// back off while there is nothing to write, without blocking the debugger thread
+		if (++idle < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	m_Stream.flush();
+}
+
+/// <summary>
+/// Hand all remaining blocks to the writer thread, signal it to stop and wait for it to finish.
+/// </summary>
+void WriterDebuggerEventHandler::StopWriter() {
+	Flush();
+	m_Stopping.store(true, std::memory_order_release);
+	m_Thread.join();
 }
 
 /// <summary>
@@ -428,7 +762,14 @@ void WriterDebuggerEventHandler::Write(
 		event.EventOffset = 0;
 	}
 
+	// A compact trace is encoded first, so that the strings it adds to the string table are written before the event
+	if (m_Compact) {
+		Encode(trace, collection);
+		WriteStrings();
+	}
+
 	// Write the EventEntry, rtti, thread context and stack trace
+	Index(event, (isBreak ? IndexFlagBreakpoint : IndexFlagNone) | (info.dwFirstChance ? IndexFlagFirstChance : IndexFlagNone));
 	Write(event);
 
 	// RTTI
@@ -458,6 +799,22 @@ void WriterDebuggerEventHandler::Write(
 
 	Write(context);
 	Write(trace, collection);
+	WriteStack(context);
+}
+
+/// <summary>
+/// Write the stack snapshot of a thread context as a <see cref="::Hindsight::BinaryLog::StackMemoryEntry"/> frame, when one was captured.
+/// </summary>
+/// <param name="context">A shared pointer to a <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
+void WriterDebuggerEventHandler::WriteStack(std::shared_ptr<const DebugContext> context) {
+	const auto& stack = context->GetStack();
+	if (stack.empty())
+		return;
+
+	StackMemoryEntry entry(context->GetStackAddress(), stack.size());
+
+	Write(entry);
+	Write(reinterpret_cast<const char*>(stack.data()), stack.size());
 }
 
 /// <summary>
@@ -482,6 +839,11 @@ void WriterDebuggerEventHandler::Write(
 	std::shared_ptr<const DebugStackTrace> trace,
 	const ModuleCollection& collection) {
 
+	if (m_Compact) {
+		WriteCompact();
+		return;
+	}
+
 	// Create a StackTrace instance which will serve as the header for that frame, and write it.
 	StackTrace stackTrace(trace->GetMaxRecursion(), trace->GetMaxInstructions(), trace->size());
 
@@ -530,4 +892,80 @@ void WriterDebuggerEventHandler::Write(
 			Write(instr.Operands);
 		}
 	}
+}
+
+/// <summary>
+/// Encode a stack trace for a <see cref="::Hindsight::BinaryLog::CompactStackTrace"/> frame, which adds its new strings to the string table.
+/// </summary>
+/// <param name="trace">A shared pointer to a <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance.</param>
+/// <param name="collection">A const reference to a <see cref="Hindsight::Debugger::ModuleCollection"/> instance containing information about loaded modules.</param>
+void WriterDebuggerEventHandler::Encode(
+	std::shared_ptr<const DebugStackTrace> trace,
+	const ModuleCollection& collection) {
+
+	m_Encoder.Clear();
+	m_Encoder.Unsigned(trace->GetMaxRecursion());
+	m_Encoder.Unsigned(trace->GetMaxInstructions());
+	m_Encoder.Unsigned(trace->size());
+
+	for (const auto& entry : trace->list()) {
+		auto base	 = reinterpret_cast<uint64_t>(entry.Module.Base);
+		auto address = reinterpret_cast<uint64_t>(entry.Address);
+
+		// the program counter is relative to its module, the other addresses are close to the program counter
+		m_Encoder.Signed(entry.Module.Base != 0 && !entry.Module.Path.empty() ? collection.GetIndex(entry.Module.Path) : 0);
+		m_Encoder.Unsigned(base);
+		m_Encoder.Signed(static_cast<int64_t>(address - base));
+		m_Encoder.Relative(reinterpret_cast<uint64_t>(entry.AbsoluteAddress), address);
+		m_Encoder.Relative(reinterpret_cast<uint64_t>(entry.AbsoluteLineAddress), address);
+		m_Encoder.Relative(reinterpret_cast<uint64_t>(entry.LineAddress), address);
+
+		m_Encoder.Interned(entry.Name);
+		m_Encoder.Interned(entry.File);
+		m_Encoder.Unsigned(entry.Line);
+		m_Encoder.Unsigned(entry.Recursion);
+		m_Encoder.Unsigned(entry.RecursionCount);
+		m_Encoder.Unsigned(entry.Instructions.size());
+
+		// each instruction offset is relative to the one before it, the hexadecimal bytes are rarely repeated
+		auto previous = address;
+		for (const auto& instr : entry.Instructions) {
+			m_Encoder.Unsigned(instr.Is64BitAddress);
+			m_Encoder.Signed(static_cast<int64_t>(instr.Offset - previous));
+			m_Encoder.Unsigned(instr.Size);
+			m_Encoder.Raw(instr.InstructionHex.data(), instr.InstructionHex.size());
+			m_Encoder.Interned(instr.InstructionMnemonic);
+			m_Encoder.Interned(instr.Operands);
+
+			previous = instr.Offset;
+		}
+	}
+}
+
+/// <summary>
+/// Write the stack trace that was encoded last by <see cref="Encode"/> as a <see cref="::Hindsight::BinaryLog::CompactStackTrace"/> frame.
+/// </summary>
+void WriterDebuggerEventHandler::WriteCompact() {
+	// Write the header with the size of the encoded trace, followed by the encoded trace
+	CompactStackTrace stackTrace(static_cast<uint32_t>(m_Encoder.data().size()));
+
+	Write(stackTrace);
+	Write(m_Encoder.data().data(), m_Encoder.data().size());
+}
+
+/// <summary>
+/// Write the identity of the module at <paramref name="path"/> as a <see cref="::Hindsight::BinaryLog::ModuleIdentityEntry"/> 
+/// frame, when the debugger read it. This directly follows the path of a create process or DLL load event.
+/// </summary>
+/// <param name="path">The module path.</param>
+/// <param name="collection">A const reference to a <see cref="Hindsight::Debugger::ModuleCollection"/> instance containing information about loaded modules.</param>
+void WriterDebuggerEventHandler::WriteIdentity(const std::wstring& path, const ModuleCollection& collection) {
+	auto identity = collection.GetIdentity(path);
+	if (identity == nullptr)
+		return;
+
+	ModuleIdentityEntry entry(*identity);
+
+	Write(entry);
+	Write(identity->PdbPath);
 }
\ No newline at end of file
@@ -4,12 +4,27 @@
 #define writer_debugger_event_handler_h
 	#include "IDebuggerEventHandler.hpp"
 	#include "BinaryLogFile.hpp"
+	#include "SpscRing.hpp"
 	#include <fstream>
+	#include <vector>
+	#include <thread>
+	#include <atomic>
 	#include <type_traits>
 
 	namespace Hindsight {
 		namespace Debugger {
 			namespace EventHandler {
+				/// <summary>
+				/// Describes when the staged data of a <see cref="::Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler"/> is 
+				/// flushed to the binary log file. Flushing more often makes the log more likely to survive a crash of hindsight itself, 
+				/// at the cost of more (and smaller) writes.
+				/// </summary>
+				enum class FlushPolicy {
+					Event,	/* flush after each event */
+					Size,	/* flush when the staged data exceeds the flush size */
+					Exit	/* only flush when the module collection is complete (or the writer is destroyed) */
+				};
+
 				/// <summary>
 				/// An implementation of <see cref="::Hindsight::Debugger::EventHandler::IDebuggerEventHandler"/> that writes 
 				/// all relevant details of each debug event to a binary log file, which can later be converted to a textual 
@@ -19,14 +34,61 @@
 				class WriterDebuggerEventHandler : public IDebuggerEventHandler {
 					private:
 						std::ofstream m_Stream;							/* The binary output stream */
-						Hindsight::BinaryLog::FileHeader m_Header;		/* The file header, the instance is kept to update the checksum at the end */
+						uint32_t		  m_Crc32;						/* The checksum of all committed data after the file header */
+
+						std::vector<char> m_Buffer;						/* The staging buffer, events are serialized here before being flushed to the stream */
+						size_t			  m_Committed;					/* The number of bytes in the staging buffer that are part of the checksum */
+						FlushPolicy		  m_FlushPolicy;				/* Determines when the staging buffer is flushed */
+						size_t			  m_FlushSize;					/* The staging buffer size that triggers a flush with FlushPolicy::Size */
+						uint64_t		  m_Position;					/* The offset in the file of the next byte that is written */
+
+						std::vector<Hindsight::BinaryLog::IndexEntry> m_Index;	/* The index of all event and string table entries written so far */
+						uint64_t		  m_Events;						/* The number of event entries written so far */
+
+						bool										m_Async;		/* True when flushed blocks are written by a background thread */
+						Hindsight::Utilities::SpscRing<std::vector<char>>	m_Blocks;		/* Flushed blocks on their way to the writer thread */
+						Hindsight::Utilities::SpscRing<std::vector<char>>	m_Recycled;		/* Written blocks on their way back, so that their memory is reused */
+						std::thread									m_Thread;		/* The writer thread in asynchronous mode */
+						std::atomic<bool>							m_Stopping;		/* Signals the writer thread to stop after writing all remaining blocks */
+
+						bool								m_Compact;	/* True when stack traces are written as STK2 frames */
+						Hindsight::BinaryLog::CompactEncoder	m_Encoder;	/* Encodes STK2 frames and holds the string table of the file */
+						Hindsight::BinaryLog::CompactEncoder	m_Table;	/* Encodes STRS frames, kept to reuse its memory */
+
+						bool				m_Compress;		/* True when the file is written as independently compressed blocks */
+						std::vector<char>	m_Compressed;	/* The compressed data of a block, kept to reuse its memory */
 
 					public:
+						/// <summary>
+						/// The default number of staged bytes after which the staging buffer is flushed with <see cref="::Hindsight::Debugger::EventHandler::FlushPolicy::Size"/>.
+						/// </summary>
+						static const size_t DefaultFlushSize = 64 * 1024;
+
+						/// <summary>
+						/// The number of flushed blocks that can be queued for the writer thread in asynchronous mode.
+						/// </summary>
+						static const size_t AsyncQueueSize = 256;
+
+						/// <summary>
+						/// The maximum size of the data in one compressed block, larger flushes are split into multiple blocks.
+						/// </summary>
+						static const size_t CompressedBlockSize = 1024 * 1024;
+
 						/// <summary>
 						/// Construct a new WriterDebuggerEventHandler, which will create and write to <paramref name="filepath"/>.
 						/// </summary>
 						/// <param name="filepath">The path to the file which will contain the logged events.</param>
-						WriterDebuggerEventHandler(const std::string& filepath);
+						/// <param name="policy">Determines when staged events are flushed to the file.</param>
+						/// <param name="flushSize">The number of staged bytes after which the staging buffer is flushed when <paramref name="policy"/> is <see cref="::Hindsight::Debugger::EventHandler::FlushPolicy::Size"/>.</param>
+						/// <param name="async">When true, flushed blocks are handed to a background thread that writes them to disk, so that the debug loop never waits for file I/O.</param>
+						/// <param name="compact">When true, stack traces are written as <see cref="::Hindsight::BinaryLog::CompactStackTrace"/> frames and module paths through the string table of the file.</param>
+						/// <param name="compress">When true, everything after the file header is written as independently compressed blocks, see <see cref="::Hindsight::BinaryLog::BlockHeader"/>.</param>
+						WriterDebuggerEventHandler(const std::string& filepath, FlushPolicy policy = FlushPolicy::Size, size_t flushSize = DefaultFlushSize, bool async = false, bool compact = false, bool compress = false);
+
+						/// <summary>
+						/// Flush any staged data that has not been written yet and stop the writer thread, if any.
+						/// </summary>
+						~WriterDebuggerEventHandler();
 
 						/// <summary>
 						/// Write the initial data to the binary log file, such as the file header. It will also write 
@@ -214,7 +276,8 @@
 							const ModuleCollection& collection) override;
 
 						/// <summary>
-						/// Finalize the binary logging, which will seek back to the header and overwrite it with the updated Crc32 checksum.
+						/// Finalize the binary logging, which will append a last checkpoint, the event index and the file footer with the 
+						/// checksum of all data after the header.
 						/// </summary>
 						/// <param name="time">The time of the event.</param>
 						/// <param name="collection">A const reference to the <see cref="::Hindsight::Debugger::ModuleCollection"/> of currently loaded modules at the time of the event.</param>
@@ -247,13 +310,79 @@
 						void Write(const std::string& s, bool writeLength = false);
 
 						/// <summary>
-						/// Write an arbitrarily sized block of data to the output stream and optionally update the internal checksum of
-						/// all the written data.
+						/// Stage an arbitrarily sized block of data, it becomes part of the checksum and the output stream once 
+						/// the event it belongs to is committed.
 						/// </summary>
 						/// <param name="data">A pointer to <paramref name="size"/> bytes of memory to write.</param>
 						/// <param name="size">The amount of bytes to write.</param>
-						/// <param name="updateChecksum">When set to true, the internal checksum will be updated.</param>
-						void Write(const char* data, size_t size, bool updateChecksum = true);
+						void Write(const char* data, size_t size);
+
+						/// <summary>
+						/// Add an entry to the index for the event entry <paramref name="entry"/>, which is about to be written at the current position.
+						/// </summary>
+						/// <param name="entry">The event entry that is about to be written.</param>
+						/// <param name="flags">A combination of <see cref="::Hindsight::BinaryLog::IndexEntryFlags"/> describing the event.</param>
+						void Index(const Hindsight::BinaryLog::EventEntry& entry, int flags = Hindsight::BinaryLog::IndexFlagNone);
+
+						/// <summary>
+						/// Write the strings that were added to the string table since the previous call as a <see cref="::Hindsight::BinaryLog::StringTableEntry"/> 
+						/// frame and add it to the index, when there are any. This is called before the event that refers to them is written.
+						/// </summary>
+						void WriteStrings();
+
+						/// <summary>
+						/// Write the index of all events that were written, followed by the index footer that allows a reader to find the index.
+						/// </summary>
+						void WriteIndex();
+
+						/// <summary>
+						/// Commit the event that was staged since the previous commit, which updates the internal checksum with all 
+						/// of its data at once and flushes the staging buffer when the flush policy requires it. Every flushed block 
+						/// ends with a checkpoint, so that all data on disk can be verified even when the log is never completed.
+						/// </summary>
+						/// <param name="checkpoint">When false, no checkpoint is written before flushing.</param>
+						void Commit(bool checkpoint = true);
+
+						/// <summary>
+						/// Update the internal checksum with all data that was staged since the previous update.
+						/// </summary>
+						void UpdateChecksum();
+
+						/// <summary>
+						/// Stage a checkpoint with the number of events and the checksum of all data written so far, and add it to the checksum.
+						/// </summary>
+						void WriteCheckpoint();
+
+						/// <summary>
+						/// Write all staged data to the output stream and empty the staging buffer. In asynchronous mode the staged 
+						/// data is handed to the writer thread instead.
+						/// </summary>
+						void Flush();
+
+						/// <summary>
+						/// Write a block of data to the output stream, this is called from the writer thread in asynchronous mode and 
+						/// from the debugger thread otherwise.
+						/// </summary>
+						/// <param name="block">The block to write.</param>
+						void WriteBlock(const std::vector<char>& block);
+
+						/// <summary>
+						/// Compress a block of data and write it to the output stream as one or more blocks of at most <see cref="CompressedBlockSize"/> bytes, 
+						/// each preceeded by a <see cref="::Hindsight::BinaryLog::BlockHeader"/>. Data that does not compress is stored as-is.
+						/// </summary>
+						/// <param name="block">The block to write.</param>
+						void WriteCompressed(const std::vector<char>& block);
+
+						/// <summary>
+						/// The writer thread procedure, which writes all blocks in <see cref="m_Blocks"/> to the output stream until it 
+						/// is signaled to stop and no blocks remain.
+						/// </summary>
+						void Drain();
+
+						/// <summary>
+						/// Hand all remaining blocks to the writer thread, signal it to stop and wait for it to finish.
+						/// </summary>
+						void StopWriter();
 
 						/// <summary>
 						/// Write an exception event, this function is defined because both breakpoints and exceptions are written in the 
@@ -283,6 +412,12 @@
 						/// <param name="context">A shared pointer to a <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
 						void Write(std::shared_ptr<const DebugContext> context);
 
+						/// <summary>
+						/// Write the stack snapshot of a thread context as a <see cref="::Hindsight::BinaryLog::StackMemoryEntry"/> frame, when one was captured.
+						/// </summary>
+						/// <param name="context">A shared pointer to a <see cref="::Hindsight::Debugger::DebugContext"/> instance.</param>
+						void WriteStack(std::shared_ptr<const DebugContext> context);
+
 						/// <summary>
 						/// Write a stack trace to the output stream, starting from an exception address.
 						/// </summary>
@@ -291,6 +426,28 @@
 						void Write(
 							std::shared_ptr<const DebugStackTrace> trace,
 							const ModuleCollection& collection);
+
+						/// <summary>
+						/// Encode a stack trace for a <see cref="::Hindsight::BinaryLog::CompactStackTrace"/> frame, which adds its new strings to the string table.
+						/// </summary>
+						/// <param name="trace">A shared pointer to a <see cref="::Hindsight::Debugger::DebugStackTrace"/> instance.</param>
+						/// <param name="collection">A const reference to a <see cref="Hindsight::Debugger::ModuleCollection"/> instance containing information about loaded modules.</param>
+						void Encode(
+							std::shared_ptr<const DebugStackTrace> trace,
+							const ModuleCollection& collection);
+
+						/// <summary>
+						/// Write the stack trace that was encoded last by <see cref="Encode"/> as a <see cref="::Hindsight::BinaryLog::CompactStackTrace"/> frame.
+						/// </summary>
+						void WriteCompact();
+
+						/// <summary>
+						/// Write the identity of the module at <paramref name="path"/> as a <see cref="::Hindsight::BinaryLog::ModuleIdentityEntry"/> 
+						/// frame, when the debugger read it. This directly follows the path of a create process or DLL load event.
+						/// </summary>
+						/// <param name="path">The module path.</param>
+						/// <param name="collection">A const reference to a <see cref="Hindsight::Debugger::ModuleCollection"/> instance containing information about loaded modules.</param>
+						void WriteIdentity(const std::wstring& path, const ModuleCollection& collection);
 				};
 
 			}
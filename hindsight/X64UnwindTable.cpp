@@ -0,0 +1,511 @@
+#include "X64UnwindTable.hpp"
+#include "CachingMemoryReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Hindsight::Debugger;
+
+static const uint16_t machine_amd64			= 0x8664;
+static const uint16_t optional_pe32_plus	= 0x20b;
+static const uint8_t flag_chain_info		= 0x4;
+static const size_t max_chain				= 32;
+static const size_t epilog_code_size		= 32;
+static const uint32_t no_info				= UINT32_MAX;
+
+static const uint8_t op_push_nonvol			= 0;
+static const uint8_t op_alloc_large			= 1;
+static const uint8_t op_alloc_small			= 2;
+static const uint8_t op_set_fpreg			= 3;
+static const uint8_t op_save_nonvol			= 4;
+static const uint8_t op_save_nonvol_far		= 5;
+static const uint8_t op_epilog				= 6;
+static const uint8_t op_save_xmm128			= 8;
+static const uint8_t op_save_xmm128_far		= 9;
+static const uint8_t op_push_machframe		= 10;
+
+/// <summary>
+/// Get the number of slots that an unwind code takes up, including the slots of its operand.
+/// </summary>
+/// <param name="code">The first slot of the unwind code.</param>
+/// <returns>The number of slots.</returns>
+static size_t code_slots(uint16_t code) {
+	auto op = static_cast<uint8_t>((code >> 8) & 0xf);
+
+	switch (op) {
+		case op_alloc_large:
+			return (code >> 12) != 0 ? 3 : 2;
+		case op_save_nonvol:
+		case op_save_xmm128:
+		case op_epilog:
+			return 2;
+		case op_save_nonvol_far:
+		case op_save_xmm128_far:
+			return 3;
+		default:
+			return 1;
+	}
+}
+
+/// <summary>
+/// Read a 64-bit value from the process.
+/// </summary>
+/// <param name="memory">The memory of the process.</param>
+/// <param name="address">The address of the value.</param>
+/// <param name="value">A reference to the value that receives the result.</param>
+/// <returns>true when the whole value was read.</returns>
+static bool read_qword(const Backend::IMemoryReader& memory, uint64_t address, uint64_t& value) {
+	return memory.Read(address, &value, sizeof(value)) == sizeof(value);
+}
+
+/// <summary>
+/// Read a little-endian 32-bit value from a code buffer.
+/// </summary>
+/// <param name="code">The code buffer.</param>
+/// <returns>The value, sign extended.</returns>
+static int64_t code_int32(const uint8_t* code) {
+	int32_t value;
+	std::memcpy(&value, code, sizeof(value));
+	return value;
+}
+
+/// <summary>
+/// Read the unwind information of an x64 image that is mapped at <paramref name="base"/>.
+/// </summary>
+/// <param name="memory">The memory of the process that mapped the image.</param>
+/// <param name="base">The base address of the image.</param>
+/// <param name="table">A reference to the table that receives the result.</param>
+/// <returns>false when the headers cannot be read, or are not those of an x64 PE image with an exception directory.</returns>
+bool X64UnwindTable::Read(const Backend::IMemoryReader& memory, uint64_t base, X64UnwindTable& table) {
+	Backend::CachingMemoryReader reader(memory, 4);
+
+	uint16_t dosMagic = 0, machine = 0, magic = 0;
+	uint32_t offset = 0, signature = 0, directories = 0, address = 0, size = 0;
+
+	// the DOS header points to the NT headers, the optional header follows the file header
+	if (!reader.Read(base, dosMagic) || dosMagic != 0x5a4d || !reader.Read(base + 0x3c, offset))
+		return false;
+
+	auto nt = base + offset;
+	auto optional = nt + 24;
+	if (!reader.Read(nt, signature) || signature != 0x00004550 || !reader.Read(nt + 4, machine) || !reader.Read(optional, magic))
+		return false;
+
+	if (machine != machine_amd64 || magic != optional_pe32_plus)
+		return false;
+
+	// the exception directory is the fourth data directory
+	auto exception = optional + 112 + 3 * 8;
+	if (!reader.Read(optional + 108, directories) || directories <= 3 || !reader.Read(exception, address) || !reader.Read(exception + 4, size))
+		return false;
+
+	table.m_Base = base;
+	table.m_Functions.clear();
+	table.m_Infos.clear();
+	table.m_Codes.clear();
+
+	if (address == 0 || size < 12)
+		return true;
+
+	// the RUNTIME_FUNCTION entries are read in one go: begin, end and unwind information RVA
+	size_t count = std::min<size_t>(size / 12, MaxFunctions);
+	std::vector<uint32_t> entries(count * 3);
+
+	if (memory.Read(base + address, entries.data(), count * 12) != count * 12)
+		return false;
+
+	std::vector<uint32_t> addresses;
+	addresses.reserve(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		// an odd RVA points to another function entry instead (RUNTIME_FUNCTION_INDIRECT), which is left to StackWalk64
+		if (entries[i * 3 + 2] != 0 && (entries[i * 3 + 2] & 1) == 0)
+			addresses.push_back(entries[i * 3 + 2]);
+	}
+
+	std::sort(addresses.begin(), addresses.end());
+	addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+	auto indices = table.ReadInfos(memory, addresses);
+
+	table.m_Functions.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		Function function;
+		function.Begin	= entries[i * 3];
+		function.End	= entries[i * 3 + 1];
+		function.Info	= no_info;
+
+		if (function.Begin >= function.End)
+			continue;
+
+		auto it = std::lower_bound(addresses.begin(), addresses.end(), entries[i * 3 + 2]);
+		if (it != addresses.end() && *it == entries[i * 3 + 2])
+			function.Info = indices[static_cast<size_t>(it - addresses.begin())];
+
+		table.m_Functions.push_back(function);
+	}
+
+	// the linker emits the entries sorted, but nothing depends on it
+	std::sort(table.m_Functions.begin(), table.m_Functions.end(),
+		[](const Function& left, const Function& right) { return left.Begin < right.Begin; });
+
+	return true;
+}
+
+/// <summary>
+/// Unwind one frame: compute the registers of the caller of the frame in <paramref name="context"/>, whose Rip has
+/// to be inside of this image. A function without a function entry is a leaf function, which only has its
+/// return address on the stack.
+/// </summary>
+/// <param name="memory">The memory of the process, which has to cover the stack and, for an interrupted frame, the code.</param>
+/// <param name="context">A reference to the registers of the frame, which receives the registers of its caller.</param>
+/// <returns>false when the stack could not be read or the unwind information is invalid, <paramref name="context"/> is undefined then.</returns>
+bool X64UnwindTable::Unwind(const Backend::IMemoryReader& memory, X64UnwindContext& context) const {
+	auto& registers = context.Registers;
+	auto& rsp = registers[X64UnwindContext::Rsp];
+
+	if (context.Rip < m_Base || context.Rip - m_Base > UINT32_MAX)
+		return false;
+
+	// a return address is the first byte after the call, which is the next function when the call does not return
+	auto pc = static_cast<uint32_t>(context.Rip - m_Base);
+	auto function = Find(context.Interrupted || pc == 0 ? pc : pc - 1);
+
+	bool machine = false;
+
+	if (function != nullptr) {
+		auto begin = function->Begin;
+		auto index = function->Info;
+		auto frame = rsp;
+
+		for (size_t depth = 0;; ++depth) {
+			if (index >= m_Infos.size() || depth >= max_chain)
+				return false;
+
+			const auto& info = m_Infos[index];
+			if (info.FrameRegister != 0)
+				frame = registers[info.FrameRegister] - info.FrameOffset * 16ull;
+
+			// the codes of the prolog instructions that did not execute yet are skipped
+			uint32_t prolog = UINT32_MAX;
+			if (pc >= begin && pc - begin < info.Prolog) {
+				prolog = pc - begin;
+			} else if (depth == 0 && context.Interrupted && info.Version == 1) {
+				// a return address is never inside of an epilog that did not start yet, so only the first frame is checked
+				bool unwound = false;
+				if (UnwindEpilog(memory, *function, context, unwound))
+					return unwound;
+			}
+
+			const auto codes = m_Codes.data() + info.Codes;
+			for (size_t i = 0; i < info.Count; i += code_slots(codes[i])) {
+				auto slots = code_slots(codes[i]);
+				if (i + slots > info.Count)
+					return false;
+
+				auto codeOffset = static_cast<uint32_t>(codes[i] & 0xff);
+				auto op = static_cast<uint8_t>((codes[i] >> 8) & 0xf);
+				auto opInfo = static_cast<size_t>(codes[i] >> 12);
+
+				if (prolog < codeOffset)
+					continue;
+
+				switch (op) {
+					case op_push_nonvol:
+						if (!read_qword(memory, rsp, registers[opInfo]))
+							return false;
+						rsp += 8;
+						break;
+					case op_alloc_large:
+						rsp += opInfo != 0 ? (codes[i + 1] | (static_cast<uint64_t>(codes[i + 2]) << 16)) : codes[i + 1] * 8ull;
+						break;
+					case op_alloc_small:
+						rsp += opInfo * 8 + 8;
+						break;
+					case op_set_fpreg:
+						rsp = frame;
+						break;
+					case op_save_nonvol:
+						if (!read_qword(memory, frame + codes[i + 1] * 8ull, registers[opInfo]))
+							return false;
+						break;
+					case op_save_nonvol_far:
+						if (!read_qword(memory, frame + (codes[i + 1] | (static_cast<uint64_t>(codes[i + 2]) << 16)), registers[opInfo]))
+							return false;
+						break;
+					case op_save_xmm128:
+					case op_save_xmm128_far:
+					case op_epilog:
+						break; /* the XMM registers are not tracked, the epilog codes of version 2 only describe epilogs */
+					case op_push_machframe:
+						// an interrupt or exception pushed SS, RSP, EFLAGS, CS and RIP, and optionally an error code
+						if (opInfo != 0)
+							rsp += 8;
+						if (!read_qword(memory, rsp, context.Rip) || !read_qword(memory, rsp + 24, rsp))
+							return false;
+						machine = true;
+						break;
+					default:
+						return false;
+				}
+			}
+
+			if ((info.Flags & flag_chain_info) == 0)
+				break;
+
+			begin = info.ChainBegin;
+			index = info.Chain;
+		}
+	}
+
+	// the caller continues at the return address, unless a machine frame restored the interrupted one
+	if (!machine) {
+		if (!read_qword(memory, rsp, context.Rip))
+			return false;
+		rsp += 8;
+	}
+
+	context.Interrupted = machine;
+	return true;
+}
+
+/// <summary>
+/// Get the base address of the image.
+/// </summary>
+/// <returns>The base address.</returns>
+uint64_t X64UnwindTable::Base() const noexcept {
+	return m_Base;
+}
+
+/// <summary>
+/// Get the number of function entries.
+/// </summary>
+/// <returns>The number of functions with unwind information.</returns>
+size_t X64UnwindTable::size() const noexcept {
+	return m_Functions.size();
+}
+
+/// <summary>
+/// Find the function entry that contains an RVA.
+/// </summary>
+/// <param name="rva">The RVA.</param>
+/// <returns>A pointer to the function entry, or nullptr for a leaf function.</returns>
+const X64UnwindTable::Function* X64UnwindTable::Find(uint32_t rva) const {
+	auto it = std::upper_bound(m_Functions.begin(), m_Functions.end(), rva,
+		[](uint32_t key, const Function& function) { return key < function.Begin; });
+
+	if (it == m_Functions.begin())
+		return nullptr;
+
+	--it;
+	return rva < it->End ? &*it : nullptr;
+}
+
+/// <summary>
+/// Read the unwind information records at a set of RVAs, and the records they chain to, into m_Infos.
+/// </summary>
+/// <param name="memory">The memory of the process that mapped the image.</param>
+/// <param name="addresses">The RVAs of the records, sorted and unique.</param>
+/// <returns>The index in m_Infos of each record in <paramref name="addresses"/>, UINT32_MAX for a record that could not be read.</returns>
+std::vector<uint32_t> X64UnwindTable::ReadInfos(const Backend::IMemoryReader& memory, const std::vector<uint32_t>& addresses) {
+	// the records are packed together in .xdata, so the page cache turns each batch into a few large reads
+	Backend::CachingMemoryReader reader(memory, 256);
+
+	std::vector<std::pair<uint32_t, uint32_t>> indices;	/* The index of each record that was read, by RVA */
+	std::vector<std::pair<uint32_t, uint32_t>> chains;	/* The records that chain to another, and the RVA of that record */
+	std::vector<uint32_t> pending = addresses;
+
+	while (!pending.empty()) {
+		// the fixed part of each record first, which tells the size of the rest
+		std::vector<uint32_t> headers(pending.size());
+		std::vector<Backend::MemoryRange> ranges(pending.size());
+
+		for (size_t i = 0; i < pending.size(); ++i) {
+			ranges[i].Address	= m_Base + pending[i];
+			ranges[i].Buffer	= &headers[i];
+			ranges[i].Size		= sizeof(uint32_t);
+		}
+
+		reader.ReadMany(ranges.data(), ranges.size());
+
+		// the unwind codes, padded to an even number of slots, and the function entry of chained information
+		std::vector<size_t> offsets(pending.size());
+		std::vector<bool> readable(pending.size());
+		size_t total = 0;
+
+		for (size_t i = 0; i < pending.size(); ++i) {
+			auto count = static_cast<size_t>((headers[i] >> 16) & 0xff);
+			auto chained = ((headers[i] & 0xff) >> 3) & flag_chain_info;
+
+			readable[i] = ranges[i].Read == sizeof(uint32_t);
+			offsets[i] = total;
+			ranges[i].Address	= m_Base + pending[i] + 4;
+			ranges[i].Size		= readable[i] ? ((count + 1) & ~static_cast<size_t>(1)) * 2 + (chained ? 12 : 0) : 0;
+			total += ranges[i].Size;
+		}
+
+		std::vector<uint8_t> bodies(total);
+		for (size_t i = 0; i < pending.size(); ++i) {
+			ranges[i].Buffer = bodies.data() + offsets[i];
+			ranges[i].Read	 = 0;
+		}
+
+		reader.ReadMany(ranges.data(), ranges.size());
+
+		std::vector<uint32_t> next;
+		for (size_t i = 0; i < pending.size(); ++i) {
+			auto header = headers[i];
+			auto version = static_cast<uint8_t>(header & 0x7);
+
+			if (!readable[i] || ranges[i].Read != ranges[i].Size || (version != 1 && version != 2)) {
+				indices.emplace_back(pending[i], no_info);
+				continue;
+			}
+
+			Info info;
+			info.Version		= version;
+			info.Flags			= static_cast<uint8_t>((header & 0xff) >> 3);
+			info.Prolog			= static_cast<uint8_t>((header >> 8) & 0xff);
+			info.Count			= static_cast<uint8_t>((header >> 16) & 0xff);
+			info.FrameRegister	= static_cast<uint8_t>((header >> 24) & 0xf);
+			info.FrameOffset	= static_cast<uint8_t>(header >> 28);
+			info.Codes			= static_cast<uint32_t>(m_Codes.size());
+			info.ChainBegin		= 0;
+			info.Chain			= no_info;
+
+			auto body = bodies.data() + offsets[i];
+			for (size_t slot = 0; slot < info.Count; ++slot) {
+				uint16_t code;
+				std::memcpy(&code, body + slot * 2, sizeof(code));
+				m_Codes.push_back(code);
+			}
+
+			if (info.Flags & flag_chain_info) {
+				uint32_t entry[3];
+				std::memcpy(entry, body + ((info.Count + 1) & ~1) * 2, sizeof(entry));
+
+				info.ChainBegin = entry[0];
+				if ((entry[2] & 1) == 0) {
+					chains.emplace_back(static_cast<uint32_t>(m_Infos.size()), entry[2]);
+					next.push_back(entry[2]);
+				}
+			}
+
+			indices.emplace_back(pending[i], static_cast<uint32_t>(m_Infos.size()));
+			m_Infos.push_back(info);
+		}
+
+		// chained records are usually the record of another function, which has been read already
+		std::sort(indices.begin(), indices.end());
+		std::sort(next.begin(), next.end());
+		next.erase(std::unique(next.begin(), next.end()), next.end());
+
+		pending.clear();
+		for (auto address : next) {
+			auto it = std::lower_bound(indices.begin(), indices.end(), std::make_pair(address, static_cast<uint32_t>(0)));
+			if (it == indices.end() || it->first != address)
+				pending.push_back(address);
+		}
+	}
+
+	for (auto& chain : chains) {
+		auto it = std::lower_bound(indices.begin(), indices.end(), std::make_pair(chain.second, static_cast<uint32_t>(0)));
+		if (it != indices.end() && it->first == chain.second)
+			m_Infos[chain.first].Chain = it->second;
+	}
+
+	std::vector<uint32_t> result(addresses.size(), no_info);
+	for (size_t i = 0; i < addresses.size(); ++i) {
+		auto it = std::lower_bound(indices.begin(), indices.end(), std::make_pair(addresses[i], static_cast<uint32_t>(0)));
+		if (it != indices.end() && it->first == addresses[i])
+			result[i] = it->second;
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Determine if an interrupted frame is inside of an epilog, by matching the instructions at its Rip against the
+/// only instructions an x64 epilog may contain, and if so, unwind it by emulating those instructions.
+/// </summary>
+/// <param name="memory">The memory of the process.</param>
+/// <param name="function">The function that contains the frame.</param>
+/// <param name="context">A reference to the registers of the frame, which receives the registers of its caller when it is inside of an epilog.</param>
+/// <param name="unwound">A reference that receives true when the frame was unwound, false when an emulated read failed.</param>
+/// <returns>true when the frame is inside of an epilog.</returns>
+bool X64UnwindTable::UnwindEpilog(const Backend::IMemoryReader& memory, const Function& function, X64UnwindContext& context, bool& unwound) const {
+	uint8_t code[epilog_code_size];
+	auto size = memory.Read(context.Rip, code, sizeof(code));
+
+	// the instructions are emulated on a copy, which is only kept when they turn out to be an epilog
+	auto next = context;
+	auto& rsp = next.Registers[X64UnwindContext::Rsp];
+	bool readable = true;
+	size_t at = 0;
+
+	// an epilog may start with add rsp, imm or lea rsp, [frame register + disp], both with REX.W
+	if (size >= 4 && (code[0] & 0xf8) == 0x48) {
+		if (code[0] == 0x48 && code[1] == 0x81 && code[2] == 0xc4 && size >= 7) {
+			rsp += code_int32(code + 3);
+			at = 7;
+		} else if (code[0] == 0x48 && code[1] == 0x83 && code[2] == 0xc4) {
+			rsp += static_cast<int8_t>(code[3]);
+			at = 4;
+		} else if (code[1] == 0x8d && (code[0] & 0x06) == 0 && ((code[2] >> 3) & 7) == 4 && (code[2] & 7) != 4) {
+			auto base = next.Registers[(code[2] & 7) + (code[0] & 1) * 8];
+
+			if ((code[2] >> 6) == 1) {
+				rsp = base + static_cast<int8_t>(code[3]);
+				at = 4;
+			} else if ((code[2] >> 6) == 2 && size >= 7) {
+				rsp = base + code_int32(code + 3);
+				at = 7;
+			} else {
+				return false;
+			}
+		}
+	}
+
+	// then the nonvolatile registers are popped, and the function returns or jumps to another function
+	while (at < size) {
+		uint8_t rex = 0;
+		if ((code[at] & 0xf0) == 0x40 && at + 1 < size)
+			rex = code[at++] & 0x0f;
+
+		auto instruction = code[at];
+		if (instruction >= 0x58 && instruction <= 0x5f) {
+			readable = readable && read_qword(memory, rsp, next.Registers[instruction - 0x58 + (rex & 1) * 8]);
+			rsp += 8;
+			++at;
+			continue;
+		}
+
+		uint64_t pop = 8;
+		if (instruction == 0xc2 && at + 3 <= size) {
+			uint16_t immediate;
+			std::memcpy(&immediate, code + at + 1, sizeof(immediate));
+			pop += immediate;
+		} else if (instruction == 0xe9 && at + 5 <= size) {
+			// a tail call leaves the function, a jump inside of it is not followed
+			auto target = static_cast<int64_t>(context.Rip - m_Base + at + 5) + code_int32(code + at + 1);
+			if (target >= function.Begin && target < function.End)
+				return false;
+		} else if (instruction == 0xff && rex == 0x8 && at + 2 <= size && code[at + 1] == 0x25) {
+			// rex.W jmp qword ptr [rip + disp], a tail call through the import table
+		} else if (instruction != 0xc3 && !(instruction == 0xf3 && at + 2 <= size && code[at + 1] == 0xc3)) {
+			return false;
+		}
+
+		readable = readable && read_qword(memory, rsp, next.Rip);
+		rsp += pop;
+		next.Interrupted = false;
+
+		unwound = readable;
+		if (unwound)
+			context = next;
+
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#ifndef debugger_x64_unwind_table_h
+#define debugger_x64_unwind_table_h
+	#include "DebugBackend.hpp"
+
+	#include <cstdint>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Debugger {
+			/// <summary>
+			/// The registers of one frame while a stack is unwound with <see cref="::Hindsight::Debugger::X64UnwindTable"/>.
+			/// </summary>
+			struct X64UnwindContext {
+				uint64_t	Rip = 0;				/* The instruction pointer of the frame. */
+				uint64_t	Registers[16] = {};		/* The integer registers in encoding order (RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8 to R15). */
+				bool		Interrupted = true;		/* True when Rip is the next instruction to execute (the first frame, or one below a machine frame) rather than a return address. */
+
+				/// <summary>
+				/// The index of RSP in <see cref="Registers"/>.
+				/// </summary>
+				static const size_t Rsp = 4;
+
+				/// <summary>
+				/// The index of RBP in <see cref="Registers"/>.
+				/// </summary>
+				static const size_t Rbp = 5;
+			};
+
+			/// <summary>
+			/// The unwind information of an x64 PE image: the RUNTIME_FUNCTION entries of its exception directory (.pdata) and the
+			/// UNWIND_INFO records they point to (.xdata), which describe exactly how every non-leaf function moved the stack
+			/// pointer and where it saved the nonvolatile registers. The table is read once, in a few batched reads of the
+			/// mapped image, and kept in compact sorted vectors so that unwinding a frame does not read the image again. Unwinding
+			/// follows RtlVirtualUnwind: partially executed prologs, epilogs of the first frame, chained unwind information and
+			/// machine frames are handled, exception handlers are not called. This class does not depend on any platform API.
+			/// </summary>
+			class X64UnwindTable {
+				private:
+					struct Function {
+						uint32_t	Begin;			/* The RVA of the first instruction */
+						uint32_t	End;			/* The RVA after the last instruction */
+						uint32_t	Info;			/* The index of the unwind information in m_Infos */
+					};
+
+					struct Info {
+						uint8_t		Version;		/* The UNWIND_INFO version, 1 or 2 */
+						uint8_t		Flags;			/* The UNW_FLAG_* flags */
+						uint8_t		Prolog;			/* The size of the prolog in bytes */
+						uint8_t		Count;			/* The number of unwind code slots */
+						uint8_t		FrameRegister;	/* The frame pointer register, or 0 when there is none */
+						uint8_t		FrameOffset;	/* The offset of the frame pointer from RSP, in units of 16 bytes */
+						uint32_t	Codes;			/* The index of the first unwind code slot in m_Codes */
+						uint32_t	ChainBegin;		/* The RVA of the function of the chained information */
+						uint32_t	Chain;			/* The index of the chained information in m_Infos, or UINT32_MAX */
+					};
+
+					uint64_t				m_Base = 0;		/* The base address of the image */
+					std::vector<Function>	m_Functions;	/* The function entries, by RVA */
+					std::vector<Info>		m_Infos;		/* The unwind information, shared by functions that use the same record */
+					std::vector<uint16_t>	m_Codes;		/* The unwind code slots of all unwind information */
+
+				public:
+					/// <summary>
+					/// The largest number of function entries that is read from an exception directory.
+					/// </summary>
+					static constexpr size_t MaxFunctions = 1 << 22;
+
+					/// <summary>
+					/// Read the unwind information of an x64 image that is mapped at <paramref name="base"/>.
+					/// </summary>
+					/// <param name="memory">The memory of the process that mapped the image.</param>
+					/// <param name="base">The base address of the image.</param>
+					/// <param name="table">A reference to the table that receives the result.</param>
+					/// <returns>false when the headers cannot be read, or are not those of an x64 PE image with an exception directory.</returns>
+					static bool Read(const Backend::IMemoryReader& memory, uint64_t base, X64UnwindTable& table);
+
+					/// <summary>
+					/// Unwind one frame: compute the registers of the caller of the frame in <paramref name="context"/>, whose Rip has
+					/// to be inside of this image. A function without a function entry is a leaf function, which only has its
+					/// return address on the stack.
+					/// </summary>
+					/// <param name="memory">The memory of the process, which has to cover the stack and, for an interrupted frame, the code.</param>
+					/// <param name="context">A reference to the registers of the frame, which receives the registers of its caller.</param>
+					/// <returns>false when the stack could not be read or the unwind information is invalid, <paramref name="context"/> is undefined then.</returns>
+					bool Unwind(const Backend::IMemoryReader& memory, X64UnwindContext& context) const;
+
+					/// <summary>
+					/// Get the base address of the image.
+					/// </summary>
+					/// <returns>The base address.</returns>
+					uint64_t Base() const noexcept;
+
+					/// <summary>
+					/// Get the number of function entries.
+					/// </summary>
+					/// <returns>The number of functions with unwind information.</returns>
+					size_t size() const noexcept;
+
+				private:
+					/// <summary>
+					/// Find the function entry that contains an RVA.
+					/// </summary>
+					/// <param name="rva">The RVA.</param>
+					/// <returns>A pointer to the function entry, or nullptr for a leaf function.</returns>
+					const Function* Find(uint32_t rva) const;
+
+					/// <summary>
+					/// Read the unwind information records at a set of RVAs, and the records they chain to, into m_Infos.
+					/// </summary>
+					/// <param name="memory">The memory of the process that mapped the image.</param>
+					/// <param name="addresses">The RVAs of the records, sorted and unique.</param>
+					/// <returns>The index in m_Infos of each record in <paramref name="addresses"/>, UINT32_MAX for a record that could not be read.</returns>
+					std::vector<uint32_t> ReadInfos(const Backend::IMemoryReader& memory, const std::vector<uint32_t>& addresses);
+
+					/// <summary>
+					/// Determine if an interrupted frame is inside of an epilog, by matching the instructions at its Rip against the
+					/// only instructions an x64 epilog may contain, and if so, unwind it by emulating those instructions.
+					/// </summary>
+					/// <param name="memory">The memory of the process.</param>
+					/// <param name="function">The function that contains the frame.</param>
+					/// <param name="context">A reference to the registers of the frame, which receives the registers of its caller when it is inside of an epilog.</param>
+					/// <param name="unwound">A reference that receives true when the frame was unwound, false when an emulated read failed.</param>
+					/// <returns>true when the frame is inside of an epilog.</returns>
+					bool UnwindEpilog(const Backend::IMemoryReader& memory, const Function& function, X64UnwindContext& context, bool& unwound) const;
+			};
+		}
+	}
+
+#endif
@@ -3,6 +3,30 @@
 #ifndef checksum_crc32_h
 #define checksum_crc32_h
 	#include <cstdint>
+	#include <cstddef>
+	#include <cstring>
+
+	/*
+		The carry-less multiplication kernel is only available on x86 and x64 targets. MSVC allows the use of
+		the intrinsics without any special compiler flags, GCC and clang require the functions that use them to
+		be marked with a target attribute instead.
+	*/
+	#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		#define HINDSIGHT_CRC32_CLMUL 1
+
+		#include <emmintrin.h>
+		#include <wmmintrin.h>
+
+		#if defined(_MSC_VER)
+			#include <intrin.h>
+			#define HINDSIGHT_CRC32_CLMUL_TARGET
+		#else
+			#include <cpuid.h>
+			#define HINDSIGHT_CRC32_CLMUL_TARGET __attribute__((target("sse2,pclmul")))
+		#endif
+	#else
+		#define HINDSIGHT_CRC32_CLMUL 0
+	#endif
 
 	namespace Hindsight {
 		namespace Checksum {
@@ -37,8 +61,37 @@
 			};
 
 			/// <summary>
-			/// A very basic CRC32 implementation to be used in the hindsight binary log files. This CRC 
-			/// implementation is not written towards optimization, but merely to having a simple checksum.
+			/// A compile-time generated set of <typeparamref name="N"/> lookup tables for the slicing-by-N CRC32 kernels.
+			/// Table 0 is the regular <see cref="::Hindsight::Checksum::LookupTable"/>, every next table k describes the
+			/// effect of a byte that is followed by k zero bytes, which allows for processing N bytes per iteration.
+			/// </summary>
+			/// <typeparam name="N">The number of tables, which is the number of bytes processed per iteration.</typeparam>
+			template <size_t N>
+			struct SlicingLookupTable {
+				uint32_t data[N][256];
+
+				/// <summary>
+				/// Construct a new set of slicing tables for the polynomial <paramref name="polynomial"/>.
+				/// </summary>
+				/// <param name="polynomial">The reversed polynomial.</param>
+				constexpr SlicingLookupTable(const uint32_t polynomial = 0xEDB88320) : data() {
+					const LookupTable base(polynomial);
+
+					for (size_t i = 0; i < 256; i++)
+						data[0][i] = base.data[i];
+
+					for (size_t k = 1; k < N; k++) {
+						for (size_t i = 0; i < 256; i++)
+							data[k][i] = (data[k - 1][i] >> 8) ^ data[0][data[k - 1][i] & 0xFF];
+					}
+				}
+			};
+
+			/// <summary>
+			/// The CRC32 implementation used in the hindsight binary log files. Data passes through this checksum both
+			/// when writing and when replaying logs, so the default <see cref="Update"/> picks the fastest kernel that
+			/// is available on the machine. All kernels produce the exact same checksum, so logs remain interchangeable
+			/// between machines.
 			/// </summary>
 			struct Crc32 {
 				/// <summary>
@@ -47,8 +100,14 @@
 				static constexpr LookupTable Default = LookupTable();
 
 				/// <summary>
-				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> using the lookup table 
-				/// <paramref name="table"/>.
+				/// The static default slicing tables, used by both the slicing-by-8 (the first 8 tables) and the
+				/// slicing-by-16 kernel.
+				/// </summary>
+				static constexpr SlicingLookupTable<16> Slicing = SlicingLookupTable<16>();
+
+				/// <summary>
+				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> using the lookup table
+				/// <paramref name="table"/>. This processes one byte at a time.
 				/// </summary>
 				/// <param name="buf">The data to update the checksum with.</param>
 				/// <param name="len">The size of the data pointed to by <paramref name="data"/>.</param>
@@ -64,17 +123,263 @@
 				}
 
 				/// <summary>
-				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> using the default lookup table 
-				/// <see cref="::Hindsight::Checksum::Crc32::Default"/>.
+				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> using the fastest kernel
+				/// available on this machine.
 				/// </summary>
 				/// <param name="buf">The data to update the checksum with.</param>
 				/// <param name="len">The size of the data pointed to by <paramref name="data"/>.</param>
 				/// <param name="initial">The initial checksum or previous iteration.</param>
 				/// <returns>The updated checksum.</returns>
 				static uint32_t Update(const void* buf, size_t len, uint32_t initial) {
+				#if HINDSIGHT_CRC32_CLMUL
+					if (len >= ClmulMinimumSize && HasClmul())
+						return UpdateClmul(buf, len, initial);
+				#endif
+					return UpdateSlicing16(buf, len, initial);
+				}
+
+				/// <summary>
+				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> one byte at a time using
+				/// the default lookup table <see cref="::Hindsight::Checksum::Crc32::Default"/>.
+				/// </summary>
+				/// <param name="buf">The data to update the checksum with.</param>
+				/// <param name="len">The size of the data pointed to by <paramref name="data"/>.</param>
+				/// <param name="initial">The initial checksum or previous iteration.</param>
+				/// <returns>The updated checksum.</returns>
+				static uint32_t UpdateBytewise(const void* buf, size_t len, uint32_t initial) {
 					return Update(buf, len, Default, initial);
 				}
+
+				/// <summary>
+				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> 8 bytes at a time using
+				/// the default slicing tables <see cref="::Hindsight::Checksum::Crc32::Slicing"/>.
+				/// </summary>
+				/// <param name="buf">The data to update the checksum with.</param>
+				/// <param name="len">The size of the data pointed to by <paramref name="data"/>.</param>
+				/// <param name="initial">The initial checksum or previous iteration.</param>
+				/// <returns>The updated checksum.</returns>
+				static uint32_t UpdateSlicing8(const void* buf, size_t len, uint32_t initial) {
+					auto c = initial ^ 0xFFFFFFFF;
+					auto u = static_cast<const uint8_t*>(buf);
+					const auto& t = Slicing.data;
+
+					for (; len >= 8; len -= 8, u += 8) {
+						auto one = Load32(u) ^ c;
+						auto two = Load32(u + 4);
+
+						c = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+							t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+					}
+
+					for (; len > 0; --len, ++u)
+						c = t[0][(c ^ *u) & 0xFF] ^ (c >> 8);
+
+					return c ^ 0xFFFFFFFF;
+				}
+
+				/// <summary>
+				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> 16 bytes at a time using
+				/// the default slicing tables <see cref="::Hindsight::Checksum::Crc32::Slicing"/>.
+				/// </summary>
+				/// <param name="buf">The data to update the checksum with.</param>
+				/// <param name="len">The size of the data pointed to by <paramref name="data"/>.</param>
+				/// <param name="initial">The initial checksum or previous iteration.</param>
+				/// <returns>The updated checksum.</returns>
+				static uint32_t UpdateSlicing16(const void* buf, size_t len, uint32_t initial) {
+					auto c = initial ^ 0xFFFFFFFF;
+					auto u = static_cast<const uint8_t*>(buf);
+					const auto& t = Slicing.data;
+
+					for (; len >= 16; len -= 16, u += 16) {
+						auto one   = Load32(u) ^ c;
+						auto two   = Load32(u + 4);
+						auto three = Load32(u + 8);
+						auto four  = Load32(u + 12);
+
+						c = t[15][one & 0xFF]   ^ t[14][(one >> 8) & 0xFF]   ^ t[13][(one >> 16) & 0xFF]   ^ t[12][one >> 24] ^
+							t[11][two & 0xFF]   ^ t[10][(two >> 8) & 0xFF]   ^ t[9][(two >> 16) & 0xFF]    ^ t[8][two >> 24] ^
+							t[7][three & 0xFF]  ^ t[6][(three >> 8) & 0xFF]  ^ t[5][(three >> 16) & 0xFF]  ^ t[4][three >> 24] ^
+							t[3][four & 0xFF]   ^ t[2][(four >> 8) & 0xFF]   ^ t[1][(four >> 16) & 0xFF]   ^ t[0][four >> 24];
+					}
+
+					for (; len > 0; --len, ++u)
+						c = t[0][(c ^ *u) & 0xFF] ^ (c >> 8);
+
+					return c ^ 0xFFFFFFFF;
+				}
+
+			#if HINDSIGHT_CRC32_CLMUL
+				/// <summary>
+				/// The minimum number of bytes for which the carry-less multiplication kernel is used, smaller
+				/// buffers are processed by the slicing-by-16 kernel.
+				/// </summary>
+				static constexpr size_t ClmulMinimumSize = 64;
+
+				/// <summary>
+				/// Determines if the processor supports the PCLMULQDQ instruction. The CPUID query is only
+				/// performed once.
+				/// </summary>
+				/// <returns>true is returned when <see cref="UpdateClmul"/> may be used.</returns>
+				static bool HasClmul() {
+					static const bool supported = []() {
+					#if defined(_MSC_VER)
+						int info[4] = { 0 };
+						__cpuid(info, 1);
+						return (info[2] & (1 << 1)) != 0 && (info[3] & (1 << 26)) != 0;
+					#else
+						unsigned int a, b, c, d;
+						if (!__get_cpuid(1, &a, &b, &c, &d))
+							return false;
+						return (c & bit_PCLMUL) != 0 && (d & bit_SSE2) != 0;
+					#endif
+					}();
+
+					return supported;
+				}
+
+				/// <summary>
+				/// Update the checksum <paramref name="initial"/> with <paramref name="data"/> by folding 64 bytes at a
+				/// time using carry-less multiplication (PCLMULQDQ), followed by a Barrett reduction. The remainder
+				/// that does not fill a 16 byte block is processed by the slicing-by-16 kernel. The caller must verify
+				/// that the processor supports the instruction using <see cref="HasClmul"/>.
+				/// </summary>
+				/// <param name="buf">The data to update the checksum with.</param>
+				/// <param name="len">The size of the data pointed to by <paramref name="data"/>.</param>
+				/// <param name="initial">The initial checksum or previous iteration.</param>
+				/// <returns>The updated checksum.</returns>
+				static uint32_t UpdateClmul(const void* buf, size_t len, uint32_t initial) {
+					if (len < ClmulMinimumSize)
+						return UpdateSlicing16(buf, len, initial);
+
+					auto u     = static_cast<const uint8_t*>(buf);
+					auto block = len & ~static_cast<size_t>(15);
+					auto c     = FoldClmul(u, block, initial ^ 0xFFFFFFFF) ^ 0xFFFFFFFF;
+
+					return UpdateSlicing16(u + block, len - block, c);
+				}
+			#endif
+
+			private:
+				/// <summary>
+				/// Read a little-endian 32-bit value from a possibly unaligned address.
+				/// </summary>
+				/// <param name="p">The address to read from.</param>
+				/// <returns>The value.</returns>
+				static inline uint32_t Load32(const uint8_t* p) {
+					uint32_t value;
+					std::memcpy(&value, p, sizeof(value));
+					return value;
+				}
+
+			#if HINDSIGHT_CRC32_CLMUL
+				/// <summary>
+				/// Fold <paramref name="len"/> bytes into the non-inverted CRC state <paramref name="crc"/>, using the
+				/// bit-reflected constants for the CRC32 polynomial from Intel's "Fast CRC Computation for Generic
+				/// Polynomials Using PCLMULQDQ Instruction".
+				/// </summary>
+				/// <param name="buf">The data to fold, at least 64 bytes.</param>
+				/// <param name="len">The size of the data pointed to by <paramref name="buf"/>, a multiple of 16.</param>
+				/// <param name="crc">The current CRC state, not inverted.</param>
+				/// <returns>The new CRC state, not inverted.</returns>
+				HINDSIGHT_CRC32_CLMUL_TARGET
+				static uint32_t FoldClmul(const uint8_t* buf, size_t len, uint32_t crc) {
+					alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+					alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+					alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+					alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+					__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+					x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+					x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+					x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+					x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+
+					x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+					x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+					buf += 64;
+					len -= 64;
+
+					// fold 4 blocks of 16 bytes in parallel
+					while (len >= 64) {
+						x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+						x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+						x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+						x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+						x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+						x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+						x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+						x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+						y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+						y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+						y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+						y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+
+						x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+						x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+						x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+						x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+						buf += 64;
+						len -= 64;
+					}
+
+					// fold the 4 lanes into a single 128-bit value
+					x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+					x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+					x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+					x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+					x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+					x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+					x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+					x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+					x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+					x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+					// fold the remaining blocks of 16 bytes
+					while (len >= 16) {
+						x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+
+						x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+						x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+						x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+						buf += 16;
+						len -= 16;
+					}
+
+					// fold 128 bits into 64 bits
+					x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+					x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+					x1 = _mm_srli_si128(x1, 8);
+					x1 = _mm_xor_si128(x1, x2);
+
+					x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+					x2 = _mm_srli_si128(x1, 4);
+					x1 = _mm_and_si128(x1, x3);
+					x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+					x1 = _mm_xor_si128(x1, x2);
+
+					// Barrett reduction into 32 bits
+					x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+					x2 = _mm_and_si128(x1, x3);
+					x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+					x2 = _mm_and_si128(x2, x3);
+					x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+					x1 = _mm_xor_si128(x1, x2);
+
+					return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+				}
+			#endif
 			};
 		}
 	}
-#endif 
\ No newline at end of file
+#endif
\ No newline at end of file
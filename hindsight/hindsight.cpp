@@ -4,6 +4,11 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <iomanip>
 #include <conio.h>
 
 #include <Windows.h>
@@ -17,6 +22,8 @@
 #include "Version.hpp"
 
 #include "EventFilterValidator.hpp"
+#include "FlushPolicyValidator.hpp"
+#include "DispatchPolicyValidator.hpp"
 
 #include "Launcher.hpp"
 #include "Process.hpp"
@@ -24,6 +31,8 @@
 #include "BinaryLogPlayer.hpp"
 #include "PrintingDebuggerEventHandler.hpp"
 #include "WriterDebuggerEventHandler.hpp"
+#include "SignatureDebuggerEventHandler.hpp"
+#include "DispatchingDebuggerEventHandler.hpp"
 #include "Path.hpp"
 #include "String.hpp"
 
@@ -157,6 +166,84 @@ void pause(const char* what) {
 	(void)_getch();
 }
 
+/// <summary>
+/// Construct the <see cref="::Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler"/> for the --write-binary option, 
+/// using the flush policy, flush size, writer mode, trace encoding and compression that were specified.
+/// </summary>
+/// <param name="cli">The state obtained through processing program arguments through <see cref="CLI::App"/>.</param>
+/// <returns>A shared pointer to the new writer.</returns>
+std::shared_ptr<Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler> create_writer(Cli::HindsightCli& cli) {
+	using Hindsight::Debugger::EventHandler::FlushPolicy;
+
+	auto name   = cli.get<std::string>(Cli::Descriptors::NAME_FLUSH);
+	auto policy = FlushPolicy::Size;
+
+	if (name == "event")
+		policy = FlushPolicy::Event;
+	else if (name == "exit")
+		policy = FlushPolicy::Exit;
+
+	return std::make_shared<Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler>(
+		cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN),
+		policy,
+		cli.get<size_t>(Cli::Descriptors::NAME_FLUSHSIZE),
+		cli.isset(Cli::Descriptors::NAME_ASYNCWRITE),
+		cli.isset(Cli::Descriptors::NAME_COMPACT),
+		cli.isset(Cli::Descriptors::NAME_COMPRESS));
+}
+
+/// <summary>
+/// Construct the <see cref="::Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler"/> for the --dispatch option,
+/// using the backpressure policy and queue size that were specified.
+/// </summary>
+/// <param name="cli">The state obtained through processing program arguments through <see cref="CLI::App"/>.</param>
+/// <returns>A shared pointer to the new dispatcher, or nullptr when --dispatch was not specified.</returns>
+std::shared_ptr<Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler> create_dispatcher(Cli::HindsightCli& cli) {
+	using Hindsight::Debugger::EventHandler::BackpressurePolicy;
+
+	if (!cli.isset(Cli::Descriptors::NAME_DISPATCH))
+		return nullptr;
+
+	auto name   = cli.get<std::string>(Cli::Descriptors::NAME_DISPATCH);
+	auto policy = BackpressurePolicy::Block;
+
+	if (name == "drop-oldest")
+		policy = BackpressurePolicy::DropOldest;
+	else if (name == "sample")
+		policy = BackpressurePolicy::Sample;
+
+	return std::make_shared<Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler>(
+		policy,
+		cli.get<size_t>(Cli::Descriptors::NAME_DISPATCHQUEUE));
+}
+
+/// <summary>
+/// Add <paramref name="handler"/> to <paramref name="target"/>, or to <paramref name="dispatcher"/> when --dispatch was specified.
+/// </summary>
+/// <param name="target">The debugger or player.</param>
+/// <param name="dispatcher">The dispatcher from <see cref="create_dispatcher"/>, which may be nullptr.</param>
+/// <param name="handler">The event handler.</param>
+/// <param name="lossless">When true, the handler never loses events regardless of the backpressure policy.</param>
+/// <typeparam name="TTarget">The type of the debugger or player.</typeparam>
+template <typename TTarget>
+void add_handler(TTarget& target, const std::shared_ptr<Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler>& dispatcher, std::shared_ptr<Hindsight::Debugger::EventHandler::IDebuggerEventHandler> handler, bool lossless = false) {
+	if (dispatcher == nullptr)
+		target.AddHandler(handler);
+	else if (lossless)
+		dispatcher->AddHandler(handler, Hindsight::Debugger::EventHandler::BackpressurePolicy::Block);
+	else
+		dispatcher->AddHandler(handler);
+}
+
+/// <summary>
+/// Print a warning when the backpressure policy of --dispatch has discarded events.
+/// </summary>
+/// <param name="dispatcher">The dispatcher from <see cref="create_dispatcher"/>, which may be nullptr.</param>
+void warn_dropped(const std::shared_ptr<Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler>& dispatcher) {
+	if (dispatcher != nullptr && dispatcher->Dropped() != 0)
+		std::cout << rang::fgB::yellow << "warning: " << dispatcher->Dropped() << " events were not printed because the output could not keep up (--dispatch)." << std::endl << rang::style::reset;
+}
+
 /// <summary>
 /// Execute the hindsight [options] launch [options] command.
 /// </summary>
@@ -168,9 +255,6 @@ int LaunchCommand(Cli::HindsightCli& cli) {
 
 	auto& command = cli[cli.get_chosen_subcommand_name()];
 
-	if (!command.isset(Cli::Descriptors::NAME_MAX_RECURSION) || command.get<size_t>(Cli::Descriptors::NAME_MAX_RECURSION) == 0)
-		command.set(Cli::Descriptors::NAME_MAX_RECURSION, static_cast<size_t>(SIZE_MAX));
-
 	try {
 		process = Hindsight::Process::Launcher::StartSuspended(
 			Hindsight::Utilities::Path::Absolute(command.get<std::string>(Cli::Descriptors::NAME_PROGPATH)),
@@ -191,9 +275,12 @@ int LaunchCommand(Cli::HindsightCli& cli) {
 		return 1;
 	}
 
+	// give each handler its own queue and thread?
+	auto dispatcher = create_dispatcher(cli);
+
 	// write to stdout?
 	if (cli.isset(Cli::Descriptors::NAME_STDOUT)) 
-		debugger->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
+		add_handler(*debugger, dispatcher, std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
 			!cli.isset(Cli::Descriptors::NAME_BLAND), 
 			command.isset(Cli::Descriptors::NAME_PRINTTIME), 
 			command.isset(Cli::Descriptors::NAME_PRINTCTX)));
@@ -201,7 +288,7 @@ int LaunchCommand(Cli::HindsightCli& cli) {
 	// write to text file?
 	if (cli.isset(Cli::Descriptors::NAME_LOGTEXT)) {
 		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT));
-		debugger->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
+		add_handler(*debugger, dispatcher, std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
 			cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT), 
 			command.isset(Cli::Descriptors::NAME_PRINTCTX)));
 	}
@@ -209,9 +296,12 @@ int LaunchCommand(Cli::HindsightCli& cli) {
 	// write to binary file?
 	if (cli.isset(Cli::Descriptors::NAME_LOGBIN)) {
 		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN));
-		debugger->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler>(cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN)));
+		add_handler(*debugger, dispatcher, create_writer(cli), true);
 	}
 
+	if (dispatcher != nullptr)
+		debugger->AddHandler(dispatcher);
+
 	if (!debugger->Attach()) {
 		auto lastError = GetLastError();
 		std::cout << rang::fgB::red << "error: cannot attach debugger (" << lastError << "), " << Hindsight::Utilities::Error::GetErrorMessage(lastError) << std::endl << rang::style::reset;
@@ -224,6 +314,8 @@ int LaunchCommand(Cli::HindsightCli& cli) {
 	// start the debugger
 	debugger->Start();
 
+	warn_dropped(dispatcher);
+
 	return 0;
 }
 
@@ -246,9 +338,12 @@ int ReplayCommand(Cli::HindsightCli& cli) {
 		return 1;
 	}
 
+	// give each handler its own queue and thread?
+	auto dispatcher = create_dispatcher(cli);
+
 	// write to stdout?
 	if (cli.isset(Cli::Descriptors::NAME_STDOUT)) 
-		player->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
+		add_handler(*player, dispatcher, std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
 			!cli.isset(Cli::Descriptors::NAME_BLAND),
 			command.isset(Cli::Descriptors::NAME_PRINTTIME),
 			command.isset(Cli::Descriptors::NAME_PRINTCTX)));
@@ -256,7 +351,7 @@ int ReplayCommand(Cli::HindsightCli& cli) {
 	// write to text file?
 	if (cli.isset(Cli::Descriptors::NAME_LOGTEXT)) {
 		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT));
-		player->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
+		add_handler(*player, dispatcher, std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
 			cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT),
 			command.isset(Cli::Descriptors::NAME_PRINTCTX)));
 	}
@@ -264,9 +359,12 @@ int ReplayCommand(Cli::HindsightCli& cli) {
 	// write to binary file?
 	if (cli.isset(Cli::Descriptors::NAME_LOGBIN)) {
 		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN));
-		player->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler>(cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN)));
+		add_handler(*player, dispatcher, create_writer(cli), true);
 	}
 
+	if (dispatcher != nullptr)
+		player->AddHandler(dispatcher);
+
 	try {
 		player->Play();
 	} catch (const std::exception& e) {
@@ -276,12 +374,212 @@ int ReplayCommand(Cli::HindsightCli& cli) {
 		return 1;
 	}
 
+	warn_dropped(dispatcher);
+
+	if (!player->Intact())
+		std::cout << rang::fgB::yellow << "warning: the file never finished writing or is damaged, " << player->VerifiedEvents() << " events up to the last intact checkpoint were replayed." << std::endl << rang::style::reset;
+
 	if (command.isset(Cli::Descriptors::NAME_PPAUSE))
 		pause(continue_window);
 	
 	return 0;
 }
 
+/// <summary>
+/// The outcome of replaying a single binary log file in the batch subcommand.
+/// </summary>
+struct BatchResult {
+	std::wstring	Stdout;			/* the textual output for --stdout */
+	std::wstring	Log;			/* the textual output for --log */
+	std::string		Error;			/* the error message when the replay failed */
+	std::string		Warning;		/* the warning when only part of the file could be replayed */
+	uintmax_t		Size = 0;		/* the size of the binary log file in bytes */
+	bool			Done = false;	/* set when the replay has completed */
+};
+
+/// <summary>
+/// The number of replays per worker thread that may be completed or in progress ahead of the file that is printed next, 
+/// in the batch subcommand. This bounds the output that is held in memory when one file takes much longer than the files after it.
+/// </summary>
+static constexpr size_t batch_window_per_job = 2;
+
+/// <summary>
+/// Execute the hindsight [options] batch [options] command. The files are distributed over a pool of worker threads,
+/// each of which replays one file at a time with its own <see cref="Hindsight::BinaryLog::BinaryLogPlayer"/> into 
+/// in-memory streams. The main thread writes the output of every file in the order of the input, as soon as all files 
+/// before it have completed, followed by the crash signatures (when requested) and a throughput summary. Workers do not 
+/// start a file more than <see cref="batch_window_per_job"/> files per worker ahead of the file that is printed next, so 
+/// at most that many outputs are held in memory.
+/// </summary>
+/// <param name="state">The state obtained through processing program arguments through <see cref="CLI::App"/>.</param>
+/// <returns>The program exit code.</returns>
+int BatchCommand(Cli::HindsightCli& cli) {
+	auto& command = cli[cli.get_chosen_subcommand_name()];
+
+	std::vector<std::string> files;
+	for (const auto& path : command.get<std::vector<std::string>>(Cli::Descriptors::NAME_BATCHPATH)) {
+		auto expanded = Utilities::Path::Expand(path, ".hind");
+		files.insert(files.end(), expanded.begin(), expanded.end());
+	}
+
+	if (files.empty()) {
+		std::cout << rang::fgB::red << "error: no binary log files were found" << std::endl << rang::style::reset;
+		return 1;
+	}
+
+	auto jobs = command.get<size_t>(Cli::Descriptors::NAME_JOBS);
+	if (jobs == 0)
+		jobs = static_cast<size_t>(std::thread::hardware_concurrency());
+	if (jobs == 0)
+		jobs = 1;
+	if (jobs > files.size())
+		jobs = files.size();
+
+	auto toStdout = cli.isset(Cli::Descriptors::NAME_STDOUT);
+	auto toLog    = cli.isset(Cli::Descriptors::NAME_LOGTEXT);
+	auto times    = command.isset(Cli::Descriptors::NAME_PRINTTIME);
+	auto context  = command.isset(Cli::Descriptors::NAME_PRINTCTX);
+	auto sign     = command.isset(Cli::Descriptors::NAME_SIGNATURES);
+
+	// each worker counts signatures in its own aggregator, they are merged when all workers are done
+	std::vector<Hindsight::Debugger::EventHandler::SignatureAggregator> aggregators(
+		jobs, Hindsight::Debugger::EventHandler::SignatureAggregator(command.get<size_t>(Cli::Descriptors::NAME_SIGFRAMES)));
+
+	// the replays are printed without colours, --bland only affects the file headers and the summary
+	if (cli.isset(Cli::Descriptors::NAME_BLAND))
+		rang::setControlMode(rang::control::Off);
+
+	std::wofstream log;
+	if (toLog) {
+		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT));
+		log.open(cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT), std::ios::trunc);
+	}
+
+	std::vector<BatchResult> results(files.size());
+	std::mutex               mutex;
+	std::condition_variable  completed;
+	std::condition_variable  printed;
+	std::atomic<size_t>      next(0);
+	size_t                   current = 0;
+	auto                     window  = jobs * batch_window_per_job;
+
+	auto worker = [&](size_t id) {
+		for (auto i = next++; i < files.size(); i = next++) {
+			// wait until the output of this file can be printed within the window, the file that is printed next always can
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				printed.wait(lock, [&]() { return i < current + window; });
+			}
+
+			BatchResult         result;
+			std::ostringstream  ansi;
+			std::wostringstream out, text;
+
+			try {
+				result.Size = fs::file_size(files[i]);
+
+				Hindsight::BinaryLog::BinaryLogPlayer player(files[i], cli);
+
+				if (toStdout)
+					player.AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(ansi, out, false, times, context));
+				if (toLog)
+					player.AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(ansi, text, false, true, context));
+				if (sign)
+					player.AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::SignatureDebuggerEventHandler>(aggregators[id], files[i]));
+
+				player.Play();
+
+				if (!player.Intact())
+					result.Warning = "the file never finished writing or is damaged, " + std::to_string(player.VerifiedEvents()) + " events up to the last intact checkpoint were replayed.";
+			} catch (const std::exception& e) {
+				result.Error = e.what();
+			}
+
+			result.Stdout = out.str();
+			result.Log    = text.str();
+			result.Done   = true;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				results[i] = std::move(result);
+			}
+
+			completed.notify_one();
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < jobs; ++i)
+		workers.emplace_back(worker, i);
+
+	size_t    failed = 0;
+	uintmax_t bytes  = 0;
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		BatchResult result;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			completed.wait(lock, [&]() { return results[i].Done; });
+			result  = std::move(results[i]);
+			current = i + 1;
+		}
+
+		printed.notify_all();
+
+		bytes += result.Size;
+
+		if (toStdout) {
+			std::cout << rang::fgB::cyan << "==> " << files[i] << " <==" << rang::style::reset << std::endl;
+			std::wcout << result.Stdout << std::flush;
+		}
+
+		if (toLog)
+			log << L"==> " << Utilities::String::ToWString(files[i]) << L" <==" << std::endl << result.Log;
+
+		if (!result.Warning.empty())
+			std::cout << rang::fgB::yellow << "warning: " << files[i] << ": " << result.Warning << std::endl << rang::style::reset;
+
+		if (!result.Error.empty()) {
+			++failed;
+			std::cout << rang::fgB::red << "error: " << files[i] << ": " << result.Error << std::endl << rang::style::reset;
+		}
+	}
+
+	for (auto& thread : workers)
+		thread.join();
+
+	if (sign) {
+		auto& signatures = aggregators.front();
+		for (size_t i = 1; i < aggregators.size(); ++i)
+			signatures.Merge(aggregators[i]);
+
+		std::cout << rang::fgB::green << signatures.size() << rang::style::reset << " distinct signatures in "
+			<< rang::fgB::green << signatures.Events() << rang::style::reset << " exceptions:" << std::endl;
+
+		for (const auto bucket : signatures.Sorted()) {
+			std::cout << rang::fgB::green << std::setw(10) << bucket->Count << rang::style::reset << "  "
+				<< rang::fg::gray << std::hex << std::setw(16) << std::setfill('0') << bucket->Hash << std::dec << std::setfill(' ') << rang::style::reset << "  "
+				<< bucket->Signature << std::endl
+				<< std::setw(30) << "" << "e.g. " << rang::fgB::cyan << bucket->Representative << rang::style::reset << std::endl;
+		}
+	}
+
+	auto seconds   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	auto megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+	if (seconds <= 0.0)
+		seconds = 1e-9;
+
+	std::cout << rang::fgB::green << files.size() << rang::style::reset << " files (" << failed << " failed), "
+		<< std::fixed << std::setprecision(2) << megabytes << " MB in " << seconds << "s using " << jobs << " threads: "
+		<< rang::fgB::green << (files.size() / seconds) << rang::style::reset << " files/s, "
+		<< rang::fgB::green << (megabytes / seconds) << rang::style::reset << " MB/s" << std::endl;
+
+	return failed == 0 ? 0 : 1;
+}
+
 /// <summary>
 /// Execute the hindsight [options] mortem [options] command.
 /// </summary>
@@ -302,9 +600,6 @@ int MortemCommand(Cli::HindsightCli& cli) {
 	std::shared_ptr<Hindsight::Process::Process>   process;
 	std::shared_ptr<Hindsight::Debugger::Debugger> debugger;
 
-	if (!command.isset(Cli::Descriptors::NAME_MAX_RECURSION) || command.get<size_t>(Cli::Descriptors::NAME_MAX_RECURSION) == 0)
-		command.set(Cli::Descriptors::NAME_MAX_RECURSION, static_cast<size_t>(SIZE_MAX));
-
 	try {
 		std::string path;
 		std::string wdir;
@@ -343,10 +638,13 @@ int MortemCommand(Cli::HindsightCli& cli) {
 		return 1;
 	}
 
+	// give each handler its own queue and thread?
+	auto dispatcher = create_dispatcher(cli);
+
 	// write to text file?
 	if (cli.isset(Cli::Descriptors::NAME_LOGTEXT)) {
 		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT));
-		debugger->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
+		add_handler(*debugger, dispatcher, std::make_shared<Hindsight::Debugger::EventHandler::PrintingDebuggerEventHandler>(
 			cli.get<std::string>(Cli::Descriptors::NAME_LOGTEXT),
 			command.isset(Cli::Descriptors::NAME_PRINTCTX)));
 	}
@@ -354,9 +652,12 @@ int MortemCommand(Cli::HindsightCli& cli) {
 	// write to binary file?
 	if (cli.isset(Cli::Descriptors::NAME_LOGBIN)) {
 		Utilities::Path::EnsureParentExists(cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN));
-		debugger->AddHandler(std::make_shared<Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler>(cli.get<std::string>(Cli::Descriptors::NAME_LOGBIN)));
+		add_handler(*debugger, dispatcher, create_writer(cli), true);
 	}
 
+	if (dispatcher != nullptr)
+		debugger->AddHandler(dispatcher);
+
 	if (!debugger->Attach()) {
 		auto lastError = GetLastError();
 		std::cout << rang::fgB::red << "error: cannot attach debugger (" << lastError << "), " << Hindsight::Utilities::Error::GetErrorMessage(lastError) << std::endl << rang::style::reset;
@@ -409,6 +710,8 @@ void create_launch_command(Cli::HindsightCli& cli) {
 	command.add_flag(Cli::Descriptors::DESC_BREAKF)->needs(command.get_option(Cli::Descriptors::NAME_BREAKE));
 	command.add_option<size_t>(Cli::Descriptors::DESC_MAX_RECURSION)->default_val("0");
 	command.add_option<size_t>(Cli::Descriptors::DESC_MAX_INSTRUCTION)->default_val("0");
+	command.add_flag(Cli::Descriptors::DESC_RAWFRAMES);
+	command.add_option<size_t>(Cli::Descriptors::DESC_STACKSNAPSHOT)->default_val("0");
 	command.add_flag(Cli::Descriptors::DESC_PRINTCTX);
 	command.add_flag(Cli::Descriptors::DESC_PRINTTIME);
 	command.add_option<std::vector<std::string>>(Cli::Descriptors::DESC_PDBSEARCH)->check(CLI::ExistingDirectory);
@@ -419,6 +722,34 @@ void create_launch_command(Cli::HindsightCli& cli) {
 	command.add_option<std::vector<std::string>>(Cli::Descriptors::DESC_ARGUMENTS);
 }
 
+/// <summary>
+/// Add the flags and options that are read by <see cref="Hindsight::BinaryLog::BinaryLogPlayer"/> to a subcommand that
+/// replays binary log files.
+/// </summary>
+/// <param name="command">The subcommand to add the options to.</param>
+void add_playback_options(Cli::HindsightCli& command) {
+	command.add_flag(Cli::Descriptors::DESC_PRINTCTX);
+	command.add_flag(Cli::Descriptors::DESC_PRINTTIME);
+
+	// this one is initialized directly due to the description relying on the EventFilterValidator entries
+	command.add_option<std::vector<std::string>>(
+		Cli::Descriptors::DESC_FILTER.Name,
+		Cli::Descriptors::DESC_FILTER.Flag,
+		Cli::Descriptors::DESC_FILTER.Desc + std::string(", options: ") + Hindsight::Cli::CliValidator::EventFilterValidator::GetValid()
+	)->check(Hindsight::Cli::CliValidator::EventFilterValidator::Validator);
+
+	command.add_flag(Cli::Descriptors::DESC_NOSANITY);
+	command.add_flag(Cli::Descriptors::DESC_NOMMAP);
+	command.add_flag(Cli::Descriptors::DESC_SINGLEPASS);
+	command.add_flag(Cli::Descriptors::DESC_RECOVER);
+	command.add_flag(Cli::Descriptors::DESC_LASTEXCEPTION);
+	command.add_flag(Cli::Descriptors::DESC_SYMBOLIZE);
+	command.add_option<std::string>(Cli::Descriptors::DESC_SYMBOLPATH)->needs(command.get_option(Cli::Descriptors::NAME_SYMBOLIZE));
+	command.add_option<std::string>(Cli::Descriptors::DESC_SYMBOLCACHE)->needs(command.get_option(Cli::Descriptors::NAME_SYMBOLIZE));
+	command.add_option<size_t>(Cli::Descriptors::DESC_WINDOWSTART);
+	command.add_option<size_t>(Cli::Descriptors::DESC_WINDOWEND);
+}
+
 /// <summary>
 /// Generate the `hindsight [options] replay [options] subcommand`.
 /// </summary>
@@ -434,23 +765,30 @@ void create_replay_command(Cli::HindsightCli& cli) {
 	command.add_flag(Cli::Descriptors::DESC_BREAKB);
 	command.add_flag(Cli::Descriptors::DESC_BREAKE);
 	command.add_flag(Cli::Descriptors::DESC_BREAKF)->needs(command.get_option(Cli::Descriptors::NAME_BREAKE));
-	command.add_flag(Cli::Descriptors::DESC_PRINTCTX);
-	command.add_flag(Cli::Descriptors::DESC_PRINTTIME);
-
-	// this one is initialized directly due to the description relying on the EventFilterValidator entries
-	command.add_option<std::vector<std::string>>(
-		Cli::Descriptors::DESC_FILTER.Name,
-		Cli::Descriptors::DESC_FILTER.Flag,
-		Cli::Descriptors::DESC_FILTER.Desc + std::string(", options: ") + Hindsight::Cli::CliValidator::EventFilterValidator::GetValid()
-	)->check(Hindsight::Cli::CliValidator::EventFilterValidator::Validator);
-
-	command.add_flag(Cli::Descriptors::DESC_NOSANITY);
+	add_playback_options(command);
 	command.add_flag(Cli::Descriptors::DESC_PPAUSE);
 
 	// positionals
 	command.add_option<std::string>(Cli::Descriptors::DESC_BINPATH)->required(true)->check(CLI::ExistingFile);
 }
 
+/// <summary>
+/// Generate the `hindsight [options] batch [options] subcommand`.
+/// </summary>
+/// <param name="app">The <see cref="CLI::App"/> instance that represents the parent command for this subcommand.</param>
+void create_batch_command(Cli::HindsightCli& cli) {
+	auto& command = cli.add_subcommand(Cli::Descriptors::NAME_SUBCOMMAND_BATCH, Cli::Descriptors::DESC_SUBCOMMAND_BATCH);
+
+	// flags and options
+	add_playback_options(command);
+	command.add_option<size_t>(Cli::Descriptors::DESC_JOBS)->default_val("0");
+	command.add_flag(Cli::Descriptors::DESC_SIGNATURES);
+	command.add_option<size_t>(Cli::Descriptors::DESC_SIGFRAMES)->default_val(std::to_string(Hindsight::Debugger::EventHandler::SignatureAggregator::DefaultFrames));
+
+	// positionals
+	command.add_option<std::vector<std::string>>(Cli::Descriptors::DESC_BATCHPATH)->required(true);
+}
+
 /// <summary>
 /// Generate the `hindsight [options] mortem [options] subcommand`.
 /// </summary>
@@ -466,6 +804,8 @@ void create_mortem_command(Cli::HindsightCli& cli) {
 	command.add_flag(Cli::Descriptors::DESC_PRINTTIME);
 	command.add_option<size_t>(Cli::Descriptors::DESC_MAX_RECURSION)->default_val("0");
 	command.add_option<size_t>(Cli::Descriptors::DESC_MAX_INSTRUCTION)->default_val("0");
+	command.add_flag(Cli::Descriptors::DESC_RAWFRAMES);
+	command.add_option<size_t>(Cli::Descriptors::DESC_STACKSNAPSHOT)->default_val("0");
 	command.add_option<std::vector<std::string>>(Cli::Descriptors::DESC_PDBSEARCH)->check(CLI::ExistingDirectory);
 	command.add_flag(Cli::Descriptors::DESC_PDBSELF);
 	command.add_option<DWORD>(Cli::Descriptors::DESC_JITPID)->required(true);
@@ -503,12 +843,32 @@ int main(int argc, char* argv[]) {
 	// add the WritingDebuggerEventHandler
 	cli.add_option<std::string>(Cli::Descriptors::DESC_LOGBIN);
 
+	// configure when the WritingDebuggerEventHandler flushes
+	cli.add_option<std::string>(
+		Cli::Descriptors::DESC_FLUSH.Name,
+		Cli::Descriptors::DESC_FLUSH.Flag,
+		Cli::Descriptors::DESC_FLUSH.Desc + std::string(", options: ") + Hindsight::Cli::CliValidator::FlushPolicyValidator::GetValid()
+	)->default_val("size")->check(Hindsight::Cli::CliValidator::FlushPolicyValidator::Validator);
+	cli.add_option<size_t>(Cli::Descriptors::DESC_FLUSHSIZE)->default_val(std::to_string(Hindsight::Debugger::EventHandler::WriterDebuggerEventHandler::DefaultFlushSize));
+	cli.add_flag(Cli::Descriptors::DESC_ASYNCWRITE);
+	cli.add_flag(Cli::Descriptors::DESC_COMPACT);
+	cli.add_flag(Cli::Descriptors::DESC_COMPRESS);
+
+	// give each handler its own queue and thread
+	cli.add_option<std::string>(
+		Cli::Descriptors::DESC_DISPATCH.Name,
+		Cli::Descriptors::DESC_DISPATCH.Flag,
+		Cli::Descriptors::DESC_DISPATCH.Desc + std::string(", options: ") + Hindsight::Cli::CliValidator::DispatchPolicyValidator::GetValid()
+	)->check(Hindsight::Cli::CliValidator::DispatchPolicyValidator::Validator);
+	cli.add_option<size_t>(Cli::Descriptors::DESC_DISPATCHQUEUE)->default_val(std::to_string(Hindsight::Debugger::EventHandler::DispatchingDebuggerEventHandler::DefaultQueueSize));
+
 	// disable colours
 	cli.add_flag(Cli::Descriptors::DESC_BLAND)
 		->needs(cli.get_option(Cli::Descriptors::NAME_STDOUT));
 
 	create_launch_command(cli);
 	create_replay_command(cli);
+	create_batch_command(cli);
 	create_mortem_command(cli);
 
 	// hindsight --version
@@ -538,7 +898,7 @@ int main(int argc, char* argv[]) {
 	auto textual_output = cli.anyset({ Cli::Descriptors::NAME_LOGTEXT, Cli::Descriptors::NAME_STDOUT });
 
 	// ensure the --print-context has a required option to specify where to print to
-	if (!textual_output && cli.subcommand_anyset({ Cli::Descriptors::NAME_SUBCOMMAND_LAUNCH, Cli::Descriptors::NAME_SUBCOMMAND_REPLAY }, { Cli::Descriptors::NAME_PRINTCTX, Cli::Descriptors::NAME_PRINTTIME })) {
+	if (!textual_output && cli.subcommand_anyset({ Cli::Descriptors::NAME_SUBCOMMAND_LAUNCH, Cli::Descriptors::NAME_SUBCOMMAND_REPLAY, Cli::Descriptors::NAME_SUBCOMMAND_BATCH }, { Cli::Descriptors::NAME_PRINTCTX, Cli::Descriptors::NAME_PRINTTIME })) {
 		std::cout << rang::fgB::red << "error: cannot use --print-context or --print-timestamp without either --stdout or --log" << std::endl << rang::style::reset;
 		return 1;
 	}
@@ -549,6 +909,15 @@ int main(int argc, char* argv[]) {
 	if (cli.is_subcommand_chosen(Cli::Descriptors::NAME_SUBCOMMAND_REPLAY))
 		return ReplayCommand(cli);
 
+	if (cli.is_subcommand_chosen(Cli::Descriptors::NAME_SUBCOMMAND_BATCH)) {
+		if (cli.isset(Cli::Descriptors::NAME_LOGBIN)) {
+			std::cout << rang::fgB::red << "error: cannot use --write-binary with the batch subcommand" << std::endl << rang::style::reset;
+			return 1;
+		}
+
+		return BatchCommand(cli);
+	}
+
 	if (cli.is_subcommand_chosen(Cli::Descriptors::NAME_SUBCOMMAND_MORTEM)) {
 		if (cli.isset(Cli::Descriptors::NAME_STDOUT)) {
 			std::cout << rang::fgB::red << "error: cannot use --stdout in the post-mortem debug mode" << std::endl << rang::style::reset;
@@ -0,0 +1,298 @@
+#include "Test.hpp"
+#include "BackendDebugger.hpp"
+#include "BinaryLogFile.hpp"
+#include "PtraceDebugBackend.hpp"
+#include "WriterDebuggerEventHandler.hpp"
+#include "crc32.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace Hindsight::BinaryLog;
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::Backend;
+using namespace Hindsight::Debugger::EventHandler;
+
+/// <summary>
+/// A handler that keeps what the tests check: the order of the events and the exception with its trace.
+/// </summary>
+struct RecordingHandler : public IDebuggerEventHandler {
+	std::vector<DWORD>						Events;			/* The debug event IDs, in order */
+	std::vector<std::wstring>				Modules;		/* The paths of the loaded modules */
+	EXCEPTION_DEBUG_INFO					Exception = {};	/* The first exception */
+	std::wstring							Name;			/* The name of the first exception */
+	std::shared_ptr<const DebugContext>		Context;		/* The context of the first exception */
+	std::shared_ptr<const DebugStackTrace>	Trace;			/* The trace of the first exception */
+	DWORD									ExitCode = 0;	/* The exit code of the process */
+	bool									Complete = false;
+
+	void OnInitialization(time_t, const std::shared_ptr<const Hindsight::Process::Process>) override {}
+
+	void OnBreakpointHit(time_t, const EXCEPTION_DEBUG_INFO&, const PROCESS_INFORMATION&, std::shared_ptr<const DebugContext>, std::shared_ptr<const DebugStackTrace>, const ModuleCollection&) override {
+		Events.push_back(EXCEPTION_DEBUG_EVENT);
+	}
+
+	void OnException(time_t, const EXCEPTION_DEBUG_INFO& info, const PROCESS_INFORMATION&, bool, const std::wstring& name, std::shared_ptr<const DebugContext> context, std::shared_ptr<const DebugStackTrace> trace, const ModuleCollection&, std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation>) override {
+		if (Trace == nullptr) {
+			Exception = info;
+			Name	  = name;
+			Context	  = context;
+			Trace	  = trace;
+		}
+
+		Events.push_back(EXCEPTION_DEBUG_EVENT);
+	}
+
+	void OnCreateProcess(time_t, const CREATE_PROCESS_DEBUG_INFO&, const PROCESS_INFORMATION&, const std::wstring& path, const ModuleCollection&) override {
+		Events.push_back(CREATE_PROCESS_DEBUG_EVENT);
+		Modules.push_back(path);
+	}
+
+	void OnCreateThread(time_t, const CREATE_THREAD_DEBUG_INFO&, const PROCESS_INFORMATION&, const ModuleCollection&) override {
+		Events.push_back(CREATE_THREAD_DEBUG_EVENT);
+	}
+
+	void OnExitProcess(time_t, const EXIT_PROCESS_DEBUG_INFO& info, const PROCESS_INFORMATION&, const ModuleCollection&) override {
+		Events.push_back(EXIT_PROCESS_DEBUG_EVENT);
+		ExitCode = info.dwExitCode;
+	}
+
+	void OnExitThread(time_t, const EXIT_THREAD_DEBUG_INFO&, const PROCESS_INFORMATION&, const ModuleCollection&) override {
+		Events.push_back(EXIT_THREAD_DEBUG_EVENT);
+	}
+
+	void OnDllLoad(time_t, const LOAD_DLL_DEBUG_INFO&, const PROCESS_INFORMATION&, const std::wstring& path, int, const ModuleCollection&) override {
+		Events.push_back(LOAD_DLL_DEBUG_EVENT);
+		Modules.push_back(path);
+	}
+
+	void OnDebugString(time_t, const OUTPUT_DEBUG_STRING_INFO&, const PROCESS_INFORMATION&, const std::string&) override {
+		Events.push_back(OUTPUT_DEBUG_STRING_EVENT);
+	}
+
+	void OnDebugStringW(time_t, const OUTPUT_DEBUG_STRING_INFO&, const PROCESS_INFORMATION&, const std::wstring&) override {
+		Events.push_back(OUTPUT_DEBUG_STRING_EVENT);
+	}
+
+	void OnRip(time_t, const RIP_INFO&, const PROCESS_INFORMATION&, const std::wstring&) override {
+		Events.push_back(RIP_EVENT);
+	}
+
+	void OnDllUnload(time_t, const UNLOAD_DLL_DEBUG_INFO&, const PROCESS_INFORMATION&, const std::wstring&, int, const ModuleCollection&) override {
+		Events.push_back(UNLOAD_DLL_DEBUG_EVENT);
+	}
+
+	void OnModuleCollectionComplete(time_t, const ModuleCollection&) override {
+		Complete = true;
+	}
+};
+
+/// <summary>
+/// Get the path of the program that crashes, as set up by the build.
+/// </summary>
+/// <returns>The path.</returns>
+static std::string crash_program() {
+	auto path = std::getenv("HINDSIGHT_TEST_CRASH");
+	return path != nullptr ? path : "";
+}
+
+/// <summary>
+/// Record a session of the crashing program with <paramref name="recorder"/> and the binary log writer.
+/// </summary>
+/// <param name="recorder">The handler that receives the events next to the writer.</param>
+/// <param name="logPath">The path of the binary log.</param>
+/// <param name="config">The options of the session.</param>
+static void record(std::shared_ptr<RecordingHandler> recorder, const std::string& logPath, const DebuggerConfig& config) {
+	PtraceDebugBackend backend(crash_program(), {});
+	BackendDebugger debugger(backend, config, crash_program(), ".", {});
+
+	const size_t flushSize = WriterDebuggerEventHandler::DefaultFlushSize;
+	debugger.AddHandler(recorder);
+	debugger.AddHandler(std::make_shared<WriterDebuggerEventHandler>(logPath, FlushPolicy::Size, flushSize, false, true));
+	debugger.Start();
+}
+
+/// <summary>
+/// Find the frame of a function in a trace.
+/// </summary>
+/// <param name="trace">The trace.</param>
+/// <param name="name">The symbol name.</param>
+/// <returns>The index of the frame, or SIZE_MAX when no frame has that name.</returns>
+static size_t find_frame(const DebugStackTrace& trace, const std::string& name) {
+	const auto& frames = trace.list();
+	for (size_t i = 0; i < frames.size(); ++i)
+		if (frames[i].Name == name)
+			return i;
+
+	return SIZE_MAX;
+}
+
+/// <summary>
+/// The events of ptrace arrive at the handlers as the debug events of Windows: the process with its image, the shared
+/// objects as DLL loads, the clone as a thread, the SIGSEGV as an access violation and the death by that signal as the
+/// exit of the process. The trace of the exception is walked along the frame pointers and symbolized from the image.
+/// </summary>
+HINDSIGHT_TEST(TranslatesPtraceEvents) {
+	auto recorder = std::make_shared<RecordingHandler>();
+	auto logPath  = std::string("BackendDebuggerTests.events.hind");
+
+	DebuggerConfig config;
+	config.StackSnapshot = 4096;
+	record(recorder, logPath, config);
+	std::remove(logPath.c_str());
+
+	const auto& events = recorder->Events;
+	CHECK(!events.empty() && events.front() == CREATE_PROCESS_DEBUG_EVENT);
+	CHECK(!events.empty() && events.back() == EXIT_PROCESS_DEBUG_EVENT);
+	CHECK(std::count(events.begin(), events.end(), CREATE_THREAD_DEBUG_EVENT) == 1);
+	CHECK(std::count(events.begin(), events.end(), EXIT_THREAD_DEBUG_EVENT) == 1);
+	CHECK(std::count(events.begin(), events.end(), LOAD_DLL_DEBUG_EVENT) > 0);
+	CHECK(std::count(events.begin(), events.end(), EXCEPTION_DEBUG_EVENT) > 0);
+	CHECK(recorder->Complete);
+
+	// the image is the process, libc is one of the modules
+	CHECK(!recorder->Modules.empty() && recorder->Modules.front().find(L"hindsight_crash") != std::wstring::npos);
+	CHECK(std::any_of(recorder->Modules.begin(), recorder->Modules.end(), [](const std::wstring& path) { return path.find(L"libc") != std::wstring::npos; }));
+
+	// killed by the signal that was passed on
+	CHECK(recorder->ExitCode == 128 + 11);
+
+	CHECK(recorder->Exception.ExceptionRecord.ExceptionCode == EXCEPTION_ACCESS_VIOLATION);
+	CHECK(recorder->Exception.ExceptionRecord.NumberParameters == 2);
+	CHECK(recorder->Exception.ExceptionRecord.ExceptionInformation[1] == 0);
+	CHECK(recorder->Exception.dwFirstChance != 0);
+	CHECK(recorder->Name == L"SIGSEGV");
+
+	CHECK(recorder->Context != nullptr && recorder->Context->Is64() == (sizeof(void*) == 8));
+	CHECK(recorder->Context != nullptr && !recorder->Context->GetStack().empty());
+
+	CHECK(recorder->Trace != nullptr);
+	if (recorder->Trace == nullptr)
+		return;
+
+	auto crash	= find_frame(*recorder->Trace, "crash_here");
+	auto caller = find_frame(*recorder->Trace, "crash_caller");
+	auto main	= find_frame(*recorder->Trace, "main");
+
+	CHECK(crash == 0);
+	CHECK(caller == 1);
+	CHECK(main == 2);
+	CHECK(recorder->Trace->list().front().Line != 0);
+}
+
+/// <summary>
+/// The writer records the translated session as a complete log: the checksum in the footer covers everything after the
+/// header, the index lists every event the handlers received in order and the string tables before them, and the module
+/// paths of the events refer to strings that were defined before them.
+/// </summary>
+HINDSIGHT_TEST(RecordsCompleteLog) {
+	auto recorder = std::make_shared<RecordingHandler>();
+	auto logPath  = std::string("BackendDebuggerTests.log.hind");
+
+	record(recorder, logPath, DebuggerConfig());
+
+	std::ifstream file(logPath, std::ios::binary);
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	std::remove(logPath.c_str());
+
+	CHECK(data.size() > sizeof(FileHeader) + sizeof(IndexFooter) + sizeof(FileFooter));
+	if (data.size() <= sizeof(FileHeader) + sizeof(IndexFooter) + sizeof(FileFooter))
+		return;
+
+	FileHeader header;
+	FileFooter footer;
+	IndexFooter indexFooter;
+	std::memcpy(&header, data.data(), sizeof(FileHeader));
+	std::memcpy(&footer, data.data() + data.size() - sizeof(FileFooter), sizeof(FileFooter));
+	std::memcpy(&indexFooter, data.data() + data.size() - sizeof(FileFooter) - sizeof(IndexFooter), sizeof(IndexFooter));
+
+	CHECK(std::memcmp(header.Signature, "HIND", 4) == 0);
+	CHECK(header.Flags == FileFlagInternedPaths);
+	CHECK(std::memcmp(footer.Signature, "HEND", 4) == 0);
+	CHECK(footer.Crc32 == Hindsight::Checksum::Crc32::Update(data.data() + sizeof(FileHeader), data.size() - sizeof(FileHeader) - sizeof(FileFooter), 0));
+	CHECK(footer.Events == recorder->Events.size());
+
+	CHECK(std::memcmp(indexFooter.Signature, "INDX", 4) == 0);
+	CHECK(indexFooter.IndexOffset + sizeof(IndexHeader) <= data.size());
+	if (indexFooter.IndexOffset + sizeof(IndexHeader) > data.size())
+		return;
+
+	IndexHeader index;
+	std::memcpy(&index, data.data() + indexFooter.IndexOffset, sizeof(IndexHeader));
+	CHECK(indexFooter.IndexOffset + sizeof(IndexHeader) + index.Count * sizeof(IndexEntry) + sizeof(IndexFooter) + sizeof(FileFooter) == data.size());
+	if (indexFooter.IndexOffset + sizeof(IndexHeader) + index.Count * sizeof(IndexEntry) > data.size())
+		return;
+
+	// every entry points at a string table or at an event frame with the same event ID, the strings are read as they come
+	std::vector<std::string> strings;
+	size_t events = 0;
+	size_t paths  = 0;
+
+	for (size_t i = 0; i < index.Count; ++i) {
+		IndexEntry entry;
+		std::memcpy(&entry, data.data() + indexFooter.IndexOffset + sizeof(IndexHeader) + i * sizeof(IndexEntry), sizeof(IndexEntry));
+
+		if (entry.Flags & IndexFlagStrings) {
+			StringTableEntry table;
+			CHECK(entry.Offset + sizeof(StringTableEntry) <= indexFooter.IndexOffset);
+			if (entry.Offset + sizeof(StringTableEntry) > indexFooter.IndexOffset)
+				return;
+
+			std::memcpy(&table, data.data() + entry.Offset, sizeof(StringTableEntry));
+			CHECK(std::memcmp(table.Signature, "STRS", 4) == 0);
+			CHECK(table.First == strings.size() + 1);
+			CHECK(entry.Offset + sizeof(StringTableEntry) + table.Size <= indexFooter.IndexOffset);
+			if (entry.Offset + sizeof(StringTableEntry) + table.Size > indexFooter.IndexOffset)
+				return;
+
+			CompactDecoder decoder(reinterpret_cast<const char*>(data.data() + entry.Offset + sizeof(StringTableEntry)), table.Size, strings);
+			for (uint32_t n = 0; n < table.Count; ++n)
+				decoder.Raw(strings.emplace_back());
+
+			CHECK(decoder.Done());
+			continue;
+		}
+
+		CHECK(events < recorder->Events.size());
+		if (events >= recorder->Events.size())
+			return;
+
+		CHECK(entry.EventId == recorder->Events[events++]);
+
+		EventEntry event;
+		CHECK(entry.Offset + sizeof(EventEntry) <= indexFooter.IndexOffset);
+		if (entry.Offset + sizeof(EventEntry) > indexFooter.IndexOffset)
+			continue;
+
+		std::memcpy(&event, data.data() + entry.Offset, sizeof(EventEntry));
+		CHECK(std::memcmp(event.Signature, "EVNT", 4) == 0);
+		CHECK(event.EventId == entry.EventId);
+
+		// the module path of a DLL load is a reference to a string that was defined before it
+		if (event.EventId == LOAD_DLL_DEBUG_EVENT && entry.Offset + sizeof(DllLoadEventEntry) <= indexFooter.IndexOffset) {
+			DllLoadEventEntry load;
+			std::wstring path;
+			std::memcpy(&load, data.data() + entry.Offset, sizeof(DllLoadEventEntry));
+
+			CompactDecoder(nullptr, 0, strings).Lookup(load.ModulePathSize, path);
+			CHECK(!path.empty());
+			++paths;
+		}
+	}
+
+	CHECK(events == recorder->Events.size());
+	CHECK(paths == static_cast<size_t>(std::count(recorder->Events.begin(), recorder->Events.end(), LOAD_DLL_DEBUG_EVENT)));
+	CHECK(paths != 0);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
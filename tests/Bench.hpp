@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef tests_bench_h
+#define tests_bench_h
+	#include <chrono>
+	#include <cstddef>
+	#include <cstdio>
+	#include <cstdint>
+	#include <fstream>
+	#include <iterator>
+	#include <string>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Bench {
+			/// <summary>
+			/// The number of times each measurement is repeated, the fastest run is reported so that a single preemption does not skew it.
+			/// </summary>
+			static const int Runs = 5;
+
+			/// <summary>
+			/// Run <paramref name="body"/> <see cref="Runs"/> times and measure the fastest run.
+			/// </summary>
+			/// <param name="body">The code to measure.</param>
+			/// <typeparam name="F">The type of the callable.</typeparam>
+			/// <returns>The duration of the fastest run in seconds.</returns>
+			template <typename F>
+			double Fastest(F body) {
+				double best = 0;
+
+				for (int run = 0; run < Runs; ++run) {
+					auto start = std::chrono::steady_clock::now();
+					body();
+					std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+					if (run == 0 || elapsed.count() < best)
+						best = elapsed.count();
+				}
+
+				return best;
+			}
+
+			/// <summary>
+			/// Print the throughput of a measurement in MB/s.
+			/// </summary>
+			/// <param name="name">The name of the measurement.</param>
+			/// <param name="bytes">The number of bytes processed in one run.</param>
+			/// <param name="seconds">The duration of one run in seconds.</param>
+			inline void Throughput(const std::string& name, size_t bytes, double seconds) {
+				std::printf("%-40s %10.1f MB/s\n", name.c_str(), seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0);
+			}
+
+			/// <summary>
+			/// Print the rate of a measurement in operations per second, with the duration of a single operation.
+			/// </summary>
+			/// <param name="name">The name of the measurement.</param>
+			/// <param name="operations">The number of operations in one run.</param>
+			/// <param name="seconds">The duration of one run in seconds.</param>
+			inline void Rate(const std::string& name, size_t operations, double seconds) {
+				std::printf("%-40s %10.1f M/s %8.1f ns/op\n", name.c_str(), seconds > 0 ? operations / seconds / 1e6 : 0.0, operations > 0 ? seconds * 1e9 / operations : 0.0);
+			}
+
+			/// <summary>
+			/// Keep a result alive, so that the compiler cannot drop the code that computes it.
+			/// </summary>
+			/// <param name="value">The result.</param>
+			inline void Keep(uint64_t value) {
+				static volatile uint64_t sink;
+				sink = sink + value;
+			}
+
+			/// <summary>
+			/// Read a file into memory, a benchmark uses this for data given on its command line.
+			/// </summary>
+			/// <param name="path">The path of the file.</param>
+			/// <returns>The contents of the file, or no data when it cannot be read.</returns>
+			inline std::vector<char> ReadFile(const std::string& path) {
+				std::ifstream file(path, std::ios::binary);
+				return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			}
+
+			/// <summary>
+			/// Generate <paramref name="size"/> bytes of deterministic pseudo-random data.
+			/// </summary>
+			/// <param name="size">The number of bytes.</param>
+			/// <param name="seed">The seed of the generator.</param>
+			/// <returns>The data.</returns>
+			inline std::vector<char> RandomData(size_t size, uint32_t seed) {
+				std::vector<char> data(size);
+				for (auto& byte : data) {
+					seed = seed * 1664525 + 1013904223;
+					byte = static_cast<char>(seed >> 24);
+				}
+
+				return data;
+			}
+		}
+	}
+#endif
@@ -0,0 +1,186 @@
+#include "Test.hpp"
+#include "CachingMemoryReader.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace Hindsight::Debugger::Backend;
+
+static const uint64_t Page = CachingMemoryReader::PageSize;
+
+/// <summary>
+/// A reader of fake process memory made of readable segments, every other address is unreadable. A read stops at the first
+/// unreadable byte, like a read of a real process stops at an unmapped page. Every call to ReadMany is recorded.
+/// </summary>
+struct FakeMemoryReader : public IMemoryReader {
+	std::vector<std::pair<uint64_t, uint64_t>>		Segments;	/* The readable segments: first address, end address */
+	mutable std::vector<std::vector<MemoryRange>>	Batches;	/* The ranges of every call to ReadMany */
+
+	/// <summary>
+	/// Get the value of the byte at an address, which differs between pages and within a page.
+	/// </summary>
+	/// <param name="address">The address.</param>
+	/// <returns>The value.</returns>
+	static uint8_t At(uint64_t address) {
+		return static_cast<uint8_t>(address ^ (address >> 12) * 31);
+	}
+
+	/// <summary>
+	/// Determine if an address is in one of the readable segments.
+	/// </summary>
+	/// <param name="address">The address.</param>
+	/// <returns>True when the address is readable.</returns>
+	bool Readable(uint64_t address) const {
+		for (const auto& segment : Segments)
+			if (address >= segment.first && address < segment.second)
+				return true;
+
+		return false;
+	}
+
+	/// <summary>
+	/// Record the batch and read its ranges one by one.
+	/// </summary>
+	/// <param name="ranges">The ranges to read, the number of bytes read is stored in each range.</param>
+	/// <param name="count">The number of ranges.</param>
+	void ReadMany(MemoryRange* ranges, size_t count) const override {
+		Batches.emplace_back(ranges, ranges + count);
+		IMemoryReader::ReadMany(ranges, count);
+	}
+
+	/// <summary>
+	/// Read up to <paramref name="size"/> bytes at <paramref name="address"/>, up to the first unreadable byte.
+	/// </summary>
+	/// <param name="address">The address.</param>
+	/// <param name="buffer">The buffer that receives the data.</param>
+	/// <param name="size">The number of bytes to read.</param>
+	/// <returns>The number of bytes that were read.</returns>
+	size_t Read(uint64_t address, void* buffer, size_t size) const override {
+		size_t read = 0;
+		while (read < size && Readable(address + read)) {
+			static_cast<uint8_t*>(buffer)[read] = At(address + read);
+			++read;
+		}
+
+		return read;
+	}
+};
+
+/// <summary>
+/// Check that <paramref name="size"/> bytes at <paramref name="address"/> in <paramref name="buffer"/> hold the fake memory.
+/// </summary>
+/// <param name="buffer">The data that was read.</param>
+/// <param name="address">The address it was read from.</param>
+/// <param name="size">The number of bytes to check.</param>
+/// <returns>True when all bytes match.</returns>
+static bool matches(const std::vector<uint8_t>& buffer, uint64_t address, size_t size) {
+	for (size_t i = 0; i < size; ++i)
+		if (buffer[i] != FakeMemoryReader::At(address + i))
+			return false;
+
+	return true;
+}
+
+/// <summary>
+/// The pages that a batch misses are merged into runs of adjacent pages and read from the source in a single call with one
+/// range per run. A page that two ranges share is read once, and reads that hit the cache do not reach the source.
+/// </summary>
+HINDSIGHT_TEST(MergesAdjacentMisses) {
+	FakeMemoryReader source;
+	source.Segments.emplace_back(0, 16 * Page);
+
+	CachingMemoryReader reader(source);
+	std::vector<uint8_t> a(16), b(Page), c(8), d(32);
+
+	MemoryRange ranges[4];
+	ranges[0] = { 5 * Page + 100, a.data(), a.size() };
+	ranges[1] = { 5 * Page + 200, b.data(), b.size() };	/* pages 5 and 6 */
+	ranges[2] = { 9 * Page + 4, c.data(), c.size() };
+	ranges[3] = { 6 * Page - 16, d.data(), d.size() };	/* pages 5 and 6 */
+	reader.ReadMany(ranges, 4);
+
+	CHECK(reader.Fetches() == 1);
+	CHECK(source.Batches.size() == 1 && source.Batches[0].size() == 2);
+	if (source.Batches.size() != 1 || source.Batches[0].size() != 2)
+		return;
+
+	CHECK(source.Batches[0][0].Address == 5 * Page && source.Batches[0][0].Size == 2 * Page);
+	CHECK(source.Batches[0][1].Address == 9 * Page && source.Batches[0][1].Size == Page);
+
+	CHECK(ranges[0].Read == a.size() && matches(a, ranges[0].Address, a.size()));
+	CHECK(ranges[1].Read == b.size() && matches(b, ranges[1].Address, b.size()));
+	CHECK(ranges[2].Read == c.size() && matches(c, ranges[2].Address, c.size()));
+	CHECK(ranges[3].Read == d.size() && matches(d, ranges[3].Address, d.size()));
+
+	// served from the cache
+	CHECK(reader.Read(6 * Page + 1000, b.data(), 64) == 64 && matches(b, 6 * Page + 1000, 64));
+	CHECK(reader.Read(9 * Page, c.data(), c.size()) == c.size() && matches(c, 9 * Page, c.size()));
+	CHECK(reader.Fetches() == 1 && source.Batches.size() == 1);
+
+	// only the pages that are not cached yet are fetched, pages 7 and 8 form one run
+	std::vector<uint8_t> e(3 * Page);
+	CHECK(reader.Read(6 * Page, e.data(), e.size()) == e.size() && matches(e, 6 * Page, e.size()));
+	CHECK(reader.Fetches() == 2);
+	CHECK(source.Batches.size() == 2 && source.Batches[1].size() == 1 && source.Batches[1][0].Address == 7 * Page && source.Batches[1][0].Size == 2 * Page);
+}
+
+/// <summary>
+/// The source returns a short read at a page boundary: the pages before it are cached as valid, the first page after it is
+/// cached as unreadable and the pages after that were not attempted, so they are not cached and a later read fetches them.
+/// </summary>
+HINDSIGHT_TEST(ReportsUnreadableTailAtPageBoundary) {
+	FakeMemoryReader source;
+	source.Segments.emplace_back(0, 3 * Page);
+
+	CachingMemoryReader reader(source);
+	std::vector<uint8_t> buffer(4 * Page);
+
+	CHECK(reader.Read(Page + 10, buffer.data(), 4 * Page) == 2 * Page - 10);
+	CHECK(matches(buffer, Page + 10, 2 * Page - 10));
+	CHECK(reader.Fetches() == 1);
+
+	// the readable pages are cached
+	CHECK(reader.Read(2 * Page, buffer.data(), Page) == Page && matches(buffer, 2 * Page, Page));
+	CHECK(reader.Fetches() == 1);
+
+	// the first unreadable page is cached as such
+	CHECK(reader.Read(3 * Page + 8, buffer.data(), 8) == 0);
+	CHECK(reader.Read(3 * Page - 8, buffer.data(), 16) == 8 && matches(buffer, 3 * Page - 8, 8));
+	CHECK(reader.Fetches() == 1);
+
+	// the pages after it were never read, so they are fetched now, and a page that becomes readable is read
+	source.Segments.emplace_back(4 * Page, 5 * Page);
+	CHECK(reader.Read(4 * Page, buffer.data(), 16) == 16 && matches(buffer, 4 * Page, 16));
+	CHECK(reader.Fetches() == 2);
+}
+
+/// <summary>
+/// A page that is only partially readable ends a range, even when the next page is cached and fully readable.
+/// </summary>
+HINDSIGHT_TEST(PartialPageEndsRange) {
+	FakeMemoryReader source;
+	source.Segments.emplace_back(0, Page + 100);
+	source.Segments.emplace_back(2 * Page, 3 * Page);
+
+	CachingMemoryReader reader(source);
+	std::vector<uint8_t> buffer(3 * Page);
+
+	// cache page 2 first
+	CHECK(reader.Read(2 * Page, buffer.data(), Page) == Page);
+	CHECK(reader.Fetches() == 1);
+
+	CHECK(reader.Read(0, buffer.data(), 3 * Page) == Page + 100);
+	CHECK(matches(buffer, 0, Page + 100));
+	CHECK(reader.Fetches() == 2);
+	CHECK(source.Batches.size() == 2 && source.Batches[1].size() == 1 && source.Batches[1][0].Address == 0 && source.Batches[1][0].Size == 2 * Page);
+
+	// the partial page is cached with its readable bytes
+	CHECK(reader.Read(Page + 90, buffer.data(), 20) == 10 && matches(buffer, Page + 90, 10));
+	CHECK(reader.Read(Page + 100, buffer.data(), 1) == 0);
+	CHECK(reader.Fetches() == 2);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,22 @@
+#include <thread>
+
+/// <summary>
+/// The program that BackendDebuggerTests records: it starts and joins a thread, then writes through a null pointer three
+/// frames deep. The frames are kept (no inlining, frame pointers) so that the recorded trace can be checked by name.
+/// </summary>
+
+extern "C" __attribute__((noinline)) void crash_here(volatile int* target) {
+	*target = 42;
+}
+
+extern "C" __attribute__((noinline)) void crash_caller(volatile int* target) {
+	crash_here(target);
+}
+
+int main() {
+	std::thread worker([] {});
+	worker.join();
+
+	crash_caller(nullptr);
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "Bench.hpp"
+#include "crc32.hpp"
+
+#include <string>
+#include <vector>
+
+using Hindsight::Checksum::Crc32;
+using namespace Hindsight::Bench;
+
+/// <summary>
+/// Measure every CRC32 kernel over <paramref name="data"/> in one call, like CheckSanity does over a log that is mapped into memory.
+/// </summary>
+/// <param name="name">The name of the data.</param>
+/// <param name="data">The data to checksum.</param>
+static void measure(const std::string& name, const std::vector<char>& data) {
+	std::printf("%s (%zu bytes)\n", name.c_str(), data.size());
+
+	Throughput("  bytewise", data.size(), Fastest([&]() { Keep(Crc32::UpdateBytewise(data.data(), data.size(), 0)); }));
+	Throughput("  slicing-by-8", data.size(), Fastest([&]() { Keep(Crc32::UpdateSlicing8(data.data(), data.size(), 0)); }));
+	Throughput("  slicing-by-16", data.size(), Fastest([&]() { Keep(Crc32::UpdateSlicing16(data.data(), data.size(), 0)); }));
+
+#if HINDSIGHT_CRC32_CLMUL
+	if (Crc32::HasClmul())
+		Throughput("  pclmulqdq", data.size(), Fastest([&]() { Keep(Crc32::UpdateClmul(data.data(), data.size(), 0)); }));
+	else
+		std::printf("  pclmulqdq not supported by this processor\n");
+#else
+	std::printf("  pclmulqdq not built for this target\n");
+#endif
+
+	Throughput("  Update (selected kernel)", data.size(), Fastest([&]() { Keep(Crc32::Update(data.data(), data.size(), 0)); }));
+}
+
+/// <summary>
+/// Compare the CRC32 kernels on multi-MB buffers of random data, and on every file given on the command line (i.e. HIND logs).
+/// </summary>
+int main(int argc, char** argv) {
+	measure("random data", RandomData(4 * 1024 * 1024, 0x1234));
+	measure("random data", RandomData(64 * 1024 * 1024, 0x5678));
+
+	for (int i = 1; i < argc; ++i) {
+		auto data = ReadFile(argv[i]);
+		if (data.empty()) {
+			std::fprintf(stderr, "cannot read %s\n", argv[i]);
+			return 1;
+		}
+
+		measure(argv[i], data);
+	}
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include "Test.hpp"
+#include "crc32.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using Hindsight::Checksum::Crc32;
+
+/// <summary>
+/// Generate <paramref name="size"/> bytes of deterministic pseudo-random data.
+/// </summary>
+/// <param name="size">The number of bytes.</param>
+/// <param name="seed">The seed of the generator.</param>
+/// <returns>The data.</returns>
+static std::vector<uint8_t> random_data(size_t size, uint32_t seed) {
+	std::vector<uint8_t> data(size);
+	for (auto& byte : data) {
+		seed = seed * 1664525 + 1013904223;
+		byte = static_cast<uint8_t>(seed >> 24);
+	}
+
+	return data;
+}
+
+/// <summary>
+/// The well-known check value of CRC-32/ISO-HDLC is 0xCBF43926 for the ASCII digits 1 through 9.
+/// </summary>
+HINDSIGHT_TEST(MatchesCheckValue) {
+	const char digits[] = "123456789";
+
+	CHECK(Crc32::UpdateBytewise(digits, 9, 0) == 0xCBF43926);
+	CHECK(Crc32::UpdateSlicing8(digits, 9, 0) == 0xCBF43926);
+	CHECK(Crc32::UpdateSlicing16(digits, 9, 0) == 0xCBF43926);
+	CHECK(Crc32::Update(digits, 9, 0) == 0xCBF43926);
+}
+
+/// <summary>
+/// Every kernel produces the bytewise checksum for every length around the block sizes of the kernels and at 
+/// every alignment of the data, with a non-zero initial checksum.
+/// </summary>
+HINDSIGHT_TEST(KernelsAreEquivalent) {
+	auto data = random_data(4096 + 64, 0x1234);
+
+	for (size_t offset = 0; offset < 16; ++offset) {
+		for (size_t size = 0; size <= 1024; size += (size < 300 ? 1 : 61)) {
+			auto buf	  = data.data() + offset;
+			auto expected = Crc32::UpdateBytewise(buf, size, 0xdeadbeef);
+
+			CHECK(Crc32::UpdateSlicing8(buf, size, 0xdeadbeef) == expected);
+			CHECK(Crc32::UpdateSlicing16(buf, size, 0xdeadbeef) == expected);
+			CHECK(Crc32::Update(buf, size, 0xdeadbeef) == expected);
+		#if HINDSIGHT_CRC32_CLMUL
+			if (Crc32::HasClmul())
+				CHECK(Crc32::UpdateClmul(buf, size, 0xdeadbeef) == expected);
+		#endif
+		}
+	}
+}
+
+/// <summary>
+/// Updating in pieces gives the same checksum as updating at once, which the writer and player rely on.
+/// </summary>
+HINDSIGHT_TEST(UpdatesCompose) {
+	auto data	  = random_data(10000, 42);
+	auto expected = Crc32::UpdateBytewise(data.data(), data.size(), 0);
+
+	uint32_t crc = 0;
+	for (size_t offset = 0, piece = 1; offset < data.size(); offset += piece, piece = piece * 3 % 1021 + 1) {
+		auto size = std::min(piece, data.size() - offset);
+		crc = Crc32::Update(data.data() + offset, size, crc);
+	}
+
+	CHECK(crc == expected);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,242 @@
+#include "Test.hpp"
+#include "DispatchingDebuggerEventHandler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::EventHandler;
+
+/// <summary>
+/// A handler that records a label for every event it receives, and holds each delivery until its gate is opened. With the
+/// gate closed the worker is stuck on the first event, so the queue in front of it fills up exactly as the test posts.
+/// </summary>
+class GatedHandler : public IDebuggerEventHandler {
+	private:
+		std::mutex					m_Mutex;			/* Guards all members below */
+		std::condition_variable		m_Changed;			/* Signalled when an event enters or the gate opens */
+		bool						m_Open = false;		/* True when deliveries may complete */
+		size_t						m_Entered = 0;		/* The number of deliveries that have started */
+		std::vector<std::string>	m_Labels;			/* The labels of the delivered events, in order */
+
+	public:
+		/// <summary>
+		/// Let all deliveries through, from now on.
+		/// </summary>
+		void Open() {
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Open = true;
+			}
+
+			m_Changed.notify_all();
+		}
+
+		/// <summary>
+		/// Wait until the worker is holding the first event at the gate.
+		/// </summary>
+		void WaitForFirst() {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Changed.wait(lock, [this]() { return m_Entered != 0; });
+		}
+
+		/// <summary>
+		/// Get the labels of the delivered events.
+		/// </summary>
+		/// <returns>A copy of the labels, in order.</returns>
+		std::vector<std::string> Labels() {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Labels;
+		}
+
+		void OnInitialization(time_t, const std::shared_ptr<const Hindsight::Process::Process>) override { Deliver("init"); }
+		void OnBreakpointHit(time_t, const EXCEPTION_DEBUG_INFO&, const PROCESS_INFORMATION&, std::shared_ptr<const DebugContext>, std::shared_ptr<const DebugStackTrace>, const ModuleCollection&) override { Deliver("breakpoint"); }
+		void OnException(time_t, const EXCEPTION_DEBUG_INFO&, const PROCESS_INFORMATION&, bool, const std::wstring&, std::shared_ptr<const DebugContext>, std::shared_ptr<const DebugStackTrace>, const ModuleCollection&, std::shared_ptr<const CxxExceptions::ExceptionRunTimeTypeInformation>) override { Deliver("exception"); }
+		void OnCreateProcess(time_t, const CREATE_PROCESS_DEBUG_INFO&, const PROCESS_INFORMATION&, const std::wstring&, const ModuleCollection&) override { Deliver("process"); }
+		void OnCreateThread(time_t, const CREATE_THREAD_DEBUG_INFO&, const PROCESS_INFORMATION&, const ModuleCollection&) override { Deliver("thread"); }
+		void OnExitProcess(time_t, const EXIT_PROCESS_DEBUG_INFO&, const PROCESS_INFORMATION&, const ModuleCollection&) override { Deliver("exit process"); }
+		void OnExitThread(time_t, const EXIT_THREAD_DEBUG_INFO&, const PROCESS_INFORMATION&, const ModuleCollection&) override { Deliver("exit thread"); }
+		void OnDllLoad(time_t, const LOAD_DLL_DEBUG_INFO&, const PROCESS_INFORMATION&, const std::wstring&, int, const ModuleCollection&) override { Deliver("load"); }
+		void OnDebugString(time_t, const OUTPUT_DEBUG_STRING_INFO&, const PROCESS_INFORMATION&, const std::string& string) override { Deliver(string); }
+		void OnDebugStringW(time_t, const OUTPUT_DEBUG_STRING_INFO&, const PROCESS_INFORMATION&, const std::wstring&) override { Deliver("string"); }
+		void OnRip(time_t, const RIP_INFO&, const PROCESS_INFORMATION&, const std::wstring&) override { Deliver("rip"); }
+		void OnDllUnload(time_t, const UNLOAD_DLL_DEBUG_INFO&, const PROCESS_INFORMATION&, const std::wstring&, int, const ModuleCollection&) override { Deliver("unload"); }
+		void OnModuleCollectionComplete(time_t, const ModuleCollection&) override { Deliver("complete"); }
+
+	private:
+		/// <summary>
+		/// Record an event once the gate is open.
+		/// </summary>
+		/// <param name="label">The label of the event.</param>
+		void Deliver(const std::string& label) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			++m_Entered;
+			m_Changed.notify_all();
+
+			m_Changed.wait(lock, [this]() { return m_Open; });
+			m_Labels.push_back(label);
+		}
+};
+
+/// <summary>
+/// Post a debug string, which may be discarded under backpressure.
+/// </summary>
+/// <param name="dispatcher">The dispatcher.</param>
+/// <param name="string">The debug string, which is also its label.</param>
+static void post_string(DispatchingDebuggerEventHandler& dispatcher, const std::string& string) {
+	dispatcher.OnDebugString(0, OUTPUT_DEBUG_STRING_INFO{}, PROCESS_INFORMATION{}, string);
+}
+
+/// <summary>
+/// Post a module load, which is never discarded.
+/// </summary>
+/// <param name="dispatcher">The dispatcher.</param>
+/// <param name="modules">The module collection, which must outlive the call.</param>
+static void post_load(DispatchingDebuggerEventHandler& dispatcher, const ModuleCollection& modules) {
+	dispatcher.OnDllLoad(0, LOAD_DLL_DEBUG_INFO{}, PROCESS_INFORMATION{}, L"module.dll", 0, modules);
+}
+
+/// <summary>
+/// Create a dispatcher with one gated handler, whose worker holds the initialization event at the gate, so that the queue
+/// is empty and every further post lands in it.
+/// </summary>
+/// <param name="handler">The handler.</param>
+/// <param name="policy">The backpressure policy.</param>
+/// <param name="capacity">The queue size.</param>
+/// <returns>The dispatcher.</returns>
+static std::unique_ptr<DispatchingDebuggerEventHandler> make_stalled(std::shared_ptr<GatedHandler> handler, BackpressurePolicy policy, size_t capacity) {
+	auto dispatcher = std::make_unique<DispatchingDebuggerEventHandler>(policy, capacity);
+	dispatcher->AddHandler(handler);
+	dispatcher->OnInitialization(0, nullptr);
+	handler->WaitForFirst();
+	return dispatcher;
+}
+
+/// <summary>
+/// A full queue with the block policy holds up the producer until the handler makes room, and nothing is lost.
+/// </summary>
+HINDSIGHT_TEST(BlockWaitsForRoom) {
+	auto handler	= std::make_shared<GatedHandler>();
+	auto dispatcher = make_stalled(handler, BackpressurePolicy::Block, 2);
+
+	post_string(*dispatcher, "0");
+	post_string(*dispatcher, "1");
+
+	std::atomic<bool> posted(false);
+	std::thread producer([&]() {
+		post_string(*dispatcher, "2");
+		post_string(*dispatcher, "3");
+		posted = true;
+	});
+
+	// the queue is full and the handler cannot take anything, so the producer stays blocked for as long as the gate is shut
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(!posted);
+
+	handler->Open();
+	producer.join();
+	dispatcher->Drain();
+
+	CHECK(posted);
+	CHECK(dispatcher->Dropped() == 0);
+	CHECK((handler->Labels() == std::vector<std::string>{ "init", "0", "1", "2", "3" }));
+}
+
+/// <summary>
+/// A full queue with the drop-oldest policy never holds up the producer: the oldest event that may be discarded makes room,
+/// the module loads are kept and the survivors arrive in order.
+/// </summary>
+HINDSIGHT_TEST(DropOldestKeepsNewestAndEssential) {
+	ModuleCollection modules;
+	auto handler	= std::make_shared<GatedHandler>();
+	auto dispatcher = make_stalled(handler, BackpressurePolicy::DropOldest, 4);
+
+	post_string(*dispatcher, "0");
+	post_load(*dispatcher, modules);
+	for (int i = 1; i < 10; ++i)
+		post_string(*dispatcher, std::to_string(i));
+
+	// [0 load 1 2] is full, each of 3 to 9 pushes out the oldest string
+	CHECK(dispatcher->Dropped() == 7);
+
+	handler->Open();
+	dispatcher->Drain();
+
+	CHECK(dispatcher->Dropped() == 7);
+	CHECK((handler->Labels() == std::vector<std::string>{ "init", "load", "7", "8", "9" }));
+}
+
+/// <summary>
+/// A full queue with the sample policy discards the events that arrive at it, except every SampleInterval-th one and the
+/// essential ones, which wait for room like the block policy.
+/// </summary>
+HINDSIGHT_TEST(SampleKeepsEveryIntervalAndEssential) {
+	static_assert(DispatchChannel::SampleInterval == 8, "the expected labels assume one in eight events is kept");
+
+	ModuleCollection modules;
+	auto handler	= std::make_shared<GatedHandler>();
+	auto dispatcher = make_stalled(handler, BackpressurePolicy::Sample, 2);
+
+	// 0 and 1 fill the queue, 2 to 8 are the first seven events under pressure and are discarded without waiting
+	for (int i = 0; i < 9; ++i)
+		post_string(*dispatcher, std::to_string(i));
+
+	CHECK(dispatcher->Dropped() == 7);
+
+	// 9 is the eighth event under pressure and the load is essential, both wait for room
+	std::atomic<bool> posted(false);
+	std::thread producer([&]() {
+		post_string(*dispatcher, "9");
+		post_load(*dispatcher, modules);
+		posted = true;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(!posted);
+
+	handler->Open();
+	producer.join();
+	dispatcher->Drain();
+
+	CHECK(dispatcher->Dropped() == 7);
+	CHECK((handler->Labels() == std::vector<std::string>{ "init", "0", "1", "9", "load" }));
+}
+
+/// <summary>
+/// Handlers with different policies are independent: a stalled handler that drops events does not hold up or thin out
+/// the events of a handler that blocks.
+/// </summary>
+HINDSIGHT_TEST(PoliciesArePerHandler) {
+	auto stalled  = std::make_shared<GatedHandler>();
+	auto complete = std::make_shared<GatedHandler>();
+	complete->Open();
+
+	DispatchingDebuggerEventHandler dispatcher(BackpressurePolicy::Block, 2);
+	dispatcher.AddHandler(stalled, BackpressurePolicy::DropOldest);
+	dispatcher.AddHandler(complete);
+
+	dispatcher.OnInitialization(0, nullptr);
+	stalled->WaitForFirst();
+
+	std::vector<std::string> expected = { "init" };
+	for (int i = 0; i < 100; ++i) {
+		post_string(dispatcher, std::to_string(i));
+		expected.push_back(std::to_string(i));
+	}
+
+	stalled->Open();
+	dispatcher.Drain();
+
+	CHECK(complete->Labels() == expected);
+	CHECK((stalled->Labels() == std::vector<std::string>{ "init", "98", "99" }));
+	CHECK(dispatcher.Dropped() == 98);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
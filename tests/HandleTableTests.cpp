@@ -0,0 +1,190 @@
+#include "Test.hpp"
+#include "HandleTable.hpp"
+
+#include <map>
+#include <set>
+#include <cstdint>
+
+using Hindsight::Debugger::HandleTable;
+
+/// <summary>
+/// A fake operating system that hands out numbered handles, tracks which of them are open and notices when a handle is
+/// closed twice or when the debugger closes a handle that the system delivered with a debug event.
+/// </summary>
+struct FakeSystem {
+	uintptr_t			NextHandle = 0x100;	/* The next handle to hand out */
+	std::set<uint32_t>	Running;			/* The IDs that can be opened */
+	std::set<uintptr_t>	Opened;				/* The handles opened through the table and not closed yet */
+	std::set<uintptr_t>	Delivered;			/* The handles delivered with creation events, owned by the system */
+	size_t				Opens = 0;			/* The number of successful opens */
+	size_t				Closes = 0;			/* The number of closes */
+	bool				Misused = false;	/* True when an unknown or delivered handle was closed */
+
+	/// <summary>
+	/// Deliver a handle with a creation event.
+	/// </summary>
+	/// <param name="id">The process or thread ID.</param>
+	/// <returns>The borrowed handle.</returns>
+	uintptr_t Deliver(uint32_t id) {
+		Running.insert(id);
+		auto handle = NextHandle++;
+		Delivered.insert(handle);
+		return handle;
+	}
+
+	/// <summary>
+	/// Open a new handle for a running process or thread.
+	/// </summary>
+	/// <param name="id">The process or thread ID.</param>
+	/// <returns>The handle, or 0 when the ID is not running.</returns>
+	uintptr_t Open(uint32_t id) {
+		if (Running.count(id) == 0)
+			return 0;
+
+		++Opens;
+		auto handle = NextHandle++;
+		Opened.insert(handle);
+		return handle;
+	}
+
+	/// <summary>
+	/// Close a handle that was opened through the table.
+	/// </summary>
+	/// <param name="handle">The handle.</param>
+	void Close(uintptr_t handle) {
+		++Closes;
+		if (Opened.erase(handle) == 0)
+			Misused = true;
+	}
+};
+
+/// <summary>
+/// Create a table on top of <paramref name="system"/>, which must outlive the table.
+/// </summary>
+/// <param name="system">The fake operating system.</param>
+/// <returns>The table.</returns>
+static HandleTable<uintptr_t> make_table(FakeSystem& system) {
+	return HandleTable<uintptr_t>(
+		[&system](uint32_t id) { return system.Open(id); },
+		[&system](uint32_t id) { return system.Open(id); },
+		[&system](uintptr_t handle) { system.Close(handle); }
+	);
+}
+
+/// <summary>
+/// The handles delivered by creation events populate the table, lookups are served without opening anything and the
+/// borrowed handles are never closed by the table.
+/// </summary>
+HINDSIGHT_TEST(PopulatesOnCreate) {
+	FakeSystem system;
+	auto process = system.Deliver(10);
+	auto main	 = system.Deliver(11);
+	auto worker	 = system.Deliver(12);
+
+	{
+		auto table = make_table(system);
+		table.AddProcess(10, process);
+		table.AddThread(10, 11, main);
+		table.AddThread(10, 12, worker);
+
+		CHECK(table.size() == 3);
+		CHECK(table.Process(10) == process);
+		CHECK(table.Thread(10, 11) == main);
+		CHECK(table.Thread(10, 12) == worker);
+		CHECK(table.Hits() == 3);
+		CHECK(table.Opens() == 0);
+
+		table.RemoveThread(12);
+		table.RemoveProcess(10);
+		CHECK(table.size() == 0);
+	}
+
+	CHECK(system.Opens == 0);
+	CHECK(system.Closes == 0);
+	CHECK(!system.Misused);
+}
+
+/// <summary>
+/// An ID that was never announced is opened once, on first use, and closed exactly once when its exit event retires it.
+/// </summary>
+HINDSIGHT_TEST(OpensOnceAndRetiresOnExit) {
+	FakeSystem system;
+	system.Running = { 20, 21, 22 };
+
+	auto table = make_table(system);
+	auto thread = table.Thread(20, 21);
+	CHECK(thread != 0);
+	CHECK(table.Thread(20, 21) == thread);
+	CHECK(table.Opens() == 1 && table.Hits() == 1);
+
+	table.RemoveThread(21);
+	CHECK(system.Closes == 1 && system.Opened.empty());
+
+	// retiring twice, or retiring something unknown, does nothing
+	table.RemoveThread(21);
+	table.RemoveThread(99);
+	CHECK(system.Closes == 1);
+
+	// a process exit retires the threads of that process only
+	table.Process(20);
+	table.Thread(20, 22);
+	auto other = system.Deliver(31);
+	table.AddThread(30, 31, other);
+	table.RemoveProcess(20);
+
+	CHECK(table.size() == 1);
+	CHECK(table.Thread(30, 31) == other);
+	CHECK(system.Opened.empty());
+	CHECK(!system.Misused);
+}
+
+/// <summary>
+/// A handle that could not be opened is not remembered, and a borrowed handle that replaces an opened one closes the
+/// opened handle.
+/// </summary>
+HINDSIGHT_TEST(ReplacesAndRetriesHandles) {
+	FakeSystem system;
+	auto table = make_table(system);
+
+	CHECK(table.Process(40) == 0);
+	CHECK(table.size() == 0);
+
+	system.Running.insert(40);
+	auto opened = table.Process(40);
+	CHECK(opened != 0 && system.Opened.count(opened) == 1);
+
+	// the creation event arrives after the handle was already needed
+	auto delivered = system.Deliver(40);
+	table.AddProcess(40, delivered);
+	CHECK(system.Opened.empty());
+	CHECK(table.Process(40) == delivered);
+
+	table.RemoveProcess(40);
+	CHECK(system.Closes == 1);
+	CHECK(!system.Misused);
+}
+
+/// <summary>
+/// Destroying the table closes every handle it opened itself and none of the borrowed ones.
+/// </summary>
+HINDSIGHT_TEST(ClosesOwnedHandlesOnDestruction) {
+	FakeSystem system;
+	system.Running = { 50, 51, 52 };
+
+	{
+		auto table = make_table(system);
+		table.Process(50);
+		table.Thread(50, 51);
+		table.AddThread(50, 53, system.Deliver(53));
+		table.Thread(50, 52);
+	}
+
+	CHECK(system.Opens == 3);
+	CHECK(system.Closes == 3);
+	CHECK(system.Opened.empty());
+	CHECK(!system.Misused);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,130 @@
+#include "Bench.hpp"
+#include "Lz.hpp"
+#include "WriterDebuggerEventHandler.hpp"
+
+#ifdef HINDSIGHT_BENCH_WORKLOAD
+	#include "BackendDebugger.hpp"
+	#include "PtraceDebugBackend.hpp"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using Hindsight::Utilities::Lz;
+using namespace Hindsight::Bench;
+using namespace Hindsight::Debugger::EventHandler;
+
+/// <summary>
+/// Measure the ratio and the throughput of <see cref="Lz::Compress"/> and <see cref="Lz::Decompress"/> over <paramref name="data"/>,
+/// split into blocks of <paramref name="blockSize"/> bytes the way the writer compresses the blocks it flushes.
+/// </summary>
+/// <param name="data">The uncompressed log.</param>
+/// <param name="blockSize">The size of the blocks.</param>
+/// <returns>False when a block does not decompress to its original data.</returns>
+static bool measure_blocks(const std::vector<char>& data, size_t blockSize) {
+	std::vector<std::vector<char>> blocks((data.size() + blockSize - 1) / blockSize);
+	std::vector<char> output(data.size());
+	size_t stored = 0;
+
+	auto compress = [&]() {
+		stored = 0;
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			auto size = data.size() - i * blockSize < blockSize ? data.size() - i * blockSize : blockSize;
+
+			blocks[i].clear();
+			Lz::Compress(data.data() + i * blockSize, size, blocks[i]);
+
+			// a block that does not compress is stored as-is by the writer
+			stored += blocks[i].size() < size ? blocks[i].size() : size;
+		}
+	};
+
+	auto decompress = [&]() {
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			auto size = data.size() - i * blockSize < blockSize ? data.size() - i * blockSize : blockSize;
+			Lz::Decompress(blocks[i].data(), blocks[i].size(), output.data() + i * blockSize, size);
+		}
+	};
+
+	auto compressSeconds   = Fastest(compress);
+	auto decompressSeconds = Fastest(decompress);
+
+	std::printf("  %zu KB blocks: %zu -> %zu bytes, ratio %.2f\n", blockSize / 1024, data.size(), stored, stored ? static_cast<double>(data.size()) / stored : 0.0);
+	Throughput("    Lz::Compress", data.size(), compressSeconds);
+	Throughput("    Lz::Decompress", data.size(), decompressSeconds);
+
+	if (std::memcmp(output.data(), data.data(), data.size()) != 0) {
+		std::fprintf(stderr, "    the blocks do not decompress to the log\n");
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Measure the LZ compression of an uncompressed log, in the blocks of a flush and in the largest blocks of the writer.
+/// </summary>
+/// <param name="name">The name of the log.</param>
+/// <param name="data">The uncompressed log.</param>
+/// <returns>False when the log does not survive the round trip.</returns>
+static bool measure(const std::string& name, const std::vector<char>& data) {
+	std::printf("%s (%zu bytes)\n", name.c_str(), data.size());
+
+	return measure_blocks(data, WriterDebuggerEventHandler::DefaultFlushSize)
+		&& measure_blocks(data, WriterDebuggerEventHandler::CompressedBlockSize);
+}
+
+#ifdef HINDSIGHT_BENCH_WORKLOAD
+/// <summary>
+/// Record an uncompressed log of the workload program through the ptrace backend and the binary log writer.
+/// </summary>
+/// <param name="path">The path of the log.</param>
+/// <param name="compact">True to record compact stack traces.</param>
+static void record(const std::string& path, bool compact) {
+	using namespace Hindsight::Debugger;
+
+	Backend::PtraceDebugBackend backend(HINDSIGHT_BENCH_WORKLOAD, {});
+	BackendDebugger debugger(backend, DebuggerConfig(), HINDSIGHT_BENCH_WORKLOAD, ".", {});
+
+	debugger.AddHandler(std::make_shared<WriterDebuggerEventHandler>(path, FlushPolicy::Size, WriterDebuggerEventHandler::DefaultFlushSize, false, compact));
+	debugger.Start();
+}
+#endif
+
+/// <summary>
+/// Report the compression ratio and the compress/decompress throughput of the LZ codec on every uncompressed HIND log given on
+/// the command line. Without logs, a plain and a compact log of the workload program are recorded first where ptrace is available.
+/// </summary>
+int main(int argc, char** argv) {
+	std::vector<std::string> paths(argv + 1, argv + argc);
+
+#ifdef HINDSIGHT_BENCH_WORKLOAD
+	if (paths.empty()) {
+		for (bool compact : { false, true }) {
+			paths.push_back(compact ? "LzBench.compact.hind" : "LzBench.plain.hind");
+			record(paths.back(), compact);
+		}
+	}
+#else
+	if (paths.empty()) {
+		std::fprintf(stderr, "usage: %s log.hind...\n", argv[0]);
+		return 1;
+	}
+#endif
+
+	for (const auto& path : paths) {
+		auto data = ReadFile(path);
+		if (data.empty()) {
+			std::fprintf(stderr, "cannot read %s\n", path.c_str());
+			return 1;
+		}
+
+		if (!measure(path, data))
+			return 1;
+	}
+
+	return 0;
+}
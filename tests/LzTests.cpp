@@ -0,0 +1,148 @@
+#include "Test.hpp"
+#include "Lz.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Hindsight::Utilities::Lz;
+
+/// <summary>
+/// Generate <paramref name="size"/> bytes of deterministic pseudo-random data.
+/// </summary>
+/// <param name="size">The number of bytes.</param>
+/// <param name="seed">The seed of the generator.</param>
+/// <returns>The data.</returns>
+static std::vector<char> random_data(size_t size, uint32_t seed) {
+	std::vector<char> data(size);
+	for (auto& byte : data) {
+		seed = seed * 1664525 + 1013904223;
+		byte = static_cast<char>(seed >> 24);
+	}
+
+	return data;
+}
+
+/// <summary>
+/// Compress and decompress <paramref name="data"/>.
+/// </summary>
+/// <param name="data">The data.</param>
+/// <returns>true when the decompressed data equals <paramref name="data"/>.</returns>
+static bool round_trip(const std::vector<char>& data) {
+	std::vector<char> compressed;
+	Lz::Compress(data.data(), data.size(), compressed);
+
+	std::vector<char> output(data.size());
+	Lz::Decompress(compressed.data(), compressed.size(), output.data(), output.size());
+
+	return output == data;
+}
+
+/// <summary>
+/// Decompress <paramref name="compressed"/> into <paramref name="rawSize"/> bytes.
+/// </summary>
+/// <param name="compressed">The compressed data.</param>
+/// <param name="rawSize">The expected size of the decompressed data.</param>
+/// <returns>true when the data was rejected with a <see cref="std::runtime_error"/>.</returns>
+static bool rejects(const std::vector<char>& compressed, size_t rawSize) {
+	std::vector<char> output(rawSize);
+
+	try {
+		Lz::Decompress(compressed.data(), compressed.size(), output.data(), output.size());
+	} catch (const std::runtime_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Empty, tiny, repetitive, incompressible and mixed data all survive a round trip.
+/// </summary>
+HINDSIGHT_TEST(RoundTrips) {
+	CHECK(round_trip({}));
+	CHECK(round_trip({ 'x' }));
+	CHECK(round_trip(std::vector<char>(12, 'a')));
+	CHECK(round_trip(std::vector<char>(13, 'a')));
+	CHECK(round_trip(std::vector<char>(100000, 'a')));
+	CHECK(round_trip(random_data(100000, 7)));
+
+	// a pattern with a period shorter than the minimum match overlaps the bytes it produces
+	std::vector<char> pattern;
+	for (size_t i = 0; i < 5000; ++i)
+		pattern.push_back("ab"[i % 2]);
+	CHECK(round_trip(pattern));
+
+	// literal runs and matches that need extra length bytes, and repeats further away than the window
+	auto mixed = random_data(300, 1);
+	auto noise = random_data(70000, 2);
+	mixed.insert(mixed.end(), noise.begin(), noise.end());
+	mixed.insert(mixed.end(), mixed.begin(), mixed.begin() + 1000);
+	mixed.insert(mixed.end(), 600, 'z');
+	CHECK(round_trip(mixed));
+}
+
+/// <summary>
+/// Repetitive data is actually compressed.
+/// </summary>
+HINDSIGHT_TEST(CompressesRepetitiveData) {
+	std::string text;
+	for (int i = 0; i < 1000; ++i)
+		text += "0x00007ff6`1234abcd KERNELBASE!RaiseException+0x69\n";
+
+	std::vector<char> compressed;
+	auto size = Lz::Compress(text.data(), text.size(), compressed);
+
+	CHECK(size == compressed.size());
+	CHECK(size * 10 < text.size());
+}
+
+/// <summary>
+/// Truncated data, a wrong size and invalid sequences are rejected instead of being read or written out of bounds.
+/// </summary>
+HINDSIGHT_TEST(RejectsMalformedInput) {
+	std::string text;
+	for (int i = 0; i < 100; ++i)
+		text += "repeated text, " + std::to_string(i % 7);
+
+	std::vector<char> compressed;
+	Lz::Compress(text.data(), text.size(), compressed);
+
+	for (size_t size = 0; size < compressed.size(); ++size)
+		CHECK(rejects(std::vector<char>(compressed.begin(), compressed.begin() + size), text.size()));
+
+	CHECK(rejects(compressed, text.size() - 1));
+	CHECK(rejects(compressed, text.size() + 1));
+
+	// a literal run longer than the input, and one longer than the output
+	CHECK(rejects({ static_cast<char>(0x30), 'a', 'b' }, 3));
+	CHECK(rejects({ static_cast<char>(0x30), 'a', 'b', 'c' }, 2));
+
+	// back references with offset 0, one before the start of the output and one past the end of the output
+	CHECK(rejects({ static_cast<char>(0x10), 'a', 0, 0, static_cast<char>(0x00) }, 5));
+	CHECK(rejects({ static_cast<char>(0x10), 'a', 2, 0, static_cast<char>(0x00) }, 5));
+	CHECK(rejects({ static_cast<char>(0x10), 'a', 1, 0, static_cast<char>(0x00) }, 4));
+
+	// a length that never ends
+	CHECK(rejects({ static_cast<char>(0xf0), static_cast<char>(0xff), static_cast<char>(0xff) }, 1000));
+}
+
+/// <summary>
+/// Random input either decompresses or is rejected, it never crashes.
+/// </summary>
+HINDSIGHT_TEST(SurvivesRandomInput) {
+	for (uint32_t seed = 0; seed < 2000; ++seed) {
+		auto data = random_data(1 + seed % 64, seed);
+		std::vector<char> output(seed % 200);
+
+		try {
+			Lz::Decompress(data.data(), data.size(), output.data(), output.size());
+		} catch (const std::runtime_error&) {
+		}
+	}
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
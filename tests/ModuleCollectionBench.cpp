@@ -0,0 +1,178 @@
+#include "Bench.hpp"
+#include "ModuleCollection.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Bench;
+
+/// <summary>
+/// One step of a replayed session: a module load, a module unload or the lookup of one stack frame.
+/// </summary>
+struct Step {
+	enum Kind { Load, Unload, Lookup } Type;
+	uintptr_t	Address;	/* The module base for a load or unload, the frame address for a lookup */
+	size_t		Size;		/* The module size for a load */
+	size_t		Path;		/* The index of the module path for a load */
+};
+
+/// <summary>
+/// A synthetic session: the modules that are loaded at the start, followed by the steps of all events.
+/// </summary>
+struct Session {
+	std::vector<std::wstring>	Paths;
+	std::vector<Step>			Steps;
+	size_t						Lookups = 0;
+	size_t						Churn	= 0;
+};
+
+/// <summary>
+/// A small deterministic generator, so that every run replays the same session.
+/// </summary>
+struct Random {
+	uint32_t State;
+
+	uint32_t Next(uint32_t bound) {
+		State = State * 1664525 + 1013904223;
+		return static_cast<uint32_t>((static_cast<uint64_t>(State >> 8) * bound) >> 24);
+	}
+};
+
+/// <summary>
+/// Generate a session with <paramref name="modules"/> modules spread over the address space with gaps between them. Every event
+/// resolves a stack of <paramref name="frames"/> frames, most of them in a small set of hot modules and a few outside of any module.
+/// Every <paramref name="churnInterval"/> events a module is unloaded and another one is loaded at a new base.
+/// </summary>
+/// <param name="modules">The number of loaded modules.</param>
+/// <param name="events">The number of events.</param>
+/// <param name="frames">The number of frames per event.</param>
+/// <param name="churnInterval">The number of events between an unload and load, 0 for none.</param>
+/// <returns>The session.</returns>
+static Session generate(size_t modules, size_t events, size_t frames, size_t churnInterval) {
+	struct Loaded { uintptr_t Base; size_t Size; };
+
+	Session session;
+	Random random { 0x5eed };
+	std::vector<Loaded> loaded;
+	uintptr_t next = 0x10000000;
+
+	auto load = [&]() {
+		Loaded module { next + 0x10000 * random.Next(16), 0x10000 * (1 + random.Next(64)) };
+		next = module.Base + module.Size + 0x10000;
+
+		session.Steps.push_back({ Step::Load, module.Base, module.Size, session.Paths.size() });
+		session.Paths.push_back(L"module" + std::to_wstring(session.Paths.size()) + L".dll");
+		return module;
+	};
+
+	for (size_t i = 0; i < modules; ++i)
+		loaded.push_back(load());
+
+	for (size_t event = 0; event < events; ++event) {
+		if (churnInterval != 0 && event % churnInterval == churnInterval - 1) {
+			auto victim = random.Next(static_cast<uint32_t>(loaded.size()));
+			session.Steps.push_back({ Step::Unload, loaded[victim].Base, 0, 0 });
+			loaded[victim] = load();
+			++session.Churn;
+		}
+
+		for (size_t frame = 0; frame < frames; ++frame) {
+			auto kind	  = random.Next(100);
+			auto& module = loaded[kind < 70 ? random.Next(8) : random.Next(static_cast<uint32_t>(loaded.size()))];
+
+			// one in twenty frames is in the gap after a module, like JIT code or a damaged return address
+			auto address = kind < 95 ? module.Base + random.Next(static_cast<uint32_t>(module.Size)) : module.Base + module.Size + random.Next(0x10000);
+
+			session.Steps.push_back({ Step::Lookup, address, 0, 0 });
+			++session.Lookups;
+		}
+	}
+
+	return session;
+}
+
+/// <summary>
+/// Replay a session through <see cref="ModuleCollection::GetModuleAtAddress"/>.
+/// </summary>
+/// <param name="session">The session.</param>
+static void replay(const Session& session) {
+	ModuleCollection collection;
+	uint64_t resolved = 0;
+
+	for (const auto& step : session.Steps) {
+		auto address = reinterpret_cast<ModulePointer>(step.Address);
+
+		switch (step.Type) {
+			case Step::Load:
+				collection.Load(session.Paths[step.Path], address, step.Size);
+				break;
+			case Step::Unload:
+				collection.Unload(address);
+				break;
+			case Step::Lookup:
+				resolved += collection.GetModuleAtAddress(address) != nullptr;
+				break;
+		}
+	}
+
+	Keep(resolved);
+}
+
+/// <summary>
+/// Replay a session through a linear scan over all loaded modules, which is how modules were resolved before the ordered lookup.
+/// </summary>
+/// <param name="session">The session.</param>
+static void replay_linear(const Session& session) {
+	std::vector<Module> modules;
+	uint64_t resolved = 0;
+
+	for (const auto& step : session.Steps) {
+		auto address = reinterpret_cast<ModulePointer>(step.Address);
+
+		switch (step.Type) {
+			case Step::Load:
+				modules.emplace_back(address, step.Size, session.Paths[step.Path]);
+				break;
+			case Step::Unload:
+				for (auto it = modules.begin(); it != modules.end(); ++it) {
+					if (it->Base == address) {
+						modules.erase(it);
+						break;
+					}
+				}
+				break;
+			case Step::Lookup:
+				for (const auto& module : modules) {
+					auto base = reinterpret_cast<uintptr_t>(module.Base);
+					if (step.Address >= base && step.Address < base + module.Size) {
+						++resolved;
+						break;
+					}
+				}
+				break;
+		}
+	}
+
+	Keep(resolved);
+}
+
+/// <summary>
+/// Measure the module lookup per stack frame over synthetic module maps of a few hundred modules, with and without modules
+/// being loaded and unloaded between the events.
+/// </summary>
+int main() {
+	for (size_t modules : { 320, 1000 }) {
+		for (size_t churn : { 0, 50, 5 }) {
+			auto session = generate(modules, 20000, 32, churn);
+			auto name	 = std::to_string(modules) + " modules, " + (churn ? std::to_string(session.Churn) + " reloads" : std::string("no reloads"));
+
+			std::printf("%s, %zu lookups\n", name.c_str(), session.Lookups);
+			Rate("  GetModuleAtAddress", session.Lookups, Fastest([&]() { replay(session); }));
+			Rate("  linear scan", session.Lookups, Fastest([&]() { replay_linear(session); }));
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include "Test.hpp"
+#include "ModuleCollection.hpp"
+
+#include <cstdint>
+
+using namespace Hindsight::Debugger;
+
+/// <summary>
+/// Convert an integer address to a <see cref="::Hindsight::Debugger::ModulePointer"/>.
+/// </summary>
+/// <param name="address">The address.</param>
+/// <returns>The address as pointer.</returns>
+static ModulePointer at(uintptr_t address) {
+	return reinterpret_cast<ModulePointer>(address);
+}
+
+/// <summary>
+/// Get the path of the module at <paramref name="address"/>, or an empty string when no module contains it.
+/// </summary>
+/// <param name="collection">The module collection.</param>
+/// <param name="address">The address to resolve.</param>
+/// <returns>The module path.</returns>
+static std::wstring path_at(const ModuleCollection& collection, uintptr_t address) {
+	auto module = collection.GetModuleAtAddress(at(address));
+	return module != nullptr ? module->Path : L"";
+}
+
+/// <summary>
+/// Two adjacent modules and one after a gap, the first byte of a module belongs to it and its end does not.
+/// </summary>
+HINDSIGHT_TEST(ResolvesModuleBoundaries) {
+	ModuleCollection collection;
+	collection.Load(L"a.dll", at(0x10000), 0x1000);
+	collection.Load(L"b.dll", at(0x11000), 0x2000);
+	collection.Load(L"c.dll", at(0x20000), 0x100);
+
+	CHECK(path_at(collection, 0x0) == L"");
+	CHECK(path_at(collection, 0xffff) == L"");
+	CHECK(path_at(collection, 0x10000) == L"a.dll");
+	CHECK(path_at(collection, 0x10fff) == L"a.dll");
+	CHECK(path_at(collection, 0x11000) == L"b.dll");
+	CHECK(path_at(collection, 0x12fff) == L"b.dll");
+	CHECK(path_at(collection, 0x13000) == L"");
+	CHECK(path_at(collection, 0x1ffff) == L"");
+	CHECK(path_at(collection, 0x20000) == L"c.dll");
+	CHECK(path_at(collection, 0x200ff) == L"c.dll");
+	CHECK(path_at(collection, 0x20100) == L"");
+	CHECK(path_at(collection, UINTPTR_MAX) == L"");
+}
+
+/// <summary>
+/// A module of which the size could not be determined contains no address, not even its base.
+/// </summary>
+HINDSIGHT_TEST(EmptyModuleContainsNothing) {
+	ModuleCollection collection;
+	collection.Load(L"a.dll", at(0x10000), 0x1000);
+	collection.Load(L"empty.dll", at(0x11000), 0);
+
+	CHECK(path_at(collection, 0x10fff) == L"a.dll");
+	CHECK(path_at(collection, 0x11000) == L"");
+	CHECK(path_at(collection, 0x11001) == L"");
+}
+
+/// <summary>
+/// An unloaded module no longer resolves, its neighbours still do and a reload at another base resolves there.
+/// </summary>
+HINDSIGHT_TEST(UnloadAndReload) {
+	ModuleCollection collection;
+	collection.Load(L"a.dll", at(0x10000), 0x1000);
+	collection.Load(L"b.dll", at(0x11000), 0x1000);
+	collection.Load(L"c.dll", at(0x12000), 0x1000);
+
+	auto generation = collection.Generation();
+	collection.Unload(at(0x11000));
+
+	CHECK(collection.Generation() != generation);
+	CHECK(path_at(collection, 0x10fff) == L"a.dll");
+	CHECK(path_at(collection, 0x11000) == L"");
+	CHECK(path_at(collection, 0x11fff) == L"");
+	CHECK(path_at(collection, 0x12000) == L"c.dll");
+	CHECK(collection.Contains(L"b.dll"));
+	CHECK(!collection.Active(L"b.dll"));
+
+	collection.Load(L"b.dll", at(0x30000), 0x1000);
+
+	CHECK(path_at(collection, 0x11000) == L"");
+	CHECK(path_at(collection, 0x30000) == L"b.dll");
+	CHECK(collection.GetIndex(L"b.dll") == 1);
+	CHECK(collection.GetIndex(at(0x30000)) == 1);
+}
+
+/// <summary>
+/// An empty collection resolves nothing.
+/// </summary>
+HINDSIGHT_TEST(EmptyCollection) {
+	ModuleCollection collection;
+
+	CHECK(collection.GetModuleAtAddress(nullptr) == nullptr);
+	CHECK(collection.GetModuleAtAddress(at(0x10000)) == nullptr);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,243 @@
+#include "Test.hpp"
+#include "PersistentSymbolCache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Hindsight::Debugger;
+
+/// <summary>
+/// A cache file in the temporary directory that is removed when it goes out of scope.
+/// </summary>
+struct TemporaryFile {
+	std::string Path;
+
+	TemporaryFile(const char* name)
+		: Path((fs::temp_directory_path() / (std::string("hindsight-") + name + "-" + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".hsyc")).string()) {
+		fs::remove(Path);
+	}
+
+	~TemporaryFile() {
+		std::error_code error;
+		fs::remove(Path, error);
+	}
+};
+
+/// <summary>
+/// Read all bytes of a file.
+/// </summary>
+/// <param name="path">The file path.</param>
+/// <returns>The contents of the file.</returns>
+static std::vector<char> read_file(const std::string& path) {
+	std::ifstream stream(path, std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+/// <summary>
+/// Replace all bytes of a file.
+/// </summary>
+/// <param name="path">The file path.</param>
+/// <param name="data">The new contents of the file.</param>
+static void write_file(const std::string& path, const std::vector<char>& data) {
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	stream.write(data.data(), data.size());
+}
+
+/// <summary>
+/// Overwrite a value in a file at <paramref name="offset"/>.
+/// </summary>
+/// <param name="path">The file path.</param>
+/// <param name="offset">The offset of the value.</param>
+/// <param name="value">The new value.</param>
+template <typename T>
+static void patch_file(const std::string& path, size_t offset, T value) {
+	auto data = read_file(path);
+	std::memcpy(data.data() + offset, &value, sizeof(T));
+	write_file(path, data);
+}
+
+/// <summary>
+/// Create a record for a symbol with a source line.
+/// </summary>
+/// <param name="name">The symbol name.</param>
+/// <param name="line">The line number.</param>
+/// <returns>The record.</returns>
+static SymbolRecord make_record(const std::string& name, uint32_t line) {
+	SymbolRecord record;
+	record.HasSymbol  = true;
+	record.Name		  = name;
+	record.SymbolRva  = 0x1000;
+	record.SymbolSize = 0x80;
+	record.HasLine	  = true;
+	record.File		  = "C:\\src\\" + name + ".cpp";
+	record.Line		  = line;
+	record.LineRva	  = 0x1010;
+	return record;
+}
+
+/// <summary>
+/// Records survive closing and opening the file again, and an insert of an address that is already cached is ignored.
+/// </summary>
+HINDSIGHT_TEST(SavesAndLoadsRecords) {
+	TemporaryFile file("save");
+	auto module = PersistentSymbolCache::ModuleKey("app.exe:12345678:1000");
+
+	{
+		PersistentSymbolCache cache(file.Path, 16);
+		cache.Insert(module, 0x1010, make_record("main", 10));
+		cache.Insert(module, 0x2020, make_record("crash", 20));
+		cache.Insert(module, 0x1010, make_record("other", 99));
+
+		CHECK(cache.Records() == 2);
+	}
+
+	PersistentSymbolCache cache(file.Path);
+	SymbolRecord record;
+
+	CHECK(cache.Records() == 2);
+	CHECK(cache.Find(module, 0x1010, record));
+	CHECK(record.HasSymbol && record.Name == "main");
+	CHECK(record.HasLine && record.Line == 10 && record.File == "C:\\src\\main.cpp");
+	CHECK(record.SymbolRva == 0x1000 && record.SymbolSize == 0x80 && record.LineRva == 0x1010);
+	CHECK(cache.Find(module, 0x2020, record) && record.Name == "crash");
+	CHECK(!cache.Find(module, 0x3030, record));
+	CHECK(!cache.Find(PersistentSymbolCache::ModuleKey("app.exe:87654321:1000"), 0x1010, record));
+	CHECK(cache.Hits() == 2 && cache.Misses() == 2);
+}
+
+/// <summary>
+/// The file grows past its initial size, and a second instance that has the file open sees the records of the first.
+/// </summary>
+HINDSIGHT_TEST(GrowsAndSharesRecords) {
+	TemporaryFile file("grow");
+	auto module = PersistentSymbolCache::ModuleKey("app.exe");
+
+	PersistentSymbolCache first(file.Path, 4);
+	PersistentSymbolCache second(file.Path);
+
+	auto initial = fs::file_size(file.Path);
+	for (uint32_t i = 0; i < 600; ++i)
+		first.Insert(module, i * 16, make_record(std::string(3000, 'a' + i % 26) + std::to_string(i), i));
+
+	CHECK(fs::file_size(file.Path) > initial);
+	CHECK(second.Records() == 600);
+
+	SymbolRecord record;
+	for (uint32_t i = 0; i < 600; ++i)
+		CHECK(second.Find(module, i * 16, record) && record.Line == i && record.Name.size() == 3000 + std::to_string(i).size());
+}
+
+/// <summary>
+/// Names and files longer than the maximum are truncated.
+/// </summary>
+HINDSIGHT_TEST(TruncatesLongStrings) {
+	TemporaryFile file("long");
+	PersistentSymbolCache cache(file.Path, 4);
+
+	cache.Insert(1, 2, make_record(std::string(PersistentSymbolCache::MaxStringLength + 100, 'x'), 1));
+
+	SymbolRecord record;
+	CHECK(cache.Find(1, 2, record));
+	CHECK(record.Name.size() == PersistentSymbolCache::MaxStringLength);
+}
+
+/// <summary>
+/// Files that are not a cache, of another version or with an inconsistent header are rejected when they are opened.
+/// </summary>
+HINDSIGHT_TEST(RejectsDamagedHeaders) {
+	TemporaryFile file("header");
+
+	write_file(file.Path, std::vector<char>(16, 'x'));
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	write_file(file.Path, std::vector<char>(4096, 'x'));
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	// version, a bucket count that is not a power of two, a used size past the capacity and a capacity past the file
+	const size_t version = 4, buckets = 8, used = 16, capacity = 24;
+
+	fs::remove(file.Path);
+	{ PersistentSymbolCache cache(file.Path, 4); }
+	auto valid = read_file(file.Path);
+
+	patch_file<uint32_t>(file.Path, version, PersistentSymbolCache::FormatVersion + 1);
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	write_file(file.Path, valid);
+	patch_file<uint32_t>(file.Path, buckets, 3);
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	write_file(file.Path, valid);
+	patch_file<uint64_t>(file.Path, used, valid.size() * 2);
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	write_file(file.Path, valid);
+	patch_file<uint64_t>(file.Path, capacity, valid.size() * 2);
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	write_file(file.Path, std::vector<char>(valid.begin(), valid.begin() + valid.size() / 2));
+	CHECK_THROWS(PersistentSymbolCache(file.Path), std::runtime_error);
+
+	// a file that was never initialized (no signature) is initialized again
+	write_file(file.Path, std::vector<char>(valid.size(), 0));
+	PersistentSymbolCache cache(file.Path, 4);
+	CHECK(cache.Records() == 0);
+}
+
+/// <summary>
+/// Damaged bucket and chain offsets and records that claim more than the used size are treated as misses, rather than 
+/// being read out of bounds or followed forever.
+/// </summary>
+HINDSIGHT_TEST(TreatsDamagedRecordsAsMisses) {
+	TemporaryFile file("records");
+	const size_t table = sizeof(SymbolCacheHeader), first = table + sizeof(uint64_t);
+
+	{
+		PersistentSymbolCache cache(file.Path, 1);
+		cache.Insert(1, 0x10, make_record("a", 1));
+		cache.Insert(1, 0x20, make_record("b", 2));
+	}
+
+	auto valid = read_file(file.Path);
+	uint64_t head;
+	std::memcpy(&head, valid.data() + table, sizeof(head));
+
+	SymbolRecord record;
+	for (uint64_t offset : { uint64_t(8), uint64_t(first + 4), uint64_t(valid.size() + 64), UINT64_MAX - 15 }) {
+		write_file(file.Path, valid);
+		patch_file<uint64_t>(file.Path, table, offset);
+
+		PersistentSymbolCache cache(file.Path);
+		CHECK(!cache.Find(1, 0x10, record));
+	}
+
+	// a chain that points back at itself ends after as many hops as there are records
+	write_file(file.Path, valid);
+	patch_file<uint64_t>(file.Path, static_cast<size_t>(head), head);
+	{
+		PersistentSymbolCache cache(file.Path);
+		CHECK(cache.Find(1, 0x20, record));
+		CHECK(!cache.Find(1, 0x10, record));
+	}
+
+	// a name that runs past the used size
+	write_file(file.Path, valid);
+	patch_file<uint32_t>(file.Path, static_cast<size_t>(head) + offsetof(SymbolCacheRecord, NameLength), 0x7fffffff);
+	{
+		PersistentSymbolCache cache(file.Path);
+		CHECK(!cache.Find(1, 0x20, record));
+		CHECK(cache.Find(1, 0x10, record) && record.Name == "a");
+	}
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
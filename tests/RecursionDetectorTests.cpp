@@ -0,0 +1,103 @@
+#include "Test.hpp"
+#include "RecursionDetector.hpp"
+
+#include <string>
+
+using namespace Hindsight::Debugger;
+
+/// <summary>
+/// Pass every frame of <paramref name="frames"/> through a detector, each character being a frame that is its own key, then flush it.
+/// </summary>
+/// <param name="frames">The frames, from the innermost outwards.</param>
+/// <param name="limit">The number of frames of a cycle that are passed on before it is cut.</param>
+/// <returns>The frames that were passed on, with each cut written as the number of skipped frames between brackets.</returns>
+static std::string collapse(const std::string& frames, size_t limit) {
+	std::string result;
+
+	RecursionDetector<char> detector(
+		[&](const char& frame) { result += frame; },
+		[&](size_t skipped) { result += "[" + std::to_string(skipped) + "]"; },
+		limit);
+
+	for (auto frame : frames)
+		detector.Push(frame, static_cast<uint64_t>(frame));
+
+	detector.Flush();
+	return result;
+}
+
+/// <summary>
+/// Repeat <paramref name="pattern"/> <paramref name="count"/> times.
+/// </summary>
+/// <param name="pattern">The frames of one repetition.</param>
+/// <param name="count">The number of repetitions.</param>
+/// <returns>The repeated frames.</returns>
+static std::string repeat(const std::string& pattern, size_t count) {
+	std::string result;
+	for (size_t i = 0; i < count; ++i)
+		result += pattern;
+
+	return result;
+}
+
+/// <summary>
+/// Frames that do not repeat are passed on unchanged and in order, also beyond the window of the detector.
+/// </summary>
+HINDSIGHT_TEST(PassesFramesWithoutRecursion) {
+	std::string frames;
+	for (char c = '!'; c <= '~'; ++c)
+		frames += c;
+
+	CHECK(collapse("", 3) == "");
+	CHECK(collapse("ABCD", 3) == "ABCD");
+	CHECK(collapse(frames, 3) == frames);
+}
+
+/// <summary>
+/// Direct recursion: the first <c>limit</c> frames are passed on, then the skipped frames are reported followed by the last one.
+/// </summary>
+HINDSIGHT_TEST(CutsDirectRecursion) {
+	CHECK(collapse(repeat("A", 10) + "B", 3) == "AAA[6]AB");
+	CHECK(collapse("X" + repeat("A", 100) + "Y", 2) == "XAA[97]AY");
+}
+
+/// <summary>
+/// Mutual recursion of two and three functions is cut on whole repetitions: the skipped frames are followed by the last repetition.
+/// </summary>
+HINDSIGHT_TEST(CutsMutualRecursion) {
+	CHECK(collapse(repeat("AB", 5) + "C", 4) == "ABAB[4]ABC");
+	CHECK(collapse(repeat("ABC", 4) + "D", 3) == "ABC[6]ABCD");
+	CHECK(collapse("X" + repeat("ABC", 10) + "Y", 6) == "XABCABC[21]ABCY");
+}
+
+/// <summary>
+/// A cycle that breaks in the middle of a repetition keeps the last period of frames it saw, which then starts mid-pattern.
+/// </summary>
+HINDSIGHT_TEST(CutsCycleThatBreaksMidPattern) {
+	CHECK(collapse(repeat("AB", 3) + "AC", 2) == "AB[3]BAC");
+	CHECK(collapse(repeat("ABC", 4) + "ABX", 3) == "ABC[8]CABX");
+}
+
+/// <summary>
+/// A limit below the period still passes on one full repetition, a limit above it passes on frames into the next repetition.
+/// A cycle that does not exceed the limit is not cut at all.
+/// </summary>
+HINDSIGHT_TEST(AppliesLimitRelativeToPeriod) {
+	CHECK(collapse(repeat("ABC", 4) + "D", 1) == "ABC[6]ABCD");
+	CHECK(collapse(repeat("ABC", 4) + "D", 0) == "ABC[6]ABCD");
+	CHECK(collapse(repeat("ABC", 4) + "D", 7) == "ABCABCA[2]ABCD");
+	CHECK(collapse(repeat("ABC", 4) + "D", 12) == repeat("ABC", 4) + "D");
+	CHECK(collapse("AAB", 10) == "AAB");
+}
+
+/// <summary>
+/// A cycle that lasts until the last frame is cut by Flush, and the frames before it are passed on first.
+/// </summary>
+HINDSIGHT_TEST(CutsCycleAtTheEnd) {
+	CHECK(collapse("X" + repeat("A", 6), 2) == "XAA[3]A");
+	CHECK(collapse("XY" + repeat("AB", 6), 2) == "XYAB[8]AB");
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,144 @@
+#include "Test.hpp"
+#include "SignatureDebuggerEventHandler.hpp"
+#include "BinaryLogFile.hpp"
+#include "DebugStackTrace.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Hindsight::BinaryLog;
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::EventHandler;
+
+/// <summary>
+/// A bucket as plain values, so that the buckets of two aggregators can be compared.
+/// </summary>
+struct Bucket {
+	std::string	Signature;
+	size_t		Count;
+	std::string	Representative;
+
+	bool operator==(const Bucket& other) const {
+		return Signature == other.Signature && Count == other.Count && Representative == other.Representative;
+	}
+};
+
+/// <summary>
+/// Get the buckets of an aggregator in the order of <see cref="SignatureAggregator::Sorted"/>.
+/// </summary>
+/// <param name="aggregator">The aggregator.</param>
+/// <returns>The buckets.</returns>
+static std::vector<Bucket> buckets(const SignatureAggregator& aggregator) {
+	std::vector<Bucket> result;
+	for (auto bucket : aggregator.Sorted())
+		result.push_back({ bucket->Signature, bucket->Count, bucket->Representative });
+
+	return result;
+}
+
+/// <summary>
+/// Build a trace of frames as read from a log that was recorded without symbols: no frame carries its module base.
+/// </summary>
+/// <param name="collection">The modules loaded at the time of the trace.</param>
+/// <param name="addresses">The addresses of the frames, from the top of the stack.</param>
+/// <returns>The trace.</returns>
+static std::shared_ptr<const DebugStackTrace> raw_trace(const ModuleCollection& collection, const std::vector<uintptr_t>& addresses) {
+	StackTraceConcrete concrete = {};
+	for (auto address : addresses) {
+		StackTraceEntryConcrete entry = {};
+		entry.Address = address;
+		concrete.Entries.push_back(entry);
+	}
+
+	return std::make_shared<const DebugStackTrace>(nullptr, collection, std::move(concrete));
+}
+
+/// <summary>
+/// Frames without symbols have no module in the trace, they are resolved through the module collection like the exception
+/// address. Only an address outside every module becomes "?", and only the configured number of top frames is included.
+/// </summary>
+HINDSIGHT_TEST(NormalizeResolvesFramesWithoutSymbols) {
+	ModuleCollection collection;
+	collection.Load(L"C:/Program Files/App/App.EXE", reinterpret_cast<ModulePointer>(0x400000), 0x10000);
+	collection.Load(L"C:/Windows/System32/ntdll.dll", reinterpret_cast<ModulePointer>(0x7ff00000), 0x10000);
+
+	EXCEPTION_DEBUG_INFO info = {};
+	info.ExceptionRecord.ExceptionCode	  = EXCEPTION_ACCESS_VIOLATION;
+	info.ExceptionRecord.ExceptionAddress = reinterpret_cast<void*>(0x401234);
+
+	auto trace = raw_trace(collection, { 0x401234, 0x7ff00010, 0x300000, 0x402000 });
+
+	CHECK(SignatureAggregator::Normalize(info, true, trace, collection, nullptr, 3) == "c0000005 first app.exe+0x1234 | app.exe+0x1234 ntdll.dll+0x10 ? |");
+	CHECK(SignatureAggregator::Normalize(info, false, trace, collection, nullptr, 1) == "c0000005 second app.exe+0x1234 | app.exe+0x1234 |");
+	CHECK(SignatureAggregator::Normalize(info, true, nullptr, collection, nullptr, 3) == "c0000005 first app.exe+0x1234 | |");
+}
+
+/// <summary>
+/// Every distinct signature has a bucket of its own, its hash is the hash of its signature and the representative is the
+/// lowest source regardless of the order in which the exceptions are added.
+/// </summary>
+HINDSIGHT_TEST(AddCountsBySignature) {
+	SignatureAggregator aggregator;
+	aggregator.Add("a", "b.hind");
+	aggregator.Add("b", "c.hind");
+	aggregator.Add("a", "c.hind");
+	aggregator.Add("a", "a.hind");
+
+	CHECK(aggregator.Events() == 4);
+	CHECK(aggregator.size() == 2);
+	CHECK((buckets(aggregator) == std::vector<Bucket> { { "a", 3, "a.hind" }, { "b", 1, "c.hind" } }));
+
+	for (auto bucket : aggregator.Sorted())
+		CHECK(bucket->Hash == SignatureAggregator::Hash(bucket->Signature));
+}
+
+/// <summary>
+/// Buckets are sorted by descending count and by signature for equal counts.
+/// </summary>
+HINDSIGHT_TEST(SortedByCountThenSignature) {
+	SignatureAggregator aggregator;
+	for (auto signature : { "c", "b", "a", "c", "b", "c", "d" })
+		aggregator.Add(signature, "x.hind");
+
+	CHECK((buckets(aggregator) == std::vector<Bucket> { { "c", 3, "x.hind" }, { "b", 2, "x.hind" }, { "a", 1, "x.hind" }, { "d", 1, "x.hind" } }));
+}
+
+/// <summary>
+/// Aggregators that each saw some of the logs, as the threads of a replay do, merge into the same buckets in any order: the
+/// counts add up and the representative of each bucket is the lowest source of all of them, including buckets one side lacks.
+/// </summary>
+HINDSIGHT_TEST(MergeDoesNotDependOnOrder) {
+	SignatureAggregator first, second, third;
+	first.Add("a", "3.hind");
+	first.Add("b", "3.hind");
+	second.Add("a", "1.hind");
+	second.Add("c", "2.hind");
+	third.Add("a", "2.hind");
+	third.Add("b", "0.hind");
+	third.Add("b", "0.hind");
+
+	SignatureAggregator forward, backward;
+	for (auto part : { &first, &second, &third })
+		forward.Merge(*part);
+	for (auto part : { &third, &second, &first })
+		backward.Merge(*part);
+
+	std::vector<Bucket> expected { { "a", 3, "1.hind" }, { "b", 3, "0.hind" }, { "c", 1, "2.hind" } };
+	CHECK(buckets(forward) == expected);
+	CHECK(buckets(backward) == expected);
+	CHECK(forward.Events() == 7 && backward.Events() == 7);
+
+	// merging into an aggregator that already has buckets keeps its lower representative
+	SignatureAggregator partial;
+	partial.Add("c", "0.hind");
+	partial.Merge(first);
+	partial.Merge(second);
+
+	CHECK((buckets(partial) == std::vector<Bucket> { { "a", 2, "1.hind" }, { "c", 2, "0.hind" }, { "b", 1, "3.hind" } }));
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
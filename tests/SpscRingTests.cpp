@@ -0,0 +1,123 @@
+#include "Test.hpp"
+#include "SpscRing.hpp"
+
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+using Hindsight::Utilities::SpscRing;
+
+/// <summary>
+/// A ring only accepts capacities that are a power of two.
+/// </summary>
+HINDSIGHT_TEST(RejectsInvalidCapacities) {
+	CHECK_THROWS(SpscRing<int>(0), std::invalid_argument);
+	CHECK_THROWS(SpscRing<int>(3), std::invalid_argument);
+	CHECK(SpscRing<int>(1).Capacity() == 1);
+	CHECK(SpscRing<int>(64).Capacity() == 64);
+}
+
+/// <summary>
+/// A full ring refuses a push and leaves the value alone, after a pop there is room again.
+/// </summary>
+HINDSIGHT_TEST(RefusesPushWhenFull) {
+	SpscRing<std::vector<char>> ring(4);
+	for (char i = 0; i < 4; ++i)
+		CHECK(ring.TryPush(std::vector<char>(16, i)));
+
+	std::vector<char> value(16, 'x');
+	CHECK(!ring.TryPush(std::move(value)));
+	CHECK(value.size() == 16 && value[0] == 'x');
+
+	std::vector<char> popped;
+	CHECK(ring.TryPop(popped) && popped[0] == 0);
+	CHECK(ring.TryPush(std::move(value)));
+	CHECK(!ring.TryPush(std::vector<char>(1)));
+}
+
+/// <summary>
+/// Values come out in the order they went in while the indices wrap around the slots many times.
+/// </summary>
+HINDSIGHT_TEST(WrapsAround) {
+	SpscRing<uint64_t> ring(4);
+	uint64_t next = 0, expected = 0, value = 0;
+
+	CHECK(ring.Empty());
+	CHECK(!ring.TryPop(value));
+
+	for (int round = 0; round < 1000; ++round) {
+		// alternate between a few values and a full ring, so the head and tail meet at every slot
+		auto count = round % 5;
+		for (int i = 0; i < count; ++i) {
+			if (ring.TryPush(uint64_t(next)))
+				++next;
+		}
+
+		while (ring.TryPop(value))
+			CHECK(value == expected++);
+	}
+
+	CHECK(ring.Empty());
+	CHECK(expected == next && next > 1000);
+}
+
+/// <summary>
+/// A producer and a consumer thread pass blocks through one ring and send the emptied blocks back through a second
+/// ring, the way the asynchronous writer does. Every block arrives intact and in order, and the producer gets
+/// blocks back with their memory still allocated.
+/// </summary>
+HINDSIGHT_TEST(ProducerConsumerRecycle) {
+	const uint32_t blocks = 100000;
+	const size_t   block_size = 64;
+
+	SpscRing<std::vector<char>> full(8);
+	SpscRing<std::vector<char>> recycled(8);
+
+	bool	 intact = true;
+	uint32_t received = 0;
+
+	std::thread consumer([&] {
+		std::vector<char> block;
+		while (received < blocks) {
+			if (!full.TryPop(block)) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			auto expected = static_cast<char>(received);
+			if (block.size() != block_size || block.front() != expected || block.back() != expected)
+				intact = false;
+
+			++received;
+			block.clear();
+			recycled.TryPush(std::move(block));
+		}
+	});
+
+	uint32_t reused = 0;
+	std::vector<char> buffer;
+	for (uint32_t i = 0; i < blocks; ++i) {
+		buffer.assign(block_size, static_cast<char>(i));
+		while (!full.TryPush(std::move(buffer)))
+			std::this_thread::yield();
+
+		if (recycled.TryPop(buffer)) {
+			if (buffer.capacity() >= block_size && buffer.empty())
+				++reused;
+		} else {
+			buffer = std::vector<char>();
+		}
+	}
+
+	consumer.join();
+
+	CHECK(intact);
+	CHECK(received == blocks);
+	CHECK(full.Empty());
+	CHECK(reused > 0);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,125 @@
+#include "Test.hpp"
+#include "SymbolCache.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace Hindsight::Debugger;
+
+/// <summary>
+/// A resolver that knows the symbols of one fake module and records every address it is asked for.
+/// </summary>
+struct FakeResolver {
+	std::vector<uint64_t>	Calls;				/* The addresses that were resolved, in order */
+	uint64_t				Base = 0x400000;	/* The base of the fake module */
+	uint64_t				Size = 0x10000;		/* The size of the fake module */
+
+	/// <summary>
+	/// Resolve an address: every 0x100 bytes of the module is a function with one source line, outside of it nothing resolves.
+	/// </summary>
+	/// <param name="address">The address to resolve.</param>
+	/// <returns>The resolved address.</returns>
+	ResolvedAddress operator()(uint64_t address) {
+		Calls.push_back(address);
+
+		ResolvedAddress resolved;
+		if (address < Base || address >= Base + Size)
+			return resolved;
+
+		resolved.HasSymbol	   = true;
+		resolved.Name		   = "function_" + std::to_string((address - Base) / 0x100);
+		resolved.SymbolAddress = address & ~0xffull;
+		resolved.ModuleBase	   = Base;
+		resolved.Displacement  = address & 0xff;
+		resolved.HasLine	   = true;
+		resolved.Line		   = static_cast<uint32_t>((address - Base) / 0x100);
+		return resolved;
+	}
+};
+
+/// <summary>
+/// Create a cache in front of <paramref name="resolver"/>, which must outlive the cache.
+/// </summary>
+/// <param name="resolver">The fake resolver.</param>
+/// <param name="capacity">The capacity of the cache.</param>
+/// <returns>The cache.</returns>
+static SymbolCache make_cache(FakeResolver& resolver, size_t capacity = SymbolCache::DefaultCapacity) {
+	return SymbolCache([&resolver](uint64_t address) { return resolver(address); }, capacity);
+}
+
+/// <summary>
+/// An address is resolved once, after that it is served from the cache, and the result is that of the resolver.
+/// </summary>
+HINDSIGHT_TEST(ResolvesOnce) {
+	FakeResolver resolver;
+	auto cache = make_cache(resolver);
+
+	const auto& first = cache.Resolve(0x400123);
+	CHECK(first.HasSymbol && first.Name == "function_1" && first.Displacement == 0x23);
+
+	const auto& second = cache.Resolve(0x400123);
+	CHECK(second.Name == "function_1");
+	CHECK(resolver.Calls.size() == 1);
+	CHECK(cache.Hits() == 1 && cache.Misses() == 1);
+	CHECK(cache.size() == 1);
+}
+
+/// <summary>
+/// An address that cannot be resolved is cached as well, it is not passed to the resolver again.
+/// </summary>
+HINDSIGHT_TEST(CachesNegativeResults) {
+	FakeResolver resolver;
+	auto cache = make_cache(resolver);
+
+	CHECK(!cache.Resolve(0x1234).HasSymbol);
+	CHECK(!cache.Resolve(0x1234).HasSymbol);
+	CHECK(resolver.Calls.size() == 1);
+}
+
+/// <summary>
+/// Invalidating a module range resolves the addresses in it again, the addresses around it remain cached.
+/// </summary>
+HINDSIGHT_TEST(InvalidatesModuleRanges) {
+	FakeResolver resolver;
+	auto cache = make_cache(resolver);
+
+	cache.Resolve(0x3fffff);
+	cache.Resolve(0x400000);
+	cache.Resolve(0x40ffff);
+	cache.Resolve(0x410000);
+
+	cache.Invalidate(0x400000, 0x10000);
+	CHECK(cache.size() == 2);
+
+	// the module was unloaded and something else was loaded, the resolver decides again
+	resolver.Base = 0x500000;
+	CHECK(!cache.Resolve(0x400000).HasSymbol);
+	CHECK(!cache.Resolve(0x3fffff).HasSymbol);
+	CHECK(resolver.Calls.size() == 5);
+
+	// a range at the very top of the address space does not wrap around
+	cache.Resolve(UINT64_MAX);
+	cache.Invalidate(UINT64_MAX - 0xf, 0x100);
+	CHECK(cache.size() == 3);
+}
+
+/// <summary>
+/// A full cache starts over, it never holds more than its capacity.
+/// </summary>
+HINDSIGHT_TEST(StaysWithinCapacity) {
+	FakeResolver resolver;
+	auto cache = make_cache(resolver, 8);
+
+	for (uint64_t address = 0x400000; address < 0x400000 + 20; ++address)
+		cache.Resolve(address);
+
+	CHECK(cache.size() <= 8);
+	CHECK(cache.Misses() == 20);
+
+	cache.Clear();
+	CHECK(cache.size() == 0);
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#ifndef tests_test_h
+#define tests_test_h
+	#include <cstddef>
+	#include <cstdio>
+	#include <exception>
+	#include <functional>
+	#include <utility>
+	#include <vector>
+
+	namespace Hindsight {
+		namespace Test {
+			/// <summary>
+			/// A test case, registered through <see cref="HINDSIGHT_TEST"/>.
+			/// </summary>
+			struct Case {
+				const char*				Name;	/* The name of the test function */
+				std::function<void()>	Body;	/* The test function */
+			};
+
+			/// <summary>
+			/// Get the test cases of this test executable, in order of registration.
+			/// </summary>
+			/// <returns>A reference to the registered test cases.</returns>
+			inline std::vector<Case>& Cases() {
+				static std::vector<Case> cases;
+				return cases;
+			}
+
+			/// <summary>
+			/// Get the number of failed checks so far.
+			/// </summary>
+			/// <returns>A reference to the number of failed checks.</returns>
+			inline size_t& Failures() {
+				static size_t failures = 0;
+				return failures;
+			}
+
+			/// <summary>
+			/// Registers a test case when it is constructed, used by <see cref="HINDSIGHT_TEST"/>.
+			/// </summary>
+			struct Registrar {
+				Registrar(const char* name, std::function<void()> body) {
+					Cases().push_back({ name, std::move(body) });
+				}
+			};
+
+			/// <summary>
+			/// Report a failed check.
+			/// </summary>
+			/// <param name="file">The source file of the check.</param>
+			/// <param name="line">The line of the check.</param>
+			/// <param name="expression">The expression that was checked.</param>
+			inline void Fail(const char* file, int line, const char* expression) {
+				std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+				++Failures();
+			}
+
+			/// <summary>
+			/// Run all registered test cases, a test case that throws fails as a whole.
+			/// </summary>
+			/// <returns>The exit code of the test executable, 0 when all checks passed.</returns>
+			inline int Run() {
+				for (const auto& test : Cases()) {
+					auto before = Failures();
+
+					try {
+						test.Body();
+					} catch (const std::exception& e) {
+						std::fprintf(stderr, "%s: unexpected exception: %s\n", test.Name, e.what());
+						++Failures();
+					}
+
+					std::printf("[%s] %s\n", Failures() == before ? "  OK  " : " FAIL ", test.Name);
+				}
+
+				return Failures() == 0 ? 0 : 1;
+			}
+		}
+	}
+
+	// Define and register a test case.
+	#define HINDSIGHT_TEST(name) \
+		static void name(); \
+		static ::Hindsight::Test::Registrar name##_registrar(#name, name); \
+		static void name()
+
+	// Check that an expression is true, the test case continues when it is not.
+	#define CHECK(expression) \
+		do { if (!(expression)) ::Hindsight::Test::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+	// Check that an expression throws an exception of type exception_type.
+	#define CHECK_THROWS(expression, exception_type) \
+		do { \
+			bool thrown_ = false; \
+			try { (void)(expression); } catch (const exception_type&) { thrown_ = true; } \
+			if (!thrown_) ::Hindsight::Test::Fail(__FILE__, __LINE__, #expression " throws " #exception_type); \
+		} while (0)
+#endif
@@ -0,0 +1,62 @@
+#include <csignal>
+#include <dlfcn.h>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// The program that LzBench records: a few rounds of loading and unloading shared objects while worker threads raise
+/// signals from recursive call chains of varying depth. This gives a log with the mix of module events, thread events and
+/// exceptions with stack traces of a real session. The frames are kept (no inlining, frame pointers) so that the traces are walked.
+/// </summary>
+
+static void on_signal(int) {}
+
+extern "C" __attribute__((noinline)) void raise_signal(int n) {
+	raise(n % 3 == 0 ? SIGUSR1 : SIGUSR2);
+}
+
+extern "C" __attribute__((noinline)) void parse_tokens(int depth, int n);
+
+extern "C" __attribute__((noinline)) void evaluate_expression(int depth, int n) {
+	if (depth == 0)
+		raise_signal(n);
+	else
+		parse_tokens(depth - 1, n);
+}
+
+extern "C" __attribute__((noinline)) void parse_tokens(int depth, int n) {
+	if (depth == 0)
+		raise_signal(n);
+	else
+		evaluate_expression(depth - 1, n);
+}
+
+extern "C" __attribute__((noinline)) void worker(int id) {
+	for (int i = 0; i < 250; ++i)
+		parse_tokens((i + id) % 12, i);
+}
+
+int main() {
+	signal(SIGUSR1, on_signal);
+	signal(SIGUSR2, on_signal);
+
+	const char* libraries[] = { "libm.so.6", "libz.so.1", "libresolv.so.2", "libdl.so.2", "libutil.so.1", "librt.so.1" };
+
+	for (int round = 0; round < 3; ++round) {
+		std::vector<void*> handles;
+		for (auto library : libraries)
+			handles.push_back(dlopen(library, RTLD_NOW));
+
+		std::vector<std::thread> threads;
+		for (int id = 0; id < 4; ++id)
+			threads.emplace_back(worker, id + round);
+		for (auto& thread : threads)
+			thread.join();
+
+		for (auto handle : handles)
+			if (handle != nullptr)
+				dlclose(handle);
+	}
+
+	return 0;
+}
@@ -0,0 +1,381 @@
+#include "Test.hpp"
+#include "X64UnwindTable.hpp"
+#include "ImageFileMemoryReader.hpp"
+#include "SnapshotMemoryReader.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+using namespace Hindsight::Debugger;
+using namespace Hindsight::Debugger::Backend;
+
+static const uint64_t image_base	= 0x140000000;
+static const uint64_t stack_base	= 0x7ff000;
+static const size_t nt_offset		= 0x80;
+static const size_t optional_offset = nt_offset + 24;
+static const size_t section_offset	= optional_offset + 240;
+
+/// <summary>
+/// A memory reader that reads zeroes at every address, used as the stack when the unwinder is run over every function of an image.
+/// </summary>
+class ZeroMemoryReader : public IMemoryReader {
+	public:
+		/// <summary>
+		/// Read <paramref name="size"/> zeroes.
+		/// </summary>
+		/// <param name="buffer">The buffer that receives the data.</param>
+		/// <param name="size">The number of bytes to read.</param>
+		/// <returns><paramref name="size"/>.</returns>
+		size_t Read(uint64_t, void* buffer, size_t size) const override {
+			std::memset(buffer, 0, size);
+			return size;
+		}
+};
+
+/// <summary>
+/// Store a little-endian value in the contents of an image file.
+/// </summary>
+/// <param name="file">The contents of the image file.</param>
+/// <param name="offset">The file offset of the value.</param>
+/// <param name="value">The value.</param>
+template <typename T>
+static void put(std::vector<uint8_t>& file, size_t offset, T value) {
+	std::memcpy(file.data() + offset, &value, sizeof(T));
+}
+
+/// <summary>
+/// Store bytes in the contents of an image file.
+/// </summary>
+/// <param name="file">The contents of the image file.</param>
+/// <param name="offset">The file offset of the bytes.</param>
+/// <param name="bytes">The bytes.</param>
+static void put_bytes(std::vector<uint8_t>& file, size_t offset, std::initializer_list<uint8_t> bytes) {
+	std::memcpy(file.data() + offset, bytes.begin(), bytes.size());
+}
+
+/// <summary>
+/// Build an x64 image file whose sections are stored at other offsets than their RVAs, like a linker does:
+/// .text at RVA 0x1000 (file 0x200) and .rdata, with the exception directory and the unwind information, at RVA 0x2000
+/// (file 0x400). The image contains these functions:
+/// 0x1000-0x1040, push rbp; sub rsp, 20h, with the epilog add rsp, 20h; pop rbp; ret at 0x1030.
+/// 0x1040-0x1060, sub rsp, 10h, chained to the function at 0x1000.
+/// 0x1060-0x1080, an interrupt handler with a machine frame.
+/// Everything else in .text is a leaf function.
+/// </summary>
+/// <returns>The contents of the image file.</returns>
+static std::vector<uint8_t> make_image() {
+	std::vector<uint8_t> file(0x600, 0);
+
+	put<uint16_t>(file, 0, 0x5a4d);
+	put<uint32_t>(file, 0x3c, nt_offset);
+
+	put<uint32_t>(file, nt_offset, 0x00004550);
+	put<uint16_t>(file, nt_offset + 4, 0x8664);
+	put<uint16_t>(file, nt_offset + 6, 2);
+	put<uint16_t>(file, nt_offset + 20, 240);
+
+	put<uint16_t>(file, optional_offset, 0x20b);
+	put<uint64_t>(file, optional_offset + 24, image_base);
+	put<uint32_t>(file, optional_offset + 32, 0x1000);
+	put<uint32_t>(file, optional_offset + 36, 0x200);
+	put<uint32_t>(file, optional_offset + 56, 0x3000);
+	put<uint32_t>(file, optional_offset + 60, 0x200);
+	put<uint32_t>(file, optional_offset + 108, 16);
+	put<uint32_t>(file, optional_offset + 112 + 3 * 8, 0x2000);
+	put<uint32_t>(file, optional_offset + 112 + 3 * 8 + 4, 36);
+
+	// name, virtual size, RVA, raw size, raw offset; .rdata is larger in memory than in the file
+	std::memcpy(file.data() + section_offset, ".text", 5);
+	put<uint32_t>(file, section_offset + 8, 0x200);
+	put<uint32_t>(file, section_offset + 12, 0x1000);
+	put<uint32_t>(file, section_offset + 16, 0x200);
+	put<uint32_t>(file, section_offset + 20, 0x200);
+
+	std::memcpy(file.data() + section_offset + 40, ".rdata", 6);
+	put<uint32_t>(file, section_offset + 40 + 8, 0x300);
+	put<uint32_t>(file, section_offset + 40 + 12, 0x2000);
+	put<uint32_t>(file, section_offset + 40 + 16, 0x200);
+	put<uint32_t>(file, section_offset + 40 + 20, 0x400);
+
+	// .text is int3 except for the prolog and the epilog of the first function
+	std::memset(file.data() + 0x200, 0xcc, 0x200);
+	put_bytes(file, 0x200, { 0x55, 0x48, 0x83, 0xec, 0x20 });
+	put_bytes(file, 0x230, { 0x48, 0x83, 0xc4, 0x20, 0x5d, 0xc3 });
+
+	// the RUNTIME_FUNCTION entries
+	const uint32_t functions[] = { 0x1000, 0x1040, 0x2100, 0x1040, 0x1060, 0x2110, 0x1060, 0x1080, 0x2130 };
+	std::memcpy(file.data() + 0x400, functions, sizeof(functions));
+
+	// version 1, prolog of 5 bytes, UWOP_ALLOC_SMALL 20h at 5 and UWOP_PUSH_NONVOL RBP at 1
+	put_bytes(file, 0x500, { 0x01, 5, 2, 0 });
+	put<uint16_t>(file, 0x504, 0x3205);
+	put<uint16_t>(file, 0x506, 0x5001);
+
+	// version 1 with UNW_FLAG_CHAININFO, UWOP_ALLOC_SMALL 10h at 4, padded, followed by the entry of the first function
+	put_bytes(file, 0x510, { 0x01 | (0x4 << 3), 4, 1, 0 });
+	put<uint16_t>(file, 0x514, 0x1204);
+	std::memcpy(file.data() + 0x518, functions, 12);
+
+	// version 1, UWOP_PUSH_MACHFRAME without an error code
+	put_bytes(file, 0x530, { 0x01, 0, 1, 0 });
+	put<uint16_t>(file, 0x534, 0x0a00);
+
+	return file;
+}
+
+/// <summary>
+/// Unwind one frame of the image from <see cref="make_image"/>.
+/// </summary>
+/// <param name="rva">The RVA of the instruction pointer.</param>
+/// <param name="interrupted">True when the frame was interrupted, false when the RVA is a return address.</param>
+/// <param name="stack">The stack, which starts at RSP.</param>
+/// <param name="context">A reference to the context that receives the registers of the caller.</param>
+/// <returns>The result of <see cref="X64UnwindTable::Unwind"/>.</returns>
+static bool unwind(uint32_t rva, bool interrupted, const std::vector<uint64_t>& stack, X64UnwindContext& context) {
+	ImageFileMemoryReader image(make_image());
+	SnapshotMemoryReader memory(stack_base, stack.data(), stack.size() * sizeof(uint64_t), &image);
+
+	X64UnwindTable table;
+	if (!X64UnwindTable::Read(image, image.Base(), table))
+		return false;
+
+	context = X64UnwindContext();
+	context.Rip = image_base + rva;
+	context.Interrupted = interrupted;
+	context.Registers[X64UnwindContext::Rsp] = stack_base;
+	context.Registers[X64UnwindContext::Rbp] = 0xbbbb;
+
+	return table.Unwind(memory, context);
+}
+
+/// <summary>
+/// The headers are mapped at the base and each section at its RVA, the uninitialized tail of a section reads as zeroes
+/// and nothing is read beyond the image.
+/// </summary>
+HINDSIGHT_TEST(MapsSectionsAtTheirRvas) {
+	ImageFileMemoryReader image(make_image());
+	CHECK(image.Base() == image_base);
+	CHECK(image.size() == 0x3000);
+
+	uint8_t code = 0;
+	uint32_t begin = 0, tail = 0xffffffff;
+	CHECK(image.Read(image_base + 0x1000, &code, 1) == 1 && code == 0x55);
+	CHECK(image.Read(image_base + 0x2000, &begin, 4) == 4 && begin == 0x1000);
+	CHECK(image.Read(image_base + 0x2280, &tail, 4) == 4 && tail == 0);
+
+	uint8_t buffer[16];
+	CHECK(image.Read(image_base + 0x3000, buffer, 1) == 0);
+	CHECK(image.Read(image_base - 1, buffer, 1) == 0);
+	CHECK(image.Read(image_base + 0x3000 - 4, buffer, sizeof(buffer)) == 4);
+
+	ImageFileMemoryReader rebased(make_image(), 0x10000000);
+	CHECK(rebased.Base() == 0x10000000);
+	CHECK(rebased.Read(0x10001000, &code, 1) == 1 && code == 0x55);
+}
+
+/// <summary>
+/// A file that is not a PE image, or whose headers are damaged, is rejected, and an image for another machine has no
+/// x64 unwind table.
+/// </summary>
+HINDSIGHT_TEST(RejectsDamagedImages) {
+	auto file = make_image();
+	put<uint16_t>(file, 0, 0);
+	CHECK_THROWS(ImageFileMemoryReader{ file }, std::runtime_error);
+
+	file = make_image();
+	file.resize(0x90);
+	CHECK_THROWS(ImageFileMemoryReader{ file }, std::runtime_error);
+
+	file = make_image();
+	put<uint32_t>(file, optional_offset + 56, 0x7fffffff);
+	CHECK_THROWS(ImageFileMemoryReader{ file }, std::runtime_error);
+
+	CHECK_THROWS(ImageFileMemoryReader{ std::string("does-not-exist.exe") }, std::runtime_error);
+
+	file = make_image();
+	put<uint16_t>(file, nt_offset + 4, 0x14c);
+	ImageFileMemoryReader image(file);
+	X64UnwindTable table;
+	CHECK(!X64UnwindTable::Read(image, image.Base(), table));
+
+	// sections that point outside of the file or the image are skipped
+	file = make_image();
+	put<uint32_t>(file, section_offset + 20, 0x10000);
+	put<uint32_t>(file, section_offset + 40 + 12, 0x10000);
+	ImageFileMemoryReader truncated(file);
+	CHECK(truncated.size() == 0x3000);
+}
+
+/// <summary>
+/// The function entries are read from the exception directory of the mapped file.
+/// </summary>
+HINDSIGHT_TEST(ReadsTheExceptionDirectory) {
+	ImageFileMemoryReader image(make_image());
+	X64UnwindTable table;
+
+	CHECK(X64UnwindTable::Read(image, image.Base(), table));
+	CHECK(table.Base() == image_base);
+	CHECK(table.size() == 3);
+}
+
+/// <summary>
+/// Inside of a prolog only the instructions that already executed are undone, in the body all of them are.
+/// </summary>
+HINDSIGHT_TEST(UnwindsProlog) {
+	X64UnwindContext context;
+
+	// after push rbp, before sub rsp, 20h
+	CHECK(unwind(0x1001, true, { 0x1111, 0x2222 }, context));
+	CHECK(context.Registers[X64UnwindContext::Rbp] == 0x1111);
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 16);
+	CHECK(!context.Interrupted);
+
+	// a return address in the body
+	CHECK(unwind(0x1010, false, { 0, 0, 0, 0, 0x1111, 0x2222 }, context));
+	CHECK(context.Registers[X64UnwindContext::Rbp] == 0x1111);
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 48);
+}
+
+/// <summary>
+/// A frame that was interrupted in an epilog is unwound by emulating the rest of the epilog.
+/// </summary>
+HINDSIGHT_TEST(UnwindsEpilog) {
+	X64UnwindContext context;
+
+	CHECK(unwind(0x1030, true, { 0, 0, 0, 0, 0x1111, 0x2222 }, context));
+	CHECK(context.Registers[X64UnwindContext::Rbp] == 0x1111);
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 48);
+
+	// after add rsp, 20h, before pop rbp
+	CHECK(unwind(0x1034, true, { 0x1111, 0x2222 }, context));
+	CHECK(context.Registers[X64UnwindContext::Rbp] == 0x1111);
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 16);
+}
+
+/// <summary>
+/// Chained unwind information is undone first, then the information it chains to, whose prolog has fully executed.
+/// </summary>
+HINDSIGHT_TEST(UnwindsChainedInfo) {
+	X64UnwindContext context;
+
+	CHECK(unwind(0x1050, false, { 0, 0, 0, 0, 0, 0, 0x1111, 0x2222 }, context));
+	CHECK(context.Registers[X64UnwindContext::Rbp] == 0x1111);
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 64);
+
+	// the chain is followed in the prolog of the chained function too
+	CHECK(unwind(0x1040, true, { 0, 0, 0, 0, 0x1111, 0x2222 }, context));
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 48);
+}
+
+/// <summary>
+/// A machine frame restores the interrupted RIP and RSP, and the frame below it is an interrupted frame.
+/// </summary>
+HINDSIGHT_TEST(UnwindsMachineFrame) {
+	X64UnwindContext context;
+
+	CHECK(unwind(0x1064, true, { 0x140001010, 0x33, 0x246, 0x7fe000, 0x2b }, context));
+	CHECK(context.Rip == 0x140001010);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == 0x7fe000);
+	CHECK(context.Interrupted);
+}
+
+/// <summary>
+/// A function without a function entry only has its return address on the stack.
+/// </summary>
+HINDSIGHT_TEST(UnwindsLeafFunction) {
+	X64UnwindContext context;
+
+	CHECK(unwind(0x1100, true, { 0x2222 }, context));
+	CHECK(context.Rip == 0x2222);
+	CHECK(context.Registers[X64UnwindContext::Rsp] == stack_base + 8);
+	CHECK(context.Registers[X64UnwindContext::Rbp] == 0xbbbb);
+}
+
+/// <summary>
+/// Every function of real x64 images unwinds, and unwinding never moves the stack pointer down unless a machine frame
+/// restores it. The images are listed in the HINDSIGHT_TEST_IMAGES environment variable, separated like PATH, and the
+/// test does nothing when it is not set. Images that are not x64 are skipped.
+/// </summary>
+HINDSIGHT_TEST(UnwindsRealImages) {
+	auto list = std::getenv("HINDSIGHT_TEST_IMAGES");
+	if (list == nullptr)
+		return;
+
+#ifdef _WIN32
+	const char separator = ';';
+#else
+	const char separator = ':';
+#endif
+
+	std::string paths = list;
+	for (size_t begin = 0, end; begin < paths.size(); begin = end + 1) {
+		end = paths.find(separator, begin);
+		if (end == std::string::npos)
+			end = paths.size();
+
+		auto path = paths.substr(begin, end - begin);
+		if (path.empty())
+			continue;
+
+		ImageFileMemoryReader image(path);
+		X64UnwindTable table;
+		if (!X64UnwindTable::Read(image, image.Base(), table)) {
+			std::printf("         %s: not an x64 image, skipped\n", path.c_str());
+			continue;
+		}
+
+		uint32_t directory[2] = {};
+		uint32_t nt = 0;
+		image.Read(image.Base() + 0x3c, &nt, sizeof(nt));
+		image.Read(image.Base() + nt + 24 + 112 + 3 * 8, directory, sizeof(directory));
+
+		std::vector<uint32_t> entries(directory[1] / 4);
+		image.Read(image.Base() + directory[0], entries.data(), entries.size() * 4);
+
+		ZeroMemoryReader stack;
+		size_t chained = 0, machine = 0, failed = 0;
+
+		for (size_t i = 0; i + 3 <= entries.size(); i += 3) {
+			uint8_t header[4] = {};
+			image.Read(image.Base() + entries[i + 2], header, sizeof(header));
+			if ((header[0] >> 3) & 0x4)
+				++chained;
+
+			// a frame pointer is always above the stack pointer
+			X64UnwindContext context;
+			context.Rip = image.Base() + entries[i] + (entries[i + 1] - entries[i]) / 2;
+			context.Interrupted = false;
+			for (auto& value : context.Registers)
+				value = stack_base + 0x100000;
+			context.Registers[X64UnwindContext::Rsp] = stack_base;
+
+			if (!table.Unwind(stack, context)) {
+				++failed;
+				continue;
+			}
+
+			if (context.Interrupted)
+				++machine;
+			else if (context.Registers[X64UnwindContext::Rsp] <= stack_base)
+				++failed;
+		}
+
+		std::printf("         %s: %zu functions, %zu chained, %zu machine frames\n", path.c_str(), table.size(), chained, machine);
+		CHECK(table.size() == entries.size() / 3);
+		CHECK(failed == 0);
+	}
+}
+
+int main() {
+	return Hindsight::Test::Run();
+}